@@ -1,45 +1,60 @@
 #include "adc_driver/adc_driver.h"
 #include "global_buffer/global_buffer.h"
+#include "persistence/persistence.h"
+#include "xy/xy.h"
+#include "mask/mask.h"
+#include "calibration/calibration.h"
+#include "perf/perf.h"
 #include <hardware/adc.h>
 #include <hardware/dma.h>
 #include <hardware/irq.h>
-#include <pico/multicore.h>
+#include <hardware/sync.h>
 
 static int dma_chan;
 static volatile bool adc_running = false;
-extern void buffer_update_stats(uint16_t* buffer);
-extern bool check_trigger(uint16_t* buffer);
-extern void buffer_process();
+static volatile uint8_t last_filled = 0;   // Последний заполненный DMA буфер
+static volatile uint32_t blocks_filled = 0; // Счётчик заполненных буферов
+static FrameMeta last_meta;                 // Его кадр, sequence 0 - не опубликован
+static bool capture_xy = false;             // Входы A и B поочерёдно
 
 
-void adc_dma_handler() {
+// Прерывание не блокируется: DMA сразу перенаправляется в слот, который ядро
+// дисплея гарантированно не читает, заполненный буфер исправляется по таблице
+// калибровки и публикуется в очередь кадров
+void __not_in_flash_func(adc_dma_handler)() {
     if (dma_channel_get_irq0_status(dma_chan)) {
+        PERF_TIMER(irq_start);
         dma_channel_acknowledge_irq0(dma_chan);
         
-        mutex_enter_blocking(&global_buffer.buffer_mutex);
-        uint8_t filled_buf = global_buffer.write_buffer;
+        uint32_t now = time_us_32();
+        FrameQueue* q = &global_buffer.frame_queue;
+        uint8_t filled_buf = frame_queue_write_slot(q);
+        uint8_t next_buf = frame_queue_reserve(q);
         
-        // Всегда обновляем display_buffer в live-режиме
-        if (global_buffer.live_update && !global_buffer.hold) {
-            global_buffer.display_buffer = filled_buf;
-        }
+        dma_channel_set_write_addr(dma_chan, global_buffer.adc_buffers[next_buf], true);
         
-        // Переключаем буфер
-        global_buffer.write_buffer = (filled_buf + 1) % NUM_BUFFERS;
-        global_buffer.buffer_ready[filled_buf] = true;
+        // Если пул исчерпан, DMA уже пишет в этот же буфер - кадр выброшен
+        if (next_buf != filled_buf) {
+            calibration_apply(global_buffer.adc_buffers[filled_buf], BUFFER_SIZE);
+        }
+        frame_queue_publish(q, now, BUFFER_SIZE, -1);
         
-        multicore_fifo_push_blocking(filled_buf);
-        mutex_exit(&global_buffer.buffer_mutex);
+        last_meta = *frame_queue_meta(q, filled_buf);
+        if (next_buf == filled_buf) last_meta.sequence = 0;
+        last_filled = filled_buf;
+        blocks_filled++;
+        PERF_COUNT(PERF_CNT_BLOCKS);
+        PERF_RECORD(PERF_IRQ, irq_start);
         
-        dma_channel_set_write_addr(dma_chan, 
-            global_buffer.adc_buffers[global_buffer.write_buffer], 
-            true);
+        // Будим оба ядра: цикл захвата и планировщик кадров спят в __wfe()
+        __sev();
     }
 }
 
 void adc_processor_init() {
     adc_init();
     adc_gpio_init(26);
+    adc_gpio_init(27); // Вход B для режима XY
     adc_select_input(0);
     adc_fifo_setup(true, true, 1, false, false);
     
@@ -51,7 +66,7 @@ void adc_processor_init() {
     channel_config_set_dreq(&cfg, DREQ_ADC);
     
     dma_channel_configure(dma_chan, &cfg,
-        global_buffer.adc_buffers[0],
+        global_buffer.adc_buffers[frame_queue_write_slot(&global_buffer.frame_queue)],
         &adc_hw->fifo,
         BUFFER_SIZE,
         false
@@ -83,12 +98,110 @@ void adc_stop() {
     }
 }
 
+// Переключение между одним входом и парой A, B (режим XY) на ходу.
+// Выполняется ядром захвата, владельцем прерывания DMA: преобразования и
+// DMA останавливаются, текущий блок пишется заново с начала слота. Блок
+// чётной длины начинается с A, поэтому пары во всех блоках идут A, B
+static void set_capture_channels(bool xy) {
+    adc_run(false);
+    dma_channel_set_irq0_enabled(dma_chan, false);
+    dma_channel_abort(dma_chan);
+    dma_channel_acknowledge_irq0(dma_chan);
+    dma_channel_set_irq0_enabled(dma_chan, true);
+    adc_fifo_drain();
+    
+    adc_select_input(0);
+    adc_set_round_robin(xy ? XY_INPUT_MASK : 0);
+    capture_xy = xy;
+    
+    if (adc_running) {
+        dma_channel_set_trans_count(dma_chan, BUFFER_SIZE, false);
+        dma_channel_set_write_addr(dma_chan,
+            global_buffer.adc_buffers[frame_queue_write_slot(&global_buffer.frame_queue)], true);
+        adc_run(true);
+    }
+}
+
+// Накопление послесвечения и испытание по маске на ядре захвата: каждый
+// заполненный буфер привязывается к триггеру (фронт ищется один раз на
+// оба), добавляется в карту попаданий и сравнивается с маской
+static void accumulate_triggered(const uint16_t* buffer) {
+    int trig = -1;
+    if (global_buffer.trigger_enabled) {
+        trig = buffer_find_trigger(buffer);
+        if (trig < 0) return; // Нет синхронизации - не размазываем картинку
+    }
+    if (global_buffer.persistence) {
+        int start = trig > TRIGGER_PRETRIGGER ? trig - TRIGGER_PRETRIGGER : 0;
+        persistence_accumulate(&buffer[start], BUFFER_SIZE - start);
+    }
+    mask_test(buffer, BUFFER_SIZE, trig);
+}
+
+// Ожидание конца записи во flash. Код цикла в RAM, прерывания не
+// запрещаются: захват идёт как обычно, не обрабатываются только буферы
+// для послесвечения и калибровки
+static void __not_in_flash_func(park_for_flash)(void) {
+    global_buffer.flash_parked = true;
+    __sev();
+    while (global_buffer.flash_park_request) {
+        __wfe();
+    }
+    global_buffer.flash_parked = false;
+}
+
 void core0_adc_task() {
+#if PERF_ENABLED
+    perf_init_core();
+#endif
     adc_processor_init();
+    persistence_init();
+    xy_init();
+    mask_init();
     adc_start();
     
+    uint32_t blocks_seen = 0;
     while (true) {
         __wfe();
+        
+        if (global_buffer.flash_park_request) park_for_flash();
+        
+        // Блоки, захваченные до переключения входов, в новом режиме не нужны
+        if (global_buffer.xy_mode != capture_xy) {
+            set_capture_channels(global_buffer.xy_mode);
+            blocks_seen = blocks_filled;
+            continue;
+        }
+        
+        // Прерывание DMA будит ядро; обрабатываем только свежий буфер.
+        // Номер, слот и кадр - согласованно, между ними прерывание не вклинится
+        uint32_t irq = save_and_disable_interrupts();
+        uint32_t filled = blocks_filled;
+        uint8_t slot = last_filled;
+        FrameMeta meta = last_meta;
+        restore_interrupts(irq);
+        if (filled == blocks_seen) continue;
+        blocks_seen = filled;
+        const uint16_t* block = global_buffer.adc_buffers[slot];
+        
+        // Каждый опубликованный блок - длинной записи, пока ядро дисплея
+        // занято выводом кадра. Пропуск здесь - только если ядро захвата
+        // не успело к следующему блоку
+        if (meta.sequence) buffer_capture_block(block, &meta);
+        
+        // XY: каждый блок - точки на карту. Послесвечение и калибровка
+        // нелинейности работают только с одним входом
+        if (capture_xy) {
+            xy_accumulate(block, BUFFER_SIZE);
+            continue;
+        }
+        
+        if (global_buffer.persistence || mask_enabled()) {
+            accumulate_triggered(block);
+        }
+        
+        // Калибровка нелинейности: гистограмма по сырым кодам
+        calibration_task(block, BUFFER_SIZE);
         //buffer_process();
         //tight_loop_contents();
     }
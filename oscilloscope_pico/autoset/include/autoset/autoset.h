@@ -0,0 +1,87 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+// Автоустановка: оценка сигнала по блокам захвата для выбора развёртки,
+// вольт/деление и уровня триггера.
+//
+// Частота дискретизации постоянна, поэтому "быстрый грубый захват" - это
+// накопление подряд идущих блоков, пока их не хватит на оценку. По каждому
+// блоку за один проход считаются минимум, максимум и сумма (огибающая и
+// постоянная составляющая с запуска), вторым - подъёмы детектором с
+// гистерезисом: из-под mid - vpp/4 выше mid + vpp/4. Период - от первого
+// до последнего подъёма.
+//
+// Оценка готова в конце блока, где набралось AUTOSET_MIN_RISES подъёмов
+// (два периода) не короче AUTOSET_MIN_SPAN отсчётов и все промежутки
+// между ними одинаковы с точностью до 1/8. У шума промежутки случайны, и
+// на таком отрезке их много - он периода не даёт. Несовпавший промежуток
+// начинает подъёмы заново. Пока огибающая растёт больше чем на 1/16
+// размаха, середина неверна - подъёмы тоже собираются заново; так же -
+// при пропуске блока (разрыв номеров). Без периода за AUTOSET_MAX_SAMPLES
+// отсчётов сигнал считается непериодическим (или постоянным).
+//
+// Модуль не зависит от SDK и собирается на хосте (osc_bench меряет время
+// до захвата на наборе сигналов).
+
+#define AUTOSET_MIN_RISES      3
+#define AUTOSET_MIN_SPAN       2048   // ~4 мс: у быстрых сигналов - много периодов
+#define AUTOSET_MAX_SAMPLES    65536  // ~131 мс при 500 кГц: период до ~20000 отсчётов
+#define AUTOSET_MIN_VPP        32     // Кодов: меньше - постоянный уровень
+#define AUTOSET_MIN_HYSTERESIS 8      // Кодов, не меньше шума младших разрядов
+
+typedef enum {
+    AUTOSET_IDLE,
+    AUTOSET_RUNNING,
+    AUTOSET_LOCKED,       // Период найден
+    AUTOSET_NO_PERIOD     // Время вышло: непериодический или постоянный
+} AutosetState;
+
+typedef struct {
+    AutosetState state;
+    uint32_t samples;         // Отсчётов с запуска, положение фронтов
+    uint16_t blocks;
+    uint32_t next_sequence;
+
+    // Огибающая и сумма с запуска
+    uint16_t min;
+    uint16_t max;
+    uint32_t sum;
+
+    // Детектор фронтов: уровни на последнем блоке
+    uint16_t env_vpp;         // Размах, при котором собраны подъёмы
+    int8_t side;              // -1 ниже mid - h, 1 выше mid + h, 0 - неизвестно
+    uint16_t rises;
+    uint32_t first_rise;
+    uint32_t last_rise;
+    uint32_t min_interval;    // Промежутки между подъёмами
+    uint32_t max_interval;
+
+    uint32_t period_q8;       // Отсчётов, Q8 (AUTOSET_LOCKED)
+} Autoset;
+
+// Новый запуск: оценка с нуля
+void autoset_start(Autoset *a);
+
+// Очередной блок захвата (номер - FrameMeta.sequence). Возвращает
+// состояние после блока; после окончания блоки не учитываются
+AutosetState autoset_feed(Autoset *a, const uint16_t *samples, uint16_t count, uint32_t sequence);
+
+// Результат, в кодах АЦП
+static inline uint16_t autoset_mid(const Autoset *a) {
+    return (uint16_t)((a->min + a->max) / 2);
+}
+
+static inline uint16_t autoset_vpp(const Autoset *a) {
+    return a->max - a->min;
+}
+
+static inline uint16_t autoset_mean(const Autoset *a) {
+    return a->samples ? (uint16_t)((a->sum + a->samples / 2) / a->samples) : 0;
+}
+
+// Гистерезис триггера для размаха vpp
+static inline uint16_t autoset_hysteresis(uint16_t vpp) {
+    uint16_t h = vpp / 8;
+    return h < AUTOSET_MIN_HYSTERESIS ? AUTOSET_MIN_HYSTERESIS : h;
+}
@@ -0,0 +1,94 @@
+#include "autoset/autoset.h"
+
+void autoset_start(Autoset *a) {
+    a->state = AUTOSET_RUNNING;
+    a->samples = 0;
+    a->blocks = 0;
+    a->min = 0xFFFF;
+    a->max = 0;
+    a->sum = 0;
+    a->env_vpp = 0;
+    a->side = 0;
+    a->rises = 0;
+}
+
+// Промежутки одинаковы: разброс не больше 1/8 длинного и пары отсчётов
+static void add_rise(Autoset *a, uint32_t at) {
+    if (a->rises) {
+        uint32_t interval = at - a->last_rise;
+        uint32_t lo = a->rises > 1 && a->min_interval < interval ? a->min_interval : interval;
+        uint32_t hi = a->rises > 1 && a->max_interval > interval ? a->max_interval : interval;
+        if ((hi - lo) * 8 > hi + 32) {
+            a->rises = 0;
+        } else {
+            a->min_interval = lo;
+            a->max_interval = hi;
+        }
+    }
+    if (!a->rises) a->first_rise = at;
+    a->last_rise = at;
+    a->rises++;
+}
+
+static void find_rises(Autoset *a, const uint16_t *samples, uint16_t count) {
+    uint16_t vpp = a->max - a->min;
+    if (vpp < AUTOSET_MIN_VPP) return;
+    int mid = (a->min + a->max) / 2;
+    int low = mid - vpp / 4;
+    int high = mid + vpp / 4;
+
+    int8_t side = a->side;
+    for (uint16_t i = 0; i < count; i++) {
+        int v = samples[i];
+        if (v < low) {
+            side = -1;
+        } else if (v > high) {
+            if (side < 0) add_rise(a, a->samples + i);
+            side = 1;
+        }
+    }
+    a->side = side;
+}
+
+AutosetState autoset_feed(Autoset *a, const uint16_t *samples, uint16_t count, uint32_t sequence) {
+    if (a->state != AUTOSET_RUNNING || !count) return a->state;
+
+    // Пропуск блока: фронты по разные стороны разрыва не складываются
+    if (a->blocks && sequence != a->next_sequence) {
+        a->side = 0;
+        a->rises = 0;
+    }
+    a->next_sequence = sequence + 1;
+
+    uint16_t lo = a->min, hi = a->max;
+    uint32_t sum = 0;
+    for (uint16_t i = 0; i < count; i++) {
+        uint16_t v = samples[i];
+        if (v < lo) lo = v;
+        if (v > hi) hi = v;
+        sum += v;
+    }
+    a->min = lo;
+    a->max = hi;
+    a->sum += sum;
+
+    // Огибающая выросла - середина сдвинулась, прежние подъёмы не годятся
+    uint16_t vpp = hi - lo;
+    if (vpp > a->env_vpp + a->env_vpp / 16) {
+        a->env_vpp = vpp;
+        a->side = 0;
+        a->rises = 0;
+    }
+
+    find_rises(a, samples, count);
+    a->samples += count;
+    a->blocks++;
+
+    if (a->rises >= AUTOSET_MIN_RISES && a->last_rise - a->first_rise >= AUTOSET_MIN_SPAN) {
+        a->period_q8 = ((a->last_rise - a->first_rise) << 8) / (a->rises - 1);
+        a->state = AUTOSET_LOCKED;
+    } else if (a->samples >= AUTOSET_MAX_SAMPLES) {
+        a->state = AUTOSET_NO_PERIOD;
+    }
+    return a->state;
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "display_driver/display_driver.h"
+#include "settings/settings_store.h"
+
+// Калибровка АЦП и таблицы пересчёта кодов.
+//
+// 1. Коррекция нелинейности (DNL): у АЦП RP2040 коды около 512, 1536, 2560
+//    и 3584 заметно шире соседних. Таблица calib_lut[4096] переводит сырой
+//    код в исправленный и применяется к каждому буферу прямо в прерывании
+//    DMA, до публикации кадра. Таблица строится методом плотности кодов:
+//    на вход подаётся сигнал, равномерно проходящий весь диапазон
+//    (треугольник или пила чуть шире 0..3.3 В), и по гистограмме кодов
+//    восстанавливается реальная передаточная характеристика.
+//    Таблица хранится в отдельном секторе flash (calibration_flash_port) и
+//    читается при запуске. В секторе - шаги таблицы по 4 бита на код:
+//      0    magic    CALIB_LUT_MAGIC (младший байт первым)
+//      2    version  1
+//      3    резерв   0
+//      4    шаги     calib_lut[code] - calib_lut[code - 1] для кодов 1..4095,
+//                    младшая тетрада первой
+//      2052 crc16    CRC-16/CCITT-FALSE по байтам 0..2051 (stream_crc16)
+//    Шаг больше CALIB_LUT_STEP_MAX (код в 16 раз шире среднего) исправный
+//    АЦП не даёт - такая калибровка не принимается.
+// 2. Усиление и смещение: исправленный код -> милливольты, по двум точкам.
+//    Хранятся вместе с настройками (settings.h).
+//    Код -> милливольты - одно умножение (на M0+ за такт), без таблицы:
+//    усиление ограничено CALIB_GAIN_MAX_Q16, произведение не выходит за
+//    32 бита.
+// 3. Таблица отображения: код -> строка осциллограммы. Пересчитывается
+//    только при смене voltage_scale / voltage_offset или калибровки, так
+//    что на отсчёт остаётся одно чтение из таблицы.
+
+#define CALIB_CODES          4096
+#define CALIB_DENSITY_HITS   256   // Среднее число попаданий на код при калибровке
+#define CALIB_FULL_SCALE_MV  3300
+#define CALIB_GAIN_REF_MV    2500  // Вход при калибровке усиления из меню
+#define CALIB_LUT_MAGIC      0xCA1B
+#define CALIB_LUT_STEP_MAX   15
+#define CALIB_GAIN_MAX_Q16   (8u << 16)  // 8 мВ на код, почти 10 номиналов
+
+typedef enum {
+    CALIB_IDLE,       // Коррекция применяется
+    CALIB_DENSITY,    // Идёт сбор гистограммы, коррекция отключена
+} CalibState;
+
+typedef enum {
+    CALIB_RESULT_NONE,
+    CALIB_RESULT_OK,
+    CALIB_RESULT_FAILED,  // Вход не покрывал весь диапазон
+} CalibResult;
+
+// Таблицы и коэффициенты открыты для чтения напрямую, как color_palette
+extern uint16_t calib_lut[CALIB_CODES];
+extern uint8_t calib_code_to_px[CALIB_CODES];
+extern uint32_t calib_gain_q16;  // мВ на код, Q16
+extern int32_t calib_offset_mv;
+
+// Начальное состояние: коррекция из flash (нет записи - тождественная),
+// номинальные усиление и смещение
+void calibration_init(const FlashPort *port);
+
+// Коррекция буфера на месте (ядро захвата, в том числе из прерывания)
+void calibration_apply(uint16_t *samples, uint16_t count);
+
+// Запуск калибровки нелинейности. Сам переход выполняет ядро захвата в
+// calibration_task(), там же накапливается гистограмма
+void calibration_start_density(void);
+void calibration_task(const uint16_t *raw_samples, uint16_t count);
+CalibState calibration_get_state(void);
+CalibResult calibration_get_result(void);
+
+// Сброс коррекции нелинейности к тождественной
+void calibration_reset_lut(void);
+
+// Запись новой таблицы нелинейности во flash после калибровки или сброса.
+// Ядро дисплея, как settings_task(): на время записи ядро захвата ждёт
+void calibration_flash_task(void);
+
+// Двухточечная калибровка по усреднённым исправленным кодам
+void calibration_set_zero(uint16_t code);                    // Вход на земле
+// Известное напряжение. false - код или напряжение не годятся (не выше
+// нуля или усиление больше CALIB_GAIN_MAX_Q16)
+bool calibration_set_gain(uint16_t code, int32_t known_mv);
+
+// Усиление (мВ на код, Q16) и смещение (мВ) для сохранения
+void calibration_get_gain_offset(uint32_t *gain_q16, int32_t *offset_mv);
+void calibration_set_gain_offset(uint32_t gain_q16, int32_t offset_mv);
+
+// Пересчёт таблицы отображения при смене масштаба или калибровки.
+// Возвращает true, если таблицы перестроены (нужно перерисовать слой)
+bool calibration_update_view(float voltage_scale, float voltage_offset);
+
+static inline int32_t calibration_code_to_mv(uint16_t code) {
+    uint32_t c = code & (CALIB_CODES - 1);
+    return (int32_t)((c * calib_gain_q16 + 0x8000) >> 16) + calib_offset_mv;
+}
+
+static inline uint8_t calibration_code_to_px(uint16_t code) {
+    return calib_code_to_px[code & (CALIB_CODES - 1)];
+}
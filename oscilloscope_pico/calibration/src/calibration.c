@@ -0,0 +1,266 @@
+#include "calibration/calibration.h"
+#include "usb_stream/stream_frame.h"
+#include <pico/stdlib.h>
+#include <string.h>
+
+uint16_t calib_lut[CALIB_CODES];
+uint8_t calib_code_to_px[CALIB_CODES];
+
+// Номинал: 3300 мВ на 4095 кодов в Q16
+#define GAIN_NOMINAL_Q16 ((uint32_t)(((uint64_t)CALIB_FULL_SCALE_MV << 16) / (CALIB_CODES - 1)))
+
+static volatile CalibState state = CALIB_IDLE;
+static volatile CalibResult result = CALIB_RESULT_NONE;
+static volatile bool density_requested = false;
+static bool lut_identity = true;
+static uint32_t density_samples = 0;
+
+uint32_t calib_gain_q16 = GAIN_NOMINAL_Q16;
+int32_t calib_offset_mv = 0;
+
+// Параметры, для которых построены таблицы отображения
+static bool view_valid = false;
+static float view_scale = 0.0f;
+static float view_offset = 0.0f;
+
+// Запись таблицы во flash (формат - в calibration.h)
+#define LUT_HEADER_BYTES  4
+#define LUT_STEP_BYTES    (CALIB_CODES / 2)
+#define LUT_RECORD_BYTES  (LUT_HEADER_BYTES + LUT_STEP_BYTES + 2)
+#define PROGRAM_CHUNK     256   // Порт пишет в пределах страницы flash
+
+static const FlashPort *port;
+static volatile bool save_requested = false;
+static uint8_t chunk[PROGRAM_CHUNK];   // Запись собирается по странице
+
+static void lut_identity_fill(void) {
+    for (int code = 0; code < CALIB_CODES; code++) calib_lut[code] = code;
+    lut_identity = true;
+}
+
+// Шаг таблицы к коду code (1..4095) из тетрад записи
+static inline uint8_t lut_step(const uint8_t *steps, int code) {
+    return (steps[(code - 1) / 2] >> (4 * ((code - 1) % 2))) & 0x0F;
+}
+
+// Таблица из flash. false - записи нет или она испорчена, таблица не тронута
+static bool lut_load(void) {
+    const uint8_t *p = port->base;
+    if (port->size < LUT_RECORD_BYTES) return false;
+    if ((p[0] | (p[1] << 8)) != CALIB_LUT_MAGIC || p[2] != 1) return false;
+    uint16_t crc = p[LUT_RECORD_BYTES - 2] | (p[LUT_RECORD_BYTES - 1] << 8);
+    if (crc != stream_crc16(0xFFFF, p, LUT_RECORD_BYTES - 2)) return false;
+
+    // Шаги должны привести ровно к последнему коду
+    const uint8_t *steps = p + LUT_HEADER_BYTES;
+    uint16_t code = 0;
+    for (int i = 1; i < CALIB_CODES; i++) code += lut_step(steps, i);
+    if (code != CALIB_CODES - 1) return false;
+
+    calib_lut[0] = 0;
+    for (int i = 1; i < CALIB_CODES; i++) {
+        calib_lut[i] = calib_lut[i - 1] + lut_step(steps, i);
+    }
+    lut_identity = false;
+    return true;
+}
+
+// Байт i записи без CRC: заголовок и тетрады шагов
+static uint8_t record_byte(uint32_t i) {
+    if (i < LUT_HEADER_BYTES) {
+        static const uint8_t header[LUT_HEADER_BYTES] = {
+            CALIB_LUT_MAGIC & 0xFF, CALIB_LUT_MAGIC >> 8, 1, 0
+        };
+        return header[i];
+    }
+    int code = 2 * (int)(i - LUT_HEADER_BYTES) + 1;
+    uint8_t lo = (uint8_t)(calib_lut[code] - calib_lut[code - 1]);
+    uint8_t hi = code + 1 < CALIB_CODES ? (uint8_t)(calib_lut[code + 1] - calib_lut[code]) : 0;
+    return (uint8_t)(lo | (hi << 4));
+}
+
+// Стирание сектора и запись таблицы страницами: CRC считается по ходу.
+// Тождественная таблица не пишется: стёртый сектор и есть её запись
+static bool lut_save(void) {
+    if (!port->erase(port->ctx, 0)) return false;
+    if (lut_identity) return true;
+
+    uint16_t crc = 0xFFFF;
+    for (uint32_t done = 0; done < LUT_RECORD_BYTES; done += PROGRAM_CHUNK) {
+        uint32_t n = LUT_RECORD_BYTES - done < PROGRAM_CHUNK ? LUT_RECORD_BYTES - done : PROGRAM_CHUNK;
+        uint32_t data = done + n == LUT_RECORD_BYTES ? n - 2 : n;  // Без CRC
+        for (uint32_t i = 0; i < data; i++) chunk[i] = record_byte(done + i);
+        crc = stream_crc16(crc, chunk, data);
+        if (data < n) {
+            chunk[data] = crc & 0xFF;
+            chunk[data + 1] = crc >> 8;
+        }
+        if (!port->program(port->ctx, done, chunk, n)) return false;
+        if (memcmp(port->base + done, chunk, n)) return false;
+    }
+    return true;
+}
+
+void calibration_init(const FlashPort *flash) {
+    port = flash;
+    if (!lut_load()) lut_identity_fill();
+    save_requested = false;
+    state = CALIB_IDLE;
+    result = CALIB_RESULT_NONE;
+    density_requested = false;
+    calib_gain_q16 = GAIN_NOMINAL_Q16;
+    calib_offset_mv = 0;
+    view_valid = false;
+}
+
+void __not_in_flash_func(calibration_apply)(uint16_t *samples, uint16_t count) {
+    // Во время калибровки calib_lut занята гистограммой
+    if (state != CALIB_IDLE || lut_identity) return;
+    for (uint16_t i = 0; i < count; i++) {
+        samples[i] = calib_lut[samples[i] & (CALIB_CODES - 1)];
+    }
+}
+
+void calibration_start_density(void) {
+    density_requested = true;
+}
+
+CalibState calibration_get_state(void) {
+    return state;
+}
+
+CalibResult calibration_get_result(void) {
+    return result;
+}
+
+void calibration_reset_lut(void) {
+    lut_identity_fill();
+    save_requested = true;
+}
+
+void calibration_flash_task(void) {
+    // Пока идёт калибровка, calib_lut занята гистограммой. Запуск тоже
+    // с ядра дисплея: во время записи он не начнётся
+    if (!save_requested || density_requested || state != CALIB_IDLE) return;
+    save_requested = false;
+    // Не записалось (ядро захвата не ответило) - попытка в следующий раз
+    if (!lut_save()) save_requested = true;
+}
+
+// Гистограмма -> исправленные коды, на месте. Исправленный код равен
+// середине доли попаданий кода в общем числе, приведённой к 0..4095.
+// Крайние коды собирают всё, что за пределами диапазона, и не учитываются.
+// Шаг таблицы больше CALIB_LUT_STEP_MAX - вход был неравномерным
+static bool density_build_lut(void) {
+    uint32_t total = 0;
+    uint16_t missing = 0;
+    for (int code = 1; code < CALIB_CODES - 1; code++) {
+        total += calib_lut[code];
+        if (calib_lut[code] == 0) missing++;
+    }
+    // Вход не прошёл по всему диапазону
+    if (total == 0 || missing > CALIB_CODES / 16) return false;
+
+    uint32_t cum = 0;
+    calib_lut[0] = 0;
+    for (int code = 1; code < CALIB_CODES - 1; code++) {
+        uint32_t hits = calib_lut[code];
+        uint64_t center = (uint64_t)(2 * cum + hits) * (CALIB_CODES - 1);
+        uint32_t corrected = (uint32_t)((center + total) / (2 * (uint64_t)total));
+        calib_lut[code] = corrected > CALIB_CODES - 1 ? CALIB_CODES - 1 : corrected;
+        if (calib_lut[code] - calib_lut[code - 1] > CALIB_LUT_STEP_MAX) return false;
+        cum += hits;
+    }
+    calib_lut[CALIB_CODES - 1] = CALIB_CODES - 1;
+    return calib_lut[CALIB_CODES - 1] - calib_lut[CALIB_CODES - 2] <= CALIB_LUT_STEP_MAX;
+}
+
+void calibration_task(const uint16_t *raw_samples, uint16_t count) {
+    if (density_requested) {
+        density_requested = false;
+        // Сначала отключаем коррекцию в прерывании, потом занимаем таблицу
+        state = CALIB_DENSITY;
+        memset(calib_lut, 0, sizeof(calib_lut));
+        density_samples = 0;
+        return; // Текущий буфер мог быть уже исправлен
+    }
+    if (state != CALIB_DENSITY) return;
+
+    bool saturated = false;
+    for (uint16_t i = 0; i < count; i++) {
+        uint16_t *bin = &calib_lut[raw_samples[i] & (CALIB_CODES - 1)];
+        if (*bin == 0xFFFF) saturated = true;
+        else (*bin)++;
+    }
+    density_samples += count;
+
+    if (saturated || density_samples >= (uint32_t)CALIB_DENSITY_HITS * CALIB_CODES) {
+        bool ok = density_build_lut();
+        if (ok) {
+            lut_identity = false;
+        } else {
+            lut_identity_fill();
+        }
+        result = ok ? CALIB_RESULT_OK : CALIB_RESULT_FAILED;
+        view_valid = false;
+        state = CALIB_IDLE;
+        // После неудачной до перезапуска - тождественная таблица, во flash
+        // остаётся прежняя
+        if (ok) save_requested = true;
+    }
+}
+
+void calibration_set_zero(uint16_t code) {
+    calib_offset_mv = -(int32_t)(((uint64_t)code * calib_gain_q16 + 0x8000) >> 16);
+    view_valid = false;
+}
+
+bool calibration_set_gain(uint16_t code, int32_t known_mv) {
+    // Усиление считаем относительно уже измеренного нуля
+    if (code == 0) return false;
+    int64_t span = (int64_t)known_mv - calib_offset_mv;
+    if (span <= 0) return false;
+    int64_t gain = (span << 16) / code;
+    if (gain > CALIB_GAIN_MAX_Q16) return false;
+    calib_gain_q16 = (uint32_t)gain;
+    view_valid = false;
+    return true;
+}
+
+void calibration_get_gain_offset(uint32_t *gain, int32_t *offset) {
+    *gain = calib_gain_q16;
+    *offset = calib_offset_mv;
+}
+
+void calibration_set_gain_offset(uint32_t gain, int32_t offset) {
+    calib_gain_q16 = gain && gain <= CALIB_GAIN_MAX_Q16 ? gain : GAIN_NOMINAL_Q16;
+    calib_offset_mv = offset;
+    view_valid = false;
+}
+
+bool calibration_update_view(float voltage_scale, float voltage_offset) {
+    if (view_valid && voltage_scale == view_scale && voltage_offset == view_offset) {
+        return false;
+    }
+
+    view_scale = voltage_scale;
+    view_offset = voltage_offset;
+
+    // voltage_scale = 1 - весь диапазон АЦП по высоте осциллограммы,
+    // больше - растяжение. voltage_offset в вольтах сдвигает картинку вниз
+    if (voltage_scale < 0.01f) voltage_scale = 0.01f;
+    int32_t window_mv = (int32_t)(CALIB_FULL_SCALE_MV / voltage_scale);
+    int32_t base_mv = (int32_t)(voltage_offset * 1000.0f);
+    if (window_mv < 1) window_mv = 1;
+
+    for (int code = 0; code < CALIB_CODES; code++) {
+        int32_t mv = calibration_code_to_mv(code);
+        int32_t y = WAVEFORM_HEIGHT - 1 - (mv - base_mv) * WAVEFORM_HEIGHT / window_mv;
+        if (y < 0) y = 0;
+        if (y > WAVEFORM_HEIGHT - 1) y = WAVEFORM_HEIGHT - 1;
+        calib_code_to_px[code] = (uint8_t)y;
+    }
+
+    view_valid = true;
+    return true;
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "usb_stream/stream_frame.h"
+
+// Файл захвата: заголовок с условиями записи и блоки отсчётов.
+//
+// Заголовок (little-endian, CAPTURE_HEADER_BYTES):
+//
+//   0  magic          "OSCC"
+//   4  version        CAPTURE_VERSION
+//   6  header_bytes   размер заголовка (новые версии только дописывают поля)
+//   8  sample_rate    Гц
+//  12  bits           разрядность отсчёта (12)
+//  13  channels       число каналов (1)
+//  14  block_samples  номинальная длина блока
+//  16  trigger_level  код АЦП после калибровки
+//  18  trigger_mode   TriggerMode
+//  19  trigger_edge   TriggerEdge
+//  20  trigger_pos    отсчётов до фронта в показанном кадре
+//  22  flags          резерв, 0
+//  24  gain_q16       калибровка: мВ на код, Q16
+//  28  offset_mv      калибровка: смещение, мВ
+//  32  start_time_us  начало записи, мкс от 1970 (0 - неизвестно)
+//  40  device_time_us время прибора в момент заголовка
+//  44  reserved       0
+//  46  crc16          CRC-16/CCITT-FALSE по байтам 0..45
+//
+// Блоки - кадры потока stream_frame.h (RAW16, PACK12 или DELTA), по одному
+// на захват, со своим sequence и временем. Поэтому запись с USB кладётся в
+// файл как есть, а при чтении работает тот же разбор с проверкой CRC.
+// Модуль не зависит от SDK.
+
+#define CAPTURE_MAGIC         "OSCC"
+#define CAPTURE_VERSION       1
+#define CAPTURE_HEADER_BYTES  48
+
+typedef struct {
+    uint16_t version;
+    uint32_t sample_rate;
+    uint8_t bits;
+    uint8_t channels;
+    uint16_t block_samples;
+    uint16_t trigger_level;
+    uint8_t trigger_mode;
+    uint8_t trigger_edge;
+    uint16_t trigger_position;
+    uint32_t gain_q16;
+    int32_t offset_mv;
+    uint64_t start_time_us;
+    uint32_t device_time_us;
+} CaptureHeader;
+
+void capture_header_encode(const CaptureHeader *header, uint8_t out[CAPTURE_HEADER_BYTES]);
+
+// Проверка magic, версии и CRC. data - не меньше CAPTURE_HEADER_BYTES байт
+bool capture_header_decode(const uint8_t *data, CaptureHeader *header);
+
+/* Запись */
+
+typedef struct {
+    size_t (*write)(void *ctx, const uint8_t *data, size_t len);
+    void *ctx;
+} CaptureSink;
+
+// Кадр блока собирается в самом писателе: в прошивке писателя нет (файлы
+// пишет хост), и под кадр не держится статический буфер
+typedef struct {
+    CaptureSink sink;
+    StreamEncoding encoding;
+    uint32_t blocks;
+    uint64_t bytes;
+    bool error;            // Запись в sink не прошла, дальше ничего не пишется
+    uint8_t frame[STREAM_FRAME_MAX_BYTES(STREAM_MAX_SAMPLES)];
+} CaptureWriter;
+
+bool capture_writer_begin(CaptureWriter *w, const CaptureSink *sink,
+                          const CaptureHeader *header, StreamEncoding encoding);
+bool capture_writer_block(CaptureWriter *w, const uint16_t *samples, uint16_t count,
+                          uint32_t sequence, uint32_t timestamp_us);
+
+/* Чтение: байты подаются кусками любого размера, как в stream_parser_feed */
+
+typedef struct {
+    uint8_t header_buf[CAPTURE_HEADER_BYTES];
+    uint32_t header_have;   // Принято байт заголовка, включая пропущенные поля новых версий
+    uint16_t header_bytes;
+    bool header_ok;
+    bool error;             // Не файл захвата или неизвестная версия
+    CaptureHeader header;
+    StreamParser parser;
+} CaptureReader;
+
+void capture_reader_init(CaptureReader *r);
+
+// false - заголовок не распознан, дальше файл не читается
+bool capture_reader_feed(CaptureReader *r, const uint8_t *data, size_t len,
+                         StreamFrameCallback cb, void *ctx);
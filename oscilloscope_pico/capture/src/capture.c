@@ -0,0 +1,143 @@
+#include "capture/capture.h"
+#include <string.h>
+
+static inline void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void put_u32(uint8_t *p, uint32_t v) {
+    put_u16(p, (uint16_t)v);
+    put_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+static inline uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t get_u32(const uint8_t *p) {
+    return get_u16(p) | ((uint32_t)get_u16(p + 2) << 16);
+}
+
+void capture_header_encode(const CaptureHeader *h, uint8_t out[CAPTURE_HEADER_BYTES]) {
+    memset(out, 0, CAPTURE_HEADER_BYTES);
+    memcpy(out, CAPTURE_MAGIC, 4);
+    put_u16(&out[4], CAPTURE_VERSION);
+    put_u16(&out[6], CAPTURE_HEADER_BYTES);
+    put_u32(&out[8], h->sample_rate);
+    out[12] = h->bits;
+    out[13] = h->channels;
+    put_u16(&out[14], h->block_samples);
+    put_u16(&out[16], h->trigger_level);
+    out[18] = h->trigger_mode;
+    out[19] = h->trigger_edge;
+    put_u16(&out[20], h->trigger_position);
+    put_u32(&out[24], h->gain_q16);
+    put_u32(&out[28], (uint32_t)h->offset_mv);
+    put_u32(&out[32], (uint32_t)h->start_time_us);
+    put_u32(&out[36], (uint32_t)(h->start_time_us >> 32));
+    put_u32(&out[40], h->device_time_us);
+    put_u16(&out[46], stream_crc16(0xFFFF, out, CAPTURE_HEADER_BYTES - 2));
+}
+
+bool capture_header_decode(const uint8_t *data, CaptureHeader *h) {
+    if (memcmp(data, CAPTURE_MAGIC, 4) != 0) return false;
+    if (stream_crc16(0xFFFF, data, CAPTURE_HEADER_BYTES - 2) != get_u16(&data[46])) return false;
+
+    // Поля версии 1 есть в любой более новой версии
+    h->version = get_u16(&data[4]);
+    if (h->version < 1 || get_u16(&data[6]) < CAPTURE_HEADER_BYTES) return false;
+
+    h->sample_rate = get_u32(&data[8]);
+    h->bits = data[12];
+    h->channels = data[13];
+    h->block_samples = get_u16(&data[14]);
+    h->trigger_level = get_u16(&data[16]);
+    h->trigger_mode = data[18];
+    h->trigger_edge = data[19];
+    h->trigger_position = get_u16(&data[20]);
+    h->gain_q16 = get_u32(&data[24]);
+    h->offset_mv = (int32_t)get_u32(&data[28]);
+    h->start_time_us = get_u32(&data[32]) | ((uint64_t)get_u32(&data[36]) << 32);
+    h->device_time_us = get_u32(&data[40]);
+    return h->sample_rate != 0 && h->channels == 1;
+}
+
+/* Запись */
+
+static bool sink_write(CaptureWriter *w, const uint8_t *data, size_t len) {
+    if (w->error) return false;
+    if (w->sink.write(w->sink.ctx, data, len) != len) {
+        w->error = true;
+        return false;
+    }
+    w->bytes += len;
+    return true;
+}
+
+bool capture_writer_begin(CaptureWriter *w, const CaptureSink *sink,
+                          const CaptureHeader *header, StreamEncoding encoding) {
+    w->sink = *sink;
+    w->encoding = encoding;
+    w->blocks = 0;
+    w->bytes = 0;
+    w->error = false;
+
+    uint8_t buf[CAPTURE_HEADER_BYTES];
+    capture_header_encode(header, buf);
+    return sink_write(w, buf, sizeof(buf));
+}
+
+bool capture_writer_block(CaptureWriter *w, const uint16_t *samples, uint16_t count,
+                          uint32_t sequence, uint32_t timestamp_us) {
+    size_t len = stream_frame_encode(w->frame, sizeof(w->frame), w->encoding,
+                                     sequence, timestamp_us, samples, count);
+    if (!len || !sink_write(w, w->frame, len)) return false;
+    w->blocks++;
+    return true;
+}
+
+/* Чтение */
+
+void capture_reader_init(CaptureReader *r) {
+    r->header_have = 0;
+    r->header_bytes = CAPTURE_HEADER_BYTES;
+    r->header_ok = false;
+    r->error = false;
+    stream_parser_init(&r->parser);
+}
+
+bool capture_reader_feed(CaptureReader *r, const uint8_t *data, size_t len,
+                         StreamFrameCallback cb, void *ctx) {
+    if (r->error) return false;
+
+    // Заголовок: первые CAPTURE_HEADER_BYTES разбираются, поля новых
+    // версий сверх них пропускаются
+    while (len && r->header_have < r->header_bytes) {
+        if (r->header_have < CAPTURE_HEADER_BYTES) {
+            size_t n = CAPTURE_HEADER_BYTES - r->header_have;
+            if (n > len) n = len;
+            memcpy(&r->header_buf[r->header_have], data, n);
+            r->header_have += n;
+            data += n;
+            len -= n;
+            if (r->header_have == CAPTURE_HEADER_BYTES) {
+                if (!capture_header_decode(r->header_buf, &r->header)) {
+                    r->error = true;
+                    return false;
+                }
+                r->header_bytes = get_u16(&r->header_buf[6]);
+                r->header_ok = true;
+            }
+        } else {
+            size_t n = r->header_bytes - r->header_have;
+            if (n > len) n = len;
+            r->header_have += n;
+            data += n;
+            len -= n;
+        }
+    }
+
+    if (len) stream_parser_feed(&r->parser, data, len, cb, ctx);
+    return true;
+}
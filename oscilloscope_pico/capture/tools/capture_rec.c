@@ -0,0 +1,252 @@
+// Запись захватов с прибора в файл (capture/capture.h).
+//
+//   capture_rec [-n блоков] [-e raw|pack12|delta] /dev/ttyACM0 out.osc
+//   capture_rec -i file.osc       - заголовок и сводка по блокам
+//
+// Заголовок запрашивается командой CAPture:HEADer?, затем включается поток
+// (STReam ON), и каждый принятый блок дописывается в файл до -n блоков или
+// Ctrl-C. Потерянные в USB блоки видны в файле по пропускам sequence.
+// Файл воспроизводится через прошивку на ПК: osc_sim --replay out.osc
+#define _DEFAULT_SOURCE
+#include "capture/capture.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <sys/time.h>
+
+#define REPLY_TIMEOUT_MS 2000
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void on_sigint(int sig) {
+    (void)sig;
+    stop_requested = 1;
+}
+
+static void set_raw_tty(int fd) {
+    struct termios t;
+    if (tcgetattr(fd, &t) != 0) return; // Не терминал (pipe в проверках)
+    cfmakeraw(&t);
+    tcsetattr(fd, TCSANOW, &t);
+}
+
+static bool send_command(int fd, const char *cmd) {
+    size_t len = strlen(cmd);
+    return write(fd, cmd, len) == (ssize_t)len;
+}
+
+// Чтение одного байта с ожиданием. false - таймаут или обрыв
+static bool read_byte(int fd, uint8_t *b) {
+    struct pollfd p = { .fd = fd, .events = POLLIN };
+    if (poll(&p, 1, REPLY_TIMEOUT_MS) <= 0) return false;
+    return read(fd, b, 1) == 1;
+}
+
+// Ответ-блок IEEE 488.2 "#<n><len><data>\n". Байты до '#' (хвост
+// выключенного потока) пропускаются
+static bool read_block(int fd, uint8_t *out, size_t capacity, size_t *len) {
+    uint8_t b;
+    do {
+        if (!read_byte(fd, &b)) return false;
+    } while (b != '#');
+
+    if (!read_byte(fd, &b) || b < '1' || b > '9') return false;
+    int digits = b - '0';
+    size_t n = 0;
+    for (int i = 0; i < digits; i++) {
+        if (!read_byte(fd, &b) || b < '0' || b > '9') return false;
+        n = n * 10 + (b - '0');
+    }
+    if (n > capacity) return false;
+    for (size_t i = 0; i < n; i++) {
+        if (!read_byte(fd, &out[i])) return false;
+    }
+    read_byte(fd, &b); // '\n'
+    *len = n;
+    return true;
+}
+
+static void print_header(const CaptureHeader *h) {
+    fprintf(stderr, "version %u, %lu Hz, %u bit, %u ch, block %u\n",
+            h->version, (unsigned long)h->sample_rate, h->bits, h->channels, h->block_samples);
+    fprintf(stderr, "trigger level %u mode %u edge %u pretrigger %u\n",
+            h->trigger_level, h->trigger_mode, h->trigger_edge, h->trigger_position);
+    fprintf(stderr, "calibration gain_q16 %lu offset %ld mV\n",
+            (unsigned long)h->gain_q16, (long)h->offset_mv);
+    fprintf(stderr, "start %llu us (unix), device time %lu us\n",
+            (unsigned long long)h->start_time_us, (unsigned long)h->device_time_us);
+}
+
+/* Запись */
+
+typedef struct {
+    CaptureWriter writer;
+    uint32_t limit;
+} RecordContext;
+
+static size_t file_write(void *ctx, const uint8_t *data, size_t len) {
+    return fwrite(data, 1, len, (FILE *)ctx);
+}
+
+static void on_frame(void *ctx, const StreamHeader *h, const uint16_t *samples) {
+    RecordContext *rc = ctx;
+    if (rc->limit && rc->writer.blocks >= rc->limit) return;
+    capture_writer_block(&rc->writer, samples, h->count, h->sequence, h->timestamp_us);
+    if (rc->limit && rc->writer.blocks >= rc->limit) stop_requested = 1;
+}
+
+static int record(const char *device, const char *path, uint32_t limit, StreamEncoding encoding) {
+    int fd = open(device, O_RDWR | O_NOCTTY);
+    if (fd < 0) {
+        perror(device);
+        return 2;
+    }
+    set_raw_tty(fd);
+
+    // Поток мог остаться включённым с прошлого раза: ответ найдётся по '#'
+    send_command(fd, "STR OFF;:CAP:HEAD?\n");
+    uint8_t raw[CAPTURE_HEADER_BYTES];
+    size_t len = 0;
+    CaptureHeader header;
+    if (!read_block(fd, raw, sizeof(raw), &len) || len != CAPTURE_HEADER_BYTES ||
+        !capture_header_decode(raw, &header)) {
+        fprintf(stderr, "%s: no capture header in reply\n", device);
+        close(fd);
+        return 1;
+    }
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    header.start_time_us = (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+    print_header(&header);
+
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        perror(path);
+        close(fd);
+        return 2;
+    }
+    RecordContext rc = { .limit = limit };
+    CaptureSink sink = { .write = file_write, .ctx = f };
+    capture_writer_begin(&rc.writer, &sink, &header, encoding);
+
+    signal(SIGINT, on_sigint);
+    send_command(fd, "STR ON\n");
+
+    static StreamParser parser;
+    stream_parser_init(&parser);
+    uint8_t buf[4096];
+    while (!stop_requested && !rc.writer.error) {
+        struct pollfd p = { .fd = fd, .events = POLLIN };
+        int ready = poll(&p, 1, REPLY_TIMEOUT_MS);
+        if (ready < 0) continue;             // EINTR от Ctrl-C
+        if (ready == 0) {
+            fprintf(stderr, "no data from %s\n", device);
+            break;
+        }
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n <= 0) break;
+        stream_parser_feed(&parser, buf, (size_t)n, on_frame, &rc);
+    }
+
+    send_command(fd, "STR OFF\n");
+    close(fd);
+    bool ok = !rc.writer.error && fclose(f) == 0;
+
+    fprintf(stderr, "blocks %lu, lost %lu in %lu gaps, crc errors %lu, %llu bytes%s\n",
+            (unsigned long)rc.writer.blocks, (unsigned long)parser.lost, (unsigned long)parser.gaps,
+            (unsigned long)parser.crc_errors, (unsigned long long)rc.writer.bytes,
+            ok ? "" : " (write error)");
+    return ok ? 0 : 1;
+}
+
+/* Сводка по файлу */
+
+typedef struct {
+    uint32_t blocks;
+    uint64_t samples;
+    uint32_t by_encoding[STREAM_ENC_COUNT];
+    uint32_t first_seq, last_seq;
+} InfoContext;
+
+static void on_info_frame(void *ctx, const StreamHeader *h, const uint16_t *samples) {
+    (void)samples;
+    InfoContext *ic = ctx;
+    if (!ic->blocks) ic->first_seq = h->sequence;
+    ic->last_seq = h->sequence;
+    ic->blocks++;
+    ic->samples += h->count;
+    if (h->encoding < STREAM_ENC_COUNT) ic->by_encoding[h->encoding]++;
+}
+
+static int info(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return 2;
+    }
+    static CaptureReader reader;
+    capture_reader_init(&reader);
+    InfoContext ic = { 0 };
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        if (!capture_reader_feed(&reader, buf, n, on_info_frame, &ic)) break;
+    }
+    fclose(f);
+
+    if (!reader.header_ok) {
+        fprintf(stderr, "%s: not a capture file\n", path);
+        return 1;
+    }
+    print_header(&reader.header);
+    fprintf(stderr, "blocks %lu (seq %lu..%lu), samples %llu, raw/pack12/delta %lu/%lu/%lu\n",
+            (unsigned long)ic.blocks, (unsigned long)ic.first_seq, (unsigned long)ic.last_seq,
+            (unsigned long long)ic.samples, (unsigned long)ic.by_encoding[STREAM_ENC_RAW16],
+            (unsigned long)ic.by_encoding[STREAM_ENC_PACK12], (unsigned long)ic.by_encoding[STREAM_ENC_DELTA]);
+    fprintf(stderr, "lost %lu in %lu gaps, crc errors %lu\n", (unsigned long)reader.parser.lost,
+            (unsigned long)reader.parser.gaps, (unsigned long)reader.parser.crc_errors);
+    return 0;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s [-n blocks] [-e raw|pack12|delta] DEVICE OUT.osc\n"
+                    "       %s -i FILE.osc\n", prog, prog);
+}
+
+int main(int argc, char **argv) {
+    uint32_t limit = 0;
+    StreamEncoding encoding = STREAM_ENC_DELTA;
+    const char *args[2];
+    int nargs = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-i") && i + 1 < argc) return info(argv[i + 1]);
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            limit = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "-e") && i + 1 < argc) {
+            const char *e = argv[++i];
+            if (!strcmp(e, "raw")) encoding = STREAM_ENC_RAW16;
+            else if (!strcmp(e, "pack12")) encoding = STREAM_ENC_PACK12;
+            else if (!strcmp(e, "delta")) encoding = STREAM_ENC_DELTA;
+            else {
+                usage(argv[0]);
+                return 2;
+            }
+        } else if (nargs < 2) {
+            args[nargs++] = argv[i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (nargs != 2) {
+        usage(argv[0]);
+        return 2;
+    }
+    return record(args[0], args[1], limit, encoding);
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+// Измерения на участке трассы между курсорами времени.
+//
+// Один проход по новой трассе строит индекс: префиксные суммы отсчётов,
+// отсчётов выше уровня и пересечений уровня, положения пересечений и
+// минимум/максимум блоков по CURSORS_BLOCK отсчётов. Измерение любого
+// участка - разности префиксов и проход по блокам (плюс два неполных по
+// краям): курсор можно двигать каждый кадр, трасса заново не читается.
+//
+// Измерения те же, что у buffer_update_stats: уровень частоты и
+// скважности - уровень триггера, пересечение - смена стороны от уровня
+// между соседними отсчётами. Период считается от первого до последнего
+// пересечения участка.
+
+#define CURSORS_MAX_SAMPLES 320   // Кадр целиком (BUFFER_SIZE)
+#define CURSORS_BLOCK_SHIFT 4
+#define CURSORS_BLOCK       (1 << CURSORS_BLOCK_SHIFT)
+#define CURSORS_BLOCKS      ((CURSORS_MAX_SAMPLES + CURSORS_BLOCK - 1) / CURSORS_BLOCK)
+
+typedef struct {
+    const uint16_t *samples;    // Трасса не должна меняться, пока индекс нужен
+    uint16_t count;
+    uint16_t level;
+    uint32_t sum[CURSORS_MAX_SAMPLES + 1];        // Сумма отсчётов [0, i)
+    uint16_t high[CURSORS_MAX_SAMPLES + 1];       // Отсчётов выше уровня в [0, i)
+    uint16_t crossings[CURSORS_MAX_SAMPLES + 1];  // Пересечений перед отсчётами [1, i)
+    uint16_t cross_at[CURSORS_MAX_SAMPLES];       // Отсчёт после k-го пересечения
+    uint16_t block_min[CURSORS_BLOCKS];
+    uint16_t block_max[CURSORS_BLOCKS];
+} CursorIndex;
+
+typedef struct {
+    uint16_t min;
+    uint16_t max;
+    uint16_t mean;
+    uint16_t crossings;
+    uint32_t frequency;         // Гц, 0 - меньше двух пересечений
+    uint16_t duty_permille;     // Доля отсчётов выше уровня, 0.1%
+} CursorMeasure;
+
+// Индекс трассы samples[0..count) (count не больше CURSORS_MAX_SAMPLES)
+void cursors_index(CursorIndex *idx, const uint16_t *samples, uint16_t count, uint16_t level);
+
+// Измерения на отсчётах [from, to). false - участок пуст
+bool cursors_measure(const CursorIndex *idx, uint16_t from, uint16_t to,
+                     uint32_t sample_rate, CursorMeasure *out);
@@ -0,0 +1,80 @@
+#include "cursors/cursors.h"
+
+void cursors_index(CursorIndex *idx, const uint16_t *samples, uint16_t count, uint16_t level) {
+    if (count > CURSORS_MAX_SAMPLES) count = CURSORS_MAX_SAMPLES;
+    idx->samples = samples;
+    idx->count = count;
+    idx->level = level;
+    idx->sum[0] = 0;
+    idx->high[0] = 0;
+    idx->crossings[0] = 0;
+    if (!count) return;
+    idx->crossings[1] = 0;
+
+    uint32_t sum = 0;
+    uint16_t high = 0, crossings = 0;
+    bool last = samples[0] > level;
+    for (uint16_t i = 0; i < count; i++) {
+        uint16_t s = samples[i];
+        bool state = s > level;
+        if (i > 0) {
+            if (state != last) idx->cross_at[crossings++] = i;
+            idx->crossings[i + 1] = crossings;
+        }
+        last = state;
+        sum += s;
+        if (state) high++;
+        idx->sum[i + 1] = sum;
+        idx->high[i + 1] = high;
+
+        uint16_t b = i >> CURSORS_BLOCK_SHIFT;
+        if (!(i & (CURSORS_BLOCK - 1))) {
+            idx->block_min[b] = s;
+            idx->block_max[b] = s;
+        } else {
+            if (s < idx->block_min[b]) idx->block_min[b] = s;
+            if (s > idx->block_max[b]) idx->block_max[b] = s;
+        }
+    }
+}
+
+bool cursors_measure(const CursorIndex *idx, uint16_t from, uint16_t to,
+                     uint32_t sample_rate, CursorMeasure *out) {
+    if (to > idx->count) to = idx->count;
+    if (from >= to) return false;
+    uint16_t n = to - from;
+
+    // Минимум и максимум: неполные блоки по краям - по отсчётам
+    const uint16_t *s = idx->samples;
+    uint16_t lo = 0xFFFF, hi = 0;
+    uint16_t i = from;
+    for (; i < to && (i & (CURSORS_BLOCK - 1)); i++) {
+        if (s[i] < lo) lo = s[i];
+        if (s[i] > hi) hi = s[i];
+    }
+    for (; i + CURSORS_BLOCK <= to; i += CURSORS_BLOCK) {
+        uint16_t b = i >> CURSORS_BLOCK_SHIFT;
+        if (idx->block_min[b] < lo) lo = idx->block_min[b];
+        if (idx->block_max[b] > hi) hi = idx->block_max[b];
+    }
+    for (; i < to; i++) {
+        if (s[i] < lo) lo = s[i];
+        if (s[i] > hi) hi = s[i];
+    }
+    out->min = lo;
+    out->max = hi;
+    out->mean = (idx->sum[to] - idx->sum[from] + n / 2) / n;
+    out->duty_permille = (uint16_t)(((uint32_t)(idx->high[to] - idx->high[from]) * 1000 + n / 2) / n);
+
+    // Пересечения внутри участка: между from и to - 1
+    uint16_t first = idx->crossings[from + 1];
+    uint16_t crossings = idx->crossings[to] - first;
+    out->crossings = crossings;
+    out->frequency = 0;
+    if (crossings >= 2) {
+        // Между первым и последним пересечением crossings - 1 полупериодов
+        uint32_t length = idx->cross_at[first + crossings - 1] - idx->cross_at[first];
+        out->frequency = (uint32_t)(((uint64_t)sample_rate * (crossings - 1) + length) / (2 * length));
+    }
+    return true;
+}
@@ -33,7 +33,22 @@ typedef enum {
     MENU_NONE,
     MENU_TIME_SCALE,
     MENU_VOLT_SCALE,
-    MENU_TRIGGER
+    MENU_TRIGGER,
+    MENU_PERSISTENCE,
+    MENU_CALIBRATION,
+    MENU_CAL_GAIN,
+    MENU_STREAM,
+    MENU_REFERENCE,
+    MENU_MATH,
+    MENU_RECORD,
+    MENU_XY,
+    MENU_AUTOSET,
+    MENU_MASK,
+    MENU_CURSORS,
+    MENU_CURSOR_T1,     // Пункты курсоров - только когда курсоры включены
+    MENU_CURSOR_T2,
+    MENU_CURSOR_V1,
+    MENU_CURSOR_V2
 } MenuState;
 
 typedef struct {
@@ -48,11 +63,85 @@ void init_buttons(void);
 // Обработка ввода
 void process_buttons(void);
 
+// Копия показанного кадра (буфер на BUFFER_SIZE отсчётов), измерения и масштаб
 void get_values_for_draw(uint16_t *, float*, float *);
 
 // Функции отрисовки
 void draw_grid(void);
 void draw_measurements(float *);
-void draw_waveform(uint16_t*);
+void draw_waveform(const uint16_t*, uint16_t);
 
+// Управление (кнопки и удалённые команды)
+void set_hold(bool enable);
+void set_stream(bool enable, uint8_t encoding); // StreamEncoding
 
+// Эталоны (reference/reference.h): слот под сигналом и для сравнения
+// (-1 - выключено), запись показанного кадра в слот, допуск сравнения
+#define REFERENCE_TOLERANCE_MV 100
+void set_reference(int8_t slot);
+int8_t get_reference(void);
+bool save_reference(uint8_t slot);
+void set_reference_tolerance(uint16_t mv);
+uint16_t get_reference_tolerance(void);
+// Сравнение последнего выведенного кадра. false - эталон не показан
+bool get_reference_result(bool *pass, uint16_t *max_mv, uint16_t *mean_mv, uint16_t *over);
+
+// Математический канал (math_channel/math_channel.h): трасса вместо захвата
+void set_math(uint8_t op);              // MathOp
+uint8_t get_math(void);
+void set_math_scale(int32_t scale_q16); // Множитель результата, Q16
+int32_t get_math_scale(void);
+// Напряжение нуля показанной трассы: 0 для захвата, у математики - подъём
+int32_t get_trace_zero_mv(void);
+
+// Делений развёртки на ширину экрана: окно кадра и длинной записи
+#define TIMEBASE_DIVS 10
+
+// Длинная запись (long_record/long_record.h) вместо кадра: окно по
+// развёртке, сдвиг - отсчётов от самого нового до правого края окна.
+// В удержании сдвиг меняют PLUS/MINUS
+void set_record_view(bool enable);
+bool get_record_view(void);
+void set_record_position(uint32_t offset);
+uint32_t get_record_position(void);
+
+// Курсоры: два времени (столбцы экрана) и два напряжения (коды АЦП).
+// Пока они включены, измерения под осциллограммой - только по отсчётам
+// между курсорами времени (cursors/cursors.h)
+#define CURSOR_COUNT 2
+void set_cursors(bool enable);
+void set_time_cursor(uint8_t n, int16_t x);
+int16_t get_time_cursor(uint8_t n);
+void set_volt_cursor(uint8_t n, uint16_t code);
+uint16_t get_volt_cursor(uint8_t n);
+
+// Автоустановка (autoset/autoset.h): оценка сигнала по следующим блокам
+// захвата, затем вольт/деление и положение по вертикали, развёртка на два
+// периода (длиннее кадра - длинная запись) и триггер по середине размаха
+// с гистерезисом. Без периода развёртка не меняется, триггер - AUTO
+void start_autoset(void);
+// Состояние (AutosetState), период найденного сигнала (отсчётов, Q8) и
+// отсчётов до результата. Указатели могут быть NULL
+uint8_t get_autoset(uint32_t *period_q8, uint32_t *samples);
+
+// Испытание по маске (mask/mask.h): маска из кадра на экране (slot = -1)
+// или из эталона, фронт в котором считается на TRIGGER_PRETRIGGER.
+// Допуск, мВ, - для следующей маски. Без маски set_mask(true) строит её
+// из кадра. Нарушение с остановкой удерживает негодный захват на экране,
+// выход из удержания и reset_mask продолжают испытания
+bool create_mask(int8_t slot);
+bool set_mask(bool enable);
+void reset_mask(void);
+void set_mask_tolerance(uint16_t mv);
+uint16_t get_mask_tolerance(void);
+
+// Двухточечная калибровка (calibration/calibration.h) по среднему кода
+// последнего кадра: ноль - вход на земле, усиление - на входе known_mv.
+// false - кадра нет или калибровка не принята
+bool calibrate_zero(void);
+bool calibrate_gain(int32_t known_mv);
+
+// Снимок экрана (screenshot/screenshot.h): то, что сейчас на панели, уходит
+// по USB CDC. До конца передачи кадры не рисуются. Возвращает размер
+// снимка или 0, если предыдущий ещё передаётся
+uint32_t display_screenshot_begin(void);
@@ -0,0 +1,40 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+// Планировщик кадров ядра дисплея: кадр рисуется только когда пришли новые
+// данные или изменился интерфейс, не чаще чем успевает панель и SPI.
+// Между кадрами ядро спит в WFE, а не крутится в busy_wait.
+
+// Частота обновления панели (команда 0xB1 в ILI9341_Init: ~70 Гц)
+#define PANEL_REFRESH_HZ   70
+#define PANEL_PERIOD_US    (1000000 / PANEL_REFRESH_HZ)
+
+// Максимальный сон без событий: USB и SCPI опрашиваются из цикла, кнопки
+// будят ядро сами (SEV из input.c)
+#define FRAME_POLL_US      20000
+
+// te_pin - вывод TE дисплея или -1, если он не подключён
+void frame_scheduler_init(int te_pin);
+
+// Сон до ближайшего события: новые данные (SEV от ядра захвата),
+// фронт TE, срок кадра или таймаут опроса интерфейса
+void frame_scheduler_sleep(void);
+
+// Пометить, что на экране устарело содержимое (новая осциллограмма, кнопка)
+void frame_scheduler_request_redraw(void);
+
+// Пора рисовать: есть что показать и прошёл минимальный интервал
+bool frame_scheduler_frame_due(void);
+
+// Ожидание начала кадровой развёртки панели по TE (если вывод подключён),
+// чтобы передача начиналась в обратном ходе и не рвала картинку
+void frame_scheduler_wait_vsync(void);
+
+// Кадр отрисован за render_us (от начала подготовки до конца вывода):
+// подстройка интервала под реальную стоимость, ожидание TE из
+// frame_scheduler_wait_vsync в неё не входит
+void frame_scheduler_frame_done(uint32_t render_us);
+
+// Текущий интервал между кадрами (мкс)
+uint32_t frame_scheduler_get_interval_us(void);
@@ -1,9 +1,30 @@
 #include "display_driver/display_driver.h"
+#include "display_driver/frame_scheduler.h"
 #include "pico_ili9341/pico_ili9341.h"
 #include "global_buffer/global_buffer.h"
+#include "persistence/persistence.h"
+#include "history/history.h"
+#include "calibration/calibration.h"
+#include "usb_stream/usb_stream.h"
+#include "settings/settings.h"
+#include "scpi/scpi_remote.h"
+#include "reference/reference.h"
+#include "math_channel/math_channel.h"
+#include "input/input.h"
+#include "long_record/long_record.h"
+#include "resample/resample.h"
+#include "cursors/cursors.h"
+#include "xy/xy.h"
+#include "screenshot/screenshot.h"
+#include "autoset/autoset.h"
+#include "mask/mask.h"
+#include "settings/settings_store.h"
+#include "perf/perf.h"
 #include "pico_ili9341/font_5x7.h"
 #include "pico_ili9341/font_8x8.h"
 #include "pico_ili9341/font_12x16.h"
+#include "pico_ili9341/framebuffer.h"
+#include "pico_ili9341/text.h"
 #include "hardware/gpio.h"
 #include "hardware/spi.h"
 #include "hardware/adc.h"
@@ -11,7 +32,6 @@
 #include "pico/time.h"
 #include <stdio.h> 
 #include <string.h>
-#include <pico/multicore.h>
 
 #define SPI_PORT spi0
 #define PIN_MISO 12
@@ -21,23 +41,151 @@
 #define PIN_DC   15
 #define PIN_RST  14
 #define PIN_LED  20
+#define PIN_TE   -1 // Вывод TE дисплея (-1 - не подключён)
+
+// Очередь потока выталкивается и во время вывода кадра: каждые 4 строки
+// (~330 мкс при 62.5 МГц) буфер CDC TinyUSB успевает опустеть
+#define STREAM_SERVICE_ROWS 4
 
 /* Глобальные переменные модуля */
 static ILI9341 tft;
 static MenuState menu_state = MENU_NONE;
-static bool show_measurements = true;
 absolute_time_t last_redraw;
-static uint16_t prev_waveform[DISPLAY_WIDTH]; // Хранит предыдущие Y-координаты
 
 // 8-битные буферы только для области осциллографа (WAVEFORM_HEIGHT = 210, WAVEFORM_WIDTH = 320)
 color8_t waveform_buf1[WAVEFORM_WIDTH * WAVEFORM_HEIGHT];
 color8_t waveform_buf2[WAVEFORM_WIDTH * WAVEFORM_HEIGHT];
 color8_t* active_wave_buf = waveform_buf1;
 color8_t* draw_wave_buf = waveform_buf2;
+static Framebuffer8 wave_fb; // Поверхность рисования поверх draw_wave_buf
+
+// Статический слой (сетка, маркер триггера) накладывается при выводе кадра
+static Overlay wave_overlay;
+static uint16_t overlay_trigger_level = 0xFFFF;
+
+// Строки измерений под осциллограммой: выводятся только изменившиеся символы
+enum {
+    MEAS_VMAX,
+    MEAS_VMIN,
+    MEAS_VPP,
+    MEAS_FREQ,
+    MEAS_DUTY,
+    MEAS_HISTORY,
+    MEAS_COUNT
+};
+static TextLine meas_lines[MEAS_COUNT];
+
+// Отсчёты между курсорами под осциллограммой: dt, 1/dt, dV
+static TextLine cursor_line;
+
+#if PERF_ENABLED
+// Строка замеров между осциллограммой и измерениями
+static TextLine perf_line;
+static uint32_t latency_sequence = 0;
+#endif
+
+// Просмотр истории в режиме удержания: -1 - текущий кадр, 0 - самый новый
+// из истории и т.д. Кадр из истории выводится обычным draw_waveform
+static int16_t replay_age = -1;
+static bool replay_dirty = false;
+static uint16_t replay_samples[BUFFER_SIZE];
+static uint32_t recorded_sequence = 0;
+
+// Эталон под сигналом: слот, допуск и сравнение последнего кадра
+static int8_t ref_slot = -1;
+static uint16_t ref_tolerance_mv = REFERENCE_TOLERANCE_MV;
+static ReferenceCompare ref_result;
+static bool ref_result_valid = false;
+
+// Математический канал: A - захват, B - показанный эталон
+static MathChannel math;
+
+// Длинная запись вместо кадра: окно по развёртке (TIMEBASE_DIVS делений
+// на экран), правый край на record_offset отсчётов раньше самого нового.
+// Блоки в запись добавляет ядро захвата (capture_hook)
+static volatile bool record_view = false;
+static uint32_t record_offset = 0;
+
+// Трасса, пересчитанная в столбцы экрана (resample.h, long_record.h), и
+// отсчёты окна, которых нет в RAM подряд: эталон, кусок длинной записи
+static RecordSpan trace_columns[WAVEFORM_WIDTH];
+static uint16_t trace_samples[WAVEFORM_WIDTH + RESAMPLE_TAPS];
+
+// Окно последней выведенной трассы: по нему столбцы курсоров переводятся
+// в отсчёты. У длинной записи start - отсчётов от начала записи до окна
+typedef enum {
+    SHOWN_NONE,     // Послесвечение или трассы нет
+    SHOWN_FRAME,
+    SHOWN_RECORD
+} ShownTrace;
+static ShownTrace shown_trace = SHOWN_NONE;
+static int32_t shown_start_q16 = 0;
+static uint32_t shown_span_q16 = 0;
+
+// Курсоры и индекс показанного кадра для измерений между ними. Индекс
+// строится заново только со сменой кадра, не при движении курсора
+static int16_t cursor_x[CURSOR_COUNT] = { WAVEFORM_WIDTH / 4, WAVEFORM_WIDTH * 3 / 4 };
+static uint16_t cursor_code[CURSOR_COUNT] = { 1024, 3072 };
+static CursorIndex cursor_index;
+static uint32_t cursor_index_sequence = 0;
+static int16_t cursor_index_age = -1;
+
+// Автоустановка: оценка по каждому блоку на ядре захвата (capture_hook),
+// новые настройки - перед следующим кадром (render_frame). Запуск - запрос
+// ядру захвата: оценку меняет только оно
+static Autoset autoset;
+static volatile bool autoset_requested = false;
+static volatile bool autoset_pending = false;
+
+// Маска: допуск для следующей компиляции. Нарушение с остановкой
+// показывается удержанием негодного захвата (фронт в нём - mask_fail_trigger)
+static uint16_t mask_tolerance_mv = MASK_TOLERANCE_MV;
+static bool mask_fail_shown = false;
+static int16_t mask_fail_trigger = -1;
+
+// Снимок экрана: выведенный кадр трассы и текстовые строки
+static const TextLine *const screen_lines[] = {
+#if PERF_ENABLED
+    &perf_line,
+#endif
+    &cursor_line,
+    &meas_lines[MEAS_VMAX],
+    &meas_lines[MEAS_VMIN],
+    &meas_lines[MEAS_VPP],
+    &meas_lines[MEAS_FREQ],
+    &meas_lines[MEAS_DUTY],
+    &meas_lines[MEAS_HISTORY],
+};
+static ScreenSource screen_source;
 
 extern void ILI9341_FillRectDMA(ILI9341 *disp, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color);
 extern bool adc_get_buffer(uint16_t** buffer);
 
+// Ядро захвата: каждый его блок - в поток, в длинную запись и в оценку
+// автоустановки, пока ядро дисплея выводит кадр. В удержании запись
+// стоит - её листают
+static void capture_hook(const uint16_t* samples, const FrameMeta* meta) {
+    if (usb_stream_enabled()) {
+        usb_stream_send(samples, meta->length, meta->sequence, meta->timestamp_us);
+    }
+    if (record_view && !global_buffer.hold) {
+        long_record_append(samples, meta->length, meta->sequence);
+    }
+    if (autoset_requested) {
+        autoset_start(&autoset);
+        autoset_requested = false;
+    }
+    if (autoset.state == AUTOSET_RUNNING &&
+        autoset_feed(&autoset, samples, meta->length, meta->sequence) != AUTOSET_RUNNING) {
+        autoset_pending = true;
+    }
+}
+
+// Состояние для ядра дисплея: запрошенный запуск уже идёт
+static AutosetState autoset_state(void) {
+    return autoset_requested ? AUTOSET_RUNNING : autoset.state;
+}
+
 void display_init(void) {
 
     // Конфигурация SPI дисплея
@@ -63,6 +211,37 @@ void display_init(void) {
     // Очистка буферов
     memset(waveform_buf1, COLOR8_BLACK, sizeof(waveform_buf1));
     memset(waveform_buf2, COLOR8_BLACK, sizeof(waveform_buf2));
+    FB8_Init(&wave_fb, draw_wave_buf, WAVEFORM_WIDTH, WAVEFORM_HEIGHT);
+    Overlay_Init(&wave_overlay, WAVEFORM_WIDTH, WAVEFORM_HEIGHT, COLOR8_BLACK);
+    
+    // Текст
+    Text_Init();
+    uint16_t fg = color_palette[COLOR8_WHITE];
+    uint16_t bg = color_palette[COLOR8_BLACK];
+    TextLine_Init(&meas_lines[MEAS_VMAX], 0, 210, FONT_8X8, 18, fg, bg);
+    TextLine_Init(&meas_lines[MEAS_VMIN], 0, 220, FONT_8X8, 18, fg, bg);
+    TextLine_Init(&meas_lines[MEAS_VPP], 0, 230, FONT_8X8, 18, fg, bg);
+    TextLine_Init(&meas_lines[MEAS_FREQ], 150, 210, FONT_8X8, 21, fg, bg);
+    TextLine_Init(&meas_lines[MEAS_DUTY], 150, 220, FONT_8X8, 21, fg, bg);
+    TextLine_Init(&meas_lines[MEAS_HISTORY], 150, 230, FONT_8X8, 21, fg, bg);
+#if PERF_ENABLED
+    TextLine_Init(&perf_line, 0, WAVEFORM_HEIGHT + 1, FONT_5X7, TEXT_LINE_MAX,
+                  color_palette[COLOR8_GRAY], bg);
+#endif
+    TextLine_Init(&cursor_line, 0, WAVEFORM_HEIGHT + 10, FONT_5X7, TEXT_LINE_MAX,
+                  color_palette[COLOR8_MAGENTA], bg);
+    
+    history_init();
+    long_record_init();
+    reference_init(reference_flash_port());
+    math_channel_init(&math);
+    usb_stream_init(NULL);
+    FB8_SetFlushHook(usb_stream_service, STREAM_SERVICE_ROWS);
+    screenshot_init(NULL);
+    settings_init();
+    scpi_remote_init();
+    buffer_set_capture_hook(capture_hook);
+    calibration_update_view(global_buffer.voltage_scale, global_buffer.voltage_offset);
 }
 
 void swap_buffers() {
@@ -80,94 +259,524 @@ void swap_wave_buffers() {
     color8_t* temp = active_wave_buf;
     active_wave_buf = draw_wave_buf;
     draw_wave_buf = temp;
+    wave_fb.pixels = draw_wave_buf;
     
-    ILI9341_DrawBuffer8to16(&tft, active_wave_buf);
-
+    // Отправляем грязную область нарисованного кадра одним окном
+    Framebuffer8 active_fb = wave_fb;
+    active_fb.pixels = active_wave_buf;
+    FB8_FlushOverlay(&tft, &active_fb, 0, 0, &wave_overlay);
+    FB8_ResetDirty(&wave_fb);
 }
 
 
+// Сетка рисуется один раз в статический слой, а не в каждом кадре
 void draw_grid(void) {
     //сетка
     for (int y = 0; y < WAVEFORM_HEIGHT; y += 50) {
-        for (int x = 10; x < WAVEFORM_WIDTH; x += 5) {
-            draw_wave_buf[y * WAVEFORM_WIDTH + x] = COLOR8_GRAY;
+        Overlay_HLine(&wave_overlay, 10, y, WAVEFORM_WIDTH - 10, 5, COLOR8_GRAY, OVERLAY_BELOW);
+    }
+}
+
+// Перестройка статического слоя. Вызывается только при изменении его содержимого
+static void build_overlay(void) {
+    uint16_t level = global_buffer.trigger_level;
+    
+    Overlay_Clear(&wave_overlay);
+    draw_grid();
+    
+    // Маркер уровня триггера у левого края, поверх трассы
+    int y = calibration_code_to_px(level);
+    Overlay_HLine(&wave_overlay, 0, y, 8, 1, COLOR8_YELLOW, OVERLAY_ABOVE);
+    
+    // Курсоры пунктиром, выбранный в меню - сплошной линией
+    if (settings_get()->cursors_enabled) {
+        for (int i = 0; i < CURSOR_COUNT; i++) {
+            int step = menu_state == (MenuState)(MENU_CURSOR_T1 + i) ? 1 : 3;
+            Overlay_VLine(&wave_overlay, cursor_x[i], 0, WAVEFORM_HEIGHT, step,
+                          COLOR8_MAGENTA, OVERLAY_ABOVE);
+            step = menu_state == (MenuState)(MENU_CURSOR_V1 + i) ? 1 : 3;
+            Overlay_HLine(&wave_overlay, 0, calibration_code_to_px(cursor_code[i]), WAVEFORM_WIDTH,
+                          step, COLOR8_MAGENTA, OVERLAY_ABOVE);
+        }
+    }
+    
+    overlay_trigger_level = level;
+    FB8_MarkAllDirty(&wave_fb);
+}
+
+// Трасса по столбцам: отрезок от минимума до максимума столбца, продлённый
+// до соседнего, чтобы крутые фронты не распадались на отдельные пиксели.
+// Пустой столбец (min > max) разрывает трассу
+static void draw_columns(const RecordSpan* columns, uint16_t count, color8_t color) {
+    int prev_top = -1, prev_bottom = -1;
+    for (int x = 0; x < count; x++) {
+        if (columns[x].min > columns[x].max) {
+            prev_top = -1;
+            continue;
+        }
+        int top = calibration_code_to_px(columns[x].max);
+        int bottom = calibration_code_to_px(columns[x].min);
+        if (top > bottom) { int t = top; top = bottom; bottom = t; }
+        int y0 = top, y1 = bottom;
+        if (prev_top >= 0) {
+            if (top > prev_bottom) y0 = prev_bottom + 1;
+            else if (bottom < prev_top) y1 = prev_top - 1;
+        }
+        FB8_VLine(&wave_fb, x, y0, y1 - y0 + 1, color);
+        prev_top = top;
+        prev_bottom = bottom;
+    }
+}
+
+// Окно развёртки в отсчётах, Q16
+static uint32_t timebase_span_q16(void) {
+    uint64_t span = (uint64_t)get_timebase_us() * TIMEBASE_DIVS * global_buffer.sample_rate;
+    span = (span << 16) / 1000000;
+    return span > UINT32_MAX ? UINT32_MAX : (uint32_t)span;
+}
+
+// Окно кадра по развёртке. Окно не уже экрана в отсчётах - кадр 1:1 (в
+// кадре их не больше ширины экрана, длинные окна - у длинной записи).
+// Уже - растягивается вокруг фронта (anchor, без синхронизации -
+// TRIGGER_PRETRIGGER): он остаётся в том же столбце, что и при 1:1.
+// Возвращает длину окна, Q16
+static uint32_t frame_window(uint16_t count, int anchor, int32_t* start_q16) {
+    const uint32_t width_q16 = (uint32_t)WAVEFORM_WIDTH << 16;
+    uint32_t span = timebase_span_q16();
+    *start_q16 = 0;
+    if (span >= width_q16 || count == 0) return width_q16;
+    
+    if (anchor < 0) anchor = TRIGGER_PRETRIGGER;
+    if (anchor >= count) anchor = count - 1;
+    int64_t start = (int64_t)anchor * (width_q16 - span) / WAVEFORM_WIDTH;
+    int64_t last = ((int64_t)count << 16) - span;
+    if (start > last) start = last > 0 ? last : 0;
+    *start_q16 = (int32_t)start;
+    return span;
+}
+
+// Коды АЦП на милливольты допуска по текущей калибровке
+static uint16_t tolerance_codes(uint16_t mv) {
+    uint32_t gain_q16;
+    int32_t offset_mv;
+    calibration_get_gain_offset(&gain_q16, &offset_mv);
+    uint32_t codes = ((uint32_t)mv << 16) / gain_q16;
+    return codes > 0xFFFF ? 0xFFFF : codes;
+}
+
+// Эталон рисуется под сигналом в том же окне развёртки и сравнивается с
+// ним по отсчётам: декодируется из flash по одному отсчёту во время сравнения
+static void draw_reference(const uint16_t* live, uint16_t live_count,
+                           int32_t start_q16, uint32_t span_q16) {
+    ReferenceCursor cursor;
+    uint16_t count = reference_open(ref_slot, &cursor);
+    ref_result_valid = false;
+    if (!count) return;
+    if (count > WAVEFORM_WIDTH) count = WAVEFORM_WIDTH;
+    
+    uint16_t tolerance = tolerance_codes(ref_tolerance_mv);
+    reference_compare_reset(&ref_result);
+    uint16_t n = 0;
+    while (n < count && reference_next(&cursor, &trace_samples[n])) {
+        if (live && n < live_count) {
+            reference_compare_add(&ref_result, n, live[n], trace_samples[n], tolerance);
         }
+        n++;
     }
+    ref_result_valid = ref_result.columns > 0;
+    
+    uint16_t columns = resample(trace_samples, n, start_q16, span_q16, trace_columns, WAVEFORM_WIDTH);
+    draw_columns(trace_columns, columns, COLOR8_CYAN);
 }
 
-void draw_waveform(uint16_t* adc_data) {
+// Границы маски под сигналом: столбец маски для отсчёта кадра - по
+// фронту (anchor), за краями маски продлеваются крайние столбцы
+static void draw_mask(uint16_t count, int anchor, int32_t start_q16, uint32_t span_q16) {
+    uint16_t mask_count, mask_trigger;
+    const MaskLimit* limits = mask_limits(&mask_count, &mask_trigger);
+    if (!limits || count == 0) return;
+    
+    if (anchor < 0) anchor = global_buffer.trigger_enabled ? TRIGGER_PRETRIGGER : 0;
+    int shift = (int)mask_trigger - anchor;
+    for (int upper = 0; upper < 2; upper++) {
+        for (int k = 0; k < count; k++) {
+            int c = k + shift;
+            if (c < 0) c = 0;
+            if (c >= mask_count) c = mask_count - 1;
+            trace_samples[k] = limits[c].lo + (upper ? limits[c].range : 0);
+        }
+        uint16_t columns = resample(trace_samples, count, start_q16, span_q16, trace_columns, WAVEFORM_WIDTH);
+        draw_columns(trace_columns, columns, COLOR8_GREEN);
+    }
+}
+
+// Отсчётов в окне длинной записи по текущей развёртке
+static uint32_t record_span(void) {
+    uint32_t span = timebase_span_q16() >> 16;
+    return span ? span : 1;
+}
+
+// Окно длинной записи: с отсчёта на столбец и больше - по пирамиде
+// минимумов/максимумов, короче экрана - интерполяция по отсчётам окна
+// (с запасом под ядро с обеих сторон, где запись это позволяет)
+static void draw_record(void) {
+    uint32_t span = record_span();
+    uint32_t length = long_record_length();
+    uint16_t columns;
+    // Окно ограничено записью так же, как в long_record_render
+    uint32_t shown = span < length ? span : length;
+    shown_trace = length ? SHOWN_RECORD : SHOWN_NONE;
+    shown_start_q16 = (int32_t)((length - get_record_position() - shown) << 16);
+    shown_span_q16 = shown << 16;
+    if (span < WAVEFORM_WIDTH && length) {
+        if (span > length) span = length;
+        uint32_t offset = get_record_position();
+        uint32_t margin = RESAMPLE_TAPS / 2;
+        uint32_t before = length - offset - span < margin ? length - offset - span : margin;
+        uint32_t after = offset < margin ? offset : margin;
+        uint32_t n = long_record_read(offset - after, span + before + after, trace_samples);
+        columns = resample(trace_samples, (uint16_t)n, (int32_t)(before << 16), span << 16,
+                           trace_columns, WAVEFORM_WIDTH);
+    } else {
+        columns = long_record_render(record_offset, span, trace_columns, WAVEFORM_WIDTH);
+    }
+    draw_columns(trace_columns, columns, COLOR8_RED);
+}
+
+void draw_waveform(const uint16_t* adc_data, uint16_t count) {
     // Очищаем буфер рисования (только область осциллографа)
-    memset(draw_wave_buf, COLOR8_BLACK, sizeof(waveform_buf1));
+    FB8_Clear(&wave_fb, COLOR8_BLACK);
     
-    draw_grid();
+    if (overlay_trigger_level != global_buffer.trigger_level) {
+        build_overlay();
+    }
 
-    // Сигнал
-    for (int x = 0; x < WAVEFORM_WIDTH; x++) {
-        int y = ((4095 - adc_data[x]) * WAVEFORM_HEIGHT / 4096);
-        draw_wave_buf[y * WAVEFORM_WIDTH + x] = COLOR8_RED;
+    // В режиме послесвечения показываем накопленную карту попаданий
+    shown_trace = SHOWN_NONE;
+    // XY: карта точек, которую ядро захвата копит на каждый блок
+    if (global_buffer.xy_mode) {
+        xy_render(draw_wave_buf, WAVEFORM_WIDTH);
+        FB8_VLine(&wave_fb, XY_LEFT - 1, 0, XY_SIZE, COLOR8_GRAY);
+        FB8_VLine(&wave_fb, XY_LEFT + XY_SIZE, 0, XY_SIZE, COLOR8_GRAY);
+        return;
     }
+    if (global_buffer.persistence) {
+        persistence_render(draw_wave_buf);
+        return;
+    }
+    
+    // Длинная запись: кадр и эталон не показываются
+    if (record_view) {
+        draw_record();
+        return;
+    }
+
+    // После сдвига по триггеру отсчётов может быть меньше ширины экрана,
+    // до первого захвата кадра нет вовсе
+    if (!adc_data) count = 0;
+    if (count > WAVEFORM_WIDTH) count = WAVEFORM_WIDTH;
+    // Фронт известен только у текущего кадра и у удержанного нарушения
+    // маски, не у кадра из истории
+    int anchor = global_buffer.display_trigger;
+    if (global_buffer.hold && replay_age >= 0) anchor = -1;
+    else if (global_buffer.hold && mask_fail_shown) anchor = mask_fail_trigger;
+    int32_t start_q16;
+    uint32_t span_q16 = frame_window(count, anchor, &start_q16);
+    // Трассу математического канала с эталоном не сравниваем: он там операнд
+    if (ref_slot >= 0) {
+        bool compare = adc_data && !global_buffer.transform_count;
+        draw_reference(compare ? adc_data : NULL, compare ? count : 0, start_q16, span_q16);
+    }
+    if (mask_enabled()) draw_mask(count, anchor, start_q16, span_q16);
+    if (count == 0) return;
+    shown_trace = SHOWN_FRAME;
+    shown_start_q16 = start_q16;
+    shown_span_q16 = span_q16;
+    
+    // Индекс для измерений между курсорами - только для нового кадра
+    int16_t age = global_buffer.hold ? replay_age : -1;
+    if (settings_get()->cursors_enabled &&
+        (adc_data != cursor_index.samples || count != cursor_index.count ||
+         global_buffer.trigger_level != cursor_index.level ||
+         global_buffer.display_sequence != cursor_index_sequence || age != cursor_index_age)) {
+        cursors_index(&cursor_index, adc_data, count, global_buffer.trigger_level);
+        cursor_index_sequence = global_buffer.display_sequence;
+        cursor_index_age = age;
+    }
+    
+    PERF_TIMER(resample_start);
+    uint16_t columns = resample(adc_data, count, start_q16, span_q16, trace_columns, WAVEFORM_WIDTH);
+    PERF_RECORD(PERF_RESAMPLE, resample_start);
+    draw_columns(trace_columns, columns, COLOR8_RED);
 }
 
 /* Публичные функции */
 
 void init_buttons(void) {
-    gpio_init(BUTTON_HOLD);
-    gpio_init(BUTTON_PLUS);
-    gpio_init(BUTTON_MINUS);
-    gpio_init(BUTTON_SET);
-    
-    gpio_set_dir(BUTTON_HOLD, GPIO_IN);
-    gpio_set_dir(BUTTON_PLUS, GPIO_IN);
-    gpio_set_dir(BUTTON_MINUS, GPIO_IN);
-    gpio_set_dir(BUTTON_SET, GPIO_IN);
+    static const uint8_t pins[INPUT_BUTTON_COUNT] = {
+        [INPUT_HOLD] = BUTTON_HOLD,
+        [INPUT_PLUS] = BUTTON_PLUS,
+        [INPUT_MINUS] = BUTTON_MINUS,
+        [INPUT_SET] = BUTTON_SET,
+    };
+    input_init(pins);
+}
+
+// Трасса математического канала вместо захвата. Множители пересчитываются
+// только при смене калибровки или частоты
+static uint16_t math_transform(const uint16_t* samples, uint16_t start,
+                               const FrameMeta* meta, uint16_t* out) {
+    uint32_t gain_q16;
+    int32_t offset_mv;
+    calibration_get_gain_offset(&gain_q16, &offset_mv);
+    if (gain_q16 != math.gain_q16 || offset_mv != math.offset_mv ||
+        global_buffer.sample_rate != math.sample_rate) {
+        math_channel_configure(&math, global_buffer.sample_rate, gain_q16, offset_mv);
+    }
     
-    gpio_pull_up(BUTTON_HOLD);
-    gpio_pull_up(BUTTON_PLUS);
-    gpio_pull_up(BUTTON_MINUS);
-    gpio_pull_up(BUTTON_SET);
+    ReferenceCursor cursor;
+    ReferenceCursor* b = NULL;
+    if (math_channel_needs_b(math.op)) {
+        if (ref_slot < 0 || !reference_open(ref_slot, &cursor)) return 0;
+        b = &cursor;
+    }
+    return math_channel_process(&math, samples, start, meta->length, meta->sequence, b, out);
 }
 
-void process_buttons(void) {
-    static absolute_time_t last_press = 0;
-    if (absolute_time_diff_us(last_press, get_absolute_time()) < 20000) return;
+// Уровень триггера: шаг в кодах АЦП при коротком нажатии (~6 мВ)
+#define TRIGGER_STEP_CODES 8
+
+// Кнопки, кроме HOLD и SET, действуют по пункту меню. Повторы при
+// удержании - только там, где листается значение
+static bool handle_button(const InputEvent* e) {
+    bool repeat = e->type == INPUT_REPEAT;
+    int step = e->button == INPUT_PLUS ? 1 : -1;
     
-    if (!gpio_get(BUTTON_SET)) {
-        menu_state = (menu_state + 1) % (MENU_TRIGGER + 1);
-        last_press = get_absolute_time();
+    if (e->button == INPUT_SET) {
+        if (repeat) return false;
+        // Пункты отдельных курсоров - только когда курсоры включены.
+        // Выбранный курсор выделяется в статическом слое
+        bool cursors = settings_get()->cursors_enabled;
+        menu_state = (menu_state + 1) % (MENU_CURSOR_V2 + 1);
+        if (menu_state > MENU_CURSORS && !cursors) menu_state = MENU_NONE;
+        if (cursors) build_overlay();
+        return true;
     }
     
-    if (!gpio_get(BUTTON_HOLD)) {
-        global_buffer.hold = !global_buffer.hold;
-        last_press = get_absolute_time();
+    if (e->button == INPUT_HOLD) {
+        if (repeat) return false;
+        // В однократном режиме выход из удержания заново взводит запуск
+        bool hold = !global_buffer.hold;
+        if (!hold && get_trigger_mode() == TRIGGER_SINGLE) settings_arm_single();
+        set_hold(hold);
+        return true;
     }
     
-    float* adjust_value = NULL;
     switch (menu_state) {
-        case MENU_TIME_SCALE: adjust_value = &global_buffer.time_scale; break;
-        case MENU_VOLT_SCALE: adjust_value = &global_buffer.voltage_scale; break;
-        case MENU_TRIGGER: adjust_value = (float*)&global_buffer.trigger_level; break;
-        default: break;
+        // Развёртка и чувствительность - по шагам таблиц настроек,
+        // PLUS растягивает изображение
+        case MENU_TIME_SCALE: {
+            int tb = (int)get_timebase() + step;
+            if (tb < TIMEBASE_1US || tb > TIMEBASE_100MS) return false;
+            set_timebase((TimebaseSetting)tb);
+            return true;
+        }
+        case MENU_VOLT_SCALE: {
+            int vd = (int)get_volt_div() - step;
+            if (vd < VOLT_DIV_0_1V || vd > VOLT_DIV_5V) return false;
+            set_volt_div((VoltDivSetting)vd);
+            return true;
+        }
+        case MENU_TRIGGER: {
+            int32_t level = (int32_t)get_trigger_level() + step * TRIGGER_STEP_CODES * input_accel(e);
+            if (level < 0) level = 0;
+            if (level > 4095) level = 4095;
+            if (level == get_trigger_level()) return false;
+            set_trigger_level((uint16_t)level);
+            return true;
+        }
+        // Курсоры: время - по столбцу, напряжение - шагом уровня триггера
+        case MENU_CURSOR_T1:
+        case MENU_CURSOR_T2: {
+            uint8_t n = menu_state - MENU_CURSOR_T1;
+            int32_t x = cursor_x[n] + step * input_accel(e);
+            if (x < 0) x = 0;
+            if (x >= WAVEFORM_WIDTH) x = WAVEFORM_WIDTH - 1;
+            if (x == cursor_x[n]) return false;
+            set_time_cursor(n, (int16_t)x);
+            return true;
+        }
+        case MENU_CURSOR_V1:
+        case MENU_CURSOR_V2: {
+            uint8_t n = menu_state - MENU_CURSOR_V1;
+            int32_t code = (int32_t)cursor_code[n] + step * TRIGGER_STEP_CODES * input_accel(e);
+            if (code < 0) code = 0;
+            if (code > 4095) code = 4095;
+            if (code == cursor_code[n]) return false;
+            set_volt_cursor(n, (uint16_t)code);
+            return true;
+        }
+        default:
+            break;
+    }
+    
+    if (repeat) {
+        // Удержание без меню: повторы листают историю, с ускорением
+        if (!global_buffer.hold || menu_state != MENU_NONE) return false;
     }
     
-    if (adjust_value) {
-        if (!gpio_get(BUTTON_PLUS)) *adjust_value *= 1.2f;
-        if (!gpio_get(BUTTON_MINUS)) *adjust_value /= 1.2f;
-        last_press = get_absolute_time();
+    switch (menu_state) {
+        case MENU_PERSISTENCE:
+            if (global_buffer.persistence == (step > 0)) return false;
+            set_persistence(step > 0);
+            return true;
+        
+        // Поток на ПК: PLUS - включение и смена кодирования, MINUS - выключение
+        case MENU_STREAM:
+            if (step > 0) {
+                StreamEncoding enc = usb_stream_get_encoding();
+                if (usb_stream_enabled()) enc = (enc + 1) % STREAM_ENC_COUNT;
+                set_stream(true, enc);
+            } else {
+                if (!usb_stream_enabled()) return false;
+                set_stream(false, usb_stream_get_encoding());
+            }
+            return true;
+        
+        // Эталон: PLUS - следующий слот (после последнего - выключено),
+        // MINUS - запись текущего кадра в показанный слот (или в первый)
+        case MENU_REFERENCE:
+            if (step > 0) {
+                int8_t slot = ref_slot + 1;
+                set_reference(slot < reference_slot_count() ? slot : -1);
+            } else {
+                uint8_t slot = ref_slot >= 0 ? ref_slot : 0;
+                if (save_reference(slot)) set_reference(slot);
+            }
+            return true;
+        
+        // Математика: PLUS - следующая операция, MINUS - выключение
+        case MENU_MATH:
+            if (step < 0 && math.op == MATH_OFF) return false;
+            set_math(step > 0 ? (math.op + 1) % MATH_OP_COUNT : MATH_OFF);
+            return true;
+        
+        // Длинная запись: PLUS - включение, MINUS - выключение
+        case MENU_RECORD:
+            if (record_view == (step > 0)) return false;
+            set_record_view(step > 0);
+            return true;
+        
+        // XY: PLUS - включение, MINUS - выключение
+        case MENU_XY:
+            if (global_buffer.xy_mode == (step > 0)) return false;
+            set_xy_mode(step > 0);
+            replay_dirty = true;
+            return true;
+        
+        // Автоустановка: PLUS - запуск заново
+        case MENU_AUTOSET:
+            if (step < 0 || autoset_state() == AUTOSET_RUNNING) return false;
+            start_autoset();
+            return true;
+        
+        // Маска: PLUS - маска из текущего кадра и включение, если включена -
+        // сброс счётчиков (и выход из остановки), MINUS - выключение
+        case MENU_MASK:
+            if (step > 0) {
+                if (mask_enabled()) reset_mask();
+                else return create_mask(-1) && set_mask(true);
+            } else {
+                if (!mask_enabled()) return false;
+                set_mask(false);
+            }
+            return true;
+        
+        // Курсоры: PLUS - включение, MINUS - выключение
+        case MENU_CURSORS:
+            if (settings_get()->cursors_enabled == (step > 0)) return false;
+            set_cursors(step > 0);
+            return true;
+        
+        // Калибровка: PLUS - нелинейность (на входе треугольник на весь
+        // диапазон), MINUS - ноль по текущему кадру (вход на земле)
+        case MENU_CALIBRATION:
+            if (step > 0) {
+                if (calibration_get_state() != CALIB_IDLE) return false;
+                calibration_start_density();
+                return true;
+            }
+            return calibrate_zero();
+        
+        // Усиление: PLUS - по текущему кадру (на входе CALIB_GAIN_REF_MV,
+        // ноль уже откалиброван), MINUS - номинальное
+        case MENU_CAL_GAIN: {
+            if (step > 0) return calibrate_gain(CALIB_GAIN_REF_MV);
+            uint32_t gain_q16;
+            int32_t offset_mv;
+            calibration_get_gain_offset(&gain_q16, &offset_mv);
+            calibration_set_gain_offset(0, offset_mv);
+            return true;
+        }
+        
+        // Удержание без меню: MINUS - назад по истории, PLUS - вперёд.
+        // Длинная запись сдвигается на деление, при удержании кнопки - быстрее
+        case MENU_NONE: {
+            if (!global_buffer.hold) return false;
+            if (record_view) {
+                uint32_t span = record_span();
+                uint32_t length = long_record_length();
+                uint32_t current = get_record_position();
+                int64_t offset = (int64_t)current -
+                    (int64_t)step * (span / TIMEBASE_DIVS + 1) * input_accel(e);
+                if (offset > (int64_t)length - (int64_t)span) offset = (int64_t)length - (int64_t)span;
+                if (offset < 0) offset = 0;
+                if ((uint32_t)offset == current) return false;
+                set_record_position((uint32_t)offset);
+                return true;
+            }
+            int32_t age = replay_age - step * input_accel(e);
+            if (age >= history_count()) age = history_count() - 1;
+            if (age < -1) age = -1;
+            if (age == replay_age) return false;
+            replay_age = age;
+            replay_dirty = true;
+            return true;
+        }
+        
+        default:
+            return false;
+    }
+}
+
+// События кнопок копит input из прерываний, здесь они только разбираются
+void process_buttons(void) {
+    InputEvent e;
+    bool changed = false;
+    while (input_get_event(&e)) {
+        if (e.type == INPUT_RELEASE) continue;
+        if (handle_button(&e)) changed = true;
     }
+    
+    // Любое изменение меняет картинку - просим кадр
+    if (changed) frame_scheduler_request_redraw();
 }
 
+// Измерения обновляет buffer_process на этом же ядре - блокировка не нужна
 static void get_measurements(float *measurements){
-    mutex_enter_blocking(&global_buffer.buffer_mutex);
     measurements[0] = global_buffer.max_value;
     measurements[1]= global_buffer.min_value;
     measurements[2] = global_buffer.vpp;
     measurements[3] = global_buffer.frequency;
     measurements[4] = global_buffer.duty_cycle;
-    mutex_exit(&global_buffer.buffer_mutex);
 }
 
+// Копия показанного кадра: буфер на BUFFER_SIZE отсчётов
 static void get_current_adc_buffer(uint16_t *buffer){
-    buffer = global_buffer.adc_buffers[global_buffer.read_buffer];
+    uint16_t count;
+    const uint16_t *samples = buffer_get_current(&count);
+    if (count > BUFFER_SIZE) count = BUFFER_SIZE;
+    if (samples) memcpy(buffer, samples, count * sizeof(samples[0]));
 }
 
 static void get_voltage_constants(float *voltage_constants){
@@ -181,104 +790,662 @@ void get_values_for_draw(uint16_t *current_adc_buffer, float *measurements, floa
     get_voltage_constants(voltage_constants);
 }
 
-void draw_measurements(float *measurements) {
-    // Безопасное получение текущих измерений
-    //mutex_enter_blocking(&global_buffer.buffer_mutex);
-    float v_max = measurements[0] * 3.3f / 4095;
-    float v_min = measurements[1] * 3.3f / 4095;
-    float v_pp = measurements[2] * 3.3f / 4095;
-    float freq = measurements[3];
-    float duty = measurements[4];
-    //mutex_exit(&global_buffer.buffer_mutex);
-    
-    // Отрисовка
-    ILI9341_SetTextColor(&tft, COLOR8_WHITE, COLOR8_BLACK);
-    ILI9341_SetTextSize(&tft, 1);
-    
-    ILI9341_SetCursor(&tft, 0, 210);
-    ILI9341_Print(&tft, "Vmax,V: ");
-    ILI9341_PrintFloat(&tft, v_max, 2);
-    
-    ILI9341_SetCursor(&tft, 0, 220);
-    ILI9341_Print(&tft, "Vmin,V: ");
-    ILI9341_PrintFloat(&tft, v_min, 2);
-
-    ILI9341_SetCursor(&tft, 0, 230);
-    ILI9341_Print(&tft, "Vpp,V: ");
-    ILI9341_PrintFloat(&tft, v_pp, 2);
+// Перевод кода АЦП в милливольты по таблице калибровки. У трассы
+// математического канала ноль результата может быть поднят
+static int32_t code_to_mv(float code) {
+    return calibration_code_to_mv((uint16_t)code) - get_trace_zero_mv();
+}
 
+// Строка измерения; при выключенных измерениях строки стираются
+static void set_meas_line(int line, const char *text) {
+    TextLine_Set(&tft, &meas_lines[line], settings_get()->measurements_enabled ? text : "");
+}
+
+// Счётчик для строки состояния, не длиннее 5 символов: до 99999 - точно,
+// дальше - три значащие цифры с приставкой ("1.23M")
+static void format_count(char *buf, int size, uint32_t n) {
+    if (n < 100000) {
+        snprintf(buf, size, "%u", (unsigned)n);
+    } else {
+        Text_FormatSI(buf, size, n > INT32_MAX ? INT32_MAX : (int32_t)n, 0, "");
+    }
+}
+
+void draw_measurements(float *measurements) {
+    char value[16];
+    char text[TEXT_LINE_MAX + 1];
+    
+    // Напряжения
+    Text_FormatSI(value, sizeof(value), code_to_mv(measurements[0]), -3, "V");
+    snprintf(text, sizeof(text), "Vmax: %s", value);
+    set_meas_line(MEAS_VMAX, text);
+    
+    Text_FormatSI(value, sizeof(value), code_to_mv(measurements[1]), -3, "V");
+    snprintf(text, sizeof(text), "Vmin: %s", value);
+    set_meas_line(MEAS_VMIN, text);
+    
+    Text_FormatSI(value, sizeof(value), code_to_mv(measurements[0]) - code_to_mv(measurements[1]), -3, "V");
+    snprintf(text, sizeof(text), "Vpp: %s", value);
+    set_meas_line(MEAS_VPP, text);
+    
     // Частота и скважность
-    ILI9341_SetCursor(&tft, 150, 210);
-    ILI9341_Print(&tft, "Freq,Hz: ");
-    char freq_buf[16];
-    snprintf(freq_buf, sizeof(freq_buf), "%d", freq);
-    ILI9341_Print(&tft, freq_buf);
+    Text_FormatSI(value, sizeof(value), (int32_t)measurements[3], 0, "Hz");
+    snprintf(text, sizeof(text), "Freq: %s", value);
+    set_meas_line(MEAS_FREQ, text);
+    
+    Text_FormatFixed(value, sizeof(value), (int32_t)(measurements[4] * 10.0f), 1, "%");
+    snprintf(text, sizeof(text), "Duty: %s", value);
+    set_meas_line(MEAS_DUTY, text);
+    
+    // Положение в истории и степень сжатия, в меню калибровки - её состояние
+    text[0] = '\0';
+    if (menu_state == MENU_STREAM) {
+        static const char *const encodings[] = { "raw", "p12", "dlt" };
+        UsbStreamStats stats;
+        usb_stream_get_stats(&stats);
+        if (usb_stream_enabled()) {
+            snprintf(text, sizeof(text), "USB %s drop %lu",
+                     encodings[usb_stream_get_encoding()], (unsigned long)stats.dropped);
+        } else {
+            snprintf(text, sizeof(text), "USB off");
+        }
+    } else if (menu_state == MENU_CALIBRATION) {
+        static const char *const results[] = { "-", "ok", "fail" };
+        snprintf(text, sizeof(text), "Cal: %s",
+                 calibration_get_state() == CALIB_DENSITY ? "run" : results[calibration_get_result()]);
+    } else if (menu_state == MENU_CAL_GAIN) {
+        // Наклон калибровки, мкВ на код
+        uint32_t gain_q16;
+        int32_t offset_mv;
+        calibration_get_gain_offset(&gain_q16, &offset_mv);
+        Text_FormatFixed(value, sizeof(value), (int32_t)(((uint64_t)gain_q16 * 1000 + 0x8000) >> 16),
+                         3, "mV");
+        snprintf(text, sizeof(text), "Gain %s/code", value);
+    } else if (menu_state == MENU_XY || (global_buffer.xy_mode && menu_state == MENU_NONE)) {
+        // XY: частота пар (на каждый вход) и точек с очистки
+        if (global_buffer.xy_mode) {
+            Text_FormatSI(value, sizeof(value), global_buffer.sample_rate / 2, 0, "S/s");
+            snprintf(text, sizeof(text), "XY %s %lu", value, (unsigned long)xy_get_points());
+        } else {
+            snprintf(text, sizeof(text), "XY off");
+        }
+    } else if (menu_state == MENU_AUTOSET || autoset_state() == AUTOSET_RUNNING) {
+        // Автоустановка: частота найденного сигнала и время до результата
+        AutosetState state = autoset_state();
+        uint32_t ms = (uint32_t)((uint64_t)autoset.samples * 1000 / global_buffer.sample_rate);
+        if (state == AUTOSET_IDLE) {
+            snprintf(text, sizeof(text), "Auto -");
+        } else if (state == AUTOSET_RUNNING) {
+            snprintf(text, sizeof(text), "Auto run");
+        } else if (state == AUTOSET_NO_PERIOD) {
+            snprintf(text, sizeof(text), "Auto no period");
+        } else {
+            Text_FormatSI(value, sizeof(value),
+                          (int32_t)(((uint64_t)global_buffer.sample_rate << 8) / autoset.period_q8), 0, "Hz");
+            snprintf(text, sizeof(text), "Auto %s %lums", value, (unsigned long)ms);
+        }
+    } else if (menu_state == MENU_MASK || (mask_enabled() && menu_state == MENU_NONE && replay_age < 0)) {
+        // Маска: негодных из испытаний и испытаний в секунду. Точные
+        // счётчики - по SCPI (MASK:COUNt?)
+        MaskCounters c;
+        mask_get_counters(&c);
+        if (!mask_enabled()) {
+            snprintf(text, sizeof(text), "Mask off");
+        } else {
+            char failed[8], total[8], rate[8];
+            format_count(failed, sizeof(failed), c.failed);
+            format_count(total, sizeof(total), c.total);
+            format_count(rate, sizeof(rate), mask_tests_per_second(time_us_32()));
+            snprintf(text, sizeof(text), "Mask %s %.5s/%.5s %.5s/s", c.failed ? "FAIL" : "pass",
+                     failed, total, rate);
+        }
+    } else if (menu_state >= MENU_CURSORS) {
+        // Курсоры: включены ли и какой из них двигают PLUS/MINUS
+        static const char *const selected[] = { "on", "T1", "T2", "V1", "V2" };
+        snprintf(text, sizeof(text), "Cur %s",
+                 settings_get()->cursors_enabled ? selected[menu_state - MENU_CURSORS] : "off");
+    } else if (menu_state == MENU_RECORD ||
+               (record_view && menu_state != MENU_MATH && menu_state != MENU_REFERENCE)) {
+        // Длинная запись: длительность окна и его сдвиг от нового отсчёта
+        uint32_t length = long_record_length();
+        if (!record_view) {
+            snprintf(text, sizeof(text), "Rec off");
+        } else if (!length) {
+            snprintf(text, sizeof(text), "Rec empty");
+        } else {
+            uint32_t span = record_span();
+            if (span > length) span = length;
+            uint32_t offset = record_offset > length - span ? length - span : record_offset;
+            char shift[12];
+            Text_FormatSI(value, sizeof(value),
+                          (int32_t)((uint64_t)span * 1000000 / global_buffer.sample_rate), -6, "s");
+            Text_FormatSI(shift, sizeof(shift),
+                          -(int32_t)((uint64_t)offset * 1000000 / global_buffer.sample_rate), -6, "s");
+            snprintf(text, sizeof(text), "Rec %s %s", value, shift);
+        }
+    } else if (menu_state == MENU_MATH || (math.op != MATH_OFF && replay_age < 0 && menu_state != MENU_REFERENCE)) {
+        bool no_b = math_channel_needs_b(math.op) && (ref_slot < 0 || !reference_valid(ref_slot));
+        snprintf(text, sizeof(text), "Math %s%s", math_channel_name(math.op), no_b ? " no ref" : "");
+    } else if (menu_state == MENU_REFERENCE || (ref_slot >= 0 && ref_result_valid && replay_age < 0)) {
+        if (ref_slot < 0) {
+            snprintf(text, sizeof(text), "Ref off");
+        } else if (!ref_result_valid) {
+            snprintf(text, sizeof(text), "Ref%d empty", ref_slot + 1);
+        } else {
+            uint16_t max_mv;
+            get_reference_result(NULL, &max_mv, NULL, NULL);
+            Text_FormatSI(value, sizeof(value), max_mv, -3, "V");
+            snprintf(text, sizeof(text), "Ref%d %s %s", ref_slot + 1,
+                     reference_compare_pass(&ref_result) ? "pass" : "FAIL", value);
+        }
+    } else if (replay_age >= 0) {
+        HistoryStats stats;
+        history_get_stats(&stats);
+        uint32_t ratio = stats.encoded_bytes ? stats.raw_bytes * 10 / stats.encoded_bytes : 0;
+        Text_FormatFixed(value, sizeof(value), ratio, 1, "");
+        snprintf(text, sizeof(text), "Hist -%d/%u x%s", replay_age + 1, history_count(), value);
+    }
+    TextLine_Set(&tft, &meas_lines[MEAS_HISTORY], text);
+}
+
+// Отсчёт под столбцом x в окне последней выведенной трассы
+static uint32_t shown_sample(int16_t x) {
+    return (uint32_t)((shown_start_q16 + (int64_t)x * shown_span_q16 / WAVEFORM_WIDTH) >> 16);
+}
+
+// Измерения только по отсчётам между курсорами времени (включительно).
+// Кадр - по индексу cursor_index, длинная запись - по её пирамиде
+// минимумов/максимумов: частоты и скважности у неё нет
+static void cursor_measurements(float *measurements) {
+    int16_t x0 = cursor_x[0] < cursor_x[1] ? cursor_x[0] : cursor_x[1];
+    int16_t x1 = cursor_x[0] < cursor_x[1] ? cursor_x[1] : cursor_x[0];
+    uint32_t from = shown_sample(x0);
+    uint32_t to = shown_sample(x1) + 1;
+    
+    if (shown_trace == SHOWN_RECORD) {
+        uint32_t length = long_record_length();
+        if (to > length) to = length;
+        if (from >= to) return;
+        RecordSpan span;
+        if (!long_record_render(length - to, to - from, &span, 1)) return;
+        measurements[0] = span.max;
+        measurements[1] = span.min;
+        measurements[2] = span.max - span.min;
+        measurements[3] = 0;
+        measurements[4] = 0;
+        return;
+    }
+    
+    CursorMeasure m;
+    if (shown_trace != SHOWN_FRAME ||
+        !cursors_measure(&cursor_index, from, to, global_buffer.sample_rate, &m)) {
+        return;
+    }
+    measurements[0] = m.max;
+    measurements[1] = m.min;
+    measurements[2] = m.max - m.min;
+    measurements[3] = m.frequency;
+    measurements[4] = m.duty_permille / 10.0f;
+}
+
+// Разность курсоров: время по окну выведенной трассы, напряжение - по
+// таблице калибровки
+static void draw_cursor_readout(void) {
+    char text[TEXT_LINE_MAX + 1] = "";
+    if (settings_get()->cursors_enabled && shown_trace != SHOWN_NONE) {
+        char dt[12], freq[12], dv[12];
+        uint32_t dx = cursor_x[1] > cursor_x[0] ? cursor_x[1] - cursor_x[0] : cursor_x[0] - cursor_x[1];
+        uint64_t ns = ((uint64_t)dx * shown_span_q16 / WAVEFORM_WIDTH * 1000000000u /
+                       global_buffer.sample_rate) >> 16;
+        Text_FormatSI(dt, sizeof(dt), (int32_t)ns, -9, "s");
+        if (!ns) {
+            snprintf(freq, sizeof(freq), "-");
+        } else if (ns >= 1000) {
+            Text_FormatSI(freq, sizeof(freq), (int32_t)(1000000000000ull / ns), -3, "Hz");
+        } else {
+            Text_FormatSI(freq, sizeof(freq), (int32_t)(1000000000u / ns), 0, "Hz");
+        }
+        Text_FormatSI(dv, sizeof(dv), calibration_code_to_mv(cursor_code[1]) -
+                      calibration_code_to_mv(cursor_code[0]), -3, "V");
+        // Text_FormatSI даёт не больше 8 символов ("-1.23kHz"): строка
+        // укладывается в TEXT_LINE_MAX
+        snprintf(text, sizeof(text), "dt %.8s  1/dt %.8s  dV %.8s", dt, freq, dv);
+    }
+    TextLine_Set(&tft, &cursor_line, text);
+}
 
-    ILI9341_SetCursor(&tft, 150, 220);
-    ILI9341_Print(&tft, "Duty,%: ");
-    ILI9341_PrintFloat(&tft, duty, 1);
+// Отсчётов в окне развёртки tb
+static uint32_t timebase_span(TimebaseSetting tb) {
+    return (uint32_t)((uint64_t)(timebase_step_us(tb) * TIMEBASE_DIVS) * global_buffer.sample_rate / 1000000);
+}
+
+// Вертикаль: самая мелкая ступень, где размах занимает не больше 4/5
+// высоты, середина размаха (у постоянного уровня - среднее) по центру.
+// Развёртка: самое короткое окно на два периода
+static void apply_autoset(void) {
+    autoset_pending = false;
+    bool periodic = autoset.state == AUTOSET_LOCKED;
+    uint16_t vpp = autoset_vpp(&autoset);
+    bool flat = vpp < AUTOSET_MIN_VPP;
+    
+    int32_t lo_mv = calibration_code_to_mv(autoset.min);
+    int32_t hi_mv = calibration_code_to_mv(autoset.max);
+    int32_t center_mv = flat ? calibration_code_to_mv(autoset_mean(&autoset)) : (lo_mv + hi_mv) / 2;
+    VoltDivSetting vd = VOLT_DIV_0_1V;
+    while (vd < VOLT_DIV_5V && (hi_mv - lo_mv) * 5 > (int32_t)(volt_window_v(vd) * 1000.0f) * 4) vd++;
+    set_volt_div(vd);
+    set_voltage_offset_mv(center_mv - (int32_t)(volt_window_v(vd) * 500.0f));
+    
+    uint16_t level = flat ? autoset_mean(&autoset) : autoset_mid(&autoset);
+    set_trigger_level(level);
+    set_trigger_hysteresis(flat ? 0 : autoset_hysteresis(vpp));
+    set_trigger_edge(EDGE_RISING);
+    set_trigger_mode(periodic ? TRIGGER_NORMAL : TRIGGER_AUTO);
+    
+    // Окно шире кадра показывает только длинная запись
+    if (periodic) {
+        uint32_t two_periods = (2 * autoset.period_q8 + 0xFF) >> 8;
+        TimebaseSetting tb = TIMEBASE_1US;
+        while (tb < TIMEBASE_100MS && timebase_span(tb) < two_periods) tb++;
+        set_timebase(tb);
+        set_record_view(timebase_span(tb) > WAVEFORM_WIDTH);
+    }
+    replay_dirty = true;
 }
 
 void render_frame() {
-    // 1. Получаем текущий буфер для отображения
-    mutex_enter_blocking(&global_buffer.buffer_mutex);
-    uint8_t buf_to_display = global_buffer.display_buffer;
-    bool live_mode = global_buffer.live_update;
-    mutex_exit(&global_buffer.buffer_mutex);
+    // 0. Автоустановка закончилась: настройки до пересчёта таблиц
+    if (autoset_pending) apply_autoset();
+    // Нарушение маски с остановкой: негодный захват удерживается на экране
+    if (mask_stopped() && !mask_fail_shown) {
+        set_hold(true);
+        mask_fail_shown = true;
+    }
+    
+    // Таблицы пересчёта: только при смене масштаба или калибровки
+    if (calibration_update_view(global_buffer.voltage_scale, global_buffer.voltage_offset)) {
+        build_overlay();
+    }
     
-    // 2. Отрисовка измерений (всегда актуальные)
+    // 1. Отрисовка волны из кадра, подготовленного buffer_process,
+    // или из истории, если её листают
+    if (global_buffer.live_update || !global_buffer.hold || replay_dirty) {
+        uint16_t count;
+        const uint16_t* samples = buffer_get_current(&count);
+        if (global_buffer.hold && replay_age >= 0) {
+            count = history_load(replay_age, replay_samples, NULL);
+            samples = replay_samples;
+        } else if (global_buffer.hold && mask_fail_shown) {
+            // Негодный блок целиком: показывается так же, как кадр по фронту
+            int16_t trigger;
+            uint16_t held = mask_get_held(replay_samples, &trigger);
+            if (held) {
+                uint16_t start = trigger > TRIGGER_PRETRIGGER ? trigger - TRIGGER_PRETRIGGER : 0;
+                samples = &replay_samples[start];
+                count = held - start;
+                mask_fail_trigger = trigger < 0 ? -1 : trigger - start;
+            } else {
+                mask_fail_trigger = global_buffer.display_trigger;
+            }
+        }
+        PERF_TIMER(draw_start);
+        draw_waveform(samples, count);
+        PERF_RECORD(PERF_DRAW, draw_start);
+        swap_wave_buffers();
+        replay_dirty = false;
+    }
+    
+    // 2. Отрисовка измерений (всегда актуальные). С курсорами - по окну
+    // только что выведенной трассы
     float measurements[5];
     get_measurements(measurements); // Читает из global_buffer
+    if (settings_get()->cursors_enabled) cursor_measurements(measurements);
     
+    PERF_TIMER(text_start);
     draw_measurements(measurements);
-    
-    // 3. Отрисовка волны
-    if (live_mode || !global_buffer.hold) {
-        draw_waveform(global_buffer.adc_buffers[buf_to_display]);
-        swap_wave_buffers();
-    }
+    draw_cursor_readout();
+    PERF_RECORD(PERF_TEXT, text_start);
+#if PERF_ENABLED && PERF_HUD
+    char hud[TEXT_LINE_MAX + 1];
+    perf_format_hud(hud, sizeof(hud));
+    TextLine_Set(&tft, &perf_line, hud);
+#endif
 }
 
+// Захват идёт и во время оценки: удержание и XY выключаются, кадры
+// выводятся со старыми настройками
+void start_autoset(void) {
+    set_hold(false);
+    if (global_buffer.xy_mode) set_xy_mode(false);
+    autoset_pending = false;
+    autoset_requested = true;
+}
+
+uint8_t get_autoset(uint32_t *period_q8, uint32_t *samples) {
+    AutosetState state = autoset_state();
+    if (period_q8) *period_q8 = state == AUTOSET_LOCKED ? autoset.period_q8 : 0;
+    if (samples) *samples = state == AUTOSET_RUNNING ? 0 : autoset.samples;
+    return state;
+}
+
+// В режиме удержания buffer_process не трогает кадр для отображения,
+// после выхода из него картинку обновит следующий захват
+// Выход из удержания продолжает испытания по маске после остановки
 void set_hold(bool enable) {
-    mutex_enter_blocking(&global_buffer.buffer_mutex);
     global_buffer.hold = enable;
-    
-    // При выходе из hold переключаем на последний буфер
+    replay_age = -1;
+    record_offset = 0;
+    replay_dirty = true;
     if (!enable) {
-        global_buffer.display_buffer = global_buffer.write_buffer;
+        mask_fail_shown = false;
+        mask_resume();
+    }
+}
+
+// Поток на ПК: каждый блок захвата уходит через capture_hook
+void set_stream(bool enable, uint8_t encoding) {
+    usb_stream_set_mode(enable, (StreamEncoding)encoding);
+}
+
+// Запись начинается заново с включением: старая уже не непрерывна
+void set_record_view(bool enable) {
+    if (enable && !record_view) long_record_clear();
+    record_view = enable;
+    record_offset = 0;
+    replay_dirty = true;
+}
+
+bool get_record_view(void) {
+    return record_view;
+}
+
+void set_record_position(uint32_t offset) {
+    record_offset = offset;
+    replay_dirty = true;
+}
+
+// Сдвиг, с которым окно выводится: не дальше начала записи
+uint32_t get_record_position(void) {
+    uint32_t length = long_record_length();
+    uint32_t span = record_span();
+    if (span > length) span = length;
+    return record_offset > length - span ? length - span : record_offset;
+}
+
+// Курсоры - в статическом слое: перестраивается он, кадр - по replay_dirty
+void set_cursors(bool enable) {
+    set_cursors_enabled(enable);
+    if (!enable && menu_state > MENU_CURSORS) menu_state = MENU_CURSORS;
+    build_overlay();
+    replay_dirty = true;
+}
+
+void set_time_cursor(uint8_t n, int16_t x) {
+    if (n >= CURSOR_COUNT) return;
+    if (x < 0) x = 0;
+    if (x >= WAVEFORM_WIDTH) x = WAVEFORM_WIDTH - 1;
+    cursor_x[n] = x;
+    build_overlay();
+    replay_dirty = true;
+}
+
+int16_t get_time_cursor(uint8_t n) {
+    return n < CURSOR_COUNT ? cursor_x[n] : 0;
+}
+
+void set_volt_cursor(uint8_t n, uint16_t code) {
+    if (n >= CURSOR_COUNT) return;
+    cursor_code[n] = code > 4095 ? 4095 : code;
+    build_overlay();
+    replay_dirty = true;
+}
+
+uint16_t get_volt_cursor(uint8_t n) {
+    return n < CURSOR_COUNT ? cursor_code[n] : 0;
+}
+
+void set_reference(int8_t slot) {
+    if (slot >= reference_slot_count()) slot = -1;
+    ref_slot = slot < 0 ? -1 : slot;
+    ref_result_valid = false;
+    replay_dirty = true;
+}
+
+int8_t get_reference(void) {
+    return ref_slot;
+}
+
+// Запись кадра, который сейчас на экране (при листании истории - из неё)
+bool save_reference(uint8_t slot) {
+    uint16_t count;
+    const uint16_t* samples = buffer_get_raw(&count);
+    if (global_buffer.hold && replay_age >= 0) {
+        count = history_load(replay_age, replay_samples, NULL);
+        samples = replay_samples;
+    }
+    if (!count) return false;
+    
+    ReferenceInfo info = {
+        .sequence = global_buffer.display_sequence,
+        .sample_rate = global_buffer.sample_rate,
+    };
+    calibration_get_gain_offset(&info.gain_q16, &info.offset_mv);
+    if (!reference_save(slot, samples, count, &info)) return false;
+    if (slot == ref_slot) set_reference(ref_slot);
+    return true;
+}
+
+void set_reference_tolerance(uint16_t mv) {
+    ref_tolerance_mv = mv;
+    replay_dirty = true;
+}
+
+uint16_t get_reference_tolerance(void) {
+    return ref_tolerance_mv;
+}
+
+// Отклонения переводятся в милливольты по текущему наклону калибровки
+bool get_reference_result(bool *pass, uint16_t *max_mv, uint16_t *mean_mv, uint16_t *over) {
+    if (ref_slot < 0 || !ref_result_valid) return false;
+    uint32_t gain_q16;
+    int32_t offset_mv;
+    calibration_get_gain_offset(&gain_q16, &offset_mv);
+    uint32_t mean = ref_result.sum_diff / ref_result.columns;
+    if (pass) *pass = reference_compare_pass(&ref_result);
+    if (max_mv) *max_mv = ((uint64_t)ref_result.max_diff * gain_q16 + 0x8000) >> 16;
+    if (mean_mv) *mean_mv = ((uint64_t)mean * gain_q16 + 0x8000) >> 16;
+    if (over) *over = ref_result.over;
+    return true;
+}
+
+// Маска из кадра на экране (фронт - как при показе) или из эталона
+bool create_mask(int8_t slot) {
+    uint16_t count;
+    const uint16_t* samples;
+    int16_t trigger;
+    if (slot >= 0) {
+        ReferenceCursor cursor;
+        count = reference_open(slot, &cursor);
+        if (count > WAVEFORM_WIDTH) count = WAVEFORM_WIDTH;
+        uint16_t n = 0;
+        while (n < count && reference_next(&cursor, &trace_samples[n])) n++;
+        count = n;
+        samples = trace_samples;
+        trigger = global_buffer.trigger_enabled ? TRIGGER_PRETRIGGER : -1;
+    } else {
+        samples = buffer_get_raw(&count);
+        trigger = global_buffer.display_trigger;
+        if (global_buffer.hold && mask_fail_shown) {
+            count = mask_get_held(replay_samples, &trigger);
+            samples = replay_samples;
+        }
+        // Кадр без фронта при включённой синхронизации не с чем совместить
+        if (global_buffer.trigger_enabled && trigger < 0) return false;
     }
-    mutex_exit(&global_buffer.buffer_mutex);
+    if (!samples || !mask_compile(samples, count, trigger, tolerance_codes(mask_tolerance_mv))) return false;
+    replay_dirty = true;
+    return true;
+}
+
+bool set_mask(bool enable) {
+    if (enable && !mask_valid() && !create_mask(-1)) return false;
+    mask_set_enabled(enable);
+    replay_dirty = true;
+    return true;
+}
+
+void reset_mask(void) {
+    mask_reset();
+    if (mask_fail_shown) set_hold(false);
+}
+
+void set_mask_tolerance(uint16_t mv) {
+    mask_tolerance_mv = mv;
+}
+
+uint16_t get_mask_tolerance(void) {
+    return mask_tolerance_mv;
+}
+
+// Средний код последнего кадра. false - кадра ещё нет
+static bool frame_mean_code(uint16_t *code) {
+    uint16_t count;
+    const uint16_t* samples = buffer_get_raw(&count);
+    if (!count) return false;
+    uint32_t sum = 0;
+    for (uint16_t i = 0; i < count; i++) sum += samples[i];
+    *code = (uint16_t)((sum + count / 2) / count);
+    return true;
+}
+
+bool calibrate_zero(void) {
+    uint16_t code;
+    if (!frame_mean_code(&code)) return false;
+    calibration_set_zero(code);
+    return true;
+}
+
+bool calibrate_gain(int32_t known_mv) {
+    uint16_t code;
+    return frame_mean_code(&code) && calibration_set_gain(code, known_mv);
+}
+
+void set_math(uint8_t op) {
+    math_channel_set_op(&math, (MathOp)op);
+    buffer_set_transform(math.op != MATH_OFF ? math_transform : NULL);
+    replay_dirty = true;
+}
+
+uint8_t get_math(void) {
+    return math.op;
+}
+
+void set_math_scale(int32_t scale_q16) {
+    math_channel_set_scale(&math, scale_q16);
+}
+
+int32_t get_math_scale(void) {
+    return math.scale_q16;
+}
+
+int32_t get_trace_zero_mv(void) {
+    return global_buffer.transform_count ? math.position_mv : 0;
 }
 
 void set_live_update(bool enable) {
-    mutex_enter_blocking(&global_buffer.buffer_mutex);
     global_buffer.live_update = enable;
-    mutex_exit(&global_buffer.buffer_mutex);
+}
+
+// Панель показывает active_wave_buf: после вывода кадра буферы уже
+// обменяны. Экран повёрнут (ILI9341_SetRotation 3): 320x240
+uint32_t display_screenshot_begin(void) {
+    if (screenshot_active()) return 0;
+    screen_source = (ScreenSource){
+        .width = WAVEFORM_WIDTH,
+        .height = DISPLAY_WIDTH,
+        .wave = active_wave_buf,
+        .wave_height = WAVEFORM_HEIGHT,
+        .overlay = &wave_overlay,
+        .lines = screen_lines,
+        .line_count = sizeof(screen_lines) / sizeof(screen_lines[0]),
+        .background = COLOR8_BLACK,
+    };
+    return screenshot_begin(&screen_source);
 }
 
 void core1_display_task() {
+#if PERF_ENABLED
+    perf_init_core();
+#endif
     display_init();
     init_buttons();
-    
-    const uint32_t target_fps = 120;
-    const uint32_t frame_delay_us = 1000000 / target_fps;
+    frame_scheduler_init(PIN_TE);
+    if (PIN_TE >= 0) ILI9341_SetTearingEffect(&tft, true);
     
     while (1) {
-        absolute_time_t frame_start = get_absolute_time();
+        // Спим до новых данных, кнопки или срока кадра
+        frame_scheduler_sleep();
         
-        // Обработка новых данных
-        if (multicore_fifo_rvalid()) {
-            uint8_t buf_idx = multicore_fifo_pop_blocking();
-            buffer_process(buf_idx);
+        // Прерывание DMA опубликовало новый кадр
+        if (frame_queue_pending(&global_buffer.frame_queue)) {
+            frame_scheduler_request_redraw();
         }
         
-        // Рендеринг
-        render_frame();
+        // Снимок экрана уходит в тот же CDC: пока он передаётся, очередь
+        // потока не выталкивается (её кадры выбрасываются), а кадр на
+        // панели не меняется. Захват и длинная запись продолжаются
+        if (screenshot_active()) {
+            scpi_remote_poll();
+            continue;
+        }
+        usb_stream_service();
+        
+        // Удалённые команды: после изменений по ним - новый кадр
+        if (scpi_remote_poll()) frame_scheduler_request_redraw();
+        settings_task();
+        calibration_flash_task();
+#if PERF_ENABLED
+        // Отчёт в stdio идёт в тот же CDC - не во время потока
+        if (!usb_stream_enabled()) perf_dump_task();
+#endif
         
         // Обработка UI
         process_buttons();
         
-        // Поддержание FPS
-        busy_wait_until(frame_start + frame_delay_us);
+        if (!frame_scheduler_frame_due()) continue;
+        
+        // Очередь отдаёт только самый свежий кадр, устаревшие уже выброшены
+        uint32_t frame_start = time_us_32();
+        PERF_TIMER(frame_cycles);
+        buffer_process();
+        
+        // Каждый новый показанный кадр сжимается в историю (~100 мкс на кадр).
+        // В историю идёт захват, не трасса математического канала и не
+        // пары входов XY
+        if (!global_buffer.hold && !global_buffer.xy_mode &&
+            global_buffer.display_sequence != recorded_sequence) {
+            uint16_t count;
+            const uint16_t* samples = buffer_get_raw(&count);
+            PERF_TIMER(history_start);
+            history_record(samples, count, global_buffer.display_sequence);
+            PERF_RECORD(PERF_HISTORY, history_start);
+            recorded_sequence = global_buffer.display_sequence;
+        }
+        
+        // Рендеринг: передачу начинаем по TE, если он подключён
+        frame_scheduler_wait_vsync();
+        render_frame();
+        PERF_RECORD(PERF_FRAME, frame_cycles);
+        PERF_COUNT(PERF_CNT_FRAMES);
+        
+#if PERF_ENABLED
+        // Задержка до экрана: один раз на каждый новый показанный кадр
+        if (global_buffer.display_sequence != latency_sequence) {
+            PERF_VALUE(PERF_LATENCY, time_us_32() - global_buffer.display_timestamp_us);
+            latency_sequence = global_buffer.display_sequence;
+        }
+#endif
+        
+        frame_scheduler_frame_done(time_us_32() - frame_start);
     }
 }
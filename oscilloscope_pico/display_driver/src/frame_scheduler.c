@@ -0,0 +1,100 @@
+#include "display_driver/frame_scheduler.h"
+#include "pico/stdlib.h"
+#include "pico/time.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+
+static int te_gpio = -1;
+static volatile uint32_t te_edges = 0;
+static volatile bool redraw_requested = true; // Первый кадр рисуем сразу
+
+static uint32_t frame_cost_us = PANEL_PERIOD_US;     // Сглаженная стоимость кадра
+static uint32_t frame_interval_us = PANEL_PERIOD_US;
+static absolute_time_t next_frame_time = 0;
+static uint32_t vsync_wait_us = 0;                   // Ожидание TE в текущем кадре
+
+static void te_irq_handler(void) {
+    if (gpio_get_irq_event_mask(te_gpio) & GPIO_IRQ_EDGE_RISE) {
+        gpio_acknowledge_irq(te_gpio, GPIO_IRQ_EDGE_RISE);
+        te_edges++;
+        __sev();
+    }
+}
+
+void frame_scheduler_init(int te_pin) {
+    te_gpio = te_pin;
+    redraw_requested = true;
+    frame_cost_us = PANEL_PERIOD_US;
+    frame_interval_us = PANEL_PERIOD_US;
+    vsync_wait_us = 0;
+    next_frame_time = get_absolute_time();
+
+    if (te_gpio >= 0) {
+        gpio_init(te_gpio);
+        gpio_set_dir(te_gpio, GPIO_IN);
+        // Свой обработчик на вывод: общий callback GPIO остаётся свободным
+        gpio_add_raw_irq_handler(te_gpio, te_irq_handler);
+        gpio_set_irq_enabled(te_gpio, GPIO_IRQ_EDGE_RISE, true);
+        irq_set_enabled(IO_IRQ_BANK0, true);
+    }
+}
+
+void frame_scheduler_request_redraw(void) {
+    redraw_requested = true;
+}
+
+bool frame_scheduler_frame_due(void) {
+    return redraw_requested &&
+           absolute_time_diff_us(next_frame_time, get_absolute_time()) >= 0;
+}
+
+void frame_scheduler_sleep(void) {
+    if (frame_scheduler_frame_due()) return;
+
+    absolute_time_t wake = make_timeout_time_us(FRAME_POLL_US);
+    if (redraw_requested && absolute_time_diff_us(next_frame_time, wake) > 0) {
+        wake = next_frame_time;
+    }
+    // Просыпаемся по SEV (FIFO ядра захвата, TE) или по таймеру
+    best_effort_wfe_or_timeout(wake);
+}
+
+void frame_scheduler_wait_vsync(void) {
+    if (te_gpio < 0) return;
+
+    uint32_t seen = te_edges;
+    uint32_t start = time_us_32();
+    absolute_time_t timeout = make_timeout_time_us(PANEL_PERIOD_US + PANEL_PERIOD_US / 4);
+    while (te_edges == seen) {
+        if (best_effort_wfe_or_timeout(timeout)) break; // TE не пришёл - не ждём дальше
+    }
+    vsync_wait_us += time_us_32() - start;
+}
+
+void frame_scheduler_frame_done(uint32_t render_us) {
+    // Ожидание TE - не стоимость кадра: иначе дешёвый кадр, пропустивший
+    // фронт, выглядит дорогим, интервал растёт до двух периодов и кадр
+    // снова попадает на ту же фазу TE
+    uint32_t cost_us = render_us > vsync_wait_us ? render_us - vsync_wait_us : 0;
+    vsync_wait_us = 0;
+
+    // Экспоненциальное сглаживание (1/8), чтобы единичный долгий кадр
+    // не сбивал темп
+    frame_cost_us = frame_cost_us - (frame_cost_us >> 3) + (cost_us >> 3);
+
+    // Интервал - целое число периодов панели, но не меньше стоимости кадра
+    uint32_t periods = (frame_cost_us + PANEL_PERIOD_US - 1) / PANEL_PERIOD_US;
+    if (periods == 0) periods = 1;
+    frame_interval_us = periods * PANEL_PERIOD_US;
+
+    // Отсчёт от начала отрисованного кадра
+    absolute_time_t now = get_absolute_time();
+    next_frame_time = render_us < frame_interval_us
+                    ? delayed_by_us(now, frame_interval_us - render_us)
+                    : now;
+    redraw_requested = false;
+}
+
+uint32_t frame_scheduler_get_interval_us(void) {
+    return frame_interval_us;
+}
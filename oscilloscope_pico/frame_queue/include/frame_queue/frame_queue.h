@@ -0,0 +1,106 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+// Очередь кадров между ядром захвата (один производитель, прерывание DMA)
+// и ядром дисплея (один потребитель) поверх пула из FRAME_QUEUE_SLOTS блоков.
+//
+// Без блокировок и без атомарных read-modify-write (их нет на Cortex-M0+):
+// каждое разделяемое слово пишет только одна сторона. Производитель
+// публикует заполненный слот, потребитель объявляет слот, который читает.
+// Порядок "запись - барьер - чтение" с обеих сторон (как в алгоритме Деккера)
+// гарантирует, что производитель никогда не выберет для записи слот,
+// который потребитель уже начал читать.
+//
+// Семантика "выбрасываем старое": производитель всегда пишет дальше,
+// непрочитанный опубликованный кадр просто заменяется более свежим, а
+// потребитель получает только последний и видит пропуски по sequence.
+//
+// Пул со счётчиками ссылок: потребитель может закрепить захваченный блок
+// (отображение, удержание, история, анализ) и держать его сколько угодно,
+// захват при этом продолжается в свободные блоки. Счётчики меняет только
+// ядро дисплея, производитель их лишь читает. Если свободных блоков не
+// осталось, новый захват выбрасывается и DMA пишет в тот же блок повторно.
+
+#ifndef FRAME_QUEUE_SLOTS
+#define FRAME_QUEUE_SLOTS 6 // 3 для очереди + закреплённые блоки
+#endif
+#define FRAME_QUEUE_NONE  0xFF
+
+// Метаданные кадра, записываются производителем до публикации
+typedef struct {
+    uint32_t sequence;      // Сквозной номер захвата (с 1)
+    uint32_t timestamp_us;  // Время окончания захвата
+    uint16_t length;        // Число отсчётов
+    int16_t trigger_index;  // Отсчёт срабатывания триггера или -1
+} FrameMeta;
+
+// Счётчики пула
+typedef struct {
+    uint32_t published;     // Опубликовано кадров
+    uint32_t dropped;       // Опубликованы, но вытеснены до захвата потребителем
+    uint32_t exhausted;     // Выброшены производителем: все блоки заняты
+    uint8_t pinned;         // Закреплено блоков сейчас
+} FrameQueueStats;
+
+typedef struct {
+    FrameMeta meta[FRAME_QUEUE_SLOTS];
+
+    // Пишет только производитель: (sequence << 8) | slot
+    _Atomic uint32_t published;
+    // Пишет только потребитель: слот, который сейчас читается, или NONE
+    _Atomic uint32_t claimed;
+    // Пишет только потребитель: число закреплений каждого блока
+    _Atomic uint8_t refcount[FRAME_QUEUE_SLOTS];
+
+    // Состояние производителя
+    uint8_t write_slot;
+    uint8_t next_slot;      // Зарезервирован для следующей записи
+    bool reserved;
+    uint32_t next_sequence;
+    volatile uint32_t exhausted;
+
+    // Состояние потребителя
+    uint8_t held_slot;
+    uint32_t last_sequence;
+    uint32_t dropped;       // Кадры, которые потребитель не успел забрать
+} FrameQueue;
+
+void frame_queue_init(FrameQueue *q);
+
+// Производитель: слот, в который сейчас идёт запись
+uint8_t frame_queue_write_slot(const FrameQueue *q);
+
+// Производитель: выбор слота для следующей записи до публикации текущего,
+// чтобы сразу перенаправить DMA, а заполненный слот обработать потом.
+// Если свободных нет, возвращается текущий слот (кадр будет выброшен)
+uint8_t frame_queue_reserve(FrameQueue *q);
+
+// Производитель: публикация заполненного слота (sequence назначается здесь).
+// Возвращает слот для следующей записи - он гарантированно не читается и
+// не закреплён. Если свободных нет, кадр не публикуется и возвращается
+// тот же слот
+uint8_t frame_queue_publish(FrameQueue *q, uint32_t timestamp_us,
+                            uint16_t length, int16_t trigger_index);
+
+// Потребитель: есть ли опубликованный кадр, который ещё не забирали
+bool frame_queue_pending(const FrameQueue *q);
+
+// Потребитель: захват самого свежего кадра. Предыдущий захваченный слот
+// освобождается. false - нового кадра нет (ничего не меняется)
+bool frame_queue_acquire(FrameQueue *q, uint8_t *slot, FrameMeta *meta);
+
+// Потребитель: освобождение захваченного слота
+void frame_queue_release(FrameQueue *q);
+
+// Потребитель: закрепление блока. Допустимо только для захваченного
+// (до frame_queue_release) или уже закреплённого блока
+void frame_queue_pin(FrameQueue *q, uint8_t slot);
+void frame_queue_unpin(FrameQueue *q, uint8_t slot);
+
+// Метаданные закреплённого или захваченного блока. Производитель может
+// читать метаданные только что опубликованного слота
+const FrameMeta *frame_queue_meta(const FrameQueue *q, uint8_t slot);
+
+void frame_queue_get_stats(const FrameQueue *q, FrameQueueStats *stats);
@@ -0,0 +1,164 @@
+#include "frame_queue/frame_queue.h"
+#include <string.h>
+
+#define PACK(seq, slot)   (((seq) << 8) | (slot))
+#define SLOT_OF(word)     ((uint8_t)((word) & 0xFF))
+#define SEQ_OF(word)      ((word) >> 8)
+
+// Функции производителя вызываются из прерывания DMA, которое продолжает
+// работать во время записи во flash: на прошивке они размещаются в RAM
+#if FRAME_QUEUE_IN_RAM
+#define PRODUCER_FUNC(name) __attribute__((noinline, section(".time_critical." #name))) name
+#else
+#define PRODUCER_FUNC(name) name
+#endif
+
+void frame_queue_init(FrameQueue *q) {
+    memset(q->meta, 0, sizeof(q->meta));
+    atomic_store_explicit(&q->published, PACK(0u, FRAME_QUEUE_NONE), memory_order_relaxed);
+    atomic_store_explicit(&q->claimed, FRAME_QUEUE_NONE, memory_order_relaxed);
+    for (int i = 0; i < FRAME_QUEUE_SLOTS; i++) {
+        atomic_store_explicit(&q->refcount[i], 0, memory_order_relaxed);
+    }
+    q->write_slot = 0;
+    q->next_slot = 0;
+    q->reserved = false;
+    q->next_sequence = 1;
+    q->exhausted = 0;
+    q->held_slot = FRAME_QUEUE_NONE;
+    q->last_sequence = 0;
+    q->dropped = 0;
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+uint8_t PRODUCER_FUNC(frame_queue_write_slot)(const FrameQueue *q) {
+    return q->write_slot;
+}
+
+uint8_t PRODUCER_FUNC(frame_queue_reserve)(FrameQueue *q) {
+    uint8_t filled = q->write_slot;
+    if (q->reserved) return q->next_slot;
+
+    uint8_t shown = SLOT_OF(atomic_load_explicit(&q->published, memory_order_relaxed));
+
+    // Барьер запись-чтение: предыдущая публикация упорядочена до чтения
+    // объявления потребителя. Либо мы увидим его объявление, либо он
+    // увидит нашу публикацию и повторит захват
+    atomic_thread_fence(memory_order_seq_cst);
+    uint8_t busy = (uint8_t)atomic_load_explicit(&q->claimed, memory_order_acquire);
+
+    // Следующий блок: не заполненный, не опубликованный (его могут вот-вот
+    // захватить), не читаемый и не закреплённый
+    uint8_t next = FRAME_QUEUE_NONE;
+    for (uint8_t i = 1; i < FRAME_QUEUE_SLOTS; i++) {
+        uint8_t candidate = (filled + i) % FRAME_QUEUE_SLOTS;
+        if (candidate == shown || candidate == busy) continue;
+        if (atomic_load_explicit(&q->refcount[candidate], memory_order_relaxed)) continue;
+        next = candidate;
+        break;
+    }
+
+    // Между резервированием и публикацией потребитель может захватить
+    // только текущий опубликованный слот, а он уже исключён
+    q->next_slot = next == FRAME_QUEUE_NONE ? filled : next;
+    q->reserved = true;
+    return q->next_slot;
+}
+
+uint8_t PRODUCER_FUNC(frame_queue_publish)(FrameQueue *q, uint32_t timestamp_us,
+                                           uint16_t length, int16_t trigger_index) {
+    uint8_t filled = q->write_slot;
+    uint8_t next = frame_queue_reserve(q);
+    q->reserved = false;
+
+    if (next == filled) {
+        // Пул исчерпан: кадр никто не видел, пишем в него же
+        q->exhausted++;
+        return filled;
+    }
+
+    uint32_t seq = q->next_sequence++;
+    FrameMeta *m = &q->meta[filled];
+    m->sequence = seq;
+    m->timestamp_us = timestamp_us;
+    m->length = length;
+    m->trigger_index = trigger_index;
+
+    // release: данные и метаданные слота видны раньше, чем сама публикация
+    atomic_store_explicit(&q->published, PACK(seq, filled), memory_order_release);
+
+    q->write_slot = next;
+    return next;
+}
+
+bool frame_queue_pending(const FrameQueue *q) {
+    uint32_t word = atomic_load_explicit(&((FrameQueue *)q)->published, memory_order_relaxed);
+    return SLOT_OF(word) != FRAME_QUEUE_NONE && SEQ_OF(word) != (q->last_sequence & 0x00FFFFFF);
+}
+
+bool frame_queue_acquire(FrameQueue *q, uint8_t *slot, FrameMeta *meta) {
+    uint32_t word;
+
+    for (;;) {
+        word = atomic_load_explicit(&q->published, memory_order_acquire);
+        uint8_t s = SLOT_OF(word);
+        if (s == FRAME_QUEUE_NONE || SEQ_OF(word) == (q->last_sequence & 0x00FFFFFF)) {
+            return false;
+        }
+
+        // Объявляем слот, затем проверяем, что он всё ещё последний
+        // опубликованный. Если производитель успел опубликовать новый,
+        // он мог выбрать наш слот для записи - пробуем ещё раз
+        atomic_store_explicit(&q->claimed, s, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        if (atomic_load_explicit(&q->published, memory_order_acquire) == word) break;
+    }
+
+    uint8_t s = SLOT_OF(word);
+    FrameMeta m = q->meta[s];
+
+    if (q->last_sequence && m.sequence > q->last_sequence + 1) {
+        q->dropped += m.sequence - q->last_sequence - 1;
+    }
+    q->last_sequence = m.sequence;
+    q->held_slot = s;
+
+    *slot = s;
+    if (meta) *meta = m;
+    return true;
+}
+
+void frame_queue_release(FrameQueue *q) {
+    q->held_slot = FRAME_QUEUE_NONE;
+    // release: закрепления блока видны производителю раньше снятия объявления
+    atomic_store_explicit(&q->claimed, FRAME_QUEUE_NONE, memory_order_release);
+}
+
+void frame_queue_pin(FrameQueue *q, uint8_t slot) {
+    uint8_t n = atomic_load_explicit(&q->refcount[slot], memory_order_relaxed);
+    if (n < 0xFF) atomic_store_explicit(&q->refcount[slot], n + 1, memory_order_relaxed);
+}
+
+void frame_queue_unpin(FrameQueue *q, uint8_t slot) {
+    uint8_t n = atomic_load_explicit(&q->refcount[slot], memory_order_relaxed);
+    // release: чтение блока завершено до того, как производитель его займёт
+    if (n) atomic_store_explicit(&q->refcount[slot], n - 1, memory_order_release);
+}
+
+// Вызывается и из прерывания DMA - тоже в RAM
+const FrameMeta *PRODUCER_FUNC(frame_queue_meta)(const FrameQueue *q, uint8_t slot) {
+    return &q->meta[slot];
+}
+
+void frame_queue_get_stats(const FrameQueue *q, FrameQueueStats *stats) {
+    uint32_t word = atomic_load_explicit(&((FrameQueue *)q)->published, memory_order_relaxed);
+    stats->published = SEQ_OF(word);
+    stats->dropped = q->dropped;
+    stats->exhausted = q->exhausted;
+    stats->pinned = 0;
+    for (int i = 0; i < FRAME_QUEUE_SLOTS; i++) {
+        if (atomic_load_explicit(&((FrameQueue *)q)->refcount[i], memory_order_relaxed)) {
+            stats->pinned++;
+        }
+    }
+}
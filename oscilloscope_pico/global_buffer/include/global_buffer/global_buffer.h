@@ -2,29 +2,47 @@
 #include <pico/stdlib.h>
 #include <pico/mutex.h>
 #include <pico/sync.h>
+#include "frame_queue/frame_queue.h"
 
 #define BUFFER_SIZE 320
-#define NUM_BUFFERS 2
+#define NUM_BUFFERS FRAME_QUEUE_SLOTS // Пул блоков захвата со счётчиками ссылок
+#define TRIGGER_PRETRIGGER 50 // Сколько отсчётов оставляем перед фронтом
 
 typedef struct {
-    volatile uint8_t read_buffer;
-    // volatile uint8_t processing_buffer;
-    volatile bool buffer_ready[NUM_BUFFERS];
     uint16_t adc_buffers[NUM_BUFFERS][BUFFER_SIZE];
-    volatile uint8_t write_buffer;  // Куда пишет ADC
-    volatile uint8_t display_buffer; // Что показываем на экране
-    volatile uint8_t processing_buffer; // Что обрабатываем
+    
+    // Очередь кадров: публикует прерывание DMA, забирает ядро дисплея
+    FrameQueue frame_queue;
+    
+    // Кадр для отображения: закреплённый блок пула (без копирования) и
+    // начало после синхронизации по триггеру. Только для ядра дисплея.
+    // В режиме удержания блок остаётся закреплённым, захват идёт в свободные
+    uint8_t display_slot;
+    uint16_t display_start;
+    uint16_t display_count;
+    int16_t display_trigger;       // Фронт от display_start, -1 - без синхронизации
+    uint32_t display_sequence;
+    uint32_t display_timestamp_us; // Время первого показанного отсчёта
+    
+    // Преобразованный кадр (математический канал): пишется в свободный
+    // из двух буферов, показанный не трогается до смены кадра
+    uint16_t transform_buffers[2][BUFFER_SIZE];
+    uint8_t transform_shown;       // Буфер показанного кадра
+    uint16_t transform_count;      // 0 - показывается сам захват
     
     // Добавляем флаг для "живого" обновления
     volatile bool live_update;
 
-    mutex_t buffer_mutex;
-    
     // Настройки
     uint32_t sample_rate;
     uint16_t trigger_level;
+    uint16_t trigger_hysteresis;  // Кодов АЦП, 0 - без гистерезиса
     bool trigger_enabled;
     bool trigger_edge; // 0 - falling, 1 - rising
+    bool trigger_any_edge;      // Срабатывание по любому фронту
+    bool trigger_auto;          // Без синхронизации показываем кадр как есть
+    bool trigger_single;        // Однократный запуск
+    volatile bool single_armed; // Ожидание кадра в однократном режиме
     
     // Измерения
     uint16_t max_value;
@@ -41,15 +59,39 @@ typedef struct {
     // Состояние
     bool hold;
     bool running;
+    volatile bool persistence; // Режим цифрового послесвечения
+    volatile bool xy_mode;     // Входы A и B поочерёдно, вывод XY (xy/xy.h)
+    
+    // Запись во flash с ядра дисплея: ядро захвата уходит в цикл в RAM,
+    // прерывание DMA (тоже в RAM) продолжает публиковать кадры
+    volatile bool flash_park_request;
+    volatile bool flash_parked;
 
 } GlobalBuffer;
 
 extern GlobalBuffer global_buffer;
 
-uint16_t* buffer_get_current();
-void buffer_init(); 
+// Показанная трасса: преобразованная, если задано преобразование
+const uint16_t* buffer_get_current(uint16_t* count);
+// Захваченные отсчёты показанного кадра, без преобразования
+const uint16_t* buffer_get_raw(uint16_t* count);
+
+// Обработчик каждого блока на ядре захвата: сырые отсчёты до поиска
+// триггера (поток, длинная запись, автоустановка). Его не задерживает
+// вывод кадра на панель, пропуски бывают только у самого ядра захвата.
+// buffer_capture_block вызывает цикл ядра захвата
+typedef void (*BufferFrameHook)(const uint16_t* samples, const FrameMeta* meta);
+void buffer_set_capture_hook(BufferFrameHook hook);
+void buffer_capture_block(const uint16_t* samples, const FrameMeta* meta);
+
+// Преобразование синхронизированного блока в новую трассу (математический
+// канал): отсчёты samples[start..length) в out. Возвращает их число,
+// 0 - показывать сам захват. Трасса заменяет канал в измерениях и на экране
+typedef uint16_t (*BufferTransform)(const uint16_t* samples, uint16_t start,
+                                    const FrameMeta* meta, uint16_t* out);
+void buffer_set_transform(BufferTransform transform);
 void buffer_init();
-void buffer_swap();
-void buffer_process();
-void buffer_update_stats();
-bool check_trigger(uint16_t* buffer);
\ No newline at end of file
+bool buffer_process();
+void buffer_update_stats(const uint16_t* buffer, uint16_t count);
+bool check_trigger(const uint16_t* buffer, uint16_t* start);
+int buffer_find_trigger(const uint16_t* buffer);
\ No newline at end of file
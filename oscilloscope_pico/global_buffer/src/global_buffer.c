@@ -1,39 +1,74 @@
 #include "global_buffer/global_buffer.h"
+#include "perf/perf.h"
 #include <pico/stdlib.h>
-#include <pico/mutex.h>
 #include <string.h>
 #include <math.h>
 
 GlobalBuffer global_buffer;
 
-uint16_t* buffer_get_current() {
-    mutex_enter_blocking(&global_buffer.buffer_mutex);
-    uint16_t* buf = global_buffer.adc_buffers[global_buffer.read_buffer];
-    mutex_exit(&global_buffer.buffer_mutex);
-    return buf;
+static BufferFrameHook volatile capture_hook = NULL;
+static BufferTransform transform = NULL;
+
+void buffer_set_capture_hook(BufferFrameHook hook) {
+    capture_hook = hook;
+}
+
+void buffer_capture_block(const uint16_t* samples, const FrameMeta* meta) {
+    BufferFrameHook hook = capture_hook;
+    if (hook) hook(samples, meta);
+}
+
+// Без преобразования показывается сам захват, в том числе уже
+// закреплённого кадра
+void buffer_set_transform(BufferTransform fn) {
+    transform = fn;
+    if (!fn) global_buffer.transform_count = 0;
+}
+
+// Последний кадр для отображения (только для ядра дисплея).
+// NULL, пока не было ни одного синхронизированного захвата
+const uint16_t* buffer_get_current(uint16_t* count) {
+    if (global_buffer.display_slot != FRAME_QUEUE_NONE && global_buffer.transform_count) {
+        *count = global_buffer.transform_count;
+        return global_buffer.transform_buffers[global_buffer.transform_shown];
+    }
+    return buffer_get_raw(count);
+}
+
+const uint16_t* buffer_get_raw(uint16_t* count) {
+    if (global_buffer.display_slot == FRAME_QUEUE_NONE) {
+        *count = 0;
+        return NULL;
+    }
+    *count = global_buffer.display_count;
+    return &global_buffer.adc_buffers[global_buffer.display_slot][global_buffer.display_start];
 }
 
 void buffer_init() {
-    mutex_init(&global_buffer.buffer_mutex);
-    
     // Инициализация буферов
     memset(global_buffer.adc_buffers, 0, sizeof(global_buffer.adc_buffers));
+    global_buffer.display_slot = FRAME_QUEUE_NONE;
+    global_buffer.display_start = 0;
+    global_buffer.display_count = 0;
+    global_buffer.display_trigger = -1;
+    global_buffer.display_sequence = 0;
+    global_buffer.display_timestamp_us = 0;
+    global_buffer.transform_shown = 0;
+    global_buffer.transform_count = 0;
     
-    // Инициализация указателей
-    global_buffer.write_buffer = 0;
-    global_buffer.read_buffer = 0;
-    global_buffer.processing_buffer = 0;
-    
-    // Флаги готовности
-    for (int i = 0; i < NUM_BUFFERS; i++) {
-        global_buffer.buffer_ready[i] = false;
-    }
+    // Очередь кадров: DMA начинает со слота 0
+    frame_queue_init(&global_buffer.frame_queue);
     
     // Настройки по умолчанию
     global_buffer.sample_rate = 500000; // 500 kHz
     global_buffer.trigger_level = 2048;  // Среднее значение (1.65V)
+    global_buffer.trigger_hysteresis = 0;
     global_buffer.trigger_enabled = true;
     global_buffer.trigger_edge = true;   // По фронту
+    global_buffer.trigger_any_edge = false;
+    global_buffer.trigger_auto = false;
+    global_buffer.trigger_single = false;
+    global_buffer.single_armed = false;
     
     // Масштабирование
     global_buffer.time_scale = 1.0f;    // 1ms/div
@@ -50,51 +85,96 @@ void buffer_init() {
     // Состояние
     global_buffer.hold = false;
     global_buffer.running = false;
+    global_buffer.persistence = false;
+    global_buffer.xy_mode = false;
+    global_buffer.flash_park_request = false;
+    global_buffer.flash_parked = false;
 }
 
-
-void buffer_swap() {
-    mutex_enter_blocking(&global_buffer.buffer_mutex);
-    
-    // Находим следующий готовый буфер для обработки
-    uint8_t next_buffer = (global_buffer.processing_buffer + 1) % NUM_BUFFERS;
-    while (next_buffer != global_buffer.processing_buffer) {
-        if (global_buffer.buffer_ready[next_buffer]) {
-            global_buffer.processing_buffer = next_buffer;
-            break;
-        }
-        next_buffer = (next_buffer + 1) % NUM_BUFFERS;
-    }
-    
-    mutex_exit(&global_buffer.buffer_mutex);
-}
-
-void buffer_process() {
-    if (!global_buffer.buffer_ready[global_buffer.processing_buffer]) {
-        return;
+// Обработка самого свежего опубликованного кадра на ядре дисплея.
+// Слот читается на месте, для отображения он закрепляется вместо копирования.
+// Возвращает false, если нового кадра не было
+bool buffer_process() {
+    uint8_t slot;
+    FrameMeta meta;
+    if (!frame_queue_acquire(&global_buffer.frame_queue, &slot, &meta)) {
+        return false;
     }
     
-    mutex_enter_blocking(&global_buffer.buffer_mutex);
+    const uint16_t* samples = global_buffer.adc_buffers[slot];
+    uint16_t start = 0;
     
-    // Проверка триггера
-    bool trigger_ok = !global_buffer.trigger_enabled || 
-                     check_trigger(global_buffer.adc_buffers[global_buffer.processing_buffer]);
-    
-    if (trigger_ok) {
+    // Проверка триггера. В автоматическом режиме кадр без синхронизации
+    // тоже показывается
+    PERF_TIMER(trigger_start);
+    bool triggered = check_trigger(samples, &start);
+    PERF_RECORD(PERF_TRIGGER, trigger_start);
+    PERF_COUNT(triggered ? PERF_CNT_TRIGGERED : PERF_CNT_UNTRIGGERED);
+    if (triggered || global_buffer.trigger_auto) {
+        // Математический канал: трасса из показанной части блока
+        // в свободный буфер, измерения - по ней
+        uint8_t spare = global_buffer.transform_shown ^ 1;
+        uint16_t transformed = 0;
+        if (transform) {
+            PERF_TIMER(math_start);
+            transformed = transform(samples, start, &meta, global_buffer.transform_buffers[spare]);
+            PERF_RECORD(PERF_MATH, math_start);
+        }
+        
         // Обновление статистики
-        buffer_update_stats(global_buffer.adc_buffers[global_buffer.processing_buffer]);
+        PERF_TIMER(stats_start);
+        if (transformed) {
+            buffer_update_stats(global_buffer.transform_buffers[spare], transformed);
+        } else {
+            buffer_update_stats(samples, meta.length);
+        }
+        PERF_RECORD(PERF_STATS, stats_start);
         
-        // Если не в режиме удержания, обновляем буфер для отображения
-        if (!global_buffer.hold) {
-            global_buffer.read_buffer = global_buffer.processing_buffer;
+        // Однократный режим: только первый синхронизированный кадр после
+        // взвода, затем удержание
+        bool update = !global_buffer.hold;
+        if (global_buffer.trigger_single) {
+            update = update && triggered && global_buffer.single_armed;
+        }
+        
+        // Если не в режиме удержания, закрепляем новый блок для отображения
+        // и отпускаем предыдущий
+        if (update) {
+            frame_queue_pin(&global_buffer.frame_queue, slot);
+            if (global_buffer.display_slot != FRAME_QUEUE_NONE) {
+                frame_queue_unpin(&global_buffer.frame_queue, global_buffer.display_slot);
+            }
+            global_buffer.display_slot = slot;
+            global_buffer.display_start = start;
+            global_buffer.display_count = meta.length - start;
+            // Фронт в первых TRIGGER_PRETRIGGER отсчётах ищется ещё раз,
+            // это короткий проход
+            global_buffer.display_trigger = -1;
+            if (triggered && global_buffer.trigger_enabled) {
+                global_buffer.display_trigger = start ? TRIGGER_PRETRIGGER :
+                                                (int16_t)buffer_find_trigger(samples);
+            }
+            global_buffer.display_sequence = meta.sequence;
+            global_buffer.transform_count = transformed;
+            if (transformed) global_buffer.transform_shown = spare;
+            // Метка времени - конец блока, отсчитываем назад до start
+            global_buffer.display_timestamp_us = meta.timestamp_us -
+                (uint32_t)((uint64_t)(meta.length - start) * 1000000 / global_buffer.sample_rate);
+            
+            if (global_buffer.trigger_single) {
+                global_buffer.single_armed = false;
+                global_buffer.hold = true;
+            }
         }
     }
     
-    global_buffer.buffer_ready[global_buffer.processing_buffer] = false;
-    mutex_exit(&global_buffer.buffer_mutex);
+    frame_queue_release(&global_buffer.frame_queue);
+    return true;
 }
 
-    void buffer_update_stats(uint16_t* buffer) {
+// Измерения по count отсчётам: захват целиком или трасса математического канала
+void buffer_update_stats(const uint16_t* buffer, uint16_t count) {
+    if (count == 0) return;
     uint16_t min_val = 4095;
     uint16_t max_val = 0;
     uint32_t sum = 0;
@@ -103,7 +183,7 @@ void buffer_process() {
     uint32_t high_samples = 0;
     
     // Первый проход: базовые измерения
-    for (int i = 0; i < BUFFER_SIZE; i++) {
+    for (int i = 0; i < count; i++) {
         if (buffer[i] < min_val) min_val = buffer[i];
         if (buffer[i] > max_val) max_val = buffer[i];
         sum += buffer[i];
@@ -126,9 +206,9 @@ void buffer_process() {
     
     // Расчёт частоты и скважности (если есть достаточное количество пересечений)
     if (zero_crossings >= 2) {
-        float avg_period = (BUFFER_SIZE * 2.0f) / zero_crossings;
+        float avg_period = (count * 2.0f) / zero_crossings;
         global_buffer.frequency = (uint16_t)(global_buffer.sample_rate / avg_period);
-        global_buffer.duty_cycle = (high_samples * 100.0f) / BUFFER_SIZE;
+        global_buffer.duty_cycle = (high_samples * 100.0f) / count;
     } else {
         global_buffer.frequency = 0;
         global_buffer.duty_cycle = 0.0f;
@@ -140,7 +220,7 @@ void buffer_process() {
         int first_cross = -1, last_cross = -1;
         int crosses = 0;
         
-        for (int i = 1; i < BUFFER_SIZE; i++) {
+        for (int i = 1; i < count; i++) {
             bool prev_state = buffer[i-1] > global_buffer.trigger_level;
             bool curr_state = buffer[i] > global_buffer.trigger_level;
             
@@ -158,57 +238,82 @@ void buffer_process() {
     }
 }
 
-bool check_trigger(uint16_t* buffer) {
-    if (!global_buffer.trigger_enabled) return true;
+// Фронт с гистерезисом: пересечение уровня засчитывается, только если
+// перед ним сигнал уходил за level -/+ hysteresis. Шум у уровня не даёт
+// ложных срабатываний на пологом участке
+static int find_trigger_hysteresis(const uint16_t* buffer, uint16_t level, uint16_t hysteresis) {
+    bool rising = global_buffer.trigger_any_edge || global_buffer.trigger_edge;
+    bool falling = global_buffer.trigger_any_edge || !global_buffer.trigger_edge;
+    int low = (int)level - hysteresis;
+    int high = (int)level + hysteresis;
+    bool armed_rise = false, armed_fall = false;
     
-    for (int i = 1; i < BUFFER_SIZE; i++) {
-        if (global_buffer.trigger_edge) {
-            // Rising edge trigger
-            if (buffer[i-1] < global_buffer.trigger_level && 
-                buffer[i] >= global_buffer.trigger_level) {
-                // Найден фронт, можно сдвинуть буфер для точного позиционирования
-                if (i > 50) { // Оставляем немного места перед фронтом
-                    memmove(buffer, &buffer[i-50], (BUFFER_SIZE - (i-50)) * sizeof(uint16_t));
-                }
-                return true;
-            }
-        } else {
-            // Falling edge trigger
-            if (buffer[i-1] > global_buffer.trigger_level && 
-                buffer[i] <= global_buffer.trigger_level) {
-                if (i > 50) {
-                    memmove(buffer, &buffer[i-50], (BUFFER_SIZE - (i-50)) * sizeof(uint16_t));
-                }
-                return true;
-            }
+    for (int i = 0; i < BUFFER_SIZE; i++) {
+        int v = buffer[i];
+        if (v < low) armed_rise = rising;
+        else if (armed_rise && v >= level) return i;
+        if (v > high) armed_fall = falling;
+        else if (armed_fall && v <= level) return i;
+    }
+    return -1;
+}
+
+// Поиск фронта без изменения буфера (безопасно вызывать с любого ядра).
+// Возвращает индекс отсчёта, на котором сработал триггер, или -1
+int buffer_find_trigger(const uint16_t* buffer) {
+    uint16_t level = global_buffer.trigger_level;
+    uint16_t hysteresis = global_buffer.trigger_hysteresis;
+    if (hysteresis) return find_trigger_hysteresis(buffer, level, hysteresis);
+    
+    if (global_buffer.trigger_any_edge) {
+        for (int i = 1; i < BUFFER_SIZE; i++) {
+            if ((buffer[i-1] < level) != (buffer[i] < level)) return i;
+        }
+    } else if (global_buffer.trigger_edge) {
+        // Rising edge trigger
+        for (int i = 1; i < BUFFER_SIZE; i++) {
+            if (buffer[i-1] < level && buffer[i] >= level) return i;
+        }
+    } else {
+        // Falling edge trigger
+        for (int i = 1; i < BUFFER_SIZE; i++) {
+            if (buffer[i-1] > level && buffer[i] <= level) return i;
         }
     }
-    return false;
+    return -1;
+}
+
+// Проверка триггера без изменения буфера: в start - первый отсчёт для
+// отображения (с запасом TRIGGER_PRETRIGGER перед фронтом)
+bool check_trigger(const uint16_t* buffer, uint16_t* start) {
+    *start = 0;
+    if (!global_buffer.trigger_enabled) return true;
+    
+    int i = buffer_find_trigger(buffer);
+    if (i < 0) return false;
+    
+    if (i > TRIGGER_PRETRIGGER) { // Оставляем немного места перед фронтом
+        *start = i - TRIGGER_PRETRIGGER;
+    }
+    return true;
 }
 
+// Настройки меняет только ядро дисплея, ядро захвата их лишь читает
 void buffer_set_sample_rate(uint32_t rate) {
-    mutex_enter_blocking(&global_buffer.buffer_mutex);
     global_buffer.sample_rate = rate;
-    mutex_exit(&global_buffer.buffer_mutex);
 }
 
 void buffer_set_trigger(uint16_t level, bool enabled, bool edge) {
-    mutex_enter_blocking(&global_buffer.buffer_mutex);
     global_buffer.trigger_level = level;
     global_buffer.trigger_enabled = enabled;
     global_buffer.trigger_edge = edge;
-    mutex_exit(&global_buffer.buffer_mutex);
 }
 
 void buffer_set_scale(float time_scale, float voltage_scale) {
-    mutex_enter_blocking(&global_buffer.buffer_mutex);
     global_buffer.time_scale = time_scale;
     global_buffer.voltage_scale = voltage_scale;
-    mutex_exit(&global_buffer.buffer_mutex);
 }
 
 void buffer_set_hold(bool hold) {
-    mutex_enter_blocking(&global_buffer.buffer_mutex);
     global_buffer.hold = hold;
-    mutex_exit(&global_buffer.buffer_mutex);
 }
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+// История осциллограмм: последние кадры хранятся в кольце в сжатом виде
+// (wave_codec, без потерь). Самая старая запись вытесняется, когда новой
+// не хватает места в кольце или в индексе. Все функции вызываются с
+// ядра дисплея.
+//
+// Размер - по бюджету RAM (host_sim/CMakeLists.txt). Кадров по 320 отсчётов
+// (osc_bench, история): синус 2 В с шумом в код АЦП - 91 (2.1:1), синус
+// 7 кГц - 57, меандр с шумом в код - 139, постоянный уровень с таким же
+// шумом - 182. Больше всего записей даёт меандр без шума - 213, индекс
+// рассчитан на него.
+#define HISTORY_BYTES        20480
+#define HISTORY_MAX_RECORDS  224
+
+typedef struct {
+    uint16_t records;         // Кадров в истории сейчас
+    uint16_t bytes_used;      // Занято байт кольца
+    uint32_t recorded;        // Записано кадров с последней очистки
+    uint32_t raw_bytes;       // Их размер при 12 битах на отсчёт
+    uint32_t encoded_bytes;   // И после сжатия
+    uint32_t encode_us_last;  // Время кодирования последнего кадра
+    uint32_t encode_us_max;
+    uint32_t encode_us_total;
+} HistoryStats;
+
+void history_init(void);
+void history_clear(void);
+
+// Запись кадра. false - кадр длиннее BUFFER_SIZE или пустой
+bool history_record(const uint16_t *samples, uint16_t count, uint32_t sequence);
+
+// Количество кадров в истории
+uint16_t history_count(void);
+
+// Восстановление кадра: age 0 - самый новый. Возвращает число отсчётов
+// (не больше BUFFER_SIZE) или 0, если такого кадра нет
+uint16_t history_load(uint16_t age, uint16_t *out, uint32_t *sequence);
+
+void history_get_stats(HistoryStats *stats);
@@ -0,0 +1,109 @@
+#include "history/history.h"
+#include "wave_codec/wave_codec.h"
+#include "global_buffer/global_buffer.h"
+#include <pico/stdlib.h>
+#include <string.h>
+
+typedef struct {
+    uint32_t sequence;
+    uint16_t offset;   // Начало в кольце
+    uint16_t size;     // Байт после сжатия
+    uint16_t count;    // Отсчётов
+} HistoryRecord;
+
+static uint8_t ring[HISTORY_BYTES];
+static HistoryRecord index_ring[HISTORY_MAX_RECORDS];
+static uint16_t oldest = 0;      // Индекс самой старой записи
+static uint16_t records = 0;
+static uint16_t write_pos = 0;   // Куда пойдёт следующая запись
+static uint16_t bytes_used = 0;
+
+// Кодер пишет сначала сюда: размер кадра заранее неизвестен
+static uint8_t scratch[WAVE_CODEC_MAX_BYTES(BUFFER_SIZE)];
+
+static HistoryStats stats;
+
+void history_init(void) {
+    history_clear();
+}
+
+void history_clear(void) {
+    oldest = 0;
+    records = 0;
+    write_pos = 0;
+    bytes_used = 0;
+    memset(&stats, 0, sizeof(stats));
+}
+
+uint16_t history_count(void) {
+    return records;
+}
+
+static void drop_oldest(void) {
+    bytes_used -= index_ring[oldest].size;
+    oldest = (oldest + 1) % HISTORY_MAX_RECORDS;
+    records--;
+}
+
+bool history_record(const uint16_t *samples, uint16_t count, uint32_t sequence) {
+    if (count == 0 || count > BUFFER_SIZE) return false;
+
+    uint32_t start = time_us_32();
+    uint16_t size = (uint16_t)wave_encode(samples, count, scratch, sizeof(scratch));
+    if (size == 0) return false;
+
+    if (records == 0) write_pos = 0;
+    if (records == HISTORY_MAX_RECORDS) drop_oldest();
+
+    // Запись не разрывается: если не влезает до конца кольца, идём в начало.
+    // Тогда самые старые записи - те, что лежат в хвосте за write_pos
+    uint16_t tail_from = HISTORY_BYTES;
+    if ((uint32_t)write_pos + size > HISTORY_BYTES) {
+        tail_from = write_pos;
+        write_pos = 0;
+    }
+
+    // Вытесняем по порядку возраста: хвост после переноса, затем всё,
+    // что пересекается с новой записью
+    while (records) {
+        const HistoryRecord *r = &index_ring[oldest];
+        bool in_tail = r->offset >= tail_from;
+        bool overlaps = r->offset < write_pos + size && r->offset + r->size > write_pos;
+        if (!in_tail && !overlaps) break;
+        drop_oldest();
+    }
+
+    memcpy(&ring[write_pos], scratch, size);
+
+    HistoryRecord *r = &index_ring[(oldest + records) % HISTORY_MAX_RECORDS];
+    r->sequence = sequence;
+    r->offset = write_pos;
+    r->size = size;
+    r->count = count;
+    records++;
+    bytes_used += size;
+    write_pos += size;
+
+    uint32_t elapsed = time_us_32() - start;
+    stats.recorded++;
+    stats.raw_bytes += (count * WAVE_CODEC_SAMPLE_BITS + 7) / 8;
+    stats.encoded_bytes += size;
+    stats.encode_us_last = elapsed;
+    stats.encode_us_total += elapsed;
+    if (elapsed > stats.encode_us_max) stats.encode_us_max = elapsed;
+    return true;
+}
+
+uint16_t history_load(uint16_t age, uint16_t *out, uint32_t *sequence) {
+    if (age >= records) return 0;
+
+    const HistoryRecord *r = &index_ring[(oldest + records - 1 - age) % HISTORY_MAX_RECORDS];
+    if (sequence) *sequence = r->sequence;
+    return wave_decode(&ring[r->offset], r->size, out, r->count);
+}
+
+void history_get_stats(HistoryStats *out) {
+    *out = stats;
+    out->records = records;
+    out->bytes_used = bytes_used;
+}
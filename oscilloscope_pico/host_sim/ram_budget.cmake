@@ -0,0 +1,43 @@
+# Проверка бюджета RAM: data + bss модулей прошивки в хостовой сборке.
+# Заглушки SDK и модель панели (src/sdk.c, src/panel.c) не считаются.
+#
+#   cmake -DSIZE=size -DBUDGET=байт -DOBJECTS=a.o;b.o -P ram_budget.cmake
+#
+# На хосте указатели по 8 байт, поэтому сумма немного больше, чем на
+# RP2040: проверка с запасом. Точный расход - карта памяти прошивки.
+
+execute_process(COMMAND ${SIZE} ${OBJECTS}
+                OUTPUT_VARIABLE table
+                RESULT_VARIABLE status)
+if (NOT status EQUAL 0)
+    message(FATAL_ERROR "${SIZE} failed")
+endif()
+
+string(REPLACE "\n" ";" lines "${table}")
+set(total 0)
+set(largest "")
+foreach (line IN LISTS lines)
+    # text data bss dec hex имя
+    if (line MATCHES "^ *[0-9]+[ \t]+([0-9]+)[ \t]+([0-9]+)[ \t]+[0-9]+[ \t]+[0-9a-f]+[ \t]+(.*)$")
+        math(EXPR bytes "${CMAKE_MATCH_1} + ${CMAKE_MATCH_2}")
+        set(file "${CMAKE_MATCH_3}")
+        if (file MATCHES "/src/(sdk|panel)\\.c\\.o$")
+            continue()
+        endif()
+        math(EXPR total "${total} + ${bytes}")
+        if (bytes GREATER 4096)
+            get_filename_component(name "${file}" NAME_WE)
+            list(APPEND largest "${name} ${bytes}")
+        endif()
+    endif()
+endforeach()
+
+foreach (entry IN LISTS largest)
+    message("  ${entry}")
+endforeach()
+math(EXPR spare "${BUDGET} - ${total}")
+message("RAM: ${total} of ${BUDGET} bytes, ${spare} spare")
+if (total GREATER BUDGET)
+    math(EXPR over "${total} - ${BUDGET}")
+    message(FATAL_ERROR "RAM budget exceeded by ${over} bytes")
+endif()
@@ -0,0 +1,15 @@
+#pragma once
+// Заглушка SDK для хостовой сборки (host_sim): только то, что использует прошивка
+#include <stdint.h>
+#include <stdbool.h>
+typedef struct { volatile uint32_t fifo; } adc_hw_t;
+extern adc_hw_t *const adc_hw;
+void adc_init(void);
+void adc_gpio_init(unsigned int gpio);
+void adc_select_input(unsigned int input);
+void adc_set_round_robin(unsigned int input_mask);
+void adc_fifo_setup(bool en, bool dreq_en, uint16_t dreq_thresh, bool err_in_fifo, bool byte_shift);
+void adc_set_clkdiv(float clkdiv);
+void adc_run(bool run);
+void adc_fifo_drain(void);
+uint16_t adc_read(void);
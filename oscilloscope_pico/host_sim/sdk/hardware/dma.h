@@ -0,0 +1,24 @@
+#pragma once
+// Заглушка SDK для хостовой сборки (host_sim): только то, что использует прошивка
+#include <stdint.h>
+#include <stdbool.h>
+typedef struct { uint32_t ctrl; } dma_channel_config;
+enum dma_channel_transfer_size { DMA_SIZE_8 = 0, DMA_SIZE_16 = 1, DMA_SIZE_32 = 2 };
+#define DREQ_ADC 36
+int dma_claim_unused_channel(bool required);
+dma_channel_config dma_channel_get_default_config(unsigned int channel);
+void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size);
+void channel_config_set_read_increment(dma_channel_config *c, bool incr);
+void channel_config_set_write_increment(dma_channel_config *c, bool incr);
+void channel_config_set_dreq(dma_channel_config *c, unsigned int dreq);
+void dma_channel_configure(unsigned int channel, const dma_channel_config *config, volatile void *write_addr, const volatile void *read_addr, unsigned int transfer_count, bool trigger);
+void dma_channel_set_read_addr(unsigned int channel, const volatile void *read_addr, bool trigger);
+void dma_channel_set_write_addr(unsigned int channel, volatile void *write_addr, bool trigger);
+void dma_channel_set_trans_count(unsigned int channel, uint32_t trans_count, bool trigger);
+void dma_channel_wait_for_finish_blocking(unsigned int channel);
+bool dma_channel_is_busy(unsigned int channel);
+bool dma_channel_get_irq0_status(unsigned int channel);
+void dma_channel_acknowledge_irq0(unsigned int channel);
+void dma_channel_set_irq0_enabled(unsigned int channel, bool enabled);
+void dma_channel_start(unsigned int channel);
+void dma_channel_abort(unsigned int channel);
@@ -0,0 +1,15 @@
+#pragma once
+// Заглушка SDK для хостовой сборки (host_sim): только то, что использует прошивка
+#include <stdint.h>
+#include <stddef.h>
+
+#define FLASH_PAGE_SIZE   256u
+#define FLASH_SECTOR_SIZE 4096u
+
+// Flash на хосте - массив в RAM, XIP указывает на него
+#define PICO_FLASH_SIZE_BYTES (64u * 1024u)
+extern uint8_t host_flash[PICO_FLASH_SIZE_BYTES];
+#define XIP_BASE ((uintptr_t)host_flash)
+
+void flash_range_erase(uint32_t flash_offs, size_t count);
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count);
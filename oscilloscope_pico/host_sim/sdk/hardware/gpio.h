@@ -0,0 +1,24 @@
+#pragma once
+// Заглушка SDK для хостовой сборки (host_sim): только то, что использует прошивка
+#include <stdint.h>
+#include <stdbool.h>
+enum { GPIO_IN = 0, GPIO_OUT = 1 };
+enum gpio_function { GPIO_FUNC_SPI = 1, GPIO_FUNC_SIO = 5 };
+enum gpio_irq_level { GPIO_IRQ_LEVEL_LOW = 1, GPIO_IRQ_LEVEL_HIGH = 2, GPIO_IRQ_EDGE_FALL = 4, GPIO_IRQ_EDGE_RISE = 8 };
+typedef void (*gpio_irq_callback_t)(unsigned int gpio, uint32_t event_mask);
+void gpio_init(unsigned int gpio);
+void gpio_set_dir(unsigned int gpio, bool out);
+void gpio_put(unsigned int gpio, bool value);
+bool gpio_get(unsigned int gpio);
+void gpio_pull_up(unsigned int gpio);
+void gpio_set_function(unsigned int gpio, enum gpio_function fn);
+void gpio_set_irq_enabled_with_callback(unsigned int gpio, uint32_t events, bool enabled, gpio_irq_callback_t callback);
+void gpio_set_irq_enabled(unsigned int gpio, uint32_t events, bool enabled);
+void gpio_acknowledge_irq(unsigned int gpio, uint32_t events);
+#ifndef IRQ_HANDLER_T_DEFINED
+#define IRQ_HANDLER_T_DEFINED
+typedef void (*irq_handler_t)(void);
+#endif
+void gpio_add_raw_irq_handler(unsigned int gpio, irq_handler_t handler);
+void gpio_add_raw_irq_handler_masked(uint32_t gpio_mask, irq_handler_t handler);
+uint32_t gpio_get_irq_event_mask(unsigned int gpio);
@@ -0,0 +1,11 @@
+#pragma once
+// Заглушка SDK для хостовой сборки (host_sim): только то, что использует прошивка
+#include <stdbool.h>
+#define DMA_IRQ_0 11
+#define IO_IRQ_BANK0 13
+#ifndef IRQ_HANDLER_T_DEFINED
+#define IRQ_HANDLER_T_DEFINED
+typedef void (*irq_handler_t)(void);
+#endif
+void irq_set_exclusive_handler(unsigned int num, irq_handler_t handler);
+void irq_set_enabled(unsigned int num, bool enabled);
@@ -0,0 +1,13 @@
+#pragma once
+// Заглушка SDK для хостовой сборки (host_sim): только то, что использует прошивка
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+typedef struct spi_inst spi_inst_t;
+extern spi_inst_t *const spi0_inst;
+#define spi0 spi0_inst
+unsigned int spi_init(spi_inst_t *spi, unsigned int baudrate);
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len);
+unsigned int spi_get_dreq(spi_inst_t *spi, bool is_tx);
+void spi_set_format(spi_inst_t *spi, unsigned int data_bits, int cpol, int cpha, int order);
+volatile void *spi_get_hw_dr(spi_inst_t *spi);
@@ -0,0 +1,5 @@
+#pragma once
+// Заглушка SDK для хостовой сборки (host_sim): только то, что использует прошивка
+#include <stdint.h>
+typedef struct { volatile uint32_t csr, rvr, cvr, calib; } systick_hw_t;
+extern systick_hw_t *systick_hw;
@@ -0,0 +1,5 @@
+#pragma once
+// Заглушка SDK для хостовой сборки (host_sim): только то, что использует прошивка
+#include <stdint.h>
+uint32_t save_and_disable_interrupts(void);
+void restore_interrupts(uint32_t status);
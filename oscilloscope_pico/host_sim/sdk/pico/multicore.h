@@ -0,0 +1,8 @@
+#pragma once
+// Заглушка SDK для хостовой сборки (host_sim): только то, что использует прошивка
+#include "pico/stdlib.h"
+void multicore_launch_core1(void (*entry)(void));
+bool multicore_fifo_rvalid(void);
+void multicore_fifo_push_blocking(uint32_t data);
+uint32_t multicore_fifo_pop_blocking(void);
+uint32_t get_core_num(void);
@@ -0,0 +1,8 @@
+#pragma once
+// Заглушка SDK для хостовой сборки (host_sim): только то, что использует прошивка
+#include "pico/stdlib.h"
+typedef struct { volatile int owner; } mutex_t;
+void mutex_init(mutex_t *m);
+void mutex_enter_blocking(mutex_t *m);
+void mutex_exit(mutex_t *m);
+bool mutex_try_enter(mutex_t *m, uint32_t *owner_out);
@@ -0,0 +1,27 @@
+#pragma once
+// Заглушка SDK для хостовой сборки (host_sim): только то, что использует прошивка
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "pico/time.h"
+#include "hardware/gpio.h"
+typedef unsigned int uint;
+static inline void tight_loop_contents(void) {}
+static inline void __wfe(void) {}
+static inline void __wfi(void) {}
+// Второго ядра нет: sdk.c отвечает на события за ядро захвата
+void __sev(void);
+static inline void __dmb(void) {}
+static inline void __compiler_memory_barrier(void) {}
+#define __not_in_flash_func(f) f
+#define __time_critical_func(f) f
+#define __not_in_flash(x)
+#define __scratch_x(x)
+#define __scratch_y(x)
+#define __aligned(x) __attribute__((aligned(x)))
+#define count_of(a) (sizeof(a)/sizeof((a)[0]))
+#define MIN(a,b) ((a)<(b)?(a):(b))
+#define MAX(a,b) ((a)>(b)?(a):(b))
+bool stdio_init_all(void);
+int getchar_timeout_us(uint32_t timeout_us);
+#define PICO_ERROR_TIMEOUT (-1)
@@ -0,0 +1,4 @@
+#pragma once
+// Заглушка SDK для хостовой сборки (host_sim): только то, что использует прошивка
+#include "pico/mutex.h"
+#include "hardware/sync.h"
@@ -0,0 +1,25 @@
+#pragma once
+// Заглушка SDK для хостовой сборки (host_sim): только то, что использует прошивка
+#include <stdint.h>
+#include <stdbool.h>
+typedef uint64_t absolute_time_t;
+absolute_time_t get_absolute_time(void);
+static inline int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to) { return (int64_t)(to - from); }
+static inline absolute_time_t delayed_by_us(absolute_time_t t, uint64_t us) { return t + us; }
+static inline uint64_t to_us_since_boot(absolute_time_t t) { return t; }
+static inline absolute_time_t make_timeout_time_us(uint64_t us) { return get_absolute_time() + us; }
+static inline absolute_time_t make_timeout_time_ms(uint32_t ms) { return get_absolute_time() + ms * 1000ull; }
+uint32_t time_us_32(void);
+uint64_t time_us_64(void);
+void sleep_ms(uint32_t ms);
+void sleep_us(uint64_t us);
+void sleep_until(absolute_time_t t);
+bool best_effort_wfe_or_timeout(absolute_time_t t);
+void busy_wait_until(absolute_time_t t);
+void busy_wait_us(uint64_t us);
+typedef int32_t alarm_id_t;
+typedef int64_t (*alarm_callback_t)(alarm_id_t id, void *user_data);
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past);
+alarm_id_t add_alarm_in_ms(uint32_t ms, alarm_callback_t callback, void *user_data, bool fire_if_past);
+bool cancel_alarm(alarm_id_t id);
+static inline bool time_reached(absolute_time_t t) { return get_absolute_time() >= t; }
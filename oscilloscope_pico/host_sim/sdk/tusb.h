@@ -0,0 +1,12 @@
+#pragma once
+// Заглушка SDK для хостовой сборки (host_sim): только то, что использует прошивка
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+bool tud_cdc_connected(void);
+uint32_t tud_cdc_write_available(void);
+uint32_t tud_cdc_write(const void *buffer, uint32_t bufsize);
+uint32_t tud_cdc_write_flush(void);
+uint32_t tud_cdc_available(void);
+uint32_t tud_cdc_read(void *buffer, uint32_t bufsize);
+void tud_task(void);
@@ -0,0 +1,461 @@
+// Замеры горячих функций прошивки на хосте: нс на вызов.
+//
+// Абсолютные числа относятся к процессору хоста, а не к Cortex-M0+; они
+// нужны для сравнения вариантов одной функции до и после изменения.
+// Передача по SPI в замер не входит (модель панели только считает байты),
+// для вывода приводится расчётное время на проводе при 60 МГц.
+//
+//   osc_bench [--signal square|sine|noise] [--freq HZ] [--min-ms MS]
+//
+// В конце - время до результата автоустановки (autoset/autoset.h) на
+// наборе сигналов: форма, частота, размах, шум, худшая из начальных фаз,
+// и сколько таких кадров помещается в историю (history/history.h).
+
+#include "host.h"
+#include "panel.h"
+#include "signal.h"
+#include "display_driver/display_driver.h"
+#include "global_buffer/global_buffer.h"
+#include "calibration/calibration.h"
+#include "persistence/persistence.h"
+#include "history/history.h"
+#include "wave_codec/wave_codec.h"
+#include "math_channel/math_channel.h"
+#include "long_record/long_record.h"
+#include "resample/resample.h"
+#include "cursors/cursors.h"
+#include "xy/xy.h"
+#include "screenshot/screenshot.h"
+#include "autoset/autoset.h"
+#include "mask/mask.h"
+#include "pico_ili9341/pico_ili9341.h"
+#include "pico_ili9341/framebuffer.h"
+#include "pico_ili9341/text.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SPI_BAUD_HZ 60000000.0
+
+extern void render_frame(void);
+extern color8_t* draw_wave_buf;
+
+static uint16_t samples[BUFFER_SIZE];
+static ILI9341 tft;
+static uint32_t min_ns = 200u * 1000u * 1000u;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+typedef void (*BenchFn)(void);
+
+// Повторы до min_ns, удвоением числа вызовов в серии. Байты SPI - за
+// повторный вызов (первый может выводить больше, например всю строку текста)
+static void bench(const char *name, BenchFn fn) {
+    fn();
+    panel_reset_stats();
+    fn();
+    PanelStats stats;
+    panel_get_stats(&stats);
+
+    uint64_t iterations = 1, elapsed = 0;
+    for (;;) {
+        uint64_t start = now_ns();
+        for (uint64_t i = 0; i < iterations; i++) fn();
+        elapsed = now_ns() - start;
+        if (elapsed >= min_ns) break;
+        iterations *= 2;
+    }
+
+    double ns = (double)elapsed / iterations;
+    printf("%-28s %12.1f ns/call", name, ns);
+    if (stats.data_bytes) {
+        printf("   SPI %6lu B (%.0f us at 60 MHz)", (unsigned long)stats.data_bytes,
+               stats.data_bytes * 8.0 / SPI_BAUD_HZ * 1e6);
+    }
+    printf("\n");
+}
+
+static uint16_t trigger_start;
+static volatile bool sink;
+
+static void run_check_trigger(void) { sink = check_trigger(samples, &trigger_start); }
+static void run_update_stats(void) { buffer_update_stats(samples, BUFFER_SIZE); }
+static void run_draw_waveform(void) { draw_waveform(samples, BUFFER_SIZE); }
+static void run_draw_8to16(void) { ILI9341_DrawBuffer8to16(&tft, draw_wave_buf); }
+static void run_render_frame(void) { render_frame(); }
+
+// Коррекция нелинейности: с тождественной таблицей calibration_apply сразу
+// выходит, стоимость коррекции - замер с таблицей после калибровки. Буфер
+// свой: таблица применяется к нему повторно, отсчёты остальных замеров не
+// трогаются
+static uint16_t calib_samples[BUFFER_SIZE];
+static void run_calibration_apply(void) { calibration_apply(calib_samples, BUFFER_SIZE); }
+
+// Калибровка плотностью кодов на модельном АЦП с DNL, как у RP2040: коды
+// 512, 1536, 2560 и 3584 вдвое шире, соседний сверху не выпадает никогда.
+// Вход - треугольник чуть шире диапазона, по 1/3 кода на отсчёт
+static bool calibrate_dnl(void) {
+    uint16_t buf[BUFFER_SIZE];
+    uint32_t phase = 0;
+    calibration_start_density();
+    calibration_task(buf, 0);
+    while (calibration_get_state() == CALIB_DENSITY) {
+        for (uint16_t i = 0; i < BUFFER_SIZE; i++) {
+            uint32_t v = (phase++ / 3) % 8400;
+            v = v < 4200 ? v : 8400 - v;
+            uint16_t code = v > CALIB_CODES - 1 ? CALIB_CODES - 1 : (uint16_t)v;
+            if ((code & 1023) == 513) code--;
+            buf[i] = code;
+        }
+        calibration_task(buf, BUFFER_SIZE);
+    }
+    return calibration_get_result() == CALIB_RESULT_OK;
+}
+static void run_persistence(void) { persistence_accumulate(samples, BUFFER_SIZE); }
+static void run_persistence_render(void) { persistence_render(draw_wave_buf); }
+static void run_xy_accumulate(void) { xy_accumulate(samples, BUFFER_SIZE); }
+static void run_xy_render(void) { xy_render(draw_wave_buf, WAVEFORM_WIDTH); }
+
+static uint8_t encoded[BUFFER_SIZE * 2 + 16];
+static void run_wave_encode(void) { sink = wave_encode(samples, BUFFER_SIZE, encoded, sizeof(encoded)) > 0; }
+
+// Математический канал: B - тот же блок, сжатый как эталон во flash,
+// так что в A-B входит и потоковое декодирование
+static MathChannel math;
+static uint16_t math_out[BUFFER_SIZE];
+static size_t ref_bytes;
+static uint32_t math_seq;
+static void run_math(MathOp op) {
+    ReferenceCursor b;
+    wave_decoder_init(&b.dec, encoded, ref_bytes, BUFFER_SIZE);
+    if (math.op != op) math_channel_set_op(&math, op);
+    sink = math_channel_process(&math, samples, 0, BUFFER_SIZE, ++math_seq, &b, math_out) > 0;
+}
+static void run_math_sub(void) { run_math(MATH_SUB); }
+static void run_math_mul(void) { run_math(MATH_MUL); }
+static void run_math_deriv(void) { run_math(MATH_DERIV); }
+static void run_math_integ(void) { run_math(MATH_INTEG); }
+
+static uint32_t history_seq;
+static void run_history_record(void) { history_record(samples, BUFFER_SIZE, ++history_seq); }
+
+// Длинная запись: достройка пирамиды на блок и вывод окна на каждом уровне.
+// Для сравнения - тот же вывод проходом по всем отсчётам окна
+static uint32_t record_seq;
+static uint32_t record_span;
+static RecordSpan record_columns[WAVEFORM_WIDTH];
+static uint16_t record_copy[LONG_RECORD_SAMPLES];
+static void run_record_append(void) { long_record_append(samples, BUFFER_SIZE, ++record_seq); }
+static void run_record_render(void) {
+    sink = long_record_render(0, record_span, record_columns, WAVEFORM_WIDTH) > 0;
+}
+static void run_record_scan(void) {
+    uint32_t from = 0;
+    for (uint32_t x = 0; x < WAVEFORM_WIDTH; x++) {
+        uint32_t to = (x + 1) * LONG_RECORD_SAMPLES / WAVEFORM_WIDTH;
+        RecordSpan s = { 0xFFFF, 0 };
+        for (; from < to; from++) {
+            if (record_copy[from] < s.min) s.min = record_copy[from];
+            if (record_copy[from] > s.max) s.max = record_copy[from];
+        }
+        record_columns[x] = s;
+    }
+}
+
+// Пересчёт окна в столбцы: растяжение (sin(x)/x), 1:1 и прореживание
+static uint32_t resample_span;
+static void run_resample(void) {
+    sink = resample(record_copy, LONG_RECORD_SAMPLES, 0, resample_span << 16,
+                    record_columns, WAVEFORM_WIDTH) > 0;
+}
+
+// Измерения между курсорами: индекс на новый кадр и запрос на сдвиг
+// курсора. Для сравнения - тот же участок полным проходом
+static CursorIndex cursor_index;
+static CursorMeasure cursor_measure;
+static void run_cursors_index(void) {
+    cursors_index(&cursor_index, samples, BUFFER_SIZE, global_buffer.trigger_level);
+}
+static void run_cursors_measure(void) {
+    static uint16_t from;
+    from = (from + 1) % (BUFFER_SIZE / 4);
+    sink = cursors_measure(&cursor_index, from, BUFFER_SIZE - from, global_buffer.sample_rate, &cursor_measure);
+}
+static void run_cursors_scan(void) {
+    static uint16_t from;
+    from = (from + 1) % (BUFFER_SIZE / 4);
+    buffer_update_stats(&samples[from], BUFFER_SIZE - 2 * from);
+}
+
+// Снимок экрана: проход для размера и передача в транспорт без ожидания.
+// Первое - пауза цикла дисплея на команде, второе - на весь снимок
+static size_t null_available(void *ctx) { return 1u << 20; }
+static size_t null_write(void *ctx, const uint8_t *data, size_t len) { return len; }
+static void null_flush(void *ctx) {}
+static const ScreenSink null_sink = { null_available, null_write, null_flush, NULL };
+static void run_screenshot(void) {
+    sink = display_screenshot_begin() > 0;
+    while (!screenshot_service()) {}
+}
+
+// Смена одного символа в строке: вывод только изменившейся ячейки
+static Autoset autoset;
+static uint32_t autoset_seq;
+static void run_autoset_feed(void) {
+    // Огибающая без роста, детектор без периода: полный проход на блок
+    if (autoset.state != AUTOSET_RUNNING || autoset.samples >= AUTOSET_MAX_SAMPLES - 2 * BUFFER_SIZE) {
+        autoset_start(&autoset);
+    }
+    autoset.rises = 0;
+    autoset_feed(&autoset, samples, BUFFER_SIZE, ++autoset_seq);
+}
+
+// Маска из того же блока: годный - проход по всем столбцам, негодный -
+// нарушение в середине, выход на нём
+static uint16_t mask_bad[BUFFER_SIZE];
+static void run_mask_pass(void) { sink = mask_test(samples, BUFFER_SIZE, -1); }
+static void run_mask_fail(void) { sink = mask_test(mask_bad, BUFFER_SIZE, -1); }
+
+typedef struct {
+    SignalShape shape;
+    double freq_hz;
+    float amplitude_v;
+    float offset_v;
+    float noise_v;
+} AutosetCase;
+
+// Блоки генератора подряд, пока оценка не закончится. Отчёт - худшая из
+// начальных фаз по времени и отклонение частоты у неё
+static void autoset_suite(void) {
+    static const AutosetCase cases[] = {
+        { SIGNAL_SQUARE, 50000, 2.0f, 1.65f, 0.0f },
+        { SIGNAL_SQUARE, 10000, 2.0f, 1.65f, 0.0f },
+        { SIGNAL_SQUARE, 1000, 0.3f, 1.0f, 0.0f },
+        { SIGNAL_SQUARE, 100, 3.0f, 1.65f, 0.02f },
+        { SIGNAL_SINE, 20000, 1.0f, 1.65f, 0.0f },
+        { SIGNAL_SINE, 7000, 0.5f, 1.65f, 0.02f },
+        { SIGNAL_SINE, 3000, 1.0f, 1.65f, 0.05f },
+        { SIGNAL_SINE, 440, 0.2f, 2.5f, 0.01f },
+        { SIGNAL_SINE, 50, 2.0f, 1.65f, 0.02f },
+        { SIGNAL_SINE, 30, 2.0f, 1.65f, 0.0f },
+        { SIGNAL_SINE, 10, 2.0f, 1.65f, 0.0f },
+        { SIGNAL_NOISE, 1000, 0.0f, 1.65f, 0.1f },
+        { SIGNAL_SINE, 1000, 0.0f, 0.8f, 0.002f },
+    };
+    static const char *const shapes[] = { "square", "sine", "noise" };
+    static const char *const states[] = { "idle", "run", "lock", "no period" };
+    static const double phases[] = { 0.0, 0.23, 0.5, 0.77 };
+    uint16_t block[BUFFER_SIZE];
+
+    printf("\nautoset time to result (worst of %u phases)\n", (unsigned)(sizeof(phases) / sizeof(phases[0])));
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        const AutosetCase *k = &cases[c];
+        Autoset worst = { 0 };
+        double true_hz = 0;
+        for (size_t p = 0; p < sizeof(phases) / sizeof(phases[0]); p++) {
+            SignalGen gen;
+            signal_init(&gen, k->shape, k->freq_hz, k->amplitude_v, k->offset_v, k->noise_v,
+                        global_buffer.sample_rate);
+            gen.phase = phases[p];
+            gen.rng = 0x12345u + (uint32_t)p;
+            true_hz = gen.freq_hz;
+
+            Autoset a;
+            autoset_start(&a);
+            for (uint32_t seq = 0; a.state == AUTOSET_RUNNING; seq++) {
+                signal_fill(&gen, block, BUFFER_SIZE);
+                autoset_feed(&a, block, BUFFER_SIZE, seq);
+            }
+            if (p == 0 || a.samples > worst.samples) worst = a;
+        }
+
+        char found[24] = "-";
+        if (worst.state == AUTOSET_LOCKED) {
+            double hz = global_buffer.sample_rate * 256.0 / worst.period_q8;
+            snprintf(found, sizeof(found), "%.1f Hz (%+.2f%%)", hz, (hz - true_hz) / true_hz * 100.0);
+        }
+        printf("%-6s %8.1f Hz %4.2f V%s  %-9s %3u blocks %6.2f ms  %s  vpp %u mid %u\n",
+               shapes[k->shape], true_hz, k->amplitude_v, k->noise_v > 0 ? " +noise" : "       ",
+               states[worst.state], worst.blocks,
+               worst.samples * 1000.0 / global_buffer.sample_rate, found,
+               autoset_vpp(&worst), autoset_mid(&worst));
+    }
+}
+
+// Сколько кадров помещается в историю: кольцо заполняется блоками
+// генератора (кадр - целый блок, длиннее показанного после триггера) и
+// проходит по кругу. Шум 0.8 мВ - один код АЦП
+static void history_suite(void) {
+    static const AutosetCase cases[] = {
+        { SIGNAL_SQUARE, 1000, 2.0f, 1.65f, 0.0f },
+        { SIGNAL_SQUARE, 1000, 2.0f, 1.65f, 0.0008f },
+        { SIGNAL_SQUARE, 1000, 2.0f, 1.65f, 0.002f },
+        { SIGNAL_SINE, 1000, 2.0f, 1.65f, 0.0008f },
+        { SIGNAL_SINE, 7000, 2.0f, 1.65f, 0.002f },
+        { SIGNAL_SINE, 1000, 0.3f, 1.65f, 0.002f },
+        { SIGNAL_SINE, 1000, 0.0f, 1.65f, 0.0008f },
+    };
+    static const char *const shapes[] = { "square", "sine", "noise" };
+    uint16_t block[BUFFER_SIZE];
+
+    printf("\nhistory capacity (%u byte ring, %u records max)\n", HISTORY_BYTES, HISTORY_MAX_RECORDS);
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        const AutosetCase *k = &cases[c];
+        SignalGen gen;
+        signal_init(&gen, k->shape, k->freq_hz, k->amplitude_v, k->offset_v, k->noise_v,
+                    global_buffer.sample_rate);
+        history_clear();
+        for (uint32_t seq = 0; seq < 4u * HISTORY_MAX_RECORDS; seq++) {
+            signal_fill(&gen, block, BUFFER_SIZE);
+            history_record(block, BUFFER_SIZE, seq);
+        }
+        HistoryStats stats;
+        history_get_stats(&stats);
+        printf("%-6s %8.1f Hz %4.2f V noise %3.1f mV  %4u frames  %5.1f B/frame  %.2f:1\n",
+               shapes[k->shape], gen.freq_hz, k->amplitude_v, k->noise_v * 1000.0f,
+               stats.records, (double)stats.encoded_bytes / stats.recorded,
+               (double)stats.raw_bytes / stats.encoded_bytes);
+    }
+    history_clear();
+}
+
+static TextLine text_line;
+static void run_text_line(void) {
+    static bool odd;
+    odd = !odd;
+    TextLine_Set(&tft, &text_line, odd ? "Freq: 10.00 kHz" : "Freq: 10.01 kHz");
+}
+
+int main(int argc, char **argv) {
+    SignalShape shape = SIGNAL_SQUARE;
+    double freq = 10000.0;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--signal")) {
+            shape = !strcmp(argv[i + 1], "sine") ? SIGNAL_SINE :
+                    !strcmp(argv[i + 1], "noise") ? SIGNAL_NOISE : SIGNAL_SQUARE;
+        } else if (!strcmp(argv[i], "--freq")) {
+            freq = atof(argv[i + 1]);
+        } else if (!strcmp(argv[i], "--min-ms")) {
+            min_ns = (uint32_t)atoi(argv[i + 1]) * 1000000u;
+        } else {
+            fprintf(stderr, "usage: %s [--signal square|sine|noise] [--freq HZ] [--min-ms MS]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    panel_init();
+    buffer_init();
+    calibration_init(calibration_flash_port());
+    display_init();
+    persistence_init();
+    history_init();
+
+    ILI9341Config config = {
+        .spi = spi0, .cs_pin = HOST_PIN_CS, .dc_pin = HOST_PIN_DC, .rst_pin = 14,
+        .sck_pin = 6, .mosi_pin = 7, .miso_pin = 12, .baudrate = 60 * 1000 * 1000, .dma = true,
+    };
+    ILI9341_Init(&tft, &config);
+    ILI9341_SetRotation(&tft, 3);
+    TextLine_Init(&text_line, 150, 210, FONT_8X8, 21, 0xFFFF, 0x0000);
+
+    SignalGen gen;
+    signal_init(&gen, shape, freq, 2.0f, 1.65f, 0.01f, global_buffer.sample_rate);
+    signal_fill(&gen, samples, BUFFER_SIZE);
+
+    // Кадр для render_frame: тот же блок через очередь, как из прерывания
+    FrameQueue *q = &global_buffer.frame_queue;
+    memcpy(global_buffer.adc_buffers[frame_queue_write_slot(q)], samples, sizeof(samples));
+    frame_queue_reserve(q);
+    frame_queue_publish(q, 0, BUFFER_SIZE, -1);
+    buffer_process();
+
+    // Разбор SPI не нужен: панель только считает байты
+    panel_set_capture(false);
+
+    printf("signal %.3f Hz, %u samples, min %u ms per test\n\n",
+           gen.freq_hz, BUFFER_SIZE, (unsigned)(min_ns / 1000000u));
+    bench("check_trigger", run_check_trigger);
+    bench("buffer_update_stats", run_update_stats);
+    bench("draw_waveform", run_draw_waveform);
+    bench("ILI9341_DrawBuffer8to16", run_draw_8to16);
+    bench("render_frame", run_render_frame);
+    // Оба временных и оба уровневых курсора в статическом слое
+    set_cursors(true);
+    set_time_cursor(0, WAVEFORM_WIDTH / 4);
+    set_time_cursor(1, WAVEFORM_WIDTH * 3 / 4);
+    bench("render_frame (cursors)", run_render_frame);
+    set_cursors(false);
+    bench("TextLine_Set (1 char)", run_text_line);
+    memcpy(calib_samples, samples, sizeof(samples));
+    bench("calibration_apply (identity)", run_calibration_apply);
+    if (calibrate_dnl()) {
+        bench("calibration_apply (DNL table)", run_calibration_apply);
+    } else {
+        printf("calibration_apply (DNL table): calibration failed\n");
+    }
+    calibration_reset_lut();
+    bench("persistence_accumulate", run_persistence);
+    bench("persistence_render", run_persistence_render);
+    xy_init();
+    bench("xy_accumulate (160 pairs)", run_xy_accumulate);
+    bench("xy_render", run_xy_render);
+    bench("wave_encode", run_wave_encode);
+    bench("history_record", run_history_record);
+    bench("cursors_index", run_cursors_index);
+    bench("cursors_measure", run_cursors_measure);
+    bench("cursor gate rescan (stats)", run_cursors_scan);
+    screenshot_init(&null_sink);
+    bench("screenshot (size pass + send)", run_screenshot);
+    bench("autoset_feed", run_autoset_feed);
+    mask_compile(samples, BUFFER_SIZE, -1, 124);
+    mask_set_enabled(true);
+    memcpy(mask_bad, samples, sizeof(samples));
+    mask_bad[BUFFER_SIZE / 2] ^= 0x800;
+    bench("mask_test (pass)", run_mask_pass);
+    bench("mask_test (fail at middle)", run_mask_fail);
+    mask_set_enabled(false);
+
+    ref_bytes = wave_encode(samples, BUFFER_SIZE, encoded, sizeof(encoded));
+    uint32_t gain_q16;
+    int32_t offset_mv;
+    calibration_get_gain_offset(&gain_q16, &offset_mv);
+    math_channel_init(&math);
+    math_channel_configure(&math, global_buffer.sample_rate, gain_q16, offset_mv);
+    bench("math A-B (with ref decode)", run_math_sub);
+    bench("math A*B (with ref decode)", run_math_mul);
+    bench("math dA/dt", run_math_deriv);
+    bench("math intA", run_math_integ);
+
+    long_record_init();
+    bench("long_record_append", run_record_append);
+    static const uint32_t spans[] = { 64, WAVEFORM_WIDTH, WAVEFORM_WIDTH * 4, WAVEFORM_WIDTH * 8,
+                                      LONG_RECORD_SAMPLES };
+    for (size_t i = 0; i < sizeof(spans) / sizeof(spans[0]); i++) {
+        char name[40];
+        record_span = spans[i];
+        snprintf(name, sizeof(name), "record render %5lu (L%d)",
+                 (unsigned long)record_span, long_record_level(record_span, WAVEFORM_WIDTH));
+        bench(name, run_record_render);
+    }
+    for (uint32_t i = 0; i < LONG_RECORD_SAMPLES; i++) record_copy[i] = samples[i % BUFFER_SIZE];
+    char scan_name[40];
+    snprintf(scan_name, sizeof(scan_name), "record scan %u (no index)", LONG_RECORD_SAMPLES);
+    bench(scan_name, run_record_scan);
+
+    static const uint32_t resample_spans[] = { 5, 50, WAVEFORM_WIDTH, WAVEFORM_WIDTH * 4 };
+    for (size_t i = 0; i < sizeof(resample_spans) / sizeof(resample_spans[0]); i++) {
+        char name[40];
+        resample_span = resample_spans[i];
+        snprintf(name, sizeof(name), "resample %4lu -> %d", (unsigned long)resample_span, WAVEFORM_WIDTH);
+        bench(name, run_resample);
+    }
+
+    autoset_suite();
+    history_suite();
+    return 0;
+}
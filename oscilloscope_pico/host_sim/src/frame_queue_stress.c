@@ -0,0 +1,207 @@
+// Нагрузочная проверка очереди кадров (frame_queue/frame_queue.h) двумя
+// потоками: производитель - прерывание DMA, потребитель - ядро дисплея.
+//
+// Производитель заполняет блок номером кадра, который получит публикация,
+// по одному отсчёту, как DMA, затем резервирует следующий блок и
+// публикует. Паузы между кадрами случайны: от быстрее потребителя (кадры
+// вытесняются, захват повторяется) до медленнее него. Потребитель
+// забирает самый свежий кадр и дважды проверяет каждый отсчёт: все равны
+// sequence кадра - блок не перезаписан ни до захвата (рваный кадр), ни
+// во время чтения: между проверками он отдаёт процессор производителю.
+// На одном ядре хоста потоки переключаются и посреди кадра. В конце
+// счётчики очереди сверяются с тем, что видели обе стороны.
+//
+// Потребитель закрепляет каждый STRESS_PIN_EVERY-й кадр (не больше
+// STRESS_PINS сразу) и держит его STRESS_PIN_HOLD следующих кадров: блок
+// не должен измениться до снятия. При пуле FRAME_QUEUE_SLOTS = 5 (цель
+// frame_queue_stress_5) заполняемый, опубликованный, читаемый и два
+// закреплённых блока занимают весь пул - захваты выбрасываются, и
+// счётчик exhausted должен это показать. В пуле из 6 блоков исчерпания
+// быть не может.
+//
+//   frame_queue_stress [кадров]
+//
+// Код возврата 0 - ошибок нет, 1 - ошибки (первые печатаются в stderr).
+
+#include "frame_queue/frame_queue.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define STRESS_SAMPLES 64
+#define STRESS_FRAMES  200000u
+#define STRESS_PINS      2
+#define STRESS_PIN_EVERY 37
+#define STRESS_PIN_HOLD  200
+#define MAX_PAUSE      2048    // Итераций ожидания между кадрами
+#define MAX_REPORTS    10
+
+static FrameQueue queue;
+static volatile uint32_t pool[FRAME_QUEUE_SLOTS][STRESS_SAMPLES];
+static atomic_bool producer_done;
+static uint32_t frames = STRESS_FRAMES;
+
+static uint32_t errors;
+
+static void fail(const char *what, uint32_t sequence, uint32_t got) {
+    if (errors++ < MAX_REPORTS) {
+        fprintf(stderr, "%s: frame %u, got %u\n", what, sequence, got);
+    }
+}
+
+typedef struct {
+    uint32_t published;
+} ProducerResult;
+
+// Каждая четвёртая пауза отдаёт процессор: на одноядерном хосте иначе
+// потоки чередуются только по кванту планировщика
+static void random_pause(uint32_t *rng) {
+    *rng = *rng * 1664525u + 1013904223u;
+    if ((*rng >> 12) % 4 == 0) sched_yield();
+    for (volatile uint32_t n = (*rng >> 16) % MAX_PAUSE; n; n--) {
+    }
+}
+
+static void *producer(void *arg) {
+    ProducerResult *r = arg;
+    uint32_t rng = 1;
+    for (uint32_t i = 0; i < frames; i++) {
+        random_pause(&rng);
+        // Номер, который получит публикация
+        uint32_t stamp = queue.next_sequence;
+        volatile uint32_t *block = pool[frame_queue_write_slot(&queue)];
+        for (int k = 0; k < STRESS_SAMPLES; k++) block[k] = stamp;
+
+        uint8_t filled = frame_queue_write_slot(&queue);
+        frame_queue_reserve(&queue);
+        if (frame_queue_publish(&queue, i, STRESS_SAMPLES, -1) != filled) r->published++;
+    }
+    atomic_store_explicit(&producer_done, true, memory_order_release);
+    return NULL;
+}
+
+typedef struct {
+    uint8_t slot;
+    uint32_t sequence;
+    uint32_t until;         // Снять после этого числа забранных кадров
+} Pin;
+
+typedef struct {
+    uint32_t received;
+    uint32_t skipped;       // Пропуски по sequence
+    uint32_t first_sequence;
+    uint32_t last_sequence;
+    uint32_t pinned;        // Закреплений за прогон
+    Pin pins[STRESS_PINS];
+    uint8_t pin_count;
+} ConsumerResult;
+
+static void check_block(uint8_t slot, uint32_t sequence, const char *what) {
+    for (int k = 0; k < STRESS_SAMPLES; k++) {
+        uint32_t v = pool[slot][k];
+        if (v != sequence) {
+            fail(what, sequence, v);
+            return;
+        }
+    }
+}
+
+// Снятие закреплений, срок которых вышел (все - при force). Блок за время
+// закрепления не должен был измениться
+static void unpin_expired(ConsumerResult *r, bool force) {
+    for (uint8_t i = 0; i < r->pin_count;) {
+        Pin *p = &r->pins[i];
+        if (!force && r->received < p->until) {
+            i++;
+            continue;
+        }
+        check_block(p->slot, p->sequence, "pinned block overwritten");
+        frame_queue_unpin(&queue, p->slot);
+        *p = r->pins[--r->pin_count];
+    }
+}
+
+static void *consumer(void *arg) {
+    ConsumerResult *r = arg;
+    for (;;) {
+        // Флаг до попытки: после него новых публикаций не будет
+        bool done = atomic_load_explicit(&producer_done, memory_order_acquire);
+        uint8_t slot;
+        FrameMeta meta;
+        if (!frame_queue_acquire(&queue, &slot, &meta)) {
+            if (done) break;
+            continue;
+        }
+        if (meta.length != STRESS_SAMPLES) fail("length", meta.sequence, meta.length);
+        if (meta.sequence <= r->last_sequence) fail("sequence order", meta.sequence, r->last_sequence);
+        else if (r->last_sequence) r->skipped += meta.sequence - r->last_sequence - 1;
+        else r->first_sequence = meta.sequence;
+        r->last_sequence = meta.sequence;
+
+        check_block(slot, meta.sequence, "torn frame");
+        sched_yield();
+        check_block(slot, meta.sequence, "overwritten while read");
+
+        // Закрепление - пока блок захвачен, как в buffer_process
+        if (meta.sequence % STRESS_PIN_EVERY == 0 && r->pin_count < STRESS_PINS) {
+            frame_queue_pin(&queue, slot);
+            r->pins[r->pin_count++] = (Pin){ slot, meta.sequence, r->received + STRESS_PIN_HOLD };
+            r->pinned++;
+            FrameQueueStats stats;
+            frame_queue_get_stats(&queue, &stats);
+            if (stats.pinned != r->pin_count) fail("pinned counter", r->pin_count, stats.pinned);
+        }
+        frame_queue_release(&queue);
+        r->received++;
+        unpin_expired(r, false);
+    }
+    unpin_expired(r, true);
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1) frames = (uint32_t)strtoul(argv[1], NULL, 0);
+
+    frame_queue_init(&queue);
+    ProducerResult pr = { 0 };
+    ConsumerResult cr = { 0 };
+    pthread_t tp, tc;
+    pthread_create(&tc, NULL, consumer, &cr);
+    pthread_create(&tp, NULL, producer, &pr);
+    pthread_join(tp, NULL);
+    pthread_join(tc, NULL);
+
+    FrameQueueStats stats;
+    frame_queue_get_stats(&queue, &stats);
+    printf("%u slots: %u frames, %u published, %u received, %u dropped, %u exhausted, %u pinned\n",
+           FRAME_QUEUE_SLOTS, frames, stats.published, cr.received, stats.dropped, stats.exhausted,
+           cr.pinned);
+
+    // Последний кадр забирается всегда, остальные после первого забранного -
+    // или забраны, или посчитаны как вытесненные
+    if (stats.published != pr.published) fail("published counter", pr.published, stats.published);
+    if (cr.last_sequence != pr.published) fail("last frame", pr.published, cr.last_sequence);
+    if (stats.dropped != cr.skipped) fail("dropped counter", cr.skipped, stats.dropped);
+    if (cr.first_sequence - 1 + cr.received + stats.dropped != stats.published) {
+        fail("received + dropped", stats.published, cr.first_sequence - 1 + cr.received + stats.dropped);
+    }
+    if (stats.exhausted != frames - pr.published) fail("exhausted counter", frames - pr.published, stats.exhausted);
+    if (stats.pinned) fail("pins left", 0, stats.pinned);
+    if (!cr.pinned) fail("no pins", 1, 0);
+
+    // Заполняемый, опубликованный, читаемый и закреплённые блоки
+    if (FRAME_QUEUE_SLOTS > 3 + STRESS_PINS && stats.exhausted) {
+        fail("exhausted with a free block", 0, stats.exhausted);
+    }
+    if (FRAME_QUEUE_SLOTS <= 3 + STRESS_PINS && !stats.exhausted) {
+        fail("pool never exhausted", 1, 0);
+    }
+
+    if (errors) {
+        fprintf(stderr, "%u errors\n", errors);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,121 @@
+// Проверка планировщика кадров (display_driver/frame_scheduler.h) на
+// модельном времени: часы, сон и вывод TE - здесь, а не в sdk.c.
+//
+// Цикл повторяет цикл ядра дисплея: сон до срока кадра, подготовка
+// кадра (buffer_process, история), ожидание TE, вывод на панель. Новые
+// данные есть всегда. TE приходит раз в PANEL_PERIOD_US со сдвигом фазы.
+//
+// Кадр дешевле периода панели: интервал должен остаться в один период,
+// и кадр выводится на каждый TE - время ожидания TE в стоимость кадра не
+// входит, даже если подготовка пропустила фронт и кадр ждал следующего.
+// Кадр дороже периода: интервал - два периода.
+//
+// Код возврата 0 - ошибок нет, 1 - ошибки (печатаются в stderr).
+
+#include "display_driver/frame_scheduler.h"
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include <stdio.h>
+
+#define TE_PIN       22
+#define RUN_US       2000000u   // Модельного времени на случай
+
+static uint32_t errors;
+
+/* Модельное время и вывод TE */
+
+static uint64_t now_us;
+static uint64_t te_next_us;
+static uint32_t te_pending;
+static irq_handler_t te_handler;
+
+// Время идёт вперёд, фронты TE по дороге вызывают обработчик, как прерывание
+static void advance_to(uint64_t t) {
+    while (te_next_us <= t) {
+        now_us = te_next_us;
+        te_next_us += PANEL_PERIOD_US;
+        te_pending |= GPIO_IRQ_EDGE_RISE;
+        if (te_handler) te_handler();
+    }
+    if (t > now_us) now_us = t;
+}
+
+absolute_time_t get_absolute_time(void) { return now_us; }
+uint32_t time_us_32(void) { return (uint32_t)now_us; }
+
+// Сон до таймаута или до ближайшего фронта TE (SEV из обработчика)
+bool best_effort_wfe_or_timeout(absolute_time_t t) {
+    if (now_us >= t) return true;
+    if (te_handler && te_next_us <= t) {
+        advance_to(te_next_us);
+        return false;
+    }
+    advance_to(t);
+    return true;
+}
+
+void __sev(void) {}
+void gpio_init(unsigned int gpio) {}
+void gpio_set_dir(unsigned int gpio, bool out) {}
+void gpio_set_irq_enabled(unsigned int gpio, uint32_t events, bool enabled) {}
+void irq_set_enabled(unsigned int num, bool enabled) {}
+void gpio_add_raw_irq_handler(unsigned int gpio, irq_handler_t handler) { te_handler = handler; }
+uint32_t gpio_get_irq_event_mask(unsigned int gpio) { return te_pending; }
+void gpio_acknowledge_irq(unsigned int gpio, uint32_t events) { te_pending &= ~events; }
+
+/* Цикл ядра дисплея */
+
+// prepare_us - до ожидания TE, draw_us - вывод после него. Первый фронт
+// TE - через te_phase_us после начала: если подготовка его пропускает,
+// кадр почти период ждёт следующего
+static void run(const char *name, uint32_t te_phase_us, uint32_t prepare_us, uint32_t draw_us,
+                uint32_t expect_interval) {
+    now_us = 1000;
+    te_next_us = now_us + te_phase_us;
+    te_pending = 0;
+    te_handler = NULL;
+    frame_scheduler_init(TE_PIN);
+
+    uint32_t frames = 0;
+    uint64_t first_us = 0, last_us = 0;
+    while (now_us < RUN_US) {
+        frame_scheduler_request_redraw();
+        frame_scheduler_sleep();
+        if (!frame_scheduler_frame_due()) continue;
+
+        uint32_t start = time_us_32();
+        advance_to(now_us + prepare_us);
+        frame_scheduler_wait_vsync();
+        if (!frames) first_us = now_us;
+        last_us = now_us;
+        advance_to(now_us + draw_us);
+        frame_scheduler_frame_done(time_us_32() - start);
+        frames++;
+    }
+
+    uint32_t interval = frame_scheduler_get_interval_us();
+    double rate = frames > 1 ? (frames - 1) * 1e6 / (double)(last_us - first_us) : 0.0;
+    double expect_rate = 1e6 / expect_interval;
+    printf("%s: interval %u us, %.1f frames/s\n", name, interval, rate);
+    if (interval != expect_interval) {
+        fprintf(stderr, "%s: interval %u, expected %u\n", name, interval, expect_interval);
+        errors++;
+    }
+    if (rate < expect_rate * 0.98) {
+        fprintf(stderr, "%s: %.1f frames/s, expected %.1f\n", name, rate, expect_rate);
+        errors++;
+    }
+}
+
+int main(void) {
+    run("cheap frame", 4000, 3000, 5000, PANEL_PERIOD_US);
+    run("cheap frame, TE just missed", 2000, 3000, 5000, PANEL_PERIOD_US);
+    run("cheap frame, long prepare", 8000, 9000, 4000, PANEL_PERIOD_US);
+    run("expensive frame", 2000, 6000, 12000, 2 * PANEL_PERIOD_US);
+    if (errors) {
+        fprintf(stderr, "%u errors\n", errors);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,193 @@
+// Проверка сжатия осциллограмм (wave_codec/wave_codec.h) и кольца
+// истории (history/history.h) на хосте.
+//
+// Кодек: CODEC_FRAMES кадров разной длины и формы - шум АЦП, полный
+// размах, фронты после тихого участка (escape), пилы через весь диапазон,
+// постоянный уровень - восстанавливаются точно обоими декодерами и не
+// больше WAVE_CODEC_MAX_BYTES. Обрезанный поток декодер должен заметить.
+//
+// История: RING_FRAMES записей, кольцо проходит по кругу много раз.
+// Кадр восстанавливается по номеру, поэтому после каждой записи кадры
+// нескольких возрастов сверяются с оригиналом, а номера в истории идут
+// подряд от самого нового. Серия коротких кадров упирается в
+// HISTORY_MAX_RECORDS.
+//
+// Код возврата 0 - ошибок нет, 1 - ошибки (первые печатаются в stderr).
+
+#include "history/history.h"
+#include "wave_codec/wave_codec.h"
+#include "global_buffer/global_buffer.h"
+#include <stdio.h>
+#include <string.h>
+
+#define CODEC_FRAMES 20000u
+#define RING_FRAMES  4000u
+#define SHORT_FROM   3000u   // С этого кадра истории - короткие постоянные
+#define MAX_REPORTS  10
+
+static uint32_t errors;
+
+static void fail(const char *what, uint32_t frame, uint32_t detail) {
+    if (errors++ < MAX_REPORTS) {
+        fprintf(stderr, "%s: frame %u (%u)\n", what, frame, detail);
+    }
+}
+
+static uint32_t next_random(uint32_t *rng) {
+    *rng = *rng * 1664525u + 1013904223u;
+    return *rng >> 8;
+}
+
+typedef enum {
+    SHAPE_NOISE,        // Шум в несколько кодов вокруг середины
+    SHAPE_FULL_NOISE,   // Шум на весь диапазон
+    SHAPE_STEPS,        // Тихие участки и скачки на полный размах - escape
+    SHAPE_RAMP,         // Пила через весь диапазон
+    SHAPE_FLAT,
+    SHAPE_COUNT
+} Shape;
+
+// Кадр определяется номером: форма, длина и отсчёты
+static uint16_t make_frame(uint32_t n, uint16_t *out) {
+    uint32_t rng = n * 2654435761u + 1;
+    Shape shape = (Shape)(n % SHAPE_COUNT);
+    uint16_t count = (uint16_t)(1 + next_random(&rng) % BUFFER_SIZE);
+    uint16_t level = (uint16_t)(next_random(&rng) % 4096);
+
+    for (uint16_t i = 0; i < count; i++) {
+        switch (shape) {
+        case SHAPE_NOISE:
+            out[i] = (uint16_t)(2048 + (int)(next_random(&rng) % 9) - 4);
+            break;
+        case SHAPE_FULL_NOISE:
+            out[i] = (uint16_t)(next_random(&rng) % 4096);
+            break;
+        case SHAPE_STEPS:
+            if (next_random(&rng) % 40 == 0) level = level < 2048 ? 4095 : 0;
+            out[i] = level;
+            break;
+        case SHAPE_RAMP:
+            out[i] = (uint16_t)((level + i * 97u) % 4096);
+            break;
+        default:
+            out[i] = level;
+            break;
+        }
+    }
+    return count;
+}
+
+static void test_codec(void) {
+    static uint16_t in[BUFFER_SIZE], out[BUFFER_SIZE];
+    static uint8_t data[WAVE_CODEC_MAX_BYTES(BUFFER_SIZE)];
+    uint64_t raw = 0, encoded = 0;
+
+    for (uint32_t n = 0; n < CODEC_FRAMES; n++) {
+        uint16_t count = make_frame(n, in);
+        size_t size = wave_encode(in, count, data, sizeof(data));
+        if (size == 0 || size > WAVE_CODEC_MAX_BYTES(count)) {
+            fail("encoded size", n, (uint32_t)size);
+            continue;
+        }
+        raw += (count * WAVE_CODEC_SAMPLE_BITS + 7) / 8;
+        encoded += size;
+
+        memset(out, 0xFF, sizeof(out));
+        if (wave_decode(data, size, out, count) != count || memcmp(in, out, count * sizeof(uint16_t))) {
+            fail("decode", n, count);
+        }
+
+        WaveDecoder dec;
+        wave_decoder_init(&dec, data, size, count);
+        uint16_t s, i = 0;
+        while (wave_decoder_next(&dec, &s)) {
+            if (i >= count || s != in[i]) break;
+            i++;
+        }
+        if (i != count || dec.error) fail("streaming decode", n, i);
+
+        // Без последнего байта поток обрывается: кадр не восстанавливается
+        // целиком или декодер помечает ошибку
+        if (size > 1 && count > 1) {
+            wave_decoder_init(&dec, data, size - 1, count);
+            i = 0;
+            while (wave_decoder_next(&dec, &s) && s == in[i]) i++;
+            if (i == count && !dec.error) {
+                // Последний байт мог быть только добивкой - так бывает
+                // только если он нулевой
+                if (data[size - 1]) fail("truncated stream", n, (uint32_t)size);
+            }
+        }
+
+        // Буфер на байт меньше - кодер отказывается
+        if (wave_encode(in, count, data, size - 1) != 0) fail("capacity", n, (uint32_t)size);
+    }
+    printf("codec: %u frames, %.2f:1\n", CODEC_FRAMES, encoded ? (double)raw / encoded : 0.0);
+}
+
+static void test_ring(void) {
+    static uint16_t in[BUFFER_SIZE], out[BUFFER_SIZE];
+    uint16_t max_records = 0;
+
+    history_init();
+    for (uint32_t n = 1; n <= RING_FRAMES; n++) {
+        uint16_t count;
+        if (n >= SHORT_FROM) {
+            count = 4;
+            for (uint16_t i = 0; i < count; i++) in[i] = (uint16_t)(n % 4096);
+        } else {
+            count = make_frame(n, in);
+        }
+        if (!history_record(in, count, n)) {
+            fail("record", n, count);
+            continue;
+        }
+
+        HistoryStats stats;
+        history_get_stats(&stats);
+        uint16_t records = history_count();
+        if (records == 0 || records > HISTORY_MAX_RECORDS) fail("record count", n, records);
+        if (stats.bytes_used > HISTORY_BYTES) fail("bytes used", n, stats.bytes_used);
+        if (records > max_records) max_records = records;
+
+        uint16_t ages[] = { 0, 1, (uint16_t)(records / 2), (uint16_t)(records - 1) };
+        for (size_t a = 0; a < sizeof(ages) / sizeof(ages[0]); a++) {
+            if (ages[a] >= records) continue;
+            uint32_t sequence = 0;
+            uint16_t got = history_load(ages[a], out, &sequence);
+            if (sequence != n - ages[a]) {
+                fail("sequence at age", n, ages[a]);
+                continue;
+            }
+            uint16_t expect_count;
+            if (sequence >= SHORT_FROM) {
+                expect_count = 4;
+                for (uint16_t i = 0; i < expect_count; i++) in[i] = (uint16_t)(sequence % 4096);
+            } else {
+                expect_count = make_frame(sequence, in);
+            }
+            if (got != expect_count || memcmp(in, out, got * sizeof(uint16_t))) {
+                fail("load", n, ages[a]);
+            }
+        }
+        if (history_load(records, out, NULL) != 0) fail("load past oldest", n, records);
+    }
+
+    HistoryStats stats;
+    history_get_stats(&stats);
+    printf("history: %u frames, %u bytes through the ring, up to %u records\n",
+           stats.recorded, stats.encoded_bytes, max_records);
+    // Кольцо прошло по кругу несколько раз, индекс заполнялся целиком
+    if (stats.encoded_bytes < 4u * HISTORY_BYTES) fail("ring wrap", RING_FRAMES, stats.encoded_bytes);
+    if (max_records != HISTORY_MAX_RECORDS) fail("index full", RING_FRAMES, max_records);
+}
+
+int main(void) {
+    test_codec();
+    test_ring();
+    if (errors) {
+        fprintf(stderr, "%u errors\n", errors);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Хостовые части заглушки SDK (sdk.c), которых нет в настоящем SDK
+
+// Выводы дисплея, как в display_driver.c
+#define HOST_PIN_CS 13
+#define HOST_PIN_DC 15
+
+// USB CDC: входные данные для SCPI и признак подключения. Ответы
+// прошивки печатаются в stdout
+void host_usb_set_connected(bool connected);
+void host_usb_input(const char *text);
+
+// Время на хосте - монотонные часы плюс сдвиг: host_advance_us переводит
+// часы вперёд, по пути выполняя наступившие будильники (add_alarm_in_us)
+void host_advance_us(uint64_t us);
+
+// Уровень на входе GPIO (кнопка): фронт вызывает обработчики прерывания,
+// если оно разрешено для этого фронта
+void host_gpio_input(unsigned int gpio, bool level);
+
+// Прогон DMA канала АЦП: запись count отсчётов по текущему адресу
+// назначения канала, как это сделал бы DMA. Возвращает false, если канал
+// не настроен
+bool host_adc_dma_fill(const uint16_t *samples, uint32_t count);
+
+// Вызывается на каждую передачу в SPI (spi_write_blocking и DMA) с её
+// длиной в байтах: по ней прогон считает время вывода кадра. NULL - снять
+void host_set_spi_hook(void (*hook)(size_t bytes));
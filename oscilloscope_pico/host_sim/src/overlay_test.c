@@ -0,0 +1,175 @@
+// Проверка статического слоя (pico_ili9341/overlay.h) на хосте: слой
+// накладывается на трассу по строкам и сверяется с эталоном, нарисованным
+// напрямую по пикселям.
+//
+// Курсоры: слой как у build_overlay - сетка, маркер триггера, оба
+// временных курсора во всю высоту (выбранный сплошной, второй пунктиром),
+// оба уровневых, рамка.
+//
+// Полный слой: запас отрезков строк занят до OVERLAY_MAX_SPANS, после
+// этого оба временных курсора во всю высоту всё равно должны лечь целиком.
+// Лишний столбец сверх OVERLAY_MAX_COLUMNS не принимается.
+//
+// Код возврата 0 - ошибок нет, 1 - ошибки (первые печатаются в stderr).
+
+#include "pico_ili9341/overlay.h"
+#include "display_driver/display_driver.h"
+#include <stdio.h>
+#include <string.h>
+
+#define MAX_REPORTS 10
+#define MAX_PRIMS   (OVERLAY_MAX_SPANS + OVERLAY_MAX_COLUMNS + 8)
+
+static uint32_t errors;
+
+static void fail(const char *what, uint32_t y, uint32_t x) {
+    if (errors++ < MAX_REPORTS) {
+        fprintf(stderr, "%s: row %u column %u\n", what, y, x);
+    }
+}
+
+/* Примитивы слоя и эталон */
+
+typedef struct {
+    bool vertical;
+    int x, y, length, step;
+    color8_t color;
+    uint8_t flags;
+} Prim;
+
+static Overlay ov;
+static Prim prims[MAX_PRIMS];
+static uint32_t prim_count;
+static color8_t trace[WAVEFORM_HEIGHT][WAVEFORM_WIDTH];
+static color8_t expect[WAVEFORM_HEIGHT][WAVEFORM_WIDTH];
+
+static void clear(void) {
+    Overlay_Clear(&ov);
+    prim_count = 0;
+}
+
+static void hline(int x, int y, int w, int step, color8_t color, uint8_t flags) {
+    if (!Overlay_HLine(&ov, x, y, w, step, color, flags)) fail("hline dropped", y, x);
+    prims[prim_count++] = (Prim){ false, x, y, w, step, color, flags };
+}
+
+static void vline(int x, int y, int h, int step, color8_t color, uint8_t flags) {
+    if (!Overlay_VLine(&ov, x, y, h, step, color, flags)) fail("vline dropped", y, x);
+    prims[prim_count++] = (Prim){ true, x, y, h, step, color, flags };
+}
+
+static void paint(const Prim *p) {
+    for (int i = 0; i < p->length; i += p->step) {
+        int x = p->vertical ? p->x : p->x + i;
+        int y = p->vertical ? p->y + i : p->y;
+        if (x < 0 || x >= WAVEFORM_WIDTH || y < 0 || y >= WAVEFORM_HEIGHT) continue;
+        if ((p->flags & OVERLAY_ABOVE) || trace[y][x] == COLOR8_BLACK) expect[y][x] = p->color;
+    }
+}
+
+// Порядок наложения: столбцы по порядку добавления, затем отрезки строк -
+// последний добавленный первым, так что поверх остаётся самый ранний
+static void build_expect(void) {
+    memcpy(expect, trace, sizeof(expect));
+    for (uint32_t i = 0; i < prim_count; i++) {
+        if (prims[i].vertical) paint(&prims[i]);
+    }
+    for (uint32_t i = prim_count; i-- > 0;) {
+        if (!prims[i].vertical) paint(&prims[i]);
+    }
+}
+
+// Наложение по строкам в индексах и в RGB565, в том числе на часть строки
+static void check(const char *name) {
+    build_expect();
+    for (uint16_t y = 0; y < WAVEFORM_HEIGHT; y++) {
+        color8_t row[WAVEFORM_WIDTH];
+        uint16_t scanline[WAVEFORM_WIDTH];
+        memcpy(row, trace[y], WAVEFORM_WIDTH);
+        Overlay_ComposeRow8(&ov, y, trace[y], row, 0, WAVEFORM_WIDTH);
+        for (uint16_t x = 0; x < WAVEFORM_WIDTH; x++) {
+            scanline[x] = color_palette[trace[y][x]];
+        }
+        Overlay_ComposeRow(&ov, y, trace[y], scanline, 0, WAVEFORM_WIDTH);
+        for (uint16_t x = 0; x < WAVEFORM_WIDTH; x++) {
+            if (row[x] != expect[y][x]) fail(name, y, x);
+            if (scanline[x] != color_palette[expect[y][x]]) fail(name, y, x);
+        }
+
+        // Окно [x0, x1): результат с x0 в начале строки
+        const uint16_t x0 = WAVEFORM_WIDTH / 5, x1 = WAVEFORM_WIDTH - 7;
+        memcpy(row, &trace[y][x0], x1 - x0);
+        Overlay_ComposeRow8(&ov, y, trace[y], row, x0, x1);
+        for (uint16_t x = x0; x < x1; x++) {
+            if (row[x - x0] != expect[y][x]) fail(name, y, x);
+        }
+    }
+    printf("%s: %u spans, %u columns\n", name, ov.span_count, ov.column_count);
+}
+
+/* Случаи */
+
+static void grid(void) {
+    for (int y = 0; y < WAVEFORM_HEIGHT; y += 50) {
+        hline(10, y, WAVEFORM_WIDTH - 10, 5, COLOR8_GRAY, OVERLAY_BELOW);
+    }
+    hline(0, 73, 8, 1, COLOR8_YELLOW, OVERLAY_ABOVE);
+}
+
+static void test_cursors(void) {
+    clear();
+    grid();
+    vline(WAVEFORM_WIDTH / 4, 0, WAVEFORM_HEIGHT, 1, COLOR8_MAGENTA, OVERLAY_ABOVE);
+    hline(0, 40, WAVEFORM_WIDTH, 3, COLOR8_MAGENTA, OVERLAY_ABOVE);
+    vline(WAVEFORM_WIDTH * 3 / 4, 0, WAVEFORM_HEIGHT, 3, COLOR8_MAGENTA, OVERLAY_ABOVE);
+    hline(0, 150, WAVEFORM_WIDTH, 3, COLOR8_MAGENTA, OVERLAY_ABOVE);
+
+    // Рамка и линия, уходящие за края области
+    if (!Overlay_Rect(&ov, 100, 20, 60, 30, COLOR8_CYAN, OVERLAY_BELOW)) fail("rect dropped", 20, 100);
+    prims[prim_count++] = (Prim){ false, 100, 20, 60, 1, COLOR8_CYAN, OVERLAY_BELOW };
+    prims[prim_count++] = (Prim){ false, 100, 49, 60, 1, COLOR8_CYAN, OVERLAY_BELOW };
+    prims[prim_count++] = (Prim){ true, 100, 21, 28, 1, COLOR8_CYAN, OVERLAY_BELOW };
+    prims[prim_count++] = (Prim){ true, 159, 21, 28, 1, COLOR8_CYAN, OVERLAY_BELOW };
+    vline(5, -7, WAVEFORM_HEIGHT + 20, 4, COLOR8_RED, OVERLAY_BELOW);
+    check("cursors");
+}
+
+static void test_full(void) {
+    clear();
+    grid();
+    // Пунктир на каждой строке, пока запас отрезков не кончится
+    for (int y = 0; ov.span_count < OVERLAY_MAX_SPANS; y = (y + 1) % WAVEFORM_HEIGHT) {
+        hline(y % 7, y, WAVEFORM_WIDTH, 6 + y % 5, (color8_t)(COLOR8_HEAT_BASE + y % COLOR8_HEAT_LEVELS),
+              OVERLAY_BELOW);
+    }
+    vline(WAVEFORM_WIDTH / 4, 0, WAVEFORM_HEIGHT, 1, COLOR8_MAGENTA, OVERLAY_ABOVE);
+    vline(WAVEFORM_WIDTH * 3 / 4, 0, WAVEFORM_HEIGHT, 1, COLOR8_MAGENTA, OVERLAY_ABOVE);
+    check("full overlay");
+
+    // Столбцы до предела, лишний не принимается
+    while (ov.column_count < OVERLAY_MAX_COLUMNS) {
+        vline(ov.column_count * 11, ov.column_count, 50, 2, COLOR8_WHITE, OVERLAY_BELOW);
+    }
+    if (Overlay_VLine(&ov, 1, 0, 10, 1, COLOR8_WHITE, OVERLAY_ABOVE)) {
+        fail("column over limit accepted", 0, 1);
+    }
+    check("all columns");
+}
+
+int main(void) {
+    Overlay_Init(&ov, WAVEFORM_WIDTH, WAVEFORM_HEIGHT, COLOR8_BLACK);
+    // Трасса - редкие точки, чтобы проверить и OVERLAY_BELOW
+    for (int y = 0; y < WAVEFORM_HEIGHT; y++) {
+        for (int x = 0; x < WAVEFORM_WIDTH; x++) {
+            trace[y][x] = (x + 3 * y) % 11 ? COLOR8_BLACK : COLOR8_GREEN;
+        }
+    }
+
+    test_cursors();
+    test_full();
+    if (errors) {
+        fprintf(stderr, "%u errors\n", errors);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,140 @@
+#include "panel.h"
+#include <stdio.h>
+#include <string.h>
+
+#define CMD_CASET  0x2A
+#define CMD_PASET  0x2B
+#define CMD_RAMWR  0x2C
+#define CMD_MADCTL 0x36
+#define MADCTL_MV  0x20
+
+static uint16_t gram[PANEL_MAX_SIDE * PANEL_MAX_SIDE];
+static uint16_t width = 240, height = 320;
+static bool capture = true;
+
+static uint8_t command;
+static uint8_t params[4];
+static uint8_t param_count;
+
+static uint16_t col0, col1, row0, row1;
+static uint16_t cur_x, cur_y;
+static bool have_high;
+static uint8_t high;
+
+static PanelStats stats;
+
+void panel_init(void) {
+    memset(gram, 0, sizeof(gram));
+    width = 240;
+    height = 320;
+    capture = true;
+    command = 0;
+    param_count = 0;
+    col0 = row0 = 0;
+    col1 = width - 1;
+    row1 = height - 1;
+    cur_x = cur_y = 0;
+    have_high = false;
+    memset(&stats, 0, sizeof(stats));
+}
+
+void panel_set_capture(bool enable) {
+    capture = enable;
+}
+
+static void put_pixel(uint16_t color) {
+    if (cur_x < width && cur_y < height) gram[cur_y * PANEL_MAX_SIDE + cur_x] = color;
+    stats.pixels++;
+
+    // Окно заполняется слева направо, сверху вниз
+    if (++cur_x > col1) {
+        cur_x = col0;
+        if (++cur_y > row1) cur_y = row0;
+    }
+}
+
+static void data_byte(uint8_t b) {
+    switch (command) {
+        case CMD_CASET:
+        case CMD_PASET:
+            if (param_count < 4) params[param_count++] = b;
+            if (param_count == 4) {
+                uint16_t a = (params[0] << 8) | params[1];
+                uint16_t e = (params[2] << 8) | params[3];
+                if (command == CMD_CASET) { col0 = a; col1 = e; }
+                else { row0 = a; row1 = e; }
+                param_count++;
+            }
+            break;
+        case CMD_MADCTL:
+            if (b & MADCTL_MV) { width = 320; height = 240; }
+            else { width = 240; height = 320; }
+            break;
+        case CMD_RAMWR:
+            if (!have_high) {
+                high = b;
+                have_high = true;
+            } else {
+                put_pixel((high << 8) | b);
+                have_high = false;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void panel_spi_write(bool dc_data, const uint8_t *data, size_t len) {
+    if (!dc_data) {
+        stats.commands += len;
+        if (!capture || !len) return;
+        command = data[len - 1];
+        param_count = 0;
+        if (command == CMD_RAMWR) {
+            cur_x = col0;
+            cur_y = row0;
+            have_high = false;
+            stats.windows++;
+        }
+        return;
+    }
+
+    stats.data_bytes += len;
+    if (!capture) return;
+    for (size_t i = 0; i < len; i++) data_byte(data[i]);
+}
+
+void panel_get_size(uint16_t *w, uint16_t *h) {
+    *w = width;
+    *h = height;
+}
+
+uint16_t panel_get_pixel(uint16_t x, uint16_t y) {
+    return gram[y * PANEL_MAX_SIDE + x];
+}
+
+void panel_get_stats(PanelStats *out) {
+    *out = stats;
+}
+
+void panel_reset_stats(void) {
+    memset(&stats, 0, sizeof(stats));
+}
+
+bool panel_save_ppm(const char *path) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return false;
+    fprintf(f, "P6\n%u %u\n255\n", width, height);
+    for (uint16_t y = 0; y < height; y++) {
+        for (uint16_t x = 0; x < width; x++) {
+            uint16_t c = gram[y * PANEL_MAX_SIDE + x];
+            uint8_t rgb[3] = {
+                (uint8_t)(((c >> 11) & 0x1F) * 255 / 31),
+                (uint8_t)(((c >> 5) & 0x3F) * 255 / 63),
+                (uint8_t)((c & 0x1F) * 255 / 31),
+            };
+            fwrite(rgb, 1, 3, f);
+        }
+    }
+    return fclose(f) == 0;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Модель ILI9341 на хосте: разбирает поток SPI (команда/данные по DC,
+// транзакции по CS) и пишет пиксели в память кадра. Понимает CASET, PASET,
+// RAMWR и MADCTL (поворот), остальные команды пропускает. Пиксели RGB565
+// приходят старшим байтом вперёд, как их принимает контроллер.
+
+#define PANEL_MAX_SIDE 320
+
+void panel_init(void);
+
+// false - трафик SPI только считается, без разбора (для замеров)
+void panel_set_capture(bool enable);
+
+// Байты SPI при CS = 0 (вызывает заглушка spi_write_blocking)
+void panel_spi_write(bool dc_data, const uint8_t *data, size_t len);
+
+// Размер памяти кадра с учётом поворота
+void panel_get_size(uint16_t *width, uint16_t *height);
+uint16_t panel_get_pixel(uint16_t x, uint16_t y);
+
+typedef struct {
+    uint32_t commands;
+    uint32_t data_bytes;
+    uint32_t pixels;
+    uint32_t windows;     // Команд RAMWR
+} PanelStats;
+
+void panel_get_stats(PanelStats *stats);
+void panel_reset_stats(void);
+
+// Снимок памяти кадра в PPM (P6)
+bool panel_save_ppm(const char *path);
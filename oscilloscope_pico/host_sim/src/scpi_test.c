@@ -0,0 +1,270 @@
+// Проверка интерпретатора SCPI (scpi/scpi.h) с транспортом в памяти:
+// разбор заголовков и параметров, пакетная обработка через ';', очередь
+// ошибок и её переполнение, переполнение строки, рамка двоичного блока и
+// отложенный блок - строки, пришедшие вместе с запросом блока, ждут его
+// конца и не попадают внутрь данных.
+//
+// Код возврата 0 - ошибок нет, 1 - ошибки (печатаются в stderr).
+
+#include "scpi/scpi.h"
+#include <stdio.h>
+#include <string.h>
+
+static uint32_t errors;
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            errors++; \
+            fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        } \
+    } while (0)
+
+/* Транспорт в памяти: вход читается порциями, выход копится в строку */
+
+typedef struct {
+    const char *input;
+    size_t input_pos;
+    size_t chunk;          // Байт за одно чтение
+    char output[1024];
+    size_t output_len;
+    uint32_t flushes;
+} MemoryPort;
+
+static size_t mem_read(void *ctx, uint8_t *buf, size_t len) {
+    MemoryPort *m = ctx;
+    size_t left = m->input ? strlen(m->input) - m->input_pos : 0;
+    if (len > left) len = left;
+    if (len > m->chunk) len = m->chunk;
+    memcpy(buf, m->input + m->input_pos, len);
+    m->input_pos += len;
+    return len;
+}
+
+static size_t mem_write(void *ctx, const uint8_t *data, size_t len) {
+    MemoryPort *m = ctx;
+    if (len > sizeof(m->output) - 1 - m->output_len) len = sizeof(m->output) - 1 - m->output_len;
+    memcpy(&m->output[m->output_len], data, len);
+    m->output_len += len;
+    m->output[m->output_len] = '\0';
+    return len;
+}
+
+static void mem_flush(void *ctx) {
+    ((MemoryPort *)ctx)->flushes++;
+}
+
+static MemoryPort port;
+static const ScpiTransport transport = { mem_read, mem_write, mem_flush, &port };
+
+/* Команды */
+
+static int32_t value;
+static const char block_data[] = "ab\ncd";
+
+static void cmd_value(ScpiContext *ctx, const char *args, bool query) {
+    if (query) {
+        scpi_reply_int(ctx, value);
+        return;
+    }
+    if (!scpi_parse_int(args, &value)) scpi_push_error(ctx, SCPI_ERR_DATA_TYPE);
+}
+
+static void cmd_idn(ScpiContext *ctx, const char *args, bool query) {
+    scpi_reply(ctx, "TEST");
+}
+
+static void cmd_error(ScpiContext *ctx, const char *args, bool query) {
+    scpi_reply_int(ctx, scpi_pop_error(ctx));
+}
+
+static void cmd_block(ScpiContext *ctx, const char *args, bool query) {
+    scpi_reply_block(ctx, block_data, sizeof(block_data) - 1);
+}
+
+// Данные отложенного блока передаёт тест
+static void cmd_deferred(ScpiContext *ctx, const char *args, bool query) {
+    scpi_reply_block_header(ctx, sizeof(block_data) - 1);
+}
+
+static const ScpiCommand commands[] = {
+    { "*IDN",                 cmd_idn },
+    { "SOURce:VALue",         cmd_value },
+    { "SYSTem:ERRor",         cmd_error },
+    { "DATA:BLOCk",           cmd_block },
+    { "DATA:DEFerred",        cmd_deferred },
+};
+
+static ScpiContext scpi;
+
+static void reset(size_t chunk) {
+    memset(&port, 0, sizeof(port));
+    port.chunk = chunk;
+    scpi_init(&scpi, &transport, commands, sizeof(commands) / sizeof(commands[0]));
+    value = 0;
+}
+
+static void feed(const char *text) {
+    scpi_feed(&scpi, (const uint8_t *)text, strlen(text));
+}
+
+static void test_parse(void) {
+    CHECK(scpi_match("SOURce:VALue", "SOUR:VAL", 8));
+    CHECK(scpi_match("SOURce:VALue", ":source:value", 13));
+    CHECK(scpi_match("SOURce:VALue", "sour:VALUE", 10));
+    CHECK(!scpi_match("SOURce:VALue", "SOU:VAL", 7));
+    CHECK(!scpi_match("SOURce:VALue", "SOUR", 4));
+    CHECK(!scpi_match("SOURce:VALue", "SOUR:VAL:X", 10));
+
+    bool b;
+    int32_t i;
+    float f;
+    CHECK(scpi_parse_bool(" on", &b) && b);
+    CHECK(scpi_parse_bool("0", &b) && !b);
+    CHECK(!scpi_parse_bool("2", &b));
+    CHECK(scpi_parse_int(" 0x10 ", &i) && i == 16);
+    CHECK(!scpi_parse_int("12abc", &i));
+    CHECK(scpi_parse_float("1.5e-3", &f) && f > 0.00149f && f < 0.00151f);
+    CHECK(!scpi_parse_float("", &f));
+    static const char *const edges[] = { "POSitive", "NEGative", "EITHer" };
+    CHECK(scpi_parse_choice("neg", edges, 3) == 1);
+    CHECK(scpi_parse_choice("EITHER", edges, 3) == 2);
+    CHECK(scpi_parse_choice("NEGA", edges, 3) == -1);
+}
+
+// Все ответы строки - одной строкой через ';' и одним flush
+static void test_batching(void) {
+    reset(64);
+    feed("*IDN?;SOUR:VAL 42;:sour:val?;SOURCE:VALUE?\r\n");
+    CHECK(!strcmp(port.output, "TEST;42;42\n"));
+    CHECK(port.flushes == 1);
+    CHECK(scpi.messages == 1 && scpi.commands_run == 4);
+
+    // Без запросов ответа нет
+    reset(64);
+    feed("SOUR:VAL 7\n");
+    CHECK(port.output_len == 0 && port.flushes == 0 && value == 7);
+
+    // Строка, пришедшая частями
+    reset(64);
+    feed("SOUR:V");
+    feed("AL?");
+    CHECK(port.output_len == 0);
+    feed("\n");
+    CHECK(!strcmp(port.output, "0\n"));
+}
+
+static void test_errors(void) {
+    reset(64);
+    feed("BOGUS;SOUR:VAL x;SYST:ERR?;SYST:ERR?;SYST:ERR?\n");
+    CHECK(!strcmp(port.output, "-113;-104;0\n"));
+
+    // Переполнение: последняя запись заменяется -350, старые сохраняются
+    reset(64);
+    for (int n = 0; n < SCPI_ERROR_QUEUE + 3; n++) feed("BOGUS\n");
+    CHECK(scpi.error_count == SCPI_ERROR_QUEUE);
+    for (int n = 0; n < SCPI_ERROR_QUEUE - 1; n++) {
+        CHECK(scpi_pop_error(&scpi) == SCPI_ERR_UNDEFINED_HEADER);
+    }
+    CHECK(scpi_pop_error(&scpi) == SCPI_ERR_QUEUE_OVERFLOW);
+    CHECK(scpi_pop_error(&scpi) == SCPI_ERR_NONE);
+}
+
+// Строка длиннее SCPI_LINE_MAX отбрасывается целиком, следующая - работает
+static void test_overrun(void) {
+    reset(64);
+    char line[SCPI_LINE_MAX + 32];
+    memset(line, 'A', sizeof(line) - 2);
+    memcpy(line, "SOUR:VAL 5;", 11);
+    line[sizeof(line) - 2] = '\n';
+    line[sizeof(line) - 1] = '\0';
+    feed(line);
+    CHECK(value == 0 && port.output_len == 0);
+    feed("SOUR:VAL 9;SYST:ERR?\n");
+    CHECK(value == 9);
+    CHECK(!strcmp(port.output, "-363\n"));
+
+    // Ровно SCPI_LINE_MAX символов - ещё не переполнение
+    reset(64);
+    memset(line, ' ', SCPI_LINE_MAX);
+    memcpy(&line[SCPI_LINE_MAX - 10], "SOUR:VAL?", 9);
+    line[SCPI_LINE_MAX] = '\n';
+    line[SCPI_LINE_MAX + 1] = '\0';
+    feed(line);
+    CHECK(!strcmp(port.output, "0\n"));
+}
+
+// "#<n><len><data>": данные как есть, в том числе '\n' внутри
+static void test_block(void) {
+    reset(64);
+    feed("*IDN?;DATA:BLOC?;SOUR:VAL?\n");
+    CHECK(!strcmp(port.output, "TEST;#15ab\ncd;0\n"));
+    CHECK(port.flushes == 1);
+}
+
+// Отложенный блок: строки после запроса не выполняются, пока владелец
+// не передаст данные и не закроет ответ
+static void test_deferred(void) {
+    reset(64);
+    port.input = "DATA:DEF?;SOUR:VAL 3\nSOUR:VAL?\n*IDN?\n";
+    scpi_poll(&scpi);
+    CHECK(scpi.deferred);
+    CHECK(!strcmp(port.output, "#15"));
+    CHECK(value == 0);            // Остаток сообщения с запросом блока не выполняется
+
+    // Повторный опрос во время блока ничего не выполняет
+    scpi_poll(&scpi);
+    feed("SOUR:VAL 8\n");
+    CHECK(!strcmp(port.output, "#15") && value == 0);
+
+    mem_write(&port, (const uint8_t *)block_data, sizeof(block_data) - 1);
+    scpi_end_deferred(&scpi);
+    CHECK(!strcmp(port.output, "#15ab\ncd\n"));
+
+    // Отложенные строки - по порядку приёма
+    scpi_poll(&scpi);
+    CHECK(!strcmp(port.output, "#15ab\ncd\n0\nTEST\n"));
+    CHECK(value == 8);
+    CHECK(scpi.held == 0 && !scpi.deferred);
+
+    // Блок, запрошенный из отложенных строк, снова останавливает разбор
+    reset(1);
+    port.input = "DATA:DEF?\nDATA:DEF?\n*IDN?\n";
+    scpi_poll(&scpi);
+    CHECK(!strcmp(port.output, "#15"));
+    CHECK(port.input_pos == 10);  // Транспорт не читается дальше строки блока
+    scpi_end_deferred(&scpi);
+    scpi_poll(&scpi);
+    CHECK(!strcmp(port.output, "#15\n#15"));
+    scpi_end_deferred(&scpi);
+    scpi_poll(&scpi);
+    CHECK(!strcmp(port.output, "#15\n#15\nTEST\n"));
+
+    // Больше SCPI_LINE_MAX байт во время блока: лишнее теряется с ошибкой
+    reset(64);
+    feed("DATA:DEF?\n");
+    char many[SCPI_LINE_MAX + 16];
+    memset(many, ' ', sizeof(many) - 1);
+    memcpy(many, "SOUR:VAL 4\n", 11);
+    many[sizeof(many) - 1] = '\0';
+    feed(many);
+    CHECK(scpi.held == SCPI_LINE_MAX);
+    scpi_end_deferred(&scpi);
+    feed("\nSYST:ERR?\n");
+    CHECK(value == 4);
+    CHECK(!strcmp(port.output, "#15\n-363\n"));
+}
+
+int main(void) {
+    test_parse();
+    test_batching();
+    test_errors();
+    test_overrun();
+    test_block();
+    test_deferred();
+    if (errors) {
+        fprintf(stderr, "%u errors\n", errors);
+        return 1;
+    }
+    printf("scpi: all checks passed\n");
+    return 0;
+}
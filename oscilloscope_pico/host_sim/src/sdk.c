@@ -0,0 +1,427 @@
+// Реализация заглушки SDK (host_sim/sdk) поверх libc.
+//
+// Время - монотонные часы хоста, ожидания не спят: симуляция идёт с той
+// скоростью, с какой её считает хост. Прерываний нет, вместо них
+// sim.c вызывает обработчики явно. SPI и DMA в сторону дисплея отдают
+// байты модели панели, DMA канала АЦП пишет отсчёты из host_adc_dma_fill.
+
+#include "host.h"
+#include "panel.h"
+#include "pico/stdlib.h"
+#include "pico/mutex.h"
+#include "pico/multicore.h"
+#include "hardware/adc.h"
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/flash.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "hardware/spi.h"
+#include "hardware/sync.h"
+#include "hardware/structs/systick.h"
+#include "tusb.h"
+#include "global_buffer/global_buffer.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* Время */
+
+static uint64_t start_ns;
+static uint64_t offset_ns;  // Сдвиг часов из host_advance_us
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t ns = (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+    if (!start_ns) start_ns = ns;
+    return ns - start_ns + offset_ns;
+}
+
+absolute_time_t get_absolute_time(void) { return now_ns() / 1000; }
+uint32_t time_us_32(void) { return (uint32_t)(now_ns() / 1000); }
+uint64_t time_us_64(void) { return now_ns() / 1000; }
+void sleep_ms(uint32_t ms) { (void)ms; }
+void sleep_us(uint64_t us) { (void)us; }
+void sleep_until(absolute_time_t t) { (void)t; }
+bool best_effort_wfe_or_timeout(absolute_time_t t) { (void)t; return true; }
+void busy_wait_until(absolute_time_t t) { (void)t; }
+void busy_wait_us(uint64_t us) { (void)us; }
+
+// Будильники срабатывают только в host_advance_us: прерываний на хосте нет
+#define ALARM_COUNT 16
+
+typedef struct {
+    bool active;
+    uint64_t at_us;
+    alarm_callback_t callback;
+    void *user_data;
+} HostAlarm;
+
+static HostAlarm alarms[ALARM_COUNT];
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+    (void)fire_if_past;
+    for (int i = 0; i < ALARM_COUNT; i++) {
+        if (alarms[i].active) continue;
+        alarms[i] = (HostAlarm){ true, time_us_64() + us, callback, user_data };
+        return i + 1;
+    }
+    return -1;
+}
+
+void host_advance_us(uint64_t us) {
+    uint64_t target = time_us_64() + us;
+    for (;;) {
+        int next = -1;
+        for (int i = 0; i < ALARM_COUNT; i++) {
+            if (alarms[i].active && alarms[i].at_us <= target &&
+                (next < 0 || alarms[i].at_us < alarms[next].at_us)) next = i;
+        }
+        if (next < 0) break;
+
+        HostAlarm *a = &alarms[next];
+        uint64_t now = time_us_64();
+        if (a->at_us > now) offset_ns += (a->at_us - now) * 1000;
+        a->active = false;
+        int64_t again = a->callback(next + 1, a->user_data);
+        // Как в SDK: > 0 - повтор через столько мкс от прошлого срока
+        if (again > 0) {
+            a->at_us += (uint64_t)again;
+            a->active = true;
+        }
+    }
+    uint64_t now = time_us_64();
+    if (target > now) offset_ns += (target - now) * 1000;
+}
+
+alarm_id_t add_alarm_in_ms(uint32_t ms, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+    return add_alarm_in_us(ms * 1000ull, callback, user_data, fire_if_past);
+}
+
+bool cancel_alarm(alarm_id_t id) {
+    if (id < 1 || id > ALARM_COUNT || !alarms[id - 1].active) return false;
+    alarms[id - 1].active = false;
+    return true;
+}
+
+bool stdio_init_all(void) { return true; }
+int getchar_timeout_us(uint32_t timeout_us) { (void)timeout_us; return PICO_ERROR_TIMEOUT; }
+
+// SysTick: 24-битный счётчик вниз с частотой clk_sys (125 МГц)
+static systick_hw_t systick_regs;
+systick_hw_t *systick_hw = &systick_regs;
+
+uint32_t clock_get_hz(enum clock_index clk_index) {
+    return clk_index == clk_usb || clk_index == clk_adc ? 48000000u : 125000000u;
+}
+
+/* GPIO: выходы хранят записанный уровень, входы с подтяжкой читаются как 1 */
+
+#define GPIO_COUNT 30
+static bool gpio_level[GPIO_COUNT];
+
+void gpio_init(unsigned int gpio) { if (gpio < GPIO_COUNT) gpio_level[gpio] = false; }
+void gpio_set_dir(unsigned int gpio, bool out) { (void)gpio; (void)out; }
+void gpio_put(unsigned int gpio, bool value) { if (gpio < GPIO_COUNT) gpio_level[gpio] = value; }
+bool gpio_get(unsigned int gpio) { return gpio < GPIO_COUNT && gpio_level[gpio]; }
+void gpio_pull_up(unsigned int gpio) { if (gpio < GPIO_COUNT) gpio_level[gpio] = true; }
+void gpio_set_function(unsigned int gpio, enum gpio_function fn) { (void)gpio; (void)fn; }
+
+// Прерывания по фронтам: флаги событий и обработчики банка, как в SDK
+#define GPIO_HANDLERS 4
+
+static uint32_t gpio_irq_enabled[GPIO_COUNT];
+static uint32_t gpio_irq_pending[GPIO_COUNT];
+static struct {
+    uint32_t mask;
+    irq_handler_t handler;
+} gpio_handlers[GPIO_HANDLERS];
+
+void gpio_set_irq_enabled_with_callback(unsigned int gpio, uint32_t events, bool enabled, gpio_irq_callback_t callback) {
+    (void)gpio; (void)events; (void)enabled; (void)callback;
+}
+
+void gpio_set_irq_enabled(unsigned int gpio, uint32_t events, bool enabled) {
+    if (gpio >= GPIO_COUNT) return;
+    if (enabled) gpio_irq_enabled[gpio] |= events;
+    else gpio_irq_enabled[gpio] &= ~events;
+}
+
+void gpio_acknowledge_irq(unsigned int gpio, uint32_t events) {
+    if (gpio < GPIO_COUNT) gpio_irq_pending[gpio] &= ~events;
+}
+
+void gpio_add_raw_irq_handler_masked(uint32_t gpio_mask, irq_handler_t handler) {
+    for (int i = 0; i < GPIO_HANDLERS; i++) {
+        if (gpio_handlers[i].handler) continue;
+        gpio_handlers[i].mask = gpio_mask;
+        gpio_handlers[i].handler = handler;
+        return;
+    }
+}
+
+void gpio_add_raw_irq_handler(unsigned int gpio, irq_handler_t handler) {
+    gpio_add_raw_irq_handler_masked(1u << gpio, handler);
+}
+
+uint32_t gpio_get_irq_event_mask(unsigned int gpio) {
+    return gpio < GPIO_COUNT ? gpio_irq_pending[gpio] & gpio_irq_enabled[gpio] : 0;
+}
+
+void host_gpio_input(unsigned int gpio, bool level) {
+    if (gpio >= GPIO_COUNT || gpio_level[gpio] == level) return;
+    gpio_level[gpio] = level;
+    gpio_irq_pending[gpio] |= level ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL;
+    if (!(gpio_irq_pending[gpio] & gpio_irq_enabled[gpio])) return;
+    for (int i = 0; i < GPIO_HANDLERS; i++) {
+        if (gpio_handlers[i].handler && (gpio_handlers[i].mask & (1u << gpio))) gpio_handlers[i].handler();
+    }
+}
+
+/* SPI: байты при выбранной панели (CS = 0) уходят в её модель */
+
+struct spi_inst { volatile uint32_t dr; };
+static struct spi_inst spi0_regs;
+spi_inst_t *const spi0_inst = &spi0_regs;
+
+#define DREQ_SPI0_TX 16
+
+unsigned int spi_init(spi_inst_t *spi, unsigned int baudrate) { (void)spi; return baudrate; }
+unsigned int spi_get_dreq(spi_inst_t *spi, bool is_tx) { (void)spi; return is_tx ? DREQ_SPI0_TX : DREQ_SPI0_TX + 1; }
+void spi_set_format(spi_inst_t *spi, unsigned int data_bits, int cpol, int cpha, int order) {
+    (void)spi; (void)data_bits; (void)cpol; (void)cpha; (void)order;
+}
+volatile void *spi_get_hw_dr(spi_inst_t *spi) { return &spi->dr; }
+
+static void (*spi_hook)(size_t bytes);
+
+void host_set_spi_hook(void (*hook)(size_t bytes)) { spi_hook = hook; }
+
+static void spi_to_panel(const uint8_t *src, size_t len) {
+    if (spi_hook) spi_hook(len);
+    if (!gpio_get(HOST_PIN_CS)) panel_spi_write(gpio_get(HOST_PIN_DC), src, len);
+}
+
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len) {
+    (void)spi;
+    spi_to_panel(src, len);
+    return (int)len;
+}
+
+/* DMA: передача выполняется сразу при запуске канала */
+
+#define DMA_CHANNELS 12
+
+typedef struct {
+    bool claimed;
+    dma_channel_config config;
+    volatile void *write_addr;
+    const volatile void *read_addr;
+    uint32_t trans_count;
+    bool irq0_enabled;
+    bool irq0_status;
+} HostDmaChannel;
+
+static HostDmaChannel dma[DMA_CHANNELS];
+
+// Раскладка dma_channel_config.ctrl: размер, инкременты, DREQ
+#define CTRL_SIZE_MASK   0x3u
+#define CTRL_INCR_READ   (1u << 2)
+#define CTRL_INCR_WRITE  (1u << 3)
+#define CTRL_DREQ_SHIFT  8
+
+int dma_claim_unused_channel(bool required) {
+    for (int i = 0; i < DMA_CHANNELS; i++) {
+        if (!dma[i].claimed) {
+            dma[i].claimed = true;
+            return i;
+        }
+    }
+    if (required) {
+        fprintf(stderr, "host_sim: no free DMA channel\n");
+        abort();
+    }
+    return -1;
+}
+
+dma_channel_config dma_channel_get_default_config(unsigned int channel) {
+    (void)channel;
+    dma_channel_config c = { DMA_SIZE_32 | CTRL_INCR_READ | (0x3Fu << CTRL_DREQ_SHIFT) };
+    return c;
+}
+
+void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size) {
+    c->ctrl = (c->ctrl & ~CTRL_SIZE_MASK) | size;
+}
+
+void channel_config_set_read_increment(dma_channel_config *c, bool incr) {
+    c->ctrl = incr ? c->ctrl | CTRL_INCR_READ : c->ctrl & ~CTRL_INCR_READ;
+}
+
+void channel_config_set_write_increment(dma_channel_config *c, bool incr) {
+    c->ctrl = incr ? c->ctrl | CTRL_INCR_WRITE : c->ctrl & ~CTRL_INCR_WRITE;
+}
+
+void channel_config_set_dreq(dma_channel_config *c, unsigned int dreq) {
+    c->ctrl = (c->ctrl & ~(0x3Fu << CTRL_DREQ_SHIFT)) | (dreq << CTRL_DREQ_SHIFT);
+}
+
+// Запуск канала. Передача в SPI выполняется сразу; канал АЦП только
+// запоминает адрес - отсчёты в него пишет host_adc_dma_fill
+static void dma_run(unsigned int channel) {
+    HostDmaChannel *ch = &dma[channel];
+    uint32_t dreq = (ch->config.ctrl >> CTRL_DREQ_SHIFT) & 0x3F;
+    if (dreq == DREQ_SPI0_TX || ch->write_addr == &spi0_regs.dr) {
+        uint32_t size = 1u << (ch->config.ctrl & CTRL_SIZE_MASK);
+        spi_to_panel((const uint8_t *)ch->read_addr, (size_t)ch->trans_count * size);
+        if (ch->irq0_enabled) ch->irq0_status = true;
+    }
+}
+
+void dma_channel_configure(unsigned int channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, unsigned int transfer_count, bool trigger) {
+    HostDmaChannel *ch = &dma[channel];
+    ch->config = *config;
+    ch->write_addr = write_addr;
+    ch->read_addr = read_addr;
+    ch->trans_count = transfer_count;
+    if (trigger) dma_run(channel);
+}
+
+void dma_channel_set_read_addr(unsigned int channel, const volatile void *read_addr, bool trigger) {
+    dma[channel].read_addr = read_addr;
+    if (trigger) dma_run(channel);
+}
+
+void dma_channel_set_write_addr(unsigned int channel, volatile void *write_addr, bool trigger) {
+    dma[channel].write_addr = write_addr;
+    if (trigger) dma_run(channel);
+}
+
+void dma_channel_set_trans_count(unsigned int channel, uint32_t trans_count, bool trigger) {
+    dma[channel].trans_count = trans_count;
+    if (trigger) dma_run(channel);
+}
+
+void dma_channel_wait_for_finish_blocking(unsigned int channel) { (void)channel; }
+bool dma_channel_is_busy(unsigned int channel) { (void)channel; return false; }
+bool dma_channel_get_irq0_status(unsigned int channel) { return dma[channel].irq0_status; }
+void dma_channel_acknowledge_irq0(unsigned int channel) { dma[channel].irq0_status = false; }
+void dma_channel_set_irq0_enabled(unsigned int channel, bool enabled) { dma[channel].irq0_enabled = enabled; }
+void dma_channel_start(unsigned int channel) { dma_run(channel); }
+void dma_channel_abort(unsigned int channel) { (void)channel; }
+
+bool host_adc_dma_fill(const uint16_t *samples, uint32_t count) {
+    for (int i = 0; i < DMA_CHANNELS; i++) {
+        HostDmaChannel *ch = &dma[i];
+        uint32_t dreq = (ch->config.ctrl >> CTRL_DREQ_SHIFT) & 0x3F;
+        if (!ch->claimed || dreq != DREQ_ADC || !ch->write_addr) continue;
+
+        if (count > ch->trans_count) count = ch->trans_count;
+        memcpy((void *)ch->write_addr, samples, count * sizeof(uint16_t));
+        if (ch->irq0_enabled) ch->irq0_status = true;
+        return true;
+    }
+    return false;
+}
+
+/* АЦП, прерывания, второе ядро: на хосте ничего не делают */
+
+static adc_hw_t adc_regs;
+adc_hw_t *const adc_hw = &adc_regs;
+
+void adc_init(void) {}
+void adc_gpio_init(unsigned int gpio) { (void)gpio; }
+void adc_select_input(unsigned int input) { (void)input; }
+void adc_set_round_robin(unsigned int input_mask) { (void)input_mask; }
+void adc_fifo_setup(bool en, bool dreq_en, uint16_t dreq_thresh, bool err_in_fifo, bool byte_shift) {
+    (void)en; (void)dreq_en; (void)dreq_thresh; (void)err_in_fifo; (void)byte_shift;
+}
+void adc_set_clkdiv(float clkdiv) { (void)clkdiv; }
+void adc_run(bool run) { (void)run; }
+void adc_fifo_drain(void) {}
+uint16_t adc_read(void) { return 0; }
+
+void irq_set_exclusive_handler(unsigned int num, irq_handler_t handler) { (void)num; (void)handler; }
+void irq_set_enabled(unsigned int num, bool enabled) { (void)num; (void)enabled; }
+
+uint32_t save_and_disable_interrupts(void) { return 0; }
+void restore_interrupts(uint32_t status) { (void)status; }
+
+void multicore_launch_core1(void (*entry)(void)) { (void)entry; }
+bool multicore_fifo_rvalid(void) { return false; }
+void multicore_fifo_push_blocking(uint32_t data) { (void)data; }
+uint32_t multicore_fifo_pop_blocking(void) { return 0; }
+uint32_t get_core_num(void) { return 0; }
+
+void mutex_init(mutex_t *m) { m->owner = -1; }
+void mutex_enter_blocking(mutex_t *m) { m->owner = 0; }
+void mutex_exit(mutex_t *m) { m->owner = -1; }
+bool mutex_try_enter(mutex_t *m, uint32_t *owner_out) {
+    if (m->owner >= 0) {
+        if (owner_out) *owner_out = (uint32_t)m->owner;
+        return false;
+    }
+    m->owner = 0;
+    return true;
+}
+
+/* События между ядрами */
+
+// Ядро захвата на хосте не крутится в своём цикле: на запрос записи во
+// flash оно "паркуется" сразу, как park_for_flash в adc_driver.c
+void __sev(void) {
+    global_buffer.flash_parked = global_buffer.flash_park_request;
+}
+
+/* Flash: массив в RAM, стирание в 0xFF, запись только сбрасывает биты */
+
+uint8_t host_flash[PICO_FLASH_SIZE_BYTES];
+
+void flash_range_erase(uint32_t flash_offs, size_t count) {
+    if (flash_offs + count <= PICO_FLASH_SIZE_BYTES) memset(&host_flash[flash_offs], 0xFF, count);
+}
+
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count) {
+    if (flash_offs + count > PICO_FLASH_SIZE_BYTES) return;
+    for (size_t i = 0; i < count; i++) host_flash[flash_offs + i] &= data[i];
+}
+
+/* USB CDC: вход из host_usb_input, ответы в stdout */
+
+static bool usb_connected;
+static char usb_input[1024];
+static size_t usb_input_len, usb_input_pos;
+
+void host_usb_set_connected(bool connected) { usb_connected = connected; }
+
+void host_usb_input(const char *text) {
+    size_t len = strlen(text);
+    if (len > sizeof(usb_input)) len = sizeof(usb_input);
+    memcpy(usb_input, text, len);
+    usb_input_len = len;
+    usb_input_pos = 0;
+}
+
+bool tud_cdc_connected(void) { return usb_connected; }
+uint32_t tud_cdc_write_available(void) { return usb_connected ? 4096 : 0; }
+
+uint32_t tud_cdc_write(const void *buffer, uint32_t bufsize) {
+    if (!usb_connected) return 0;
+    return (uint32_t)fwrite(buffer, 1, bufsize, stdout);
+}
+
+uint32_t tud_cdc_write_flush(void) { fflush(stdout); return 0; }
+uint32_t tud_cdc_available(void) { return (uint32_t)(usb_input_len - usb_input_pos); }
+
+uint32_t tud_cdc_read(void *buffer, uint32_t bufsize) {
+    uint32_t n = tud_cdc_available();
+    if (n > bufsize) n = bufsize;
+    memcpy(buffer, &usb_input[usb_input_pos], n);
+    usb_input_pos += n;
+    return n;
+}
+
+void tud_task(void) {}
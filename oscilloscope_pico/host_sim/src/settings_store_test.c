@@ -0,0 +1,199 @@
+// Проверка журнала настроек (settings/settings_store.h) на хосте. Flash
+// заменена массивом в RAM с поведением NOR: стирание - сектор в 0xFF,
+// запись только сбрасывает биты (1 -> 0).
+//
+// Дописывание: APPEND_RECORDS записей подряд. После каждой читается
+// актуальная запись, время от времени журнал просматривается заново, как
+// после перезагрузки; число стираний - по одному на сектор, в который
+// журнал переходит.
+//
+// Обрывы: TORN_CUTS раз питание пропадает посреди стирания или записи -
+// операция выполнена на случайное число байт, до перезагрузки flash больше
+// ничего не принимает. После перезагрузки актуальной должна быть последняя
+// целиком записанная запись, а журнал - продолжаться с неё.
+//
+// Код возврата 0 - ошибок нет, 1 - ошибки (первые печатаются в stderr).
+
+#include "settings/settings_store.h"
+#include <stdio.h>
+#include <string.h>
+
+#define SECTOR_BYTES    4096u
+#define SECTORS         2u
+#define APPEND_RECORDS  1000u
+#define TORN_CUTS       2000u
+#define MAX_REPORTS     10
+
+static uint32_t errors;
+
+static void fail(const char *what, uint32_t record, uint32_t detail) {
+    if (errors++ < MAX_REPORTS) {
+        fprintf(stderr, "%s: record %u (%u)\n", what, record, detail);
+    }
+}
+
+static uint32_t next_random(uint32_t *rng) {
+    *rng = *rng * 1664525u + 1013904223u;
+    return *rng >> 8;
+}
+
+/* NOR в RAM */
+
+typedef struct {
+    uint8_t data[SECTORS * SECTOR_BYTES];
+    int32_t budget;        // Байт до обрыва питания, < 0 - без обрыва
+    bool dead;             // Питание пропало, до перезагрузки операции не идут
+} RamFlash;
+
+static RamFlash flash;
+
+// Сколько байт операции выполнится до обрыва
+static uint32_t spend(RamFlash *f, uint32_t len) {
+    if (f->budget < 0) return len;
+    if ((uint32_t)f->budget >= len) {
+        f->budget -= (int32_t)len;
+        return len;
+    }
+    len = (uint32_t)f->budget;
+    f->budget = 0;
+    f->dead = true;
+    return len;
+}
+
+static bool ram_erase(void *ctx, uint32_t offset) {
+    RamFlash *f = ctx;
+    if (f->dead || offset % SECTOR_BYTES) return false;
+    uint32_t done = spend(f, SECTOR_BYTES);
+    memset(&f->data[offset], 0xFF, done);
+    return !f->dead;
+}
+
+static bool ram_program(void *ctx, uint32_t offset, const uint8_t *data, uint32_t len) {
+    RamFlash *f = ctx;
+    if (f->dead || offset + len > sizeof(f->data)) return false;
+    uint32_t done = spend(f, len);
+    for (uint32_t i = 0; i < done; i++) f->data[offset + i] &= data[i];
+    return !f->dead;
+}
+
+static const FlashPort port = {
+    .base = flash.data,
+    .size = sizeof(flash.data),
+    .sector_size = SECTOR_BYTES,
+    .erase = ram_erase,
+    .program = ram_program,
+    .ctx = &flash,
+};
+
+/* Записи */
+
+// Запись определяется номером: длина, версия и байты
+static uint8_t make_payload(uint32_t n, uint8_t *out) {
+    uint8_t length = (uint8_t)(1 + n % SETTINGS_PAYLOAD_MAX);
+    for (uint8_t i = 0; i < length; i++) out[i] = (uint8_t)(n * 7 + i);
+    return length;
+}
+
+static bool append(SettingsStore *store, uint32_t n) {
+    uint8_t payload[SETTINGS_PAYLOAD_MAX];
+    uint8_t length = make_payload(n, payload);
+    return settings_store_append(store, payload, length, (uint8_t)n);
+}
+
+// Актуальная запись - n-я (0 - записей нет)
+static void check_newest(const SettingsStore *store, uint32_t n, const char *what) {
+    uint8_t payload[SETTINGS_PAYLOAD_MAX], expect[SETTINGS_PAYLOAD_MAX];
+    uint8_t length = 0, version = 0;
+    if (!settings_store_read(store, payload, &length, &version)) {
+        if (n) fail(what, n, 0);
+        return;
+    }
+    uint8_t expect_length = make_payload(n, expect);
+    if (!n || length != expect_length || version != (uint8_t)n ||
+        memcmp(payload, expect, length) || store->sequence != n) {
+        fail(what, n, store->sequence);
+    }
+}
+
+static void reboot(SettingsStore *store) {
+    flash.dead = false;
+    flash.budget = -1;
+    settings_store_init(store, &port);
+}
+
+static void test_appends(void) {
+    SettingsStore store;
+    uint32_t erases = 0;          // store.erases - с момента запуска
+    memset(flash.data, 0xFF, sizeof(flash.data));
+    reboot(&store);
+    check_newest(&store, 0, "empty log");
+
+    for (uint32_t n = 1; n <= APPEND_RECORDS; n++) {
+        if (!append(&store, n)) fail("append", n, 0);
+        check_newest(&store, n, "read after append");
+        if (n % 50 == 0) {
+            erases += store.erases;
+            reboot(&store);
+            check_newest(&store, n, "read after reboot");
+        }
+    }
+    erases += store.erases;
+
+    // Стирание - при входе в каждый сектор, включая первый
+    const uint32_t per_sector = SECTOR_BYTES / SETTINGS_RECORD_BYTES;
+    if (erases != (APPEND_RECORDS + per_sector - 1) / per_sector) {
+        fail("erase count", APPEND_RECORDS, erases);
+    }
+    printf("appends: %u records, %u erases\n", APPEND_RECORDS, erases);
+}
+
+static void test_torn(void) {
+    SettingsStore store;
+    uint32_t rng = 1;
+    uint32_t committed = 0;       // Последняя целиком записанная запись
+    uint32_t torn_erases = 0;
+
+    memset(flash.data, 0xFF, sizeof(flash.data));
+    reboot(&store);
+
+    for (uint32_t cut = 0; cut < TORN_CUTS; cut++) {
+        // Несколько целых записей, затем одна с обрывом
+        for (uint32_t k = next_random(&rng) % 4; k; k--) {
+            if (append(&store, committed + 1)) committed++;
+            else fail("append", committed + 1, 0);
+        }
+
+        // Переход в новый сектор - стирание, обрыв чаще всего в нём
+        bool erasing = store.need_erase;
+        uint32_t budget = next_random(&rng) %
+                          ((erasing ? SECTOR_BYTES : 0) + SETTINGS_RECORD_BYTES);
+        flash.budget = (int32_t)budget;
+        if (append(&store, committed + 1)) {
+            fail("append after power loss", committed + 1, budget);
+            committed++;
+        }
+        if (erasing && budget < SECTOR_BYTES) torn_erases++;
+
+        reboot(&store);
+        check_newest(&store, committed, "read after torn write");
+    }
+
+    // Журнал после обрывов работает как обычно
+    for (uint32_t n = 0; n < 300; n++) {
+        if (append(&store, committed + 1)) committed++;
+        else fail("append after cuts", committed + 1, 0);
+    }
+    reboot(&store);
+    check_newest(&store, committed, "read after cuts");
+    printf("torn: %u cuts (%u in erase), %u records kept\n", TORN_CUTS, torn_erases, committed);
+}
+
+int main(void) {
+    test_appends();
+    test_torn();
+    if (errors) {
+        fprintf(stderr, "%u errors\n", errors);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include "signal.h"
+#include <math.h>
+
+double signal_meander_freq(uint32_t requested_hz) {
+    if (requested_hz == 0 || requested_hz > SIGNAL_F_CPU / 2) return 0.0;
+
+    // Тот же перебор делителей, что в скетче: 1, 8, 64, 256, 1024
+    static const uint8_t shifts[] = { 3, 3, 2, 2 };
+    uint32_t divider = 1;
+    uint32_t ocr = SIGNAL_F_CPU / requested_hz / 2 / divider;
+    for (int i = 0; i < 4 && ocr > 65536; i++) {
+        divider <<= shifts[i];
+        ocr = SIGNAL_F_CPU / requested_hz / 2 / divider;
+    }
+    if (ocr > 65536) ocr = 65536;
+
+    // OCR1A = ocr - 1, период счёта ocr тактов делителя
+    return (double)SIGNAL_F_CPU / 2 / ocr / divider;
+}
+
+void signal_init(SignalGen *gen, SignalShape shape, double freq_hz,
+                 float amplitude_v, float offset_v, float noise_v,
+                 uint32_t sample_rate) {
+    gen->shape = shape;
+    gen->freq_hz = shape == SIGNAL_SQUARE ? signal_meander_freq((uint32_t)(freq_hz + 0.5)) : freq_hz;
+    gen->amplitude_v = amplitude_v;
+    gen->offset_v = offset_v;
+    gen->noise_v = noise_v;
+    gen->sample_rate = sample_rate;
+    gen->phase = 0.0;
+    gen->rng = 0x12345678u;
+}
+
+// xorshift32: воспроизводимый шум между запусками
+static uint32_t next_random(SignalGen *gen) {
+    uint32_t x = gen->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    gen->rng = x;
+    return x;
+}
+
+// Нормальное распределение: сумма 4 равномерных (СКО 1)
+static float gaussian(SignalGen *gen) {
+    float sum = 0.0f;
+    for (int i = 0; i < 4; i++) sum += (float)(next_random(gen) >> 8) / (float)(1u << 24);
+    return (sum - 2.0f) * 1.7320508f;
+}
+
+void signal_fill(SignalGen *gen, uint16_t *codes, uint32_t count) {
+    double step = gen->freq_hz / gen->sample_rate;
+    float half = gen->amplitude_v * 0.5f;
+
+    for (uint32_t i = 0; i < count; i++) {
+        float v;
+        switch (gen->shape) {
+            case SIGNAL_SQUARE:
+                v = gen->phase < 0.5 ? half : -half;
+                break;
+            case SIGNAL_SINE:
+                v = half * (float)sin(2.0 * M_PI * gen->phase);
+                break;
+            default:
+                v = half * ((float)(next_random(gen) >> 8) / (float)(1u << 23) - 1.0f);
+                break;
+        }
+        v += gen->offset_v;
+        if (gen->noise_v > 0.0f) v += gen->noise_v * gaussian(gen);
+
+        int32_t code = (int32_t)lroundf(v / SIGNAL_VREF * (SIGNAL_ADC_MAX + 1));
+        if (code < 0) code = 0;
+        if (code > SIGNAL_ADC_MAX) code = SIGNAL_ADC_MAX;
+        codes[i] = (uint16_t)code;
+
+        gen->phase += step;
+        gen->phase -= floor(gen->phase);
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+// Синтетический сигнал на входе АЦП.
+//
+// Меандр повторяет генератор meander/meander.ino: Arduino с F_CPU = 16 МГц,
+// таймер 1 в режиме CTC, делители 1/8/64/256, частоты от 1 Гц до 8 МГц.
+// Запрошенная частота округляется так же, как в скетче, поэтому на экране
+// получается та же частота, что и от настоящего генератора.
+
+#define SIGNAL_F_CPU        16000000u
+#define SIGNAL_VREF         3.3f
+#define SIGNAL_ADC_MAX      4095
+
+typedef enum {
+    SIGNAL_SQUARE,
+    SIGNAL_SINE,
+    SIGNAL_NOISE
+} SignalShape;
+
+typedef struct {
+    SignalShape shape;
+    double freq_hz;        // Фактическая частота (для меандра - после округления)
+    float amplitude_v;     // Размах
+    float offset_v;        // Середина размаха
+    float noise_v;         // СКО добавочного шума
+    uint32_t sample_rate;
+
+    double phase;          // В периодах, [0, 1)
+    uint32_t rng;
+} SignalGen;
+
+// Частота, которую выдаст meander.ino на запрос requested_hz.
+// 0 - скетч такой запрос игнорирует (0 или выше F_CPU/2)
+double signal_meander_freq(uint32_t requested_hz);
+
+void signal_init(SignalGen *gen, SignalShape shape, double freq_hz,
+                 float amplitude_v, float offset_v, float noise_v,
+                 uint32_t sample_rate);
+
+// Следующие count отсчётов: 12-битные коды АЦП с насыщением
+void signal_fill(SignalGen *gen, uint16_t *codes, uint32_t count);
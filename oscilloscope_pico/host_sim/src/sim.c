@@ -0,0 +1,551 @@
+// Прогон прошивки на хосте: сигнал из генератора проходит тот же путь,
+// что на плате (DMA -> прерывание -> очередь кадров -> buffer_process ->
+// render_frame), а модель панели сохраняет итоговый экран в PPM.
+//
+//   osc_sim --signal square --freq 10000 --amp 2 --offset 1.65 --out screen.ppm
+//   osc_sim --scpi "TRIG:LEV 1.2;:MEAS:ALL?" --frames 20
+//
+// Файлы захвата (capture/capture.h): --record пишет блоки генератора,
+// --replay прогоняет записанные блоки с прибора или из --record через
+// buffer_process и render_frame с максимальной скоростью. С --report на
+// каждый блок печатается строка с результатом синхронизации и измерениями:
+// сравнение вывода двух сборок - регрессионная проверка.
+//
+//   osc_sim --replay capture.osc --report > new.txt && diff old.txt new.txt
+//
+// --flash хранит содержимое flash (настройки, эталоны) в файле между
+// запусками, --scpi-end выполняет команды после последнего кадра:
+//
+//   osc_sim --flash f.bin --scpi-end "REF:SAVE 1"
+//   osc_sim --flash f.bin --freq 1100 --scpi "REF:DISP 1" --scpi-end "REF:RES?"
+//
+// --keys нажимает кнопки после последнего кадра (и выводит ещё один):
+// имя кнопки и время удержания в мс (100 по умолчанию). Каждое нажатие и
+// отпускание дребезжит, время идёт виртуально, прерывания и будильники
+// input.c срабатывают как на плате:
+//
+//   osc_sim --keys "set,set,plus:2000" --scpi-end "TRIG:LEV?"
+//   osc_sim --scpi "DISP:REC ON" --frames 40 --keys "hold,minus:1500"
+//
+// В режиме XY блок - пары отсчётов входов A и B, как при опросе АЦП по
+// очереди: B оцифрован на такт позже A. Вход B - та же форма, что A, со
+// своей частотой и сдвигом фазы:
+//
+//   osc_sim --signal sine --freq 3000 --b-freq 6000 --b-phase 90 --scpi "DISP:XY ON"
+//
+// --realtime: кроме --blocks блоков между кадрами, генератор выдаёт блоки
+// и во время вывода кадра - по одному на время передачи 5000 байт SPI
+// (640 мкс при 62.5 МГц). Ядро дисплея забирает их только после кадра,
+// очередь теряет лишние, как на плате. В конце - строка потерь очереди,
+// длинной записи и потока:
+//
+//   osc_sim --realtime --scpi "DISP:REC ON" --frames 100
+//
+// Ответы SCPI идут в stdout, снимок экрана декодирует screenshot/tools/screen_dump
+// (картинка должна совпасть с --out):
+//
+//   osc_sim --scpi-end "DISP:SCR?" > shot.bin && screen_dump -o shot.ppm shot.bin
+
+#include "host.h"
+#include "panel.h"
+#include "signal.h"
+#include "adc_driver/adc_driver.h"
+#include "display_driver/display_driver.h"
+#include "global_buffer/global_buffer.h"
+#include "calibration/calibration.h"
+#include "persistence/persistence.h"
+#include "xy/xy.h"
+#include "mask/mask.h"
+#include "history/history.h"
+#include "scpi/scpi_remote.h"
+#include "screenshot/screenshot.h"
+#include "settings/settings.h"
+#include "capture/capture.h"
+#include "usb_stream/usb_stream.h"
+#include "long_record/long_record.h"
+#include "hardware/flash.h"
+#include "input/input.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Функции прошивки без объявления в заголовках
+extern void adc_dma_handler(void);
+extern void render_frame(void);
+
+typedef struct {
+    SignalShape shape;
+    double freq_hz;
+    float amplitude_v;
+    float offset_v;
+    float noise_v;
+    double b_freq_hz;           // Вход B в режиме XY, 0 - как у A
+    float b_phase_deg;
+    uint32_t frames;
+    uint32_t blocks_per_frame;  // Блоков захвата между кадрами экрана
+    bool persistence;
+    const char *scpi;
+    const char *scpi_end;       // Команды после последнего кадра
+    const char *keys;           // Нажатия кнопок: "set,plus:1500"
+    const char *flash;          // Файл с содержимым flash
+    const char *out;
+    const char *record;         // Файл захвата для записи блоков генератора
+    const char *replay;         // Файл захвата вместо генератора
+    bool report;                // Строка измерений на каждый кадр
+    bool realtime;              // Блоки идут и во время вывода кадра
+} SimOptions;
+
+// Как accumulate_triggered() в цикле ядра захвата (там буфер уже после
+// калибровки; здесь калибровка по умолчанию - тождественная)
+static void accumulate_triggered(const uint16_t *buffer) {
+    int trig = -1;
+    if (global_buffer.trigger_enabled) {
+        trig = buffer_find_trigger(buffer);
+        if (trig < 0) return;
+    }
+    if (global_buffer.persistence) {
+        int start = trig > TRIGGER_PRETRIGGER ? trig - TRIGGER_PRETRIGGER : 0;
+        persistence_accumulate(&buffer[start], BUFFER_SIZE - start);
+    }
+    mask_test(buffer, BUFFER_SIZE, trig);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+        "usage: %s [options]\n"
+        "  --signal square|sine|noise   форма сигнала (square)\n"
+        "  --freq HZ                    частота (1000); меандр округляется как в meander.ino\n"
+        "  --amp V                      размах (2.0)\n"
+        "  --offset V                   середина размаха (1.65)\n"
+        "  --noise V                    СКО шума (0)\n"
+        "  --b-freq HZ                  частота входа B для XY (как у A)\n"
+        "  --b-phase DEG                сдвиг фазы входа B (90)\n"
+        "  --frames N                   кадров экрана (10)\n"
+        "  --blocks N                   блоков захвата на кадр (4)\n"
+        "  --persist                    режим послесвечения\n"
+        "  --scpi \"CMD;CMD?\"            команды SCPI до первого кадра\n"
+        "  --scpi-end \"CMD;CMD?\"        команды SCPI после последнего кадра\n"
+        "  --keys \"KEY[:MS],...\"        нажатия hold|plus|minus|set с удержанием (100 мс)\n"
+        "  --flash FILE.bin             содержимое flash между запусками\n"
+        "  --record FILE.osc            запись блоков генератора в файл захвата\n"
+        "  --replay FILE.osc            блоки из файла захвата вместо генератора\n"
+        "  --report                     строка измерений на каждый кадр в stdout\n"
+        "  --realtime                   блоки и во время вывода кадра, по времени SPI\n"
+        "  --out FILE.ppm               снимок экрана (screen.ppm)\n",
+        prog);
+}
+
+static bool parse_args(int argc, char **argv, SimOptions *opt) {
+    *opt = (SimOptions){
+        .shape = SIGNAL_SQUARE, .freq_hz = 1000.0, .amplitude_v = 2.0f, .offset_v = 1.65f,
+        .noise_v = 0.0f, .b_freq_hz = 0.0, .b_phase_deg = 90.0f, .frames = 10, .blocks_per_frame = 4, .persistence = false,
+        .scpi = NULL, .scpi_end = NULL, .keys = NULL, .flash = NULL, .out = "screen.ppm", .record = NULL, .replay = NULL, .report = false,
+    };
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *val = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!strcmp(arg, "--persist")) { opt->persistence = true; continue; }
+        if (!strcmp(arg, "--report")) { opt->report = true; continue; }
+        if (!strcmp(arg, "--realtime")) { opt->realtime = true; continue; }
+        if (!val) return false;
+        i++;
+        if (!strcmp(arg, "--signal")) {
+            if (!strcmp(val, "square")) opt->shape = SIGNAL_SQUARE;
+            else if (!strcmp(val, "sine")) opt->shape = SIGNAL_SINE;
+            else if (!strcmp(val, "noise")) opt->shape = SIGNAL_NOISE;
+            else return false;
+        }
+        else if (!strcmp(arg, "--freq")) opt->freq_hz = atof(val);
+        else if (!strcmp(arg, "--amp")) opt->amplitude_v = (float)atof(val);
+        else if (!strcmp(arg, "--offset")) opt->offset_v = (float)atof(val);
+        else if (!strcmp(arg, "--noise")) opt->noise_v = (float)atof(val);
+        else if (!strcmp(arg, "--b-freq")) opt->b_freq_hz = atof(val);
+        else if (!strcmp(arg, "--b-phase")) opt->b_phase_deg = (float)atof(val);
+        else if (!strcmp(arg, "--frames")) opt->frames = (uint32_t)atoi(val);
+        else if (!strcmp(arg, "--blocks")) opt->blocks_per_frame = (uint32_t)atoi(val);
+        else if (!strcmp(arg, "--scpi")) opt->scpi = val;
+        else if (!strcmp(arg, "--scpi-end")) opt->scpi_end = val;
+        else if (!strcmp(arg, "--keys")) opt->keys = val;
+        else if (!strcmp(arg, "--flash")) opt->flash = val;
+        else if (!strcmp(arg, "--out")) opt->out = val;
+        else if (!strcmp(arg, "--record")) opt->record = val;
+        else if (!strcmp(arg, "--replay")) opt->replay = val;
+        else return false;
+    }
+    return opt->blocks_per_frame > 0;
+}
+
+// Блок захвата, как его получает прошивка: DMA, прерывание, цикл ядра захвата
+// display_idle - ядро дисплея ждёт нового кадра и выталкивает поток; во
+// время вывода кадра на панель блоки копятся в очереди кадров
+static void feed_block(const uint16_t *block, bool display_idle) {
+    FrameQueue *q = &global_buffer.frame_queue;
+    uint8_t filled = frame_queue_write_slot(q);
+    host_adc_dma_fill(block, BUFFER_SIZE);
+    adc_dma_handler();
+    // Цикл ядра захвата: блок опубликован, если DMA ушёл в другой блок пула
+    if (frame_queue_write_slot(q) != filled) {
+        buffer_capture_block(global_buffer.adc_buffers[filled], frame_queue_meta(q, filled));
+    }
+    if (global_buffer.xy_mode) xy_accumulate(block, BUFFER_SIZE);
+    else if (global_buffer.persistence || mask_enabled()) accumulate_triggered(block);
+    if (display_idle) usb_stream_service();
+}
+
+// Генератор: блоки идут в прошивку и, с --record, в файл захвата
+typedef struct {
+    SignalGen a;
+    SignalGen b;
+    FILE *rec;
+    CaptureWriter writer;
+    uint32_t sequence;
+} BlockSource;
+
+static BlockSource source;
+
+static void source_block(bool display_idle) {
+    uint16_t block[BUFFER_SIZE], block_b[BUFFER_SIZE];
+    signal_fill(&source.a, block, BUFFER_SIZE);
+    // XY: нечётные такты - вход B
+    signal_fill(&source.b, block_b, BUFFER_SIZE);
+    if (global_buffer.xy_mode) {
+        for (int i = 1; i < BUFFER_SIZE; i += 2) block[i] = block_b[i];
+    }
+    feed_block(block, display_idle);
+    source.sequence++;
+    if (source.rec) {
+        uint32_t t_us = (uint32_t)((uint64_t)source.sequence * BUFFER_SIZE * 1000000 / global_buffer.sample_rate);
+        capture_writer_block(&source.writer, block, BUFFER_SIZE, source.sequence, t_us);
+    }
+}
+
+// --realtime: время вывода кадра считается по байтам SPI, и за каждый
+// блок этого времени АЦП заполняет следующий блок, которого ядро дисплея
+// не забирает до конца кадра - как на плате
+#define SIM_SPI_HZ 62500000u  // spi_init(60 МГц) на RP2040: clk_peri / 2
+
+static uint64_t spi_bits;
+
+static void realtime_spi(size_t bytes) {
+    uint64_t block_bits = (uint64_t)SIM_SPI_HZ * BUFFER_SIZE / global_buffer.sample_rate;
+    spi_bits += (uint64_t)bytes * 8;
+    while (spi_bits >= block_bits) {
+        spi_bits -= block_bits;
+        source_block(false);
+    }
+}
+
+// Кадр экрана, как в цикле ядра дисплея
+static uint32_t frames_shown;
+
+static void show_frame(bool report) {
+    bool fresh = buffer_process();
+    if (fresh) {
+        uint16_t count;
+        const uint16_t *samples = buffer_get_raw(&count);
+        if (samples) history_record(samples, count, global_buffer.display_sequence);
+    }
+    render_frame();
+    frames_shown++;
+
+    if (report) {
+        printf("frame %lu seq %lu start %u count %u vmax %u vmin %u freq %u duty %.1f\n",
+               (unsigned long)frames_shown, (unsigned long)global_buffer.display_sequence,
+               global_buffer.display_start, global_buffer.display_count,
+               global_buffer.max_value, global_buffer.min_value,
+               global_buffer.frequency, global_buffer.duty_cycle);
+    }
+}
+
+/* Файлы захвата */
+
+static size_t file_write(void *ctx, const uint8_t *data, size_t len) {
+    return fwrite(data, 1, len, (FILE *)ctx);
+}
+
+static void current_header(CaptureHeader *h) {
+    uint32_t gain_q16;
+    int32_t offset_mv;
+    calibration_get_gain_offset(&gain_q16, &offset_mv);
+    *h = (CaptureHeader){
+        .version = CAPTURE_VERSION,
+        .sample_rate = global_buffer.sample_rate,
+        .bits = 12,
+        .channels = 1,
+        .block_samples = BUFFER_SIZE,
+        .trigger_level = get_trigger_level(),
+        .trigger_mode = get_trigger_mode(),
+        .trigger_edge = get_trigger_edge(),
+        .trigger_position = TRIGGER_PRETRIGGER,
+        .gain_q16 = gain_q16,
+        .offset_mv = offset_mv,
+    };
+}
+
+typedef struct {
+    bool report;
+    bool configured;
+    uint32_t blocks;
+    uint32_t resized;           // Блоки другой длины (дополнены или обрезаны)
+} ReplayContext;
+
+// Условия записи из заголовка - до первого блока
+static void apply_header(const CaptureHeader *h) {
+    global_buffer.sample_rate = h->sample_rate;
+    calibration_set_gain_offset(h->gain_q16, h->offset_mv);
+    set_trigger_mode((TriggerMode)h->trigger_mode);
+    set_trigger_edge((TriggerEdge)h->trigger_edge);
+    set_trigger_level(h->trigger_level);
+}
+
+static CaptureReader reader;
+
+static void on_replay_block(void *ctx, const StreamHeader *h, const uint16_t *samples) {
+    ReplayContext *rc = ctx;
+    if (!rc->configured) {
+        apply_header(&reader.header);
+        rc->configured = true;
+    }
+
+    // Пул захвата рассчитан на BUFFER_SIZE: короткий блок дополняется
+    // последним отсчётом
+    uint16_t block[BUFFER_SIZE];
+    uint16_t n = h->count < BUFFER_SIZE ? h->count : BUFFER_SIZE;
+    memcpy(block, samples, n * sizeof(uint16_t));
+    for (uint16_t i = n; i < BUFFER_SIZE; i++) block[i] = n ? samples[n - 1] : 0;
+    if (h->count != BUFFER_SIZE) rc->resized++;
+
+    feed_block(block, true);
+    show_frame(rc->report);
+    rc->blocks++;
+}
+
+// Строка команд, как принятая по USB CDC
+static void run_scpi(const char *commands) {
+    char line[512];
+    snprintf(line, sizeof(line), "%s\n", commands);
+    host_usb_set_connected(true);
+    host_usb_input(line);
+    scpi_remote_poll();
+    // Снимок экрана передаётся частями, как из цикла ядра дисплея
+    while (screenshot_active()) scpi_remote_poll();
+}
+
+// Кнопка замыкает вывод на землю: несколько коротких отскоков, потом
+// установившийся уровень
+#define KEY_BOUNCES    3
+#define KEY_BOUNCE_US  300
+#define KEY_STEP_US    10000  // Шаг цикла ядра дисплея при удержании
+
+static void key_edge(unsigned int pin, bool level) {
+    for (int i = 0; i < KEY_BOUNCES; i++) {
+        host_gpio_input(pin, level);
+        host_advance_us(KEY_BOUNCE_US);
+        host_gpio_input(pin, !level);
+        host_advance_us(KEY_BOUNCE_US);
+    }
+    host_gpio_input(pin, level);
+}
+
+// Пока кнопка держится, цикл ядра дисплея забирает события
+static void key_wait(uint32_t us) {
+    while (us) {
+        uint32_t step = us < KEY_STEP_US ? us : KEY_STEP_US;
+        host_advance_us(step);
+        process_buttons();
+        us -= step;
+    }
+}
+
+static bool run_keys(const char *keys) {
+    static const struct { const char *name; unsigned int pin; } names[] = {
+        { "hold", BUTTON_HOLD }, { "plus", BUTTON_PLUS },
+        { "minus", BUTTON_MINUS }, { "set", BUTTON_SET },
+    };
+    const char *p = keys;
+    while (*p) {
+        size_t len = strcspn(p, ",:");
+        int key = -1;
+        for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+            if (strlen(names[i].name) == len && !strncmp(p, names[i].name, len)) key = (int)i;
+        }
+        if (key < 0) {
+            fprintf(stderr, "--keys: unknown button '%.*s'\n", (int)len, p);
+            return false;
+        }
+        p += len;
+        uint32_t hold_ms = 100;
+        if (*p == ':') {
+            char *end;
+            hold_ms = (uint32_t)strtoul(p + 1, &end, 10);
+            p = end;
+        }
+        if (*p == ',') p++;
+
+        key_edge(names[key].pin, false);
+        key_wait(hold_ms * 1000);
+        key_edge(names[key].pin, true);
+        key_wait(100000);
+    }
+
+    InputStats stats;
+    input_get_stats(&stats);
+    fprintf(stderr, "keys: %lu events, %lu bounces, %lu dropped\n", (unsigned long)stats.events,
+            (unsigned long)stats.bounces, (unsigned long)stats.dropped);
+    return true;
+}
+
+// Содержимое flash: нет файла - чистая (стёртая) flash
+static void load_flash(const char *path) {
+    memset(host_flash, 0xFF, sizeof(host_flash));
+    FILE *f = fopen(path, "rb");
+    if (!f) return;
+    if (fread(host_flash, 1, sizeof(host_flash), f) != sizeof(host_flash)) {
+        fprintf(stderr, "%s: short flash image, erased\n", path);
+        memset(host_flash, 0xFF, sizeof(host_flash));
+    }
+    fclose(f);
+}
+
+static bool save_flash(const char *path) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return false;
+    bool ok = fwrite(host_flash, 1, sizeof(host_flash), f) == sizeof(host_flash);
+    return fclose(f) == 0 && ok;
+}
+
+static int replay(const SimOptions *opt) {
+    FILE *f = fopen(opt->replay, "rb");
+    if (!f) {
+        perror(opt->replay);
+        return 1;
+    }
+
+    ReplayContext rc = { .report = opt->report };
+    capture_reader_init(&reader);
+    uint64_t start = time_us_64();
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        if (!capture_reader_feed(&reader, buf, n, on_replay_block, &rc)) break;
+    }
+    fclose(f);
+    uint64_t elapsed = time_us_64() - start;
+
+    if (!reader.header_ok) {
+        fprintf(stderr, "%s: not a capture file\n", opt->replay);
+        return 1;
+    }
+    fprintf(stderr, "replay: %lu blocks at %lu Hz, %lu lost, %lu crc errors, %lu resized, %.1f blocks/s\n",
+            (unsigned long)rc.blocks, (unsigned long)reader.header.sample_rate,
+            (unsigned long)reader.parser.lost, (unsigned long)reader.parser.crc_errors,
+            (unsigned long)rc.resized, elapsed ? rc.blocks * 1e6 / elapsed : 0.0);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    SimOptions opt;
+    if (!parse_args(argc, argv, &opt)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    if (opt.flash) load_flash(opt.flash);
+
+    // Порядок инициализации как в main() и на обоих ядрах прошивки
+    panel_init();
+    stdio_init_all();
+    buffer_init();
+    calibration_init(calibration_flash_port());
+    display_init();
+    init_buttons();
+    adc_processor_init();
+    persistence_init();
+    xy_init();
+    adc_start();
+    global_buffer.persistence = opt.persistence;
+
+    if (opt.scpi) run_scpi(opt.scpi);
+
+    if (opt.replay) {
+        int rc = replay(&opt);
+        if (rc) return rc;
+    } else {
+        signal_init(&source.a, opt.shape, opt.freq_hz, opt.amplitude_v, opt.offset_v, opt.noise_v,
+                    global_buffer.sample_rate);
+        signal_init(&source.b, opt.shape, opt.b_freq_hz > 0 ? opt.b_freq_hz : opt.freq_hz,
+                    opt.amplitude_v, opt.offset_v, opt.noise_v, global_buffer.sample_rate);
+        source.b.phase = opt.b_phase_deg / 360.0 - floor(opt.b_phase_deg / 360.0);
+        source.b.rng = 0x9E3779B9u; // Шум входа B не повторяет шум A
+        fprintf(stderr, "signal: %.3f Hz, %u frames x %u blocks\n",
+                source.a.freq_hz, opt.frames, opt.blocks_per_frame);
+
+        if (opt.record) {
+            source.rec = fopen(opt.record, "wb");
+            if (!source.rec) {
+                perror(opt.record);
+                return 1;
+            }
+            CaptureHeader header;
+            current_header(&header);
+            CaptureSink sink = { .write = file_write, .ctx = source.rec };
+            capture_writer_begin(&source.writer, &sink, &header, STREAM_ENC_DELTA);
+        }
+
+        if (opt.realtime) host_set_spi_hook(realtime_spi);
+        for (uint32_t frame = 0; frame < opt.frames; frame++) {
+            for (uint32_t b = 0; b < opt.blocks_per_frame; b++) source_block(true);
+            show_frame(opt.report);
+        }
+        host_set_spi_hook(NULL);
+
+        if (opt.realtime) {
+            FrameQueueStats qs;
+            LongRecordStats ls;
+            UsbStreamStats us;
+            frame_queue_get_stats(&global_buffer.frame_queue, &qs);
+            long_record_get_stats(&ls);
+            usb_stream_get_stats(&us);
+            fprintf(stderr, "realtime: %lu blocks, queue %lu dropped %lu exhausted, "
+                    "record %lu samples %lu restarts, stream %lu sent %lu dropped\n",
+                    (unsigned long)source.sequence, (unsigned long)qs.dropped,
+                    (unsigned long)qs.exhausted, (unsigned long)long_record_length(),
+                    (unsigned long)ls.restarts, (unsigned long)us.sent, (unsigned long)us.dropped);
+        }
+
+        if (source.rec) {
+            bool ok = !source.writer.error && fclose(source.rec) == 0;
+            fprintf(stderr, "record: %lu blocks, %llu bytes%s\n", (unsigned long)source.writer.blocks,
+                    (unsigned long long)source.writer.bytes, ok ? "" : " (write error)");
+            if (!ok) return 1;
+        }
+    }
+
+    if (opt.keys) {
+        if (!run_keys(opt.keys)) return 2;
+        show_frame(opt.report);
+    }
+    if (opt.scpi_end) run_scpi(opt.scpi_end);
+    if (opt.flash && !save_flash(opt.flash)) {
+        fprintf(stderr, "cannot write %s\n", opt.flash);
+        return 1;
+    }
+
+    PanelStats stats;
+    panel_get_stats(&stats);
+    fprintf(stderr, "frames: %lu, trigger seq %lu, SPI %lu bytes, %lu pixels, %lu windows\n",
+            (unsigned long)frames_shown, (unsigned long)global_buffer.display_sequence,
+            (unsigned long)stats.data_bytes, (unsigned long)stats.pixels, (unsigned long)stats.windows);
+    fprintf(stderr, "Vmax %u Vmin %u Freq %u Hz Duty %.1f%%\n",
+            global_buffer.max_value, global_buffer.min_value,
+            global_buffer.frequency, global_buffer.duty_cycle);
+
+    if (!panel_save_ppm(opt.out)) {
+        fprintf(stderr, "cannot write %s\n", opt.out);
+        return 1;
+    }
+    fprintf(stderr, "screen: %s\n", opt.out);
+    return 0;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+// Кнопки на прерываниях GPIO.
+//
+// Фронт на выводе запрещает его прерывание и ставит будильник SDK на
+// INPUT_DEBOUNCE_US: по нему уровень читается уже после дребезга, и если
+// он отличается от принятого - в очередь уходит нажатие или отпускание.
+// Пока кнопка нажата, тот же будильник выдаёт повторы: первый через
+// INPUT_REPEAT_DELAY_US, дальше всё чаще, до INPUT_REPEAT_MIN_US.
+//
+// Прерывания и будильники работают на ядре дисплея, события забираются
+// в его цикле: опроса выводов в цикле нет, и задержка реакции не зависит
+// от времени кадра. Кнопки замыкают вывод на землю (подтяжка вверх).
+
+#define INPUT_DEBOUNCE_US      5000
+#define INPUT_REPEAT_DELAY_US  400000
+#define INPUT_REPEAT_START_US  150000
+#define INPUT_REPEAT_MIN_US    30000
+#define INPUT_QUEUE_SIZE       16      // Степень двойки
+
+typedef enum {
+    INPUT_HOLD,
+    INPUT_PLUS,
+    INPUT_MINUS,
+    INPUT_SET,
+    INPUT_BUTTON_COUNT
+} InputButton;
+
+typedef enum {
+    INPUT_PRESS,
+    INPUT_REPEAT,
+    INPUT_RELEASE
+} InputEventType;
+
+typedef struct {
+    uint8_t button;     // InputButton
+    uint8_t type;       // InputEventType
+    uint16_t repeat;    // Номер повтора (0 у нажатия)
+    uint32_t time_us;
+} InputEvent;
+
+typedef struct {
+    uint32_t events;    // Событий в очередь
+    uint32_t bounces;   // Фронтов, после которых уровень не изменился
+    uint32_t dropped;   // Очередь была полна
+} InputStats;
+
+// Выводы кнопок в порядке InputButton
+void input_init(const uint8_t pins[INPUT_BUTTON_COUNT]);
+
+// Следующее событие из очереди. false - очередь пуста
+bool input_get_event(InputEvent *event);
+
+// Принятое (после подавления дребезга) состояние кнопки
+bool input_is_pressed(InputButton button);
+
+void input_get_stats(InputStats *stats);
+
+// Множитель шага для повторов: чем дольше держат кнопку, тем крупнее шаг
+static inline int32_t input_accel(const InputEvent *event) {
+    if (event->repeat < 8) return 1;
+    if (event->repeat < 24) return 4;
+    return 16;
+}
@@ -0,0 +1,145 @@
+#include "input/input.h"
+#include "pico/stdlib.h"
+#include "pico/time.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+
+#define EDGES (GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE)
+
+typedef struct {
+    uint8_t pin;
+    volatile bool pressed;  // Принятое состояние
+    bool settling;          // Будильник ждёт конца дребезга
+    alarm_id_t alarm;       // 0 - будильника нет
+    uint16_t repeats;
+    uint32_t interval_us;   // Следующий интервал повтора
+} Button;
+
+static Button buttons[INPUT_BUTTON_COUNT];
+
+// Очередь событий: пишут прерывания, читает цикл ядра дисплея (то же ядро)
+static InputEvent queue[INPUT_QUEUE_SIZE];
+static volatile uint8_t queue_head;
+static volatile uint8_t queue_tail;
+static InputStats stats;
+
+static void push_event(InputButton button, InputEventType type, uint16_t repeat) {
+    uint8_t head = queue_head;
+    if ((uint8_t)(head - queue_tail) >= INPUT_QUEUE_SIZE) {
+        stats.dropped++;
+        return;
+    }
+    queue[head & (INPUT_QUEUE_SIZE - 1)] = (InputEvent){
+        .button = button,
+        .type = type,
+        .repeat = repeat,
+        .time_us = time_us_32(),
+    };
+    queue_head = head + 1;
+    stats.events++;
+    __sev();
+}
+
+// Будильник кнопки: сначала конец дребезга, потом повторы. Возвращаемое
+// значение > 0 - перезапуск через столько мкс
+static int64_t button_alarm(alarm_id_t id, void *user_data) {
+    (void)id;
+    Button *b = user_data;
+    InputButton button = (InputButton)(b - buttons);
+    bool down = !gpio_get(b->pin);
+
+    if (b->settling) {
+        b->settling = false;
+        // Фронты за время дребезга не нужны: уровень прочитан сейчас
+        gpio_acknowledge_irq(b->pin, EDGES);
+        gpio_set_irq_enabled(b->pin, EDGES, true);
+
+        if (down != b->pressed) {
+            b->pressed = down;
+            push_event(button, down ? INPUT_PRESS : INPUT_RELEASE, 0);
+        } else {
+            stats.bounces++;
+        }
+        if (!down) {
+            b->alarm = 0;
+            return 0;
+        }
+        b->repeats = 0;
+        b->interval_us = INPUT_REPEAT_START_US;
+        return INPUT_REPEAT_DELAY_US;
+    }
+
+    // Отпускание придёт фронтом, повторы на этом кончаются
+    if (!down) {
+        b->alarm = 0;
+        return 0;
+    }
+    push_event(button, INPUT_REPEAT, ++b->repeats);
+    uint32_t interval = b->interval_us;
+    b->interval_us = interval - interval / 4;
+    if (b->interval_us < INPUT_REPEAT_MIN_US) b->interval_us = INPUT_REPEAT_MIN_US;
+    return interval;
+}
+
+// Общее прерывание банка GPIO: один обработчик на выводы всех кнопок
+static void input_irq_handler(void) {
+    for (int i = 0; i < INPUT_BUTTON_COUNT; i++) {
+        Button *b = &buttons[i];
+        if (!(gpio_get_irq_event_mask(b->pin) & EDGES)) continue;
+
+        gpio_acknowledge_irq(b->pin, EDGES);
+        gpio_set_irq_enabled(b->pin, EDGES, false);
+        if (b->alarm) cancel_alarm(b->alarm);
+        b->settling = true;
+        b->alarm = add_alarm_in_us(INPUT_DEBOUNCE_US, button_alarm, b, true);
+        if (b->alarm <= 0) {
+            // Будильников не осталось: без подавления дребезга
+            b->alarm = 0;
+            b->settling = false;
+            gpio_set_irq_enabled(b->pin, EDGES, true);
+            bool down = !gpio_get(b->pin);
+            if (down != b->pressed) {
+                b->pressed = down;
+                push_event((InputButton)i, down ? INPUT_PRESS : INPUT_RELEASE, 0);
+            }
+        }
+    }
+}
+
+void input_init(const uint8_t pins[INPUT_BUTTON_COUNT]) {
+    queue_head = queue_tail = 0;
+    stats = (InputStats){ 0 };
+
+    uint32_t mask = 0;
+    for (int i = 0; i < INPUT_BUTTON_COUNT; i++) {
+        Button *b = &buttons[i];
+        *b = (Button){ .pin = pins[i] };
+        gpio_init(b->pin);
+        gpio_set_dir(b->pin, GPIO_IN);
+        gpio_pull_up(b->pin);
+        b->pressed = !gpio_get(b->pin);
+        mask |= 1u << b->pin;
+    }
+
+    gpio_add_raw_irq_handler_masked(mask, input_irq_handler);
+    for (int i = 0; i < INPUT_BUTTON_COUNT; i++) {
+        gpio_set_irq_enabled(buttons[i].pin, EDGES, true);
+    }
+    irq_set_enabled(IO_IRQ_BANK0, true);
+}
+
+bool input_get_event(InputEvent *event) {
+    uint8_t tail = queue_tail;
+    if (tail == queue_head) return false;
+    *event = queue[tail & (INPUT_QUEUE_SIZE - 1)];
+    queue_tail = tail + 1;
+    return true;
+}
+
+bool input_is_pressed(InputButton button) {
+    return button < INPUT_BUTTON_COUNT && buttons[button].pressed;
+}
+
+void input_get_stats(InputStats *out) {
+    *out = stats;
+}
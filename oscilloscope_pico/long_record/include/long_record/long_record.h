@@ -0,0 +1,67 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+// Длинная запись: последние LONG_RECORD_SAMPLES отсчётов непрерывного
+// захвата (много блоков подряд) и пирамида минимумов/максимумов над ними.
+//
+// Узел уровня l покрывает 4^(l+1) соседних отсчётов. Пирамида достраивается
+// при каждом добавленном блоке: пересчитываются только задетые им узлы.
+// Вывод окна выбирает уровень, у которого узел не длиннее отсчётов на
+// столбец, поэтому на столбец приходится не больше четырёх узлов - время
+// вывода зависит от ширины экрана, а не от длины окна. Отсчёты по краям
+// записи, не покрытые целым узлом, берутся из самой записи.
+//
+// Пропуск блока (разрыв по sequence) начинает запись заново: окно всегда
+// непрерывно во времени.
+//
+// Блоки добавляет ядро захвата (long_record_append), остальные функции -
+// ядра дисплея, в том числе очистка: она выполняется ядром захвата перед
+// следующим блоком. Вывод берёт согласованные конец и длину записи; если
+// за время вывода окно у старого края перезаписано новым кругом кольца,
+// крайний столбец один кадр показывает новые отсчёты.
+
+// 4096 отсчётов - 8,2 мс при 500 кГц; вместе с пирамидой 13 КБ RAM
+#define LONG_RECORD_SAMPLES      4096  // Степень двойки, кратная 4^LEVELS
+#define LONG_RECORD_FANOUT_SHIFT 2     // 4 узла нижнего уровня на узел
+// Узлы по 4 и 16 отсчётов: на 320 столбцов при 4096 отсчётах больше 13
+// отсчётов на столбец не бывает, узлы по 16 нужны узким окнам (отсчёт
+// курсора по записи - один столбец)
+#define LONG_RECORD_LEVELS       2
+
+typedef struct {
+    uint16_t min;
+    uint16_t max;
+} RecordSpan;
+
+typedef struct {
+    uint32_t blocks;    // Добавлено блоков
+    uint32_t restarts;  // Запись начата заново из-за пропуска блока
+} LongRecordStats;
+
+void long_record_init(void);
+// Длина сразу 0, отсчёты сбрасываются перед следующим блоком
+void long_record_clear(void);
+
+// Блок захвата в конец записи (ядро захвата)
+void long_record_append(const uint16_t *samples, uint16_t count, uint32_t sequence);
+
+// Отсчётов в записи (не больше LONG_RECORD_SAMPLES)
+uint32_t long_record_length(void);
+
+// Уровень пирамиды для окна span отсчётов на width столбцов: -1 - сами
+// отсчёты, 0 - узлы по 4 и т.д.
+int long_record_level(uint32_t span, uint16_t width);
+
+// Минимум и максимум каждого из width столбцов для окна из span отсчётов,
+// правый край которого на offset отсчётов раньше самого нового. Окно
+// ограничивается записью. Если отсчётов меньше, чем столбцов, столбец -
+// один отсчёт. Возвращает число столбцов, 0 - запись пуста
+uint16_t long_record_render(uint32_t offset, uint32_t span, RecordSpan *columns, uint16_t width);
+
+// Копия count отсчётов подряд, последний из которых на offset раньше
+// самого нового (для интерполяции окна короче экрана). Ограничивается
+// записью; возвращает число скопированных
+uint32_t long_record_read(uint32_t offset, uint32_t count, uint16_t *out);
+
+void long_record_get_stats(LongRecordStats *stats);
@@ -0,0 +1,203 @@
+#include "long_record/long_record.h"
+#include <string.h>
+
+#define RING_MASK (LONG_RECORD_SAMPLES - 1)
+
+// Сдвиг размера узла уровня l: 4 << 2l отсчётов
+#define LEVEL_SHIFT(l) (LONG_RECORD_FANOUT_SHIFT * ((l) + 1))
+#define FANOUT         (1u << LONG_RECORD_FANOUT_SHIFT)
+
+static uint16_t ring[LONG_RECORD_SAMPLES];
+static RecordSpan level_4[LONG_RECORD_SAMPLES >> LEVEL_SHIFT(0)];
+static RecordSpan level_16[LONG_RECORD_SAMPLES >> LEVEL_SHIFT(1)];
+static RecordSpan *const levels[LONG_RECORD_LEVELS] = { level_4, level_16 };
+
+// Позиции отсчётов сквозные (uint32 с переполнением): отсчёт p лежит в
+// ring[p & RING_MASK], узел уровня l с номером k - в levels[l][k & mask].
+// Запись - это [written - length, written). Пишет только ядро захвата
+static volatile uint32_t written = 0;
+static volatile uint32_t length = 0;
+static uint32_t next_sequence = 0;
+static volatile bool clear_requested = false;
+
+static LongRecordStats stats;
+
+void long_record_init(void) {
+    length = 0;
+    clear_requested = false;
+    memset(&stats, 0, sizeof(stats));
+}
+
+void long_record_clear(void) {
+    clear_requested = true;
+}
+
+// Конец и длина записи из одного и того же состояния: если между чтениями
+// добавился блок, читаем заново
+static uint32_t snapshot(uint32_t *end) {
+    uint32_t w, n;
+    do {
+        w = written;
+        n = clear_requested ? 0 : length;
+    } while (w != written);
+    *end = w;
+    return n;
+}
+
+uint32_t long_record_length(void) {
+    uint32_t end;
+    return snapshot(&end);
+}
+
+static inline uint32_t level_mask(int level) {
+    return (LONG_RECORD_SAMPLES >> LEVEL_SHIFT(level)) - 1;
+}
+
+static inline void merge(RecordSpan *s, uint16_t min, uint16_t max) {
+    if (min < s->min) s->min = min;
+    if (max > s->max) s->max = max;
+}
+
+// Узел заново из четырёх узлов (или отсчётов) уровнем ниже. Часть из них
+// может быть ещё от прошлого круга кольца: такой узел выходит за запись и
+// при выводе не используется
+static void rebuild_node(int level, uint32_t k) {
+    RecordSpan s = { 0xFFFF, 0 };
+    uint32_t first = k << LONG_RECORD_FANOUT_SHIFT;
+    if (level == 0) {
+        for (uint32_t i = 0; i < FANOUT; i++) {
+            uint16_t v = ring[(first + i) & RING_MASK];
+            merge(&s, v, v);
+        }
+    } else {
+        const RecordSpan *below = levels[level - 1];
+        uint32_t mask = level_mask(level - 1);
+        for (uint32_t i = 0; i < FANOUT; i++) {
+            const RecordSpan *c = &below[(first + i) & mask];
+            merge(&s, c->min, c->max);
+        }
+    }
+    levels[level][k & level_mask(level)] = s;
+}
+
+void long_record_append(const uint16_t *samples, uint16_t count, uint32_t sequence) {
+    uint32_t len = length;
+    if (clear_requested) {
+        len = 0;
+        memset(&stats, 0, sizeof(stats));
+        clear_requested = false;
+    }
+    if (count == 0) return;
+    if (len && sequence != next_sequence) {
+        len = 0;
+        stats.restarts++;
+    }
+    next_sequence = sequence + 1;
+    length = len;
+
+    // Блок в кольцо, не больше двух кусков
+    uint32_t from = written;
+    uint32_t end = from + count;
+    uint32_t pos = from & RING_MASK;
+    uint32_t first = count < LONG_RECORD_SAMPLES - pos ? count : LONG_RECORD_SAMPLES - pos;
+    memcpy(&ring[pos], samples, first * sizeof(uint16_t));
+    memcpy(ring, &samples[first], (count - first) * sizeof(uint16_t));
+
+    // Задетые узлы снизу вверх: на 320 отсчётов 80 + 20 узлов. Число узлов
+    // считается разностью позиций - номер узла переполняется не на 2^32
+    for (int level = 0; level < LONG_RECORD_LEVELS; level++) {
+        uint32_t shift = LEVEL_SHIFT(level);
+        uint32_t k = from >> shift;
+        uint32_t n = ((end - 1 - (k << shift)) >> shift) + 1;
+        for (; n; n--, k++) rebuild_node(level, k);
+    }
+
+    // Блок виден выводу только целиком, вместе с узлами
+    written = end;
+    length = len + count < LONG_RECORD_SAMPLES ? len + count : LONG_RECORD_SAMPLES;
+    stats.blocks++;
+}
+
+int long_record_level(uint32_t span, uint16_t width) {
+    uint32_t per_column = width ? span / width : 0;
+    int level = -1;
+    while (level + 1 < LONG_RECORD_LEVELS && per_column >= (1u << LEVEL_SHIFT(level + 1))) level++;
+    return level;
+}
+
+static void span_samples(RecordSpan *s, uint32_t p, uint32_t end) {
+    for (; p != end; p++) {
+        uint16_t v = ring[p & RING_MASK];
+        merge(s, v, v);
+    }
+}
+
+// Отсчёты [p, end): целые узлы уровня, края - отсчётами
+static void span_range(RecordSpan *s, int level, uint32_t p, uint32_t end) {
+    if (level < 0) {
+        span_samples(s, p, end);
+        return;
+    }
+    uint32_t shift = LEVEL_SHIFT(level);
+    uint32_t size = 1u << shift;
+    uint32_t lo = (p + size - 1) & ~(size - 1);
+    uint32_t hi = end & ~(size - 1);
+    if ((int32_t)(hi - lo) <= 0) {
+        span_samples(s, p, end);
+        return;
+    }
+    span_samples(s, p, lo);
+    const RecordSpan *nodes = levels[level];
+    uint32_t mask = level_mask(level);
+    uint32_t k = lo >> shift;
+    for (uint32_t n = (hi - lo) >> shift; n; n--, k++) {
+        merge(s, nodes[k & mask].min, nodes[k & mask].max);
+    }
+    span_samples(s, hi, end);
+}
+
+uint16_t long_record_render(uint32_t offset, uint32_t span, RecordSpan *columns, uint16_t width) {
+    uint32_t end;
+    uint32_t len = snapshot(&end);
+    if (!len || !width) return 0;
+    if (span > len) span = len;
+    if (span == 0) span = 1;
+    if (offset > len - span) offset = len - span;
+    uint32_t start = end - offset - span;
+
+    if (span < width) {
+        for (uint16_t x = 0; x < width; x++) {
+            uint16_t v = ring[(start + (uint32_t)x * span / width) & RING_MASK];
+            columns[x] = (RecordSpan){ v, v };
+        }
+        return width;
+    }
+
+    // Внутренние границы столбцов выравниваются по узлам выбранного уровня:
+    // каждый узел попадает ровно в один столбец, отсчёты - только по краям
+    int level = long_record_level(span, width);
+    uint32_t align = level < 0 ? ~0u : ~((1u << LEVEL_SHIFT(level)) - 1);
+    uint32_t lo = start;
+    for (uint16_t x = 0; x < width; x++) {
+        uint32_t hi = x + 1 == width ? start + span :
+            (start + (uint32_t)((uint64_t)(x + 1) * span / width)) & align;
+        columns[x] = (RecordSpan){ 0xFFFF, 0 };
+        span_range(&columns[x], level, lo, hi);
+        lo = hi;
+    }
+    return width;
+}
+
+uint32_t long_record_read(uint32_t offset, uint32_t count, uint16_t *out) {
+    uint32_t end;
+    uint32_t len = snapshot(&end);
+    if (offset >= len) return 0;
+    if (count > len - offset) count = len - offset;
+    uint32_t p = end - offset - count;
+    for (uint32_t i = 0; i < count; i++) out[i] = ring[(p + i) & RING_MASK];
+    return count;
+}
+
+void long_record_get_stats(LongRecordStats *out) {
+    *out = stats;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+// Испытание по маске: каждый захват сравнивается с допустимой областью
+// вокруг образцовой осциллограммы, считаются годные и негодные.
+//
+// Маска компилируется один раз в пары [lo, lo + range] на столбец -
+// отсчёт от фронта. Границы столбца - минимум и максимум образца на
+// +-MASK_SPREAD отсчётов вокруг (дрожание фронта на отсчёт-другой не
+// считается нарушением), расширенные на допуск. Проверка - один проход
+// по блоку с выходом на первом нарушении, на отсчёт одно сравнение:
+// (v - lo) без знака больше range.
+//
+// Испытания идут на ядре захвата, на каждый обработанный блок с фронтом,
+// а не раз в кадр экрана. Блок без фронта (при включённой синхронизации)
+// испытанием не считается. Ядро дисплея только компилирует маску (во
+// второй банк, затем переключение; если по второму банку ещё идёт
+// испытание, начатое до прошлого переключения, компиляция ждёт его конца),
+// читает счётчики и сбрасывает их запросом, который выполняет ядро захвата. С остановкой на нарушении
+// негодный блок копируется, испытания стоят до mask_resume.
+
+#define MASK_MAX_POINTS    320      // Блок захвата целиком (BUFFER_SIZE)
+#define MASK_SPREAD        2
+#define MASK_TOLERANCE_MV  100      // Допуск по умолчанию
+#define MASK_RATE_US       1000000  // Период пересчёта испытаний в секунду
+
+typedef struct {
+    uint16_t lo;
+    uint16_t range;     // Допустимо lo..lo + range
+} MaskLimit;
+
+typedef struct {
+    uint32_t total;
+    uint32_t passed;
+    uint32_t failed;
+} MaskCounters;
+
+// Последнее нарушение
+typedef struct {
+    uint32_t test;      // Номер испытания (с единицы после сброса)
+    uint16_t column;    // Столбец маски
+    uint16_t value;     // Отсчёт, вышедший за границу
+} MaskFailure;
+
+void mask_init(void);
+
+// Ядро дисплея. Образец samples[0..count), фронт в нём на отсчёте
+// trigger (< 0 - без синхронизации, столбцы с начала блока). Счётчики
+// сбрасываются. false - образец пуст
+bool mask_compile(const uint16_t *samples, uint16_t count, int16_t trigger, uint16_t tolerance);
+bool mask_valid(void);
+
+// Границы действующей маски и отсчёт фронта в ней. NULL - маски нет
+const MaskLimit *mask_limits(uint16_t *count, uint16_t *trigger);
+
+void mask_set_enabled(bool enable);
+bool mask_enabled(void);
+
+void mask_set_stop_on_fail(bool enable);
+bool mask_get_stop_on_fail(void);
+
+// Сброс счётчиков (выполнится перед следующим испытанием) и продолжение
+// после остановки
+void mask_reset(void);
+void mask_resume(void);
+bool mask_stopped(void);
+
+// Счётчики (нули, пока сброс не выполнен)
+void mask_get_counters(MaskCounters *counters);
+// false - нарушений после сброса не было
+bool mask_get_failure(MaskFailure *failure);
+
+// Удержанный при остановке блок: число отсчётов, фронт (< 0 - без
+// синхронизации). 0 - остановки нет
+uint16_t mask_get_held(uint16_t *samples, int16_t *trigger);
+
+// Испытаний в секунду по счётчику, пересчёт раз в MASK_RATE_US
+uint32_t mask_tests_per_second(uint32_t now_us);
+
+// Ядро захвата: блок с фронтом на отсчёте trigger (< 0 - без
+// синхронизации). Возвращает false при нарушении
+bool mask_test(const uint16_t *block, uint16_t count, int trigger);
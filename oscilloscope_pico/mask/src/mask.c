@@ -0,0 +1,217 @@
+#include "mask/mask.h"
+#include <pico/stdlib.h>
+#include <stdatomic.h>
+#include <string.h>
+
+#define BANK_NONE 0xFF
+
+// Два банка: ядро захвата читает active, компиляция пишет в другой.
+// Испытание объявляет банк, который читает (reading), как захват слота в
+// frame_queue: компиляция не пишет в банк, пока по нему идёт испытание,
+// начатое до предыдущего переключения
+static MaskLimit banks[2][MASK_MAX_POINTS];
+static uint16_t bank_count[2];
+static uint16_t bank_trigger[2];
+static _Atomic uint8_t active = 0;
+static _Atomic uint8_t reading = BANK_NONE;
+static volatile bool valid = false;
+
+static volatile bool enabled = false;
+static volatile bool stop_on_fail = false;
+static volatile bool stopped = false;
+static volatile bool reset_requested = false;
+
+// Пишет только ядро захвата
+static volatile uint32_t total = 0;
+static volatile uint32_t passed = 0;
+static volatile uint32_t failed = 0;
+static MaskFailure last_failure;
+
+static uint16_t held[MASK_MAX_POINTS];
+static uint16_t held_count = 0;
+static int16_t held_trigger = -1;
+
+// Испытаний в секунду: только ядро дисплея
+static uint32_t rate_us = 0;
+static uint32_t rate_total = 0;
+static uint32_t rate = 0;
+
+void mask_init(void) {
+    atomic_store_explicit(&active, 0, memory_order_relaxed);
+    atomic_store_explicit(&reading, BANK_NONE, memory_order_relaxed);
+    valid = false;
+    enabled = false;
+    stop_on_fail = false;
+    stopped = false;
+    reset_requested = false;
+    total = passed = failed = 0;
+    held_count = 0;
+    rate = 0;
+}
+
+bool mask_compile(const uint16_t *samples, uint16_t count, int16_t trigger, uint16_t tolerance) {
+    if (!count) return false;
+    if (count > MASK_MAX_POINTS) count = MASK_MAX_POINTS;
+
+    uint8_t b = atomic_load_explicit(&active, memory_order_relaxed) ^ 1;
+    // Барьер запись-чтение: предыдущее переключение упорядочено до чтения
+    // объявления. Испытание по этому банку - самое большее одно, начатое
+    // до переключения; следующее увидит новый active
+    atomic_thread_fence(memory_order_seq_cst);
+    while (atomic_load_explicit(&reading, memory_order_acquire) == b) tight_loop_contents();
+
+    for (int c = 0; c < count; c++) {
+        int from = c - MASK_SPREAD < 0 ? 0 : c - MASK_SPREAD;
+        int to = c + MASK_SPREAD >= count ? count - 1 : c + MASK_SPREAD;
+        uint16_t lo = samples[from], hi = samples[from];
+        for (int i = from + 1; i <= to; i++) {
+            if (samples[i] < lo) lo = samples[i];
+            if (samples[i] > hi) hi = samples[i];
+        }
+        int32_t l = (int32_t)lo - tolerance;
+        int32_t h = (int32_t)hi + tolerance;
+        if (l < 0) l = 0;
+        if (h > 4095) h = 4095;
+        banks[b][c] = (MaskLimit){ .lo = (uint16_t)l, .range = (uint16_t)(h - l) };
+    }
+    bank_count[b] = count;
+    bank_trigger[b] = trigger < 0 ? 0 : (uint16_t)trigger;
+    atomic_store_explicit(&active, b, memory_order_release);
+    valid = true;
+    mask_reset();
+    return true;
+}
+
+bool mask_valid(void) {
+    return valid;
+}
+
+const MaskLimit *mask_limits(uint16_t *count, uint16_t *trigger) {
+    if (!valid) return NULL;
+    uint8_t b = atomic_load_explicit(&active, memory_order_relaxed);
+    if (count) *count = bank_count[b];
+    if (trigger) *trigger = bank_trigger[b];
+    return banks[b];
+}
+
+void mask_set_enabled(bool enable) {
+    enabled = enable && valid;
+}
+
+bool mask_enabled(void) {
+    return enabled;
+}
+
+void mask_set_stop_on_fail(bool enable) {
+    stop_on_fail = enable;
+}
+
+bool mask_get_stop_on_fail(void) {
+    return stop_on_fail;
+}
+
+void mask_reset(void) {
+    reset_requested = true;
+    mask_resume();
+}
+
+// Удержанный блок ядро захвата не трогает, пока stopped
+void mask_resume(void) {
+    stopped = false;
+}
+
+bool mask_stopped(void) {
+    return stopped;
+}
+
+void mask_get_counters(MaskCounters *c) {
+    if (reset_requested) {
+        *c = (MaskCounters){ 0 };
+        return;
+    }
+    c->total = total;
+    c->passed = passed;
+    c->failed = failed;
+}
+
+bool mask_get_failure(MaskFailure *failure) {
+    if (reset_requested || !failed) return false;
+    *failure = last_failure;
+    return true;
+}
+
+uint16_t mask_get_held(uint16_t *samples, int16_t *trigger) {
+    if (!stopped) return 0;
+    memcpy(samples, held, held_count * sizeof(held[0]));
+    *trigger = held_trigger;
+    return held_count;
+}
+
+uint32_t mask_tests_per_second(uint32_t now_us) {
+    MaskCounters c;
+    mask_get_counters(&c);
+    if (c.total < rate_total) {
+        rate_total = c.total;
+        rate_us = now_us;
+        rate = 0;
+    }
+    uint32_t elapsed = now_us - rate_us;
+    if (elapsed >= MASK_RATE_US) {
+        rate = (uint32_t)((uint64_t)(c.total - rate_total) * 1000000 / elapsed);
+        rate_total = c.total;
+        rate_us = now_us;
+    }
+    return rate;
+}
+
+// Испытание по банку b: false - нарушение
+static bool __not_in_flash_func(test_bank)(uint8_t b, const uint16_t *block, uint16_t count, int trigger) {
+    // Столбец c - отсчёт c + shift блока
+    const MaskLimit *limits = banks[b];
+    int shift = trigger < 0 ? 0 : trigger - bank_trigger[b];
+    int first = shift < 0 ? -shift : 0;
+    int last = count - shift < bank_count[b] ? count - shift : bank_count[b];
+    if (first >= last) return true;
+
+    const uint16_t *s = &block[shift];
+    int c = first;
+    while (c < last && (uint16_t)(s[c] - limits[c].lo) <= limits[c].range) c++;
+
+    uint32_t n = total + 1;
+    total = n;
+    if (c == last) {
+        passed++;
+        return true;
+    }
+
+    failed++;
+    last_failure = (MaskFailure){ .test = n, .column = (uint16_t)c, .value = s[c] };
+    if (stop_on_fail) {
+        held_count = count > MASK_MAX_POINTS ? MASK_MAX_POINTS : count;
+        memcpy(held, block, held_count * sizeof(held[0]));
+        held_trigger = (int16_t)trigger;
+        stopped = true;
+    }
+    return false;
+}
+
+bool __not_in_flash_func(mask_test)(const uint16_t *block, uint16_t count, int trigger) {
+    if (reset_requested) {
+        total = passed = failed = 0;
+        reset_requested = false;
+    }
+    if (!enabled || stopped) return true;
+
+    // Объявляем банк, затем проверяем, что он всё ещё действующий. Если
+    // маску успели переключить, компиляция могла не увидеть объявления
+    uint8_t b;
+    for (;;) {
+        b = atomic_load_explicit(&active, memory_order_acquire);
+        atomic_store_explicit(&reading, b, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        if (atomic_load_explicit(&active, memory_order_acquire) == b) break;
+    }
+    bool pass = test_bank(b, block, count, trigger);
+    atomic_store_explicit(&reading, BANK_NONE, memory_order_release);
+    return pass;
+}
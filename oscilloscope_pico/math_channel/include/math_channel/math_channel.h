@@ -0,0 +1,83 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "reference/reference.h"
+
+// Математический канал: A+B, A-B, A*B, dA/dt и интеграл A в целых числах.
+//
+// A - захваченный канал, B - эталон (reference.h), других каналов у АЦП
+// нет. Отсчёты переводятся в милливольты по усилению и смещению
+// калибровки, результат умножается на масштаб и переводится обратно в
+// коды той же калибровки - трасса идёт через измерения и отрисовку как
+// обычный канал. Всё за один проход по блоку.
+//
+// Единицы результата (на экране - "В"):
+//   A+B, A-B  В
+//   A*B       В^2
+//   dA/dt     В/мс
+//   intA      В*мс, интеграл начинается с первого показанного отсчёта
+//
+// Результат вне диапазона АЦП ограничивается, как у настоящего канала.
+// Для разности, производной и интеграла ноль поднят на середину шкалы
+// (position_mv), иначе отрицательная половина не видна.
+
+typedef enum {
+    MATH_OFF,
+    MATH_ADD,
+    MATH_SUB,
+    MATH_MUL,
+    MATH_DERIV,
+    MATH_INTEG,
+    MATH_OP_COUNT
+} MathOp;
+
+#define MATH_SCALE_ONE_Q16  65536
+#define MATH_SCALE_MIN_Q16  (MATH_SCALE_ONE_Q16 / 64)
+#define MATH_SCALE_MAX_Q16  (MATH_SCALE_ONE_Q16 * 64)
+
+typedef struct {
+    MathOp op;
+    int32_t scale_q16;      // Множитель результата
+    int32_t position_mv;    // Где на шкале ноль результата (напряжение трассы)
+
+    // Пересчёт, обновляет math_channel_configure
+    uint32_t sample_rate;
+    uint32_t gain_q16;      // мВ на код
+    int32_t offset_mv;
+    uint32_t inv_gain_q16;  // Кодов на мВ
+    int32_t full_mv;        // Размах шкалы (код 4095) от offset_mv
+    int32_t k;              // Множитель операции вместе с масштабом,
+    uint8_t k_shift;        // результат = (v * k) >> k_shift
+
+    // Состояние между блоками: производная продолжается на следующий блок
+    uint32_t next_sequence;
+    int32_t prev_mv;
+    bool have_prev;
+} MathChannel;
+
+void math_channel_init(MathChannel *m);
+
+// Выбор операции сбрасывает состояние и ставит ноль результата по умолчанию
+void math_channel_set_op(MathChannel *m, MathOp op);
+void math_channel_set_scale(MathChannel *m, int32_t scale_q16);
+
+// Пересчёт множителей под частоту дискретизации и калибровку. Дёшево,
+// но с делениями - вызывается при их изменении, не на каждый блок
+void math_channel_configure(MathChannel *m, uint32_t sample_rate,
+                            uint32_t gain_q16, int32_t offset_mv);
+
+static inline bool math_channel_needs_b(MathOp op) {
+    return op == MATH_ADD || op == MATH_SUB || op == MATH_MUL;
+}
+
+// Короткое имя для экрана: "A+B", "dA/dt"
+const char *math_channel_name(MathOp op);
+
+// Обработка блока: отсчёты block[start..count) в out[0..count - start).
+// Отсчёт перед start (или последний отсчёт предыдущего блока, если
+// sequence идёт подряд) нужен производной. b - эталон, выровненный по
+// start; нужен для A+B, A-B, A*B. Возвращает число отсчётов в out,
+// 0 - операция выключена или нет B
+uint16_t math_channel_process(MathChannel *m, const uint16_t *block, uint16_t start,
+                              uint16_t count, uint32_t sequence,
+                              ReferenceCursor *b, uint16_t *out);
@@ -0,0 +1,151 @@
+#include "math_channel/math_channel.h"
+
+#define CODE_MAX 4095
+
+// Сдвиги множителей: у интеграла множитель мал (1000 / частота), ему
+// нужна дробная часть длиннее
+#define SHIFT_DEFAULT 16
+#define SHIFT_INTEG   24
+
+// Множитель операции и положение нуля по текущим масштабу, частоте и
+// калибровке
+static void update_factors(MathChannel *m) {
+    int64_t scale = m->scale_q16;
+    int64_t k;
+    m->k_shift = SHIFT_DEFAULT;
+    switch (m->op) {
+        case MATH_MUL:
+            // v = (a * b) >> 10, в В^2 (мВ * мВ / 1000)
+            k = scale * 1024 / 1000;
+            break;
+        case MATH_DERIV:
+            // v = разность соседних отсчётов, мВ на отсчёт -> мВ/мс
+            k = scale * m->sample_rate / 1000;
+            break;
+        case MATH_INTEG:
+            // v = сумма отсчётов, мВ * отсчёт -> мВ * мс
+            m->k_shift = SHIFT_INTEG;
+            k = m->sample_rate ? (scale << (SHIFT_INTEG - SHIFT_DEFAULT)) * 1000 / m->sample_rate : 0;
+            break;
+        default:
+            k = scale;
+            break;
+    }
+    // Дальше результат всё равно упрётся в шкалу
+    m->k = k > INT32_MAX ? INT32_MAX : (int32_t)k;
+
+    bool centered = m->op == MATH_SUB || m->op == MATH_DERIV || m->op == MATH_INTEG;
+    m->position_mv = centered ? m->offset_mv + m->full_mv / 2 : 0;
+}
+
+void math_channel_init(MathChannel *m) {
+    *m = (MathChannel){
+        .op = MATH_OFF,
+        .scale_q16 = MATH_SCALE_ONE_Q16,
+    };
+}
+
+void math_channel_set_op(MathChannel *m, MathOp op) {
+    m->op = op < MATH_OP_COUNT ? op : MATH_OFF;
+    m->have_prev = false;
+    update_factors(m);
+}
+
+void math_channel_set_scale(MathChannel *m, int32_t scale_q16) {
+    if (scale_q16 < MATH_SCALE_MIN_Q16) scale_q16 = MATH_SCALE_MIN_Q16;
+    if (scale_q16 > MATH_SCALE_MAX_Q16) scale_q16 = MATH_SCALE_MAX_Q16;
+    m->scale_q16 = scale_q16;
+    update_factors(m);
+}
+
+void math_channel_configure(MathChannel *m, uint32_t sample_rate,
+                            uint32_t gain_q16, int32_t offset_mv) {
+    if (!gain_q16) gain_q16 = 1;
+    m->sample_rate = sample_rate;
+    m->gain_q16 = gain_q16;
+    m->offset_mv = offset_mv;
+    m->inv_gain_q16 = (uint32_t)(((uint64_t)1 << 32) / gain_q16);
+    m->full_mv = (int32_t)(((uint64_t)CODE_MAX * gain_q16 + 0x8000) >> 16);
+    update_factors(m);
+}
+
+const char *math_channel_name(MathOp op) {
+    static const char *const names[MATH_OP_COUNT] = {
+        "off", "A+B", "A-B", "A*B", "dA/dt", "intA"
+    };
+    return op < MATH_OP_COUNT ? names[op] : "?";
+}
+
+// Код -> мВ так же, как calibration_code_to_mv
+static inline int32_t to_mv(const MathChannel *m, uint16_t code) {
+    return (int32_t)(((uint32_t)code * m->gain_q16 + 0x8000) >> 16) + m->offset_mv;
+}
+
+// Результат операции -> код с ограничением по шкале АЦП
+static inline uint16_t to_code(const MathChannel *m, int32_t v) {
+    int32_t mv = (int32_t)(((int64_t)v * m->k) >> m->k_shift) + m->position_mv - m->offset_mv;
+    if (mv <= 0) return 0;
+    if (mv >= m->full_mv) return CODE_MAX;
+    uint32_t code = ((uint32_t)mv * m->inv_gain_q16 + 0x8000) >> 16;
+    return code > CODE_MAX ? CODE_MAX : (uint16_t)code;
+}
+
+uint16_t math_channel_process(MathChannel *m, const uint16_t *block, uint16_t start,
+                              uint16_t count, uint32_t sequence,
+                              ReferenceCursor *b, uint16_t *out) {
+    if (m->op == MATH_OFF || start >= count) return 0;
+    if (math_channel_needs_b(m->op) && !b) return 0;
+
+    const uint16_t *a = &block[start];
+    uint16_t n = count - start;
+    uint16_t i = 0;
+    uint16_t ref;
+
+    switch (m->op) {
+        case MATH_ADD:
+            for (; i < n && reference_next(b, &ref); i++) {
+                out[i] = to_code(m, to_mv(m, a[i]) + to_mv(m, ref));
+            }
+            break;
+        case MATH_SUB:
+            for (; i < n && reference_next(b, &ref); i++) {
+                out[i] = to_code(m, to_mv(m, a[i]) - to_mv(m, ref));
+            }
+            break;
+        case MATH_MUL:
+            for (; i < n && reference_next(b, &ref); i++) {
+                out[i] = to_code(m, (to_mv(m, a[i]) * to_mv(m, ref)) >> 10);
+            }
+            break;
+        case MATH_DERIV: {
+            // Первому отсчёту нужен предыдущий: из этого блока или из
+            // прошлого, если блоки идут подряд. Иначе производная 0
+            int32_t prev;
+            if (start > 0) prev = to_mv(m, block[start - 1]);
+            else if (m->have_prev && sequence == m->next_sequence) prev = m->prev_mv;
+            else prev = to_mv(m, a[0]);
+            for (; i < n; i++) {
+                int32_t v = to_mv(m, a[i]);
+                out[i] = to_code(m, v - prev);
+                prev = v;
+            }
+            break;
+        }
+        case MATH_INTEG: {
+            int32_t sum = 0;
+            for (; i < n; i++) {
+                sum += to_mv(m, a[i]);
+                out[i] = to_code(m, sum);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+
+    // Последний отсчёт блока для производной следующего блока
+    m->prev_mv = to_mv(m, block[count - 1]);
+    m->have_prev = true;
+    m->next_sequence = sequence + 1;
+    return i;
+}
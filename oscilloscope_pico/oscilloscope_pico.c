@@ -3,12 +3,14 @@
 #include "adc_driver/adc_driver.h"
 #include "display_driver/display_driver.h"
 #include "global_buffer/global_buffer.h"
+#include "calibration/calibration.h"
 
 int main() {
     stdio_init_all();
 
     // Инициализация периферии
     buffer_init();
+    calibration_init(calibration_flash_port());
     
     // Запуск ядра 1 с правильным указателем на функцию
     multicore_launch_core1(core0_adc_task);
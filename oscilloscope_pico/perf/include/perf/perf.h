@@ -0,0 +1,120 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Замеры этапов конвейера: время (такты SysTick), счётчики событий и
+// задержка от фронта триггера до пикселей на экране.
+//
+// Включается определением PERF_ENABLED=1 (опция CMake OSC_PERF). Без
+// него все макросы пустые, а perf.c собирается в пустой модуль - в
+// обычной прошивке от замеров не остаётся ни кода, ни памяти.
+//
+// Время считает SysTick каждого ядра (24 бита на частоте ядра, до ~130 мс
+// при 125 МГц), поэтому начало и конец замера должны быть на одном ядре.
+// Каждый этап пишет только одно ядро, запись без блокировок.
+
+#ifndef PERF_ENABLED
+#define PERF_ENABLED 0
+#endif
+
+// Экранная строка со средним временем этапов
+#ifndef PERF_HUD
+#define PERF_HUD 1
+#endif
+
+// Период вывода отчёта в stdio USB, 0 - не выводить
+#ifndef PERF_DUMP_MS
+#define PERF_DUMP_MS 5000
+#endif
+
+typedef enum {
+    PERF_IRQ,        // Прерывание DMA (ядро захвата)
+    PERF_TRIGGER,    // check_trigger
+    PERF_MATH,       // Математический канал (преобразование блока)
+    PERF_STATS,      // buffer_update_stats
+    PERF_HISTORY,    // history_record
+    PERF_DRAW,       // draw_waveform
+    PERF_RESAMPLE,   // Пересчёт кадра в столбцы экрана (внутри draw)
+    PERF_CONVERT,    // Перевод строк 8 -> 16 бит с наложением слоя
+    PERF_SPI,        // Передача по SPI
+    PERF_TEXT,       // Строки измерений
+    PERF_FRAME,      // Кадр целиком
+    PERF_LATENCY,    // От фронта триггера до конца вывода, мкс
+    PERF_STAGE_COUNT
+} PerfStage;
+
+typedef enum {
+    PERF_CNT_BLOCKS,      // Заполненные DMA блоки
+    PERF_CNT_TRIGGERED,   // Кадры с найденным фронтом
+    PERF_CNT_UNTRIGGERED, // Кадры без фронта
+    PERF_CNT_FRAMES,      // Выведенные кадры
+    PERF_COUNTER_COUNT
+} PerfCounter;
+
+#define PERF_HIST_BUCKETS 16 // Корзина i: [2^i, 2^(i+1)) тактов, последняя - всё больше
+
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint32_t hist[PERF_HIST_BUCKETS];
+} PerfStat;
+
+#if PERF_ENABLED
+#include "hardware/structs/systick.h"
+
+extern PerfStat perf_stats[PERF_STAGE_COUNT];
+extern volatile uint32_t perf_counters[PERF_COUNTER_COUNT];
+
+// Текущее значение счётчика тактов (растущее, 24 бита)
+static inline uint32_t perf_now(void) {
+    return ~systick_hw->cvr & 0x00FFFFFF;
+}
+
+static inline uint32_t perf_elapsed(uint32_t start) {
+    return (perf_now() - start) & 0x00FFFFFF;
+}
+
+// Встраивается в место вызова: годится и для прерывания в RAM
+static inline void perf_record(PerfStage stage, uint32_t value) {
+    PerfStat *s = &perf_stats[stage];
+    if (s->count == 0 || value < s->min) s->min = value;
+    if (value > s->max) s->max = value;
+    s->sum += value;
+    s->count++;
+    // Без __builtin_clz: на M0+ это вызов __clzsi2 из flash
+    uint32_t bucket = 0;
+    while (bucket < PERF_HIST_BUCKETS - 1 && (value >> (bucket + 1))) bucket++;
+    s->hist[bucket]++;
+}
+
+// Запуск SysTick (на каждом ядре, где есть замеры)
+void perf_init_core(void);
+
+// Сброс статистики (ядро дисплея)
+void perf_reset(void);
+
+// Перевод тактов в наносекунды
+uint32_t perf_cycles_to_ns(uint32_t cycles);
+
+// Короткая строка для экрана: средние времена в мкс
+int perf_format_hud(char *buf, int size);
+
+// Полный отчёт в stdio, не чаще PERF_DUMP_MS
+void perf_dump_task(void);
+
+#define PERF_TIMER(name)          uint32_t name = perf_now()
+#define PERF_RECORD(stage, name)  perf_record(stage, perf_elapsed(name))
+#define PERF_VALUE(stage, value)  perf_record(stage, value)
+#define PERF_COUNT(counter)       (perf_counters[counter]++)
+
+#else
+
+#define PERF_TIMER(name)          ((void)0)
+#define PERF_RECORD(stage, name)  ((void)0)
+#define PERF_VALUE(stage, value)  ((void)0)
+#define PERF_COUNT(counter)       ((void)0)
+
+#endif
@@ -0,0 +1,89 @@
+#include "perf/perf.h"
+
+#if PERF_ENABLED
+#include "global_buffer/global_buffer.h"
+#include "hardware/clocks.h"
+#include "pico/time.h"
+#include <stdio.h>
+#include <string.h>
+
+PerfStat perf_stats[PERF_STAGE_COUNT];
+volatile uint32_t perf_counters[PERF_COUNTER_COUNT];
+
+static const char *const stage_names[PERF_STAGE_COUNT] = {
+    "irq", "trigger", "math", "stats", "history", "draw", "resample", "convert", "spi", "text", "frame", "latency"
+};
+
+static const char *const counter_names[PERF_COUNTER_COUNT] = {
+    "blocks", "triggered", "untriggered", "frames"
+};
+
+static absolute_time_t next_dump;
+
+void perf_init_core(void) {
+    systick_hw->rvr = 0x00FFFFFF;
+    systick_hw->cvr = 0;
+    systick_hw->csr = 0x5; // Включён, такты ядра, без прерывания
+}
+
+// Статистику этапа ядра захвата сбрасываем вместе со всеми: одно
+// искажённое значение в отчёте допустимо
+void perf_reset(void) {
+    memset(perf_stats, 0, sizeof(perf_stats));
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) perf_counters[i] = 0;
+}
+
+uint32_t perf_cycles_to_ns(uint32_t cycles) {
+    uint32_t mhz = clock_get_hz(clk_sys) / 1000000;
+    return (uint32_t)((uint64_t)cycles * 1000 / (mhz ? mhz : 1));
+}
+
+static uint32_t average(const PerfStat *s) {
+    return s->count ? (uint32_t)(s->sum / s->count) : 0;
+}
+
+static uint32_t avg_us(PerfStage stage) {
+    return perf_cycles_to_ns(average(&perf_stats[stage])) / 1000;
+}
+
+int perf_format_hud(char *buf, int size) {
+    FrameQueueStats q;
+    frame_queue_get_stats(&global_buffer.frame_queue, &q);
+    return snprintf(buf, size, "t%lu s%lu d%lu c%lu p%lu f%lu L%lu x%lu",
+                    (unsigned long)avg_us(PERF_TRIGGER), (unsigned long)avg_us(PERF_STATS),
+                    (unsigned long)avg_us(PERF_DRAW), (unsigned long)avg_us(PERF_CONVERT),
+                    (unsigned long)avg_us(PERF_SPI), (unsigned long)avg_us(PERF_FRAME),
+                    (unsigned long)average(&perf_stats[PERF_LATENCY]),
+                    (unsigned long)(q.dropped + q.exhausted));
+}
+
+void perf_dump_task(void) {
+    if (PERF_DUMP_MS == 0 || !time_reached(next_dump)) return;
+    next_dump = make_timeout_time_ms(PERF_DUMP_MS);
+
+    printf("perf: stage count min/avg/max us, log2 histogram\n");
+    for (int i = 0; i < PERF_STAGE_COUNT; i++) {
+        const PerfStat *s = &perf_stats[i];
+        if (!s->count) continue;
+        // Задержка уже в мкс, остальные этапы - в тактах
+        bool cycles = i != PERF_LATENCY;
+        uint32_t mn = cycles ? perf_cycles_to_ns(s->min) / 1000 : s->min;
+        uint32_t av = cycles ? perf_cycles_to_ns(average(s)) / 1000 : average(s);
+        uint32_t mx = cycles ? perf_cycles_to_ns(s->max) / 1000 : s->max;
+        printf("  %-8s %7lu %6lu/%lu/%lu  ", stage_names[i], (unsigned long)s->count,
+               (unsigned long)mn, (unsigned long)av, (unsigned long)mx);
+        for (int b = 0; b < PERF_HIST_BUCKETS; b++) printf(" %lu", (unsigned long)s->hist[b]);
+        printf("\n");
+    }
+
+    FrameQueueStats q;
+    frame_queue_get_stats(&global_buffer.frame_queue, &q);
+    printf("  counters:");
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        printf(" %s=%lu", counter_names[i], (unsigned long)perf_counters[i]);
+    }
+    printf(" published=%lu dropped=%lu exhausted=%lu\n",
+           (unsigned long)q.published, (unsigned long)q.dropped, (unsigned long)q.exhausted);
+}
+
+#endif
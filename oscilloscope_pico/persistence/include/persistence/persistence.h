@@ -0,0 +1,42 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "pico_ili9341/pico_ili9341.h"
+#include "display_driver/display_driver.h"
+
+// Цифровое послесвечение: на каждый пиксель области осциллограммы приходится
+// 4-битный счётчик попаданий. Два счётчика упакованы в байт (чётный x - младшая
+// тетрада), строки идут подряд, как в draw_wave_buf.
+#define PERSIST_MAX_COUNT   15
+#define PERSIST_ROW_BYTES   (WAVEFORM_WIDTH / 2)
+#define PERSIST_MAP_BYTES   (PERSIST_ROW_BYTES * WAVEFORM_HEIGHT)
+
+// Карта одна на послесвечение и режим XY (xy/xy.h): в режиме XY ядро
+// захвата послесвечение не накапливает. Смена режима запрашивает очистку
+// у обоих, пока она не выполнена, карта не выводится
+extern uint8_t persistence_hit_map[PERSIST_MAP_BYTES];
+
+// Период затухания по умолчанию (в накоплениях): каждые N осциллограмм
+// все счётчики делятся пополам
+#define PERSIST_DEFAULT_DECAY 128
+
+// Инициализация карты (вызывается до запуска накопления)
+void persistence_init(void);
+
+// Запрос очистки. Сама очистка выполняется ядром, которое накапливает,
+// при следующем вызове persistence_accumulate()
+void persistence_clear(void);
+
+// Установка периода затухания в осциллограммах (0 - без затухания)
+void persistence_set_decay_period(uint16_t acquisitions);
+
+// Добавление одной осциллограммы: count отсчётов ложатся в столбцы 0..count-1,
+// соседние точки соединяются вертикальными отрезками
+void persistence_accumulate(const uint16_t *samples, uint16_t count);
+
+// Вывод карты в 8-битный буфер через тепловую палитру.
+// Пиксели с нулевым счётчиком не трогаются (сетка остаётся видна)
+void persistence_render(color8_t *dst);
+
+// Количество осциллограмм, накопленных с момента последней очистки
+uint32_t persistence_get_count(void);
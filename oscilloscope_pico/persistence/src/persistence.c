@@ -0,0 +1,97 @@
+#include "persistence/persistence.h"
+#include "calibration/calibration.h"
+#include <pico/stdlib.h>
+#include <string.h>
+
+// Карта счётчиков выровнена на слово, чтобы затухание шло по 8 пикселей за раз
+uint8_t persistence_hit_map[PERSIST_MAP_BYTES] __attribute__((aligned(4)));
+#define hit_map persistence_hit_map
+
+static volatile bool clear_requested = false;
+static volatile uint16_t decay_period = PERSIST_DEFAULT_DECAY;
+static uint16_t since_decay = 0;
+static volatile uint32_t accumulated = 0;
+
+void persistence_init(void) {
+    memset(hit_map, 0, sizeof(hit_map));
+    clear_requested = false;
+    since_decay = 0;
+    accumulated = 0;
+}
+
+void persistence_clear(void) {
+    clear_requested = true;
+}
+
+void persistence_set_decay_period(uint16_t acquisitions) {
+    decay_period = acquisitions;
+}
+
+uint32_t persistence_get_count(void) {
+    return accumulated;
+}
+
+// Деление всех счётчиков пополам: сдвиг слова и маска старших битов тетрад
+static void __not_in_flash_func(persistence_decay)(void) {
+    uint32_t *words = (uint32_t *)hit_map;
+    for (int i = 0; i < PERSIST_MAP_BYTES / 4; i++) {
+        uint32_t w = words[i];
+        if (w) words[i] = (w >> 1) & 0x77777777u;
+    }
+}
+
+void __not_in_flash_func(persistence_accumulate)(const uint16_t *samples, uint16_t count) {
+    if (clear_requested) {
+        memset(hit_map, 0, sizeof(hit_map));
+        clear_requested = false;
+        since_decay = 0;
+        accumulated = 0;
+    }
+
+    if (count > WAVEFORM_WIDTH) count = WAVEFORM_WIDTH;
+
+    int prev_y = -1;
+    for (int x = 0; x < count; x++) {
+        int y = calibration_code_to_px(samples[x]);
+
+        // Вертикальный отрезок от предыдущей точки (её саму не считаем повторно)
+        int y0 = y, y1 = y;
+        if (prev_y >= 0) {
+            if (y > prev_y) y0 = prev_y + 1;
+            else if (y < prev_y) y1 = prev_y - 1;
+        }
+        prev_y = y;
+
+        uint8_t *p = &hit_map[y0 * PERSIST_ROW_BYTES + (x >> 1)];
+        if (x & 1) {
+            for (int row = y0; row <= y1; row++, p += PERSIST_ROW_BYTES) {
+                if ((*p & 0xF0) != 0xF0) *p += 0x10;
+            }
+        } else {
+            for (int row = y0; row <= y1; row++, p += PERSIST_ROW_BYTES) {
+                if ((*p & 0x0F) != 0x0F) *p += 0x01;
+            }
+        }
+    }
+
+    accumulated++;
+    if (decay_period && ++since_decay >= decay_period) {
+        since_decay = 0;
+        persistence_decay();
+    }
+}
+
+void persistence_render(color8_t *dst) {
+    if (clear_requested) return; // В карте ещё прежний режим
+    const uint32_t *words = (const uint32_t *)hit_map;
+
+    for (int i = 0; i < PERSIST_MAP_BYTES / 4; i++, dst += 8) {
+        uint32_t w = words[i];
+        if (!w) continue; // 8 пустых пикселей подряд - типичный случай
+
+        for (int n = 0; n < 8; n++, w >>= 4) {
+            uint8_t level = w & 0x0F;
+            if (level) dst[n] = COLOR8_HEAT_BASE + level - 1;
+        }
+    }
+}
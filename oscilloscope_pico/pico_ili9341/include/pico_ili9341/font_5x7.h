@@ -73,7 +73,7 @@ static const uint8_t font_5x7[128][7] = {
     
     // Символы [ \ ] ^ _ `
     [91] = {0x00, 0x7F, 0x41, 0x41, 0x00, 0x00, 0x00}, // [
-    [92] = {0x02, 0x04, 0x08, 0x10, 0x20, 0x00, 0x00}, // \ 
+    [92] = {0x02, 0x04, 0x08, 0x10, 0x20, 0x00, 0x00}, // обратная косая черта
     [93] = {0x00, 0x41, 0x41, 0x7F, 0x00, 0x00, 0x00}, // ]
     [94] = {0x04, 0x02, 0x01, 0x02, 0x04, 0x00, 0x00}, // ^
     [95] = {0x40, 0x40, 0x40, 0x40, 0x40, 0x00, 0x00}, // _
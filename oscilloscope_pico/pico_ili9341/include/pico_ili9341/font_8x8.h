@@ -71,7 +71,7 @@ static const uint8_t font_8x8[128][8] = {
     
     // Символы [ \ ] ^ _ `
     [91] = {0x78, 0x60, 0x60, 0x60, 0x60, 0x60, 0x78, 0x00}, // [
-    [92] = {0xC0, 0x60, 0x30, 0x18, 0x0C, 0x06, 0x02, 0x00}, // \ 
+    [92] = {0xC0, 0x60, 0x30, 0x18, 0x0C, 0x06, 0x02, 0x00}, // обратная косая черта
     [93] = {0x78, 0x18, 0x18, 0x18, 0x18, 0x18, 0x78, 0x00}, // ]
     [94] = {0x10, 0x38, 0x6C, 0xC6, 0x00, 0x00, 0x00, 0x00}, // ^
     [95] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF}, // _
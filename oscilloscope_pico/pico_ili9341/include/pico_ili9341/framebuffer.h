@@ -0,0 +1,62 @@
+#pragma once
+#include "pico_ili9341/pico_ili9341.h"
+#include "pico_ili9341/overlay.h"
+
+// 8-битная поверхность рисования (индексы палитры color_palette).
+// Все примитивы отсекаются по границам поверхности и расширяют
+// "грязную" область, которую FB8_Flush отправляет на дисплей.
+typedef struct {
+    color8_t *pixels;
+    uint16_t width;
+    uint16_t height;
+    uint16_t stride;     // Шаг строки в пикселях
+
+    // Грязная область: [x0, x1) x [y0, y1), пустая если x0 >= x1
+    uint16_t dirty_x0;
+    uint16_t dirty_y0;
+    uint16_t dirty_x1;
+    uint16_t dirty_y1;
+} Framebuffer8;
+
+// Инициализация поверхности поверх готового буфера (например draw_wave_buf)
+void FB8_Init(Framebuffer8 *fb, color8_t *pixels, uint16_t width, uint16_t height);
+
+// Грязная область
+void FB8_MarkDirty(Framebuffer8 *fb, int x, int y, int w, int h);
+void FB8_MarkAllDirty(Framebuffer8 *fb);
+void FB8_ResetDirty(Framebuffer8 *fb);
+bool FB8_IsDirty(const Framebuffer8 *fb);
+
+// Примитивы
+void FB8_Clear(Framebuffer8 *fb, color8_t color);
+void FB8_DrawPixel(Framebuffer8 *fb, int x, int y, color8_t color);
+void FB8_HLine(Framebuffer8 *fb, int x, int y, int w, color8_t color);
+void FB8_VLine(Framebuffer8 *fb, int x, int y, int h, color8_t color);
+void FB8_Line(Framebuffer8 *fb, int x0, int y0, int x1, int y1, color8_t color);
+void FB8_Rect(Framebuffer8 *fb, int x, int y, int w, int h, color8_t color);
+void FB8_FillRect(Framebuffer8 *fb, int x, int y, int w, int h, color8_t color);
+
+// Пунктирные линии сетки: точка через каждые step пикселей
+void FB8_DottedHLine(Framebuffer8 *fb, int x, int y, int w, int step, color8_t color);
+void FB8_DottedVLine(Framebuffer8 *fb, int x, int y, int h, int step, color8_t color);
+
+// Копирование прямоугольника 8-битных пикселей. Если transparent >= 0,
+// пиксели этого цвета пропускаются
+void FB8_Blit(Framebuffer8 *fb, int x, int y, const color8_t *src,
+              int w, int h, int src_stride, int transparent);
+
+// Отправка грязной области на дисплей: одно окно CASET/PASET/RAMWR на всю
+// область, строки конвертируются в RGB565 по одной. (screen_x, screen_y) -
+// положение левого верхнего угла поверхности на экране
+void FB8_Flush(ILI9341 *disp, Framebuffer8 *fb, uint16_t screen_x, uint16_t screen_y);
+
+// То же, но с наложением статического слоя во время конвертации строк.
+// Слой должен совпадать по размеру с поверхностью
+void FB8_FlushOverlay(ILI9341 *disp, Framebuffer8 *fb, uint16_t screen_x, uint16_t screen_y,
+                      const Overlay *overlay);
+
+// Обработчик, который FB8_Flush вызывает после каждых rows строк: вывод
+// большой области длится десятки миллисекунд, за это время нужно
+// обслуживать другую периферию. SPI в нём трогать нельзя - окно открыто.
+// NULL - не вызывать
+void FB8_SetFlushHook(void (*hook)(void), uint16_t rows);
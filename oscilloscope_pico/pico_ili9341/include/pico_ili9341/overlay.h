@@ -0,0 +1,69 @@
+#pragma once
+#include "pico_ili9341/pico_ili9341.h"
+
+// Статический слой поверх (или под) 8-битной поверхности: сетка, подписи,
+// маркер триггера, курсоры. Хранится как списки отрезков по строкам и
+// накладывается при конвертации 8->16, поэтому в кадре ничего не рисуется.
+// Вертикальные линии (курсоры, стороны рамок) - отдельно, столбцами: одна
+// запись на линию и бит в маске каждой строки, через которую она проходит,
+// а не по отрезку на строку из общего запаса.
+#define OVERLAY_MAX_ROWS    ILI9341_WIDTH   // Высота области не больше 240 строк
+#define OVERLAY_MAX_SPANS   512
+#define OVERLAY_MAX_COLUMNS 16              // По биту в column_rows
+#define OVERLAY_NONE        0xFFFF
+
+// Флаги отрезка
+#define OVERLAY_BELOW 0x00  // Только там, где пиксель трассы - фон
+#define OVERLAY_ABOVE 0x01  // Всегда поверх трассы
+
+typedef struct {
+    uint16_t x;       // Первая точка
+    uint16_t count;   // Число точек
+    uint8_t step;     // Шаг между точками (1 - сплошной отрезок)
+    color8_t color;
+    uint8_t flags;
+    uint8_t reserved;
+    uint16_t next;    // Следующий отрезок той же строки или OVERLAY_NONE
+} OverlaySpan;
+
+typedef struct {
+    uint16_t x;
+    color8_t color;
+    uint8_t flags;
+} OverlayColumn;
+
+typedef struct {
+    uint16_t width;
+    uint16_t height;
+    color8_t background;                   // Цвет "пустого" пикселя трассы
+    uint16_t row_head[OVERLAY_MAX_ROWS];   // Первый отрезок каждой строки
+    OverlaySpan spans[OVERLAY_MAX_SPANS];
+    uint16_t span_count;
+    uint16_t column_rows[OVERLAY_MAX_ROWS]; // Биты столбцов, проходящих через строку
+    OverlayColumn columns[OVERLAY_MAX_COLUMNS];
+    uint16_t column_count;
+    uint32_t version;                      // Растёт при каждой перестройке
+} Overlay;
+
+void Overlay_Init(Overlay *ov, uint16_t width, uint16_t height, color8_t background);
+
+// Перестройка: Clear, затем добавление примитивов. version меняется в Clear
+void Overlay_Clear(Overlay *ov);
+bool Overlay_HLine(Overlay *ov, int x, int y, int w, int step, color8_t color, uint8_t flags);
+bool Overlay_VLine(Overlay *ov, int x, int y, int h, int step, color8_t color, uint8_t flags);
+bool Overlay_Rect(Overlay *ov, int x, int y, int w, int h, color8_t color, uint8_t flags);
+
+// Однобитная маска (строки по bytes_per_row байт, старший бит - левый пиксель),
+// каждая непрерывная серия единиц становится одним отрезком
+bool Overlay_Mask(Overlay *ov, int x, int y, const uint8_t *mask,
+                  int w, int h, int bytes_per_row, color8_t color, uint8_t flags);
+
+// Наложение строки y на уже сконвертированную строку RGB565. Столбцы
+// накладываются первыми, отрезки строки - поверх них.
+// src8 - 8-битная строка трассы, scanline - результат, [x0, x1) - диапазон
+void Overlay_ComposeRow(const Overlay *ov, uint16_t y, const color8_t *src8,
+                        uint16_t *scanline, uint16_t x0, uint16_t x1);
+
+// То же в индексах палитры (снимок экрана): row - результат для [x0, x1)
+void Overlay_ComposeRow8(const Overlay *ov, uint16_t y, const color8_t *src8,
+                         color8_t *row, uint16_t x0, uint16_t x1);
@@ -36,6 +36,8 @@
 #define ILI9341_CASET     0x2A
 #define ILI9341_PASET     0x2B
 #define ILI9341_RAMWR     0x2C
+#define ILI9341_TEOFF     0x34
+#define ILI9341_TEON      0x35
 #define ILI9341_MADCTL    0x36
 
 typedef uint8_t color8_t;
@@ -51,10 +53,15 @@ enum {
     COLOR8_YELLOW,
     COLOR8_CYAN,
     COLOR8_MAGENTA,
+    // Тепловая палитра послесвечения (от редких попаданий к частым)
+    COLOR8_HEAT_BASE,
+    COLOR8_HEAT_LAST = COLOR8_HEAT_BASE + 14,
     // Добавьте свои цвета
     COLOR8_COUNT
 };
 
+#define COLOR8_HEAT_LEVELS (COLOR8_HEAT_LAST - COLOR8_HEAT_BASE + 1)
+
 // Таблица преобразования в RGB565 (хранится во Flash)
 extern const uint16_t color_palette[COLOR8_COUNT];
 
@@ -82,9 +89,6 @@ typedef struct {
     uint8_t rotation;
 } ILI9341;
 
-// 8-битный буфер кадра
-static uint8_t frame_buffer[ILI9341_WIDTH * ILI9341_HEIGHT];
-
 // Инициализация
 void ILI9341_Init(ILI9341 *disp, const ILI9341Config *config);
 void ILI9341_SetRotation(ILI9341 *disp, uint8_t rotation);
@@ -93,11 +97,12 @@ void ILI9341_SetRotation(ILI9341 *disp, uint8_t rotation);
 //void ILI9341_SetRotation(ILI9341 *disp, display_rotation_t rotation);
 void ILI9341_FillScreen(ILI9341 *disp, uint16_t color);
 void ILI9341_FillScreen8(ILI9341 *disp, color8_t color_index);\
-void ILI9341_DrawPixel(ILI9341 *disp, uint16_t x, uint16_t y, color8_t color);
+void ILI9341_DrawPixel(ILI9341 *disp, uint16_t x, uint16_t y, uint16_t color);
 void ILI9341_DrawLine(ILI9341 *disp, uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t color);
 void ILI9341_DrawRect(ILI9341 *disp, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color);
 void ILI9341_FillRect(ILI9341 *disp, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color);
 void ILI9341_SetPalette(ILI9341 *disp, uint8_t mac_data);
+void ILI9341_SetTearingEffect(ILI9341 *disp, bool enable);
 
 // Текст
 void ILI9341_SetFont(ILI9341 *disp, const uint8_t *font);
@@ -106,7 +111,6 @@ void ILI9341_SetTextSize(ILI9341 *disp, uint8_t size);
 void ILI9341_SetCursor(ILI9341 *disp, uint16_t x, uint16_t y);
 void ILI9341_Print(ILI9341 *disp, const char *text);
 void ILI9341_PrintInteger(ILI9341 *disp, int num);
-void ILI9341_PrintFloat(ILI9341 *disp, float value, uint8_t decimals);
 
 // Оптимизированные функции
 void ILI9341_DrawBufferDMA(
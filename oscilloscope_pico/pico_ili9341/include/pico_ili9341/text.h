@@ -0,0 +1,64 @@
+#pragma once
+#include "pico_ili9341/pico_ili9341.h"
+
+// Пакетный вывод текста: строка рендерится построчно в один буфер развёртки и
+// уходит одной транзакцией на каждую серию изменившихся символов. Глифы всех
+// шрифтов заранее развёрнуты в единый формат (строки по 16 бит, старший бит -
+// левый пиксель), поэтому формат исходного шрифта на выводе не важен.
+
+typedef enum {
+    FONT_5X7,
+    FONT_8X8,
+    FONT_12X16,
+    FONT_COUNT
+} FontId;
+
+#define TEXT_LINE_MAX 40  // Максимум символов в одной текстовой строке
+
+// Текстовая строка на экране с теневой копией того, что уже выведено
+typedef struct {
+    uint16_t x;
+    uint16_t y;
+    uint8_t font;        // FontId
+    uint8_t max_chars;
+    uint16_t fg;         // RGB565
+    uint16_t bg;
+    bool valid;          // false - содержимое экрана неизвестно
+    char shown[TEXT_LINE_MAX + 1];
+} TextLine;
+
+// Построение кэша глифов (один раз при старте)
+void Text_Init(void);
+
+// Размер знакоместа шрифта с учётом межсимвольного интервала
+uint8_t Text_CellWidth(FontId font);
+uint8_t Text_CellHeight(FontId font);
+
+void TextLine_Init(TextLine *line, uint16_t x, uint16_t y, FontId font,
+                   uint8_t max_chars, uint16_t fg, uint16_t bg);
+
+// Вывод строки: сравнивается с тем, что уже на экране, и отправляются только
+// изменившиеся знакоместа. Строка дополняется пробелами до max_chars.
+// Возвращает число перерисованных символов
+uint16_t TextLine_Set(ILI9341 *disp, TextLine *line, const char *str);
+
+// Принудительная перерисовка при следующем TextLine_Set
+void TextLine_Invalidate(TextLine *line);
+
+// Развёрнутые строки глифа (для композиции вне дисплея, например снимков экрана)
+const uint16_t *Text_GlyphRows(FontId font, char c);
+
+// Строка y экрана из того, что строка текста уже вывела, в индексах палитры
+// fg/bg (row - строка экрана шириной width). Пока содержимое экрана
+// неизвестно (valid == false), row не меняется
+void TextLine_ComposeRow8(const TextLine *line, uint16_t y, color8_t *row, uint16_t width,
+                          color8_t fg, color8_t bg);
+
+// Целочисленное форматирование с приставками СИ. Значение равно
+// value * 10^exp10 единиц unit, выводится 3 значащие цифры: "1.23kHz",
+// "450mV", "12.5us" (вместо "µ" - "u", шрифты только ASCII).
+// Возвращает длину строки
+int Text_FormatSI(char *buf, int size, int32_t value, int8_t exp10, const char *unit);
+
+// Фиксированная точка: value в единицах 10^-decimals, например (505, 1) -> "50.5"
+int Text_FormatFixed(char *buf, int size, int32_t value, uint8_t decimals, const char *unit);
@@ -48,9 +48,11 @@ void ILI9341_SetCursor(ILI9341 *disp, uint16_t x, uint16_t y) {
 
 // Рисование символа с текущими настройками
 void ILI9341_DrawChar(ILI9341 *disp, char c) {
-    if (c < 32 || c > 127) return; // Только печатные символы ASCII
+    // Только печатные символы ASCII. char бывает знаковым: сравниваем код
+    unsigned char code = (unsigned char)c;
+    if (code < 32 || code > 127) return;
     
-    const uint8_t *char_data = &current_font[c * font_height];
+    const uint8_t *char_data = &current_font[code * font_height];
     
     // Буфер для строки символа (оптимизация DMA)
     uint16_t pixel_buffer[font_width * font_height];
@@ -145,24 +147,6 @@ void ILI9341_PrintInteger(ILI9341 *disp, int num) {
     }
 }
 
-//вывод float
-void ILI9341_PrintFloat(ILI9341 *disp, float value, uint8_t decimals) {
-    int integer = (int)value;
-    ILI9341_PrintInteger(disp, integer); // Вывод целой части
-    
-    if (decimals > 0) {
-        ILI9341_Print(disp, ".");
-        
-        float frac = value - integer;
-        for (uint8_t i = 0; i < decimals; i++) {
-            frac *= 10;
-            int digit = (int)frac;
-            ILI9341_DrawChar(disp, '0' + digit);
-            frac -= digit;
-        }
-    }
-}
-
 // Дополнительные функции для работы с текстом
 
 // Вывод текста с заданными параметрами
@@ -0,0 +1,302 @@
+#include "pico_ili9341/framebuffer.h"
+#include "hardware/spi.h"
+#include "perf/perf.h"
+#include <stdlib.h>
+#include <string.h>
+
+static inline int clamp_int(int v, int lo, int hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+void FB8_Init(Framebuffer8 *fb, color8_t *pixels, uint16_t width, uint16_t height) {
+    fb->pixels = pixels;
+    fb->width = width;
+    fb->height = height;
+    fb->stride = width;
+    FB8_ResetDirty(fb);
+}
+
+void FB8_ResetDirty(Framebuffer8 *fb) {
+    fb->dirty_x0 = fb->width;
+    fb->dirty_y0 = fb->height;
+    fb->dirty_x1 = 0;
+    fb->dirty_y1 = 0;
+}
+
+bool FB8_IsDirty(const Framebuffer8 *fb) {
+    return fb->dirty_x0 < fb->dirty_x1 && fb->dirty_y0 < fb->dirty_y1;
+}
+
+// Расширение грязной области на уже отсечённый прямоугольник
+static inline void mark_clipped(Framebuffer8 *fb, int x0, int y0, int x1, int y1) {
+    if (x0 < fb->dirty_x0) fb->dirty_x0 = x0;
+    if (y0 < fb->dirty_y0) fb->dirty_y0 = y0;
+    if (x1 > fb->dirty_x1) fb->dirty_x1 = x1;
+    if (y1 > fb->dirty_y1) fb->dirty_y1 = y1;
+}
+
+void FB8_MarkDirty(Framebuffer8 *fb, int x, int y, int w, int h) {
+    int x0 = clamp_int(x, 0, fb->width);
+    int y0 = clamp_int(y, 0, fb->height);
+    int x1 = clamp_int(x + w, 0, fb->width);
+    int y1 = clamp_int(y + h, 0, fb->height);
+    if (x0 < x1 && y0 < y1) mark_clipped(fb, x0, y0, x1, y1);
+}
+
+void FB8_MarkAllDirty(Framebuffer8 *fb) {
+    mark_clipped(fb, 0, 0, fb->width, fb->height);
+}
+
+void FB8_Clear(Framebuffer8 *fb, color8_t color) {
+    if (fb->stride == fb->width) {
+        memset(fb->pixels, color, (size_t)fb->width * fb->height);
+    } else {
+        for (int y = 0; y < fb->height; y++) {
+            memset(&fb->pixels[y * fb->stride], color, fb->width);
+        }
+    }
+    FB8_MarkAllDirty(fb);
+}
+
+void FB8_DrawPixel(Framebuffer8 *fb, int x, int y, color8_t color) {
+    if ((unsigned)x >= fb->width || (unsigned)y >= fb->height) return;
+    fb->pixels[y * fb->stride + x] = color;
+    mark_clipped(fb, x, y, x + 1, y + 1);
+}
+
+void FB8_HLine(Framebuffer8 *fb, int x, int y, int w, color8_t color) {
+    if ((unsigned)y >= fb->height) return;
+    int x0 = clamp_int(x, 0, fb->width);
+    int x1 = clamp_int(x + w, 0, fb->width);
+    if (x0 >= x1) return;
+
+    memset(&fb->pixels[y * fb->stride + x0], color, x1 - x0);
+    mark_clipped(fb, x0, y, x1, y + 1);
+}
+
+void FB8_VLine(Framebuffer8 *fb, int x, int y, int h, color8_t color) {
+    if ((unsigned)x >= fb->width) return;
+    int y0 = clamp_int(y, 0, fb->height);
+    int y1 = clamp_int(y + h, 0, fb->height);
+    if (y0 >= y1) return;
+
+    color8_t *p = &fb->pixels[y0 * fb->stride + x];
+    for (int n = y1 - y0; n > 0; n--, p += fb->stride) *p = color;
+    mark_clipped(fb, x, y0, x + 1, y1);
+}
+
+// Коды областей для отсечения Коэна-Сазерленда
+enum { CLIP_LEFT = 1, CLIP_RIGHT = 2, CLIP_TOP = 4, CLIP_BOTTOM = 8 };
+
+static int clip_code(const Framebuffer8 *fb, int x, int y) {
+    int code = 0;
+    if (x < 0) code |= CLIP_LEFT;
+    else if (x >= fb->width) code |= CLIP_RIGHT;
+    if (y < 0) code |= CLIP_TOP;
+    else if (y >= fb->height) code |= CLIP_BOTTOM;
+    return code;
+}
+
+// Отсечение отрезка по прямоугольнику поверхности. false - отрезок снаружи
+static bool clip_line(const Framebuffer8 *fb, int *x0, int *y0, int *x1, int *y1) {
+    int c0 = clip_code(fb, *x0, *y0);
+    int c1 = clip_code(fb, *x1, *y1);
+    const int xmax = fb->width - 1;
+    const int ymax = fb->height - 1;
+
+    while (c0 | c1) {
+        if (c0 & c1) return false;
+
+        int c = c0 ? c0 : c1;
+        int dx = *x1 - *x0;
+        int dy = *y1 - *y0;
+        int x, y;
+
+        if (c & CLIP_BOTTOM) {
+            x = *x0 + (int)((int64_t)dx * (ymax - *y0) / dy);
+            y = ymax;
+        } else if (c & CLIP_TOP) {
+            x = *x0 + (int)((int64_t)dx * (0 - *y0) / dy);
+            y = 0;
+        } else if (c & CLIP_RIGHT) {
+            y = *y0 + (int)((int64_t)dy * (xmax - *x0) / dx);
+            x = xmax;
+        } else {
+            y = *y0 + (int)((int64_t)dy * (0 - *x0) / dx);
+            x = 0;
+        }
+
+        if (c == c0) {
+            *x0 = x; *y0 = y;
+            c0 = clip_code(fb, x, y);
+        } else {
+            *x1 = x; *y1 = y;
+            c1 = clip_code(fb, x, y);
+        }
+    }
+    return true;
+}
+
+void FB8_Line(Framebuffer8 *fb, int x0, int y0, int x1, int y1, color8_t color) {
+    // Горизонтальные и вертикальные отрезки - через быстрые спаны
+    if (y0 == y1) {
+        if (x1 < x0) { int t = x0; x0 = x1; x1 = t; }
+        FB8_HLine(fb, x0, y0, x1 - x0 + 1, color);
+        return;
+    }
+    if (x0 == x1) {
+        if (y1 < y0) { int t = y0; y0 = y1; y1 = t; }
+        FB8_VLine(fb, x0, y0, y1 - y0 + 1, color);
+        return;
+    }
+
+    if (!clip_line(fb, &x0, &y0, &x1, &y1)) return;
+
+    mark_clipped(fb, x0 < x1 ? x0 : x1, y0 < y1 ? y0 : y1,
+                 (x0 > x1 ? x0 : x1) + 1, (y0 > y1 ? y0 : y1) + 1);
+
+    // Брезенхэм с шагом по указателю: концы уже внутри поверхности
+    int dx = abs(x1 - x0);
+    int dy = -abs(y1 - y0);
+    int sx = x0 < x1 ? 1 : -1;
+    int sy = y0 < y1 ? fb->stride : -(int)fb->stride;
+    int err = dx + dy;
+    color8_t *p = &fb->pixels[y0 * fb->stride + x0];
+
+    for (int n = (dx > -dy ? dx : -dy); ; n--) {
+        *p = color;
+        if (n == 0) break;
+        int e2 = 2 * err;
+        if (e2 >= dy) { err += dy; p += sx; }
+        if (e2 <= dx) { err += dx; p += sy; }
+    }
+}
+
+void FB8_Rect(Framebuffer8 *fb, int x, int y, int w, int h, color8_t color) {
+    if (w <= 0 || h <= 0) return;
+    FB8_HLine(fb, x, y, w, color);
+    FB8_HLine(fb, x, y + h - 1, w, color);
+    FB8_VLine(fb, x, y + 1, h - 2, color);
+    FB8_VLine(fb, x + w - 1, y + 1, h - 2, color);
+}
+
+void FB8_FillRect(Framebuffer8 *fb, int x, int y, int w, int h, color8_t color) {
+    int x0 = clamp_int(x, 0, fb->width);
+    int x1 = clamp_int(x + w, 0, fb->width);
+    int y0 = clamp_int(y, 0, fb->height);
+    int y1 = clamp_int(y + h, 0, fb->height);
+    if (x0 >= x1 || y0 >= y1) return;
+
+    for (int row = y0; row < y1; row++) {
+        memset(&fb->pixels[row * fb->stride + x0], color, x1 - x0);
+    }
+    mark_clipped(fb, x0, y0, x1, y1);
+}
+
+void FB8_DottedHLine(Framebuffer8 *fb, int x, int y, int w, int step, color8_t color) {
+    if ((unsigned)y >= fb->height || step <= 0) return;
+    int x1 = clamp_int(x + w, 0, fb->width);
+
+    // Первая точка внутри поверхности с сохранением фазы пунктира
+    int x0 = x;
+    if (x0 < 0) x0 += ((-x0 + step - 1) / step) * step;
+    if (x0 >= x1) return;
+
+    color8_t *row = &fb->pixels[y * fb->stride];
+    for (int px = x0; px < x1; px += step) row[px] = color;
+    mark_clipped(fb, x0, y, x1, y + 1);
+}
+
+void FB8_DottedVLine(Framebuffer8 *fb, int x, int y, int h, int step, color8_t color) {
+    if ((unsigned)x >= fb->width || step <= 0) return;
+    int y1 = clamp_int(y + h, 0, fb->height);
+
+    int y0 = y;
+    if (y0 < 0) y0 += ((-y0 + step - 1) / step) * step;
+    if (y0 >= y1) return;
+
+    for (int py = y0; py < y1; py += step) fb->pixels[py * fb->stride + x] = color;
+    mark_clipped(fb, x, y0, x + 1, y1);
+}
+
+void FB8_Blit(Framebuffer8 *fb, int x, int y, const color8_t *src,
+              int w, int h, int src_stride, int transparent) {
+    int x0 = clamp_int(x, 0, fb->width);
+    int x1 = clamp_int(x + w, 0, fb->width);
+    int y0 = clamp_int(y, 0, fb->height);
+    int y1 = clamp_int(y + h, 0, fb->height);
+    if (x0 >= x1 || y0 >= y1) return;
+
+    const color8_t *s = &src[(y0 - y) * src_stride + (x0 - x)];
+    color8_t *d = &fb->pixels[y0 * fb->stride + x0];
+    int n = x1 - x0;
+
+    for (int row = y0; row < y1; row++, s += src_stride, d += fb->stride) {
+        if (transparent < 0) {
+            memcpy(d, s, n);
+        } else {
+            for (int i = 0; i < n; i++) {
+                if (s[i] != (color8_t)transparent) d[i] = s[i];
+            }
+        }
+    }
+    mark_clipped(fb, x0, y0, x1, y1);
+}
+
+static void (*flush_hook)(void) = NULL;
+static uint16_t flush_hook_rows = 1;
+
+void FB8_SetFlushHook(void (*hook)(void), uint16_t rows) {
+    flush_hook = hook;
+    flush_hook_rows = rows ? rows : 1;
+}
+
+void FB8_Flush(ILI9341 *disp, Framebuffer8 *fb, uint16_t screen_x, uint16_t screen_y) {
+    FB8_FlushOverlay(disp, fb, screen_x, screen_y, NULL);
+}
+
+void FB8_FlushOverlay(ILI9341 *disp, Framebuffer8 *fb, uint16_t screen_x, uint16_t screen_y,
+                      const Overlay *overlay) {
+    static uint16_t scanline[ILI9341_HEIGHT]; // Самая длинная строка экрана
+
+    if (!FB8_IsDirty(fb)) return;
+
+    PERF_TIMER(flush_start);
+#if PERF_ENABLED
+    uint32_t convert_cycles = 0;
+#endif
+    uint16_t x0 = fb->dirty_x0, x1 = fb->dirty_x1;
+    uint16_t y0 = fb->dirty_y0, y1 = fb->dirty_y1;
+    uint16_t w = x1 - x0;
+
+    // Одно окно на всю грязную область
+    ILI9341_SetAddressWindow(disp, screen_x + x0, screen_y + y0,
+                             screen_x + x1 - 1, screen_y + y1 - 1);
+    gpio_put(disp->dc_pin, 1);
+    gpio_put(disp->cs_pin, 0);
+
+    for (uint16_t y = y0; y < y1; y++) {
+        PERF_TIMER(row_start);
+        const color8_t *row = &fb->pixels[y * fb->stride];
+        for (uint16_t i = 0; i < w; i++) {
+            scanline[i] = color_palette[row[x0 + i]];
+        }
+        if (overlay) {
+            Overlay_ComposeRow(overlay, y, row, scanline, x0, x1);
+        }
+#if PERF_ENABLED
+        convert_cycles += perf_elapsed(row_start);
+#endif
+        spi_write_blocking(disp->spi, (uint8_t*)scanline, w * 2);
+        if (flush_hook && (y - y0 + 1) % flush_hook_rows == 0) flush_hook();
+    }
+
+    gpio_put(disp->cs_pin, 1);
+    FB8_ResetDirty(fb);
+
+    // Остальное время - ожидание SPI
+#if PERF_ENABLED
+    PERF_VALUE(PERF_CONVERT, convert_cycles);
+    PERF_VALUE(PERF_SPI, perf_elapsed(flush_start) - convert_cycles);
+#endif
+}
@@ -7,14 +7,8 @@ extern void write_data(ILI9341 *disp, const uint8_t *data, size_t len);
 extern void write_command(ILI9341 *disp, uint8_t cmd);
 extern void write_command_data(ILI9341 *disp, uint8_t cmd, const uint8_t *data, uint8_t len);
 
-// Конвертация RGB888 в RGB565
-static uint16_t color565(uint8_t r, uint8_t g, uint8_t b) {
-    return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
-}
-
 // Настройка DMA (вызывается один раз при инициализации)
 static int dma_channel = -1;
-static dma_channel_config dma_config;
 static int dma_chan;
 void ILI9341_SetupDMA(ILI9341 *disp) {
     if (!disp->dma) return;
@@ -89,50 +83,97 @@ void ILI9341_FillRectDMA(ILI9341 *disp, uint16_t x, uint16_t y, uint16_t w, uint
     gpio_put(disp->cs_pin, 1);
 }
 
-// Рисование линии (оптимизированная версия)
+// Заливка окна одним цветом: CASET/PASET/RAMWR один раз на весь прямоугольник
+static void fill_window(ILI9341 *disp, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color) {
+    uint8_t chunk[64 * 2];
+    for (int i = 0; i < 64; i++) {
+        chunk[i*2] = color >> 8;
+        chunk[i*2+1] = color & 0xFF;
+    }
+    
+    ILI9341_SetAddressWindow(disp, x, y, x + w - 1, y + h - 1);
+    gpio_put(disp->dc_pin, 1);
+    gpio_put(disp->cs_pin, 0);
+    
+    uint32_t left = (uint32_t)w * h;
+    while (left) {
+        uint32_t n = left > 64 ? 64 : left;
+        spi_write_blocking(disp->spi, chunk, n * 2);
+        left -= n;
+    }
+    
+    gpio_put(disp->cs_pin, 1);
+}
+
+void ILI9341_FillRect(ILI9341 *disp, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color) {
+    if (x >= disp->width || y >= disp->height || w == 0 || h == 0) return;
+    if (x + w > disp->width) w = disp->width - x;
+    if (y + h > disp->height) h = disp->height - y;
+    fill_window(disp, x, y, w, h, color);
+}
+
+// Рисование линии: Брезенхэм, но пиксели собираются в горизонтальные
+// (для пологих линий) или вертикальные (для крутых) отрезки, и каждый
+// отрезок уходит одной транзакцией вместо CASET/PASET/RAMWR на пиксель
 void ILI9341_DrawLine(ILI9341 *disp, uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t color) {
     int dx = abs(x1 - x0);
     int dy = -abs(y1 - y0);
     int sx = x0 < x1 ? 1 : -1;
     int sy = y0 < y1 ? 1 : -1;
     int err = dx + dy;
+    bool steep = -dy > dx;
     
-    uint8_t color_bytes[2] = {color >> 8, color & 0xFF};
+    int x = x0, y = y0;
+    int run_x = x, run_y = y, run_len = 0;
     
     while (1) {
-        // Установка позиции пикселя
-        uint8_t caset_data[4] = {x0 >> 8, x0 & 0xFF, x0 >> 8, x0 & 0xFF};
-        write_command_data(disp, ILI9341_CASET, caset_data, 4);
-        
-        uint8_t paset_data[4] = {y0 >> 8, y0 & 0xFF, y0 >> 8, y0 & 0xFF};
-        write_command_data(disp, ILI9341_PASET, paset_data, 4);
-        
-        // Запись пикселя
-        write_command(disp, ILI9341_RAMWR);
-        write_data(disp, color_bytes, 2);
-        
-        if (x0 == x1 && y0 == y1) break;
+        run_len++;
+        if (x == x1 && y == y1) break;
         int e2 = 2 * err;
+        bool step_x = false, step_y = false;
         if (e2 >= dy) {
             err += dy;
-            x0 += sx;
+            x += sx;
+            step_x = true;
         }
         if (e2 <= dx) {
             err += dx;
-            y0 += sy;
+            y += sy;
+            step_y = true;
+        }
+        
+        // Смена строки (или столбца для крутой линии) завершает отрезок
+        if (steep ? step_x : step_y) {
+            if (steep) {
+                ILI9341_FillRect(disp, run_x, sy > 0 ? run_y : run_y - run_len + 1, 1, run_len, color);
+            } else {
+                ILI9341_FillRect(disp, sx > 0 ? run_x : run_x - run_len + 1, run_y, run_len, 1, color);
+            }
+            run_x = x;
+            run_y = y;
+            run_len = 0;
         }
     }
+    
+    if (steep) {
+        ILI9341_FillRect(disp, run_x, sy > 0 ? run_y : run_y - run_len + 1, 1, run_len, color);
+    } else {
+        ILI9341_FillRect(disp, sx > 0 ? run_x : run_x - run_len + 1, run_y, run_len, 1, color);
+    }
 }
 
-void ILI9341_DrawPixel(ILI9341 *disp, uint16_t x, uint16_t y, color8_t color) {
+void ILI9341_DrawPixel(ILI9341 *disp, uint16_t x, uint16_t y, uint16_t color) {
     if (x >= disp->width || y >= disp->height) return;
-    frame_buffer[y * disp->width + x] = color;
+    fill_window(disp, x, y, 1, 1, color);
 }
 
-// Оптимизированное рисование прямоугольника
+// Прямоугольник из четырёх отрезков, по одной транзакции на сторону
 void ILI9341_DrawRect(ILI9341 *disp, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color) {
-    ILI9341_DrawLine(disp, x, y, x + w - 1, y, color);         // Верхняя линия
-    ILI9341_DrawLine(disp, x, y + h - 1, x + w - 1, y + h - 1, color); // Нижняя линия
-    ILI9341_DrawLine(disp, x, y, x, y + h - 1, color);         // Левая линия
-    ILI9341_DrawLine(disp, x + w - 1, y, x + w - 1, y + h - 1, color); // Правая линия
+    if (w == 0 || h == 0) return;
+    ILI9341_FillRect(disp, x, y, w, 1, color);                 // Верхняя линия
+    ILI9341_FillRect(disp, x, y + h - 1, w, 1, color);         // Нижняя линия
+    if (h > 2) {
+        ILI9341_FillRect(disp, x, y + 1, 1, h - 2, color);         // Левая линия
+        ILI9341_FillRect(disp, x + w - 1, y + 1, 1, h - 2, color); // Правая линия
+    }
 }
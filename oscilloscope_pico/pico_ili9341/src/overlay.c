@@ -0,0 +1,149 @@
+#include "pico_ili9341/overlay.h"
+#include <string.h>
+
+void Overlay_Init(Overlay *ov, uint16_t width, uint16_t height, color8_t background) {
+    ov->width = width;
+    ov->height = height > OVERLAY_MAX_ROWS ? OVERLAY_MAX_ROWS : height;
+    ov->background = background;
+    ov->version = 0;
+    Overlay_Clear(ov);
+}
+
+void Overlay_Clear(Overlay *ov) {
+    memset(ov->row_head, 0xFF, sizeof(ov->row_head));
+    ov->span_count = 0;
+    memset(ov->column_rows, 0, sizeof(ov->column_rows));
+    ov->column_count = 0;
+    ov->version++;
+}
+
+// Добавление отрезка в список строки. Отрезок уже отсечён по ширине
+static bool add_span(Overlay *ov, int x, int y, int count, int step, color8_t color, uint8_t flags) {
+    if (ov->span_count >= OVERLAY_MAX_SPANS) return false;
+
+    uint16_t idx = ov->span_count++;
+    OverlaySpan *s = &ov->spans[idx];
+    s->x = x;
+    s->count = count;
+    s->step = step;
+    s->color = color;
+    s->flags = flags;
+    s->reserved = 0;
+    s->next = ov->row_head[y];
+    ov->row_head[y] = idx;
+    return true;
+}
+
+bool Overlay_HLine(Overlay *ov, int x, int y, int w, int step, color8_t color, uint8_t flags) {
+    if (y < 0 || y >= ov->height || step <= 0 || step > 255) return true;
+
+    int end = x + w;
+    if (end > ov->width) end = ov->width;
+    if (x < 0) x += ((-x + step - 1) / step) * step; // Фаза пунктира сохраняется
+    if (x >= end) return true;
+
+    return add_span(ov, x, y, (end - x + step - 1) / step, step, color, flags);
+}
+
+bool Overlay_VLine(Overlay *ov, int x, int y, int h, int step, color8_t color, uint8_t flags) {
+    if (x < 0 || x >= ov->width || step <= 0) return true;
+
+    int end = y + h;
+    if (end > ov->height) end = ov->height;
+    if (y < 0) y += ((-y + step - 1) / step) * step;
+    if (y >= end) return true;
+
+    // Один столбец на линию, в строках - только бит
+    if (ov->column_count >= OVERLAY_MAX_COLUMNS) return false;
+    uint16_t idx = ov->column_count++;
+    OverlayColumn *c = &ov->columns[idx];
+    c->x = x;
+    c->color = color;
+    c->flags = flags;
+    for (int row = y; row < end; row += step) {
+        ov->column_rows[row] |= 1u << idx;
+    }
+    return true;
+}
+
+bool Overlay_Rect(Overlay *ov, int x, int y, int w, int h, color8_t color, uint8_t flags) {
+    if (w <= 0 || h <= 0) return true;
+    return Overlay_HLine(ov, x, y, w, 1, color, flags) &&
+           Overlay_HLine(ov, x, y + h - 1, w, 1, color, flags) &&
+           Overlay_VLine(ov, x, y + 1, h - 2, 1, color, flags) &&
+           Overlay_VLine(ov, x + w - 1, y + 1, h - 2, 1, color, flags);
+}
+
+bool Overlay_Mask(Overlay *ov, int x, int y, const uint8_t *mask,
+                  int w, int h, int bytes_per_row, color8_t color, uint8_t flags) {
+    for (int row = 0; row < h; row++) {
+        const uint8_t *bits = &mask[row * bytes_per_row];
+        int run_start = -1;
+
+        for (int col = 0; col <= w; col++) {
+            bool set = col < w && (bits[col >> 3] & (0x80 >> (col & 7)));
+            if (set && run_start < 0) {
+                run_start = col;
+            } else if (!set && run_start >= 0) {
+                if (!Overlay_HLine(ov, x + run_start, y + row, col - run_start, 1, color, flags)) {
+                    return false;
+                }
+                run_start = -1;
+            }
+        }
+    }
+    return true;
+}
+
+void Overlay_ComposeRow(const Overlay *ov, uint16_t y, const color8_t *src8,
+                        uint16_t *scanline, uint16_t x0, uint16_t x1) {
+    if (y >= ov->height) return;
+
+    const OverlayColumn *c = ov->columns;
+    for (uint16_t bits = ov->column_rows[y]; bits; bits >>= 1, c++) {
+        if (!(bits & 1) || c->x < x0 || c->x >= x1) continue;
+        if ((c->flags & OVERLAY_ABOVE) || src8[c->x] == ov->background) {
+            scanline[c->x - x0] = color_palette[c->color];
+        }
+    }
+
+    for (uint16_t idx = ov->row_head[y]; idx != OVERLAY_NONE; idx = ov->spans[idx].next) {
+        const OverlaySpan *s = &ov->spans[idx];
+        uint16_t color = color_palette[s->color];
+        uint16_t px = s->x;
+
+        for (uint16_t n = s->count; n > 0; n--, px += s->step) {
+            if (px < x0) continue;
+            if (px >= x1) break;
+            if ((s->flags & OVERLAY_ABOVE) || src8[px] == ov->background) {
+                scanline[px - x0] = color;
+            }
+        }
+    }
+}
+
+void Overlay_ComposeRow8(const Overlay *ov, uint16_t y, const color8_t *src8,
+                         color8_t *row, uint16_t x0, uint16_t x1) {
+    if (y >= ov->height) return;
+
+    const OverlayColumn *c = ov->columns;
+    for (uint16_t bits = ov->column_rows[y]; bits; bits >>= 1, c++) {
+        if (!(bits & 1) || c->x < x0 || c->x >= x1) continue;
+        if ((c->flags & OVERLAY_ABOVE) || src8[c->x] == ov->background) {
+            row[c->x - x0] = c->color;
+        }
+    }
+
+    for (uint16_t idx = ov->row_head[y]; idx != OVERLAY_NONE; idx = ov->spans[idx].next) {
+        const OverlaySpan *s = &ov->spans[idx];
+        uint16_t px = s->x;
+
+        for (uint16_t n = s->count; n > 0; n--, px += s->step) {
+            if (px < x0) continue;
+            if (px >= x1) break;
+            if ((s->flags & OVERLAY_ABOVE) || src8[px] == ov->background) {
+                row[px - x0] = s->color;
+            }
+        }
+    }
+}
@@ -1,4 +1,5 @@
 #include "pico_ili9341/pico_ili9341.h"
+#include "pico_ili9341/framebuffer.h"
 #include "display_driver/display_driver.h"
 #include "hardware/spi.h"
 #include "hardware/dma.h"
@@ -14,21 +15,32 @@ const uint16_t color_palette[COLOR8_COUNT] = {
     [COLOR8_GRAY]    = 0x8410,  // Серый (R=16, G=32, B=16)
     [COLOR8_YELLOW]  = 0xFFE0,  // Жёлтый (R=31, G=63, B=0)
     [COLOR8_CYAN]    = 0x07FF,  // Голубой (R=0, G=63, B=31)
-    [COLOR8_MAGENTA] = 0xF81F   // Пурпурный (R=31, G=0, B=31)
+    [COLOR8_MAGENTA] = 0xF81F,  // Пурпурный (R=31, G=0, B=31)
+
+    // Тепловая шкала: тёмно-синий -> голубой -> зелёный -> жёлтый -> красный -> белый
+    [COLOR8_HEAT_BASE + 0]  = 0x0008,
+    [COLOR8_HEAT_BASE + 1]  = 0x0014,
+    [COLOR8_HEAT_BASE + 2]  = 0x001F,
+    [COLOR8_HEAT_BASE + 3]  = 0x041F,
+    [COLOR8_HEAT_BASE + 4]  = 0x07FF,
+    [COLOR8_HEAT_BASE + 5]  = 0x07F0,
+    [COLOR8_HEAT_BASE + 6]  = 0x07E0,
+    [COLOR8_HEAT_BASE + 7]  = 0x87E0,
+    [COLOR8_HEAT_BASE + 8]  = 0xFFE0,
+    [COLOR8_HEAT_BASE + 9]  = 0xFE00,
+    [COLOR8_HEAT_BASE + 10] = 0xFC00,
+    [COLOR8_HEAT_BASE + 11] = 0xFA00,
+    [COLOR8_HEAT_BASE + 12] = 0xF800,
+    [COLOR8_HEAT_BASE + 13] = 0xFC10,
+    [COLOR8_HEAT_BASE + 14] = 0xFFFF
 };
 
 void ILI9341_DrawBuffer8to16(ILI9341* tft, color8_t* buf8) {
-    static uint16_t scanline[ILI9341_HEIGHT]; // Конвертируем построчно
-    
-    for (int y = 0; y < WAVEFORM_HEIGHT; y++) {
-        // Конвертация строки
-        for (int x = 0; x < ILI9341_HEIGHT; x++) {
-            scanline[x] = color_palette[buf8[y * ILI9341_HEIGHT + x]];
-        }
-        
-        // Отправка через DMA
-        ILI9341_DrawBufferDMA(tft, 0, y, ILI9341_HEIGHT, 1, scanline);
-    }
+    // Вся область осциллограммы одним окном через 8-битную поверхность
+    Framebuffer8 fb;
+    FB8_Init(&fb, buf8, ILI9341_HEIGHT, WAVEFORM_HEIGHT);
+    FB8_MarkAllDirty(&fb);
+    FB8_Flush(tft, &fb, 0, 0);
 }
 
 // Приватные функции
@@ -263,6 +275,16 @@ void ILI9341_SetPalette(ILI9341 *disp, uint8_t mac_data){
     write_data(disp, &mac_data, 1);
 }
 
+// Выход TE: импульс в начале обратного хода кадровой развёртки (режим V-blank)
+void ILI9341_SetTearingEffect(ILI9341 *disp, bool enable) {
+    if (enable) {
+        uint8_t mode = 0x00; // Только V-blank
+        write_command_data(disp, ILI9341_TEON, &mode, 1);
+    } else {
+        write_command(disp, ILI9341_TEOFF);
+    }
+}
+
 // pico_ili9341.c
 void ILI9341_SetAddressWindow(ILI9341 *disp, uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1) {
     // Проверка границ
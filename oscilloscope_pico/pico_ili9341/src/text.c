@@ -0,0 +1,287 @@
+#include "pico_ili9341/text.h"
+#include "pico_ili9341/font_5x7.h"
+#include "pico_ili9341/font_8x8.h"
+#include "pico_ili9341/font_12x16.h"
+#include "hardware/spi.h"
+#include <string.h>
+
+#define GLYPH_FIRST 32
+#define GLYPH_COUNT 96   // ASCII 32..127
+#define GLYPH_ROWS  16
+
+// Знакоместа: у 5x7 добавляем по пикселю справа и снизу
+static const uint8_t cell_width[FONT_COUNT]  = { 6, 8, 12 };
+static const uint8_t cell_height[FONT_COUNT] = { 8, 8, 16 };
+
+// Развёрнутые глифы. В 12x16 есть только цифры и несколько знаков,
+// остальные символы выводятся пробелом
+static uint16_t glyphs_5x7[GLYPH_COUNT][8];
+static uint16_t glyphs_8x8[GLYPH_COUNT][8];
+static uint16_t glyphs_12x16[14][GLYPH_ROWS];
+static const uint16_t blank_rows[GLYPH_ROWS];
+
+// Таблица "тетрада битов -> 4 пикселя" для текущей пары цветов
+static uint16_t nibble_px[16][4];
+static uint16_t lut_fg = 0, lut_bg = 0;
+static bool lut_valid = false;
+
+// Буфер одной строки развёртки (запас под обрезанное знакоместо и последнюю тетраду)
+static uint16_t scanline[ILI9341_HEIGHT + 16];
+
+static int glyph_index_12x16(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    switch (c) {
+        case ':': return 10;
+        case ';': return 11;
+        case '<': return 12;
+        default:  return 13; // Пробел
+    }
+}
+
+void Text_Init(void) {
+    for (int g = 0; g < GLYPH_COUNT; g++) {
+        int c = GLYPH_FIRST + g;
+
+        // 5x7: по байту на столбец, младший бит - верхняя строка
+        memset(glyphs_5x7[g], 0, sizeof(glyphs_5x7[g]));
+        for (int col = 0; col < 5; col++) {
+            uint8_t bits = font_5x7[c][col];
+            for (int row = 0; row < 7; row++) {
+                if (bits & (1 << row)) glyphs_5x7[g][row] |= 0x8000 >> col;
+            }
+        }
+
+        // 8x8: по байту на строку, старший бит - левый пиксель
+        for (int row = 0; row < 8; row++) {
+            glyphs_8x8[g][row] = (uint16_t)font_8x8[c][row] << 8;
+        }
+    }
+
+    // 12x16: две страницы по 12 столбцов, младший бит - верхняя строка страницы
+    for (int g = 0; g < 14; g++) {
+        memset(glyphs_12x16[g], 0, sizeof(glyphs_12x16[g]));
+        for (int page = 0; page < 2; page++) {
+            for (int col = 0; col < 12; col++) {
+                uint8_t bits = font_12x16[g][page * 12 + col];
+                for (int row = 0; row < 8; row++) {
+                    if (bits & (1 << row)) glyphs_12x16[g][page * 8 + row] |= 0x8000 >> col;
+                }
+            }
+        }
+    }
+    lut_valid = false;
+}
+
+uint8_t Text_CellWidth(FontId font) {
+    return cell_width[font];
+}
+
+uint8_t Text_CellHeight(FontId font) {
+    return cell_height[font];
+}
+
+const uint16_t *Text_GlyphRows(FontId font, char c) {
+    if (font == FONT_12X16) return glyphs_12x16[glyph_index_12x16(c)];
+
+    int g = (uint8_t)c - GLYPH_FIRST;
+    if (g < 0 || g >= GLYPH_COUNT) return blank_rows;
+    return font == FONT_5X7 ? glyphs_5x7[g] : glyphs_8x8[g];
+}
+
+static void build_nibble_lut(uint16_t fg, uint16_t bg) {
+    if (lut_valid && fg == lut_fg && bg == lut_bg) return;
+    for (int n = 0; n < 16; n++) {
+        for (int i = 0; i < 4; i++) {
+            nibble_px[n][i] = (n & (8 >> i)) ? fg : bg;
+        }
+    }
+    lut_fg = fg;
+    lut_bg = bg;
+    lut_valid = true;
+}
+
+void TextLine_Init(TextLine *line, uint16_t x, uint16_t y, FontId font,
+                   uint8_t max_chars, uint16_t fg, uint16_t bg) {
+    line->x = x;
+    line->y = y;
+    line->font = font;
+    line->max_chars = max_chars > TEXT_LINE_MAX ? TEXT_LINE_MAX : max_chars;
+    line->fg = fg;
+    line->bg = bg;
+    line->valid = false;
+    memset(line->shown, ' ', sizeof(line->shown));
+    line->shown[TEXT_LINE_MAX] = '\0';
+}
+
+void TextLine_Invalidate(TextLine *line) {
+    line->valid = false;
+}
+
+// Вывод серии символов [first, first + count) одним окном
+static void push_cells(ILI9341 *disp, const TextLine *line, const char *text, int first, int count) {
+    FontId font = (FontId)line->font;
+    uint8_t cw = cell_width[font];
+    uint8_t ch = cell_height[font];
+    uint16_t x0 = line->x + first * cw;
+    uint16_t w = count * cw;
+
+    if (x0 >= disp->width || line->y >= disp->height) return;
+    if (x0 + w > disp->width) {
+        w = disp->width - x0;
+        count = (w + cw - 1) / cw;
+    }
+
+    const uint16_t *rows[TEXT_LINE_MAX];
+    for (int i = 0; i < count; i++) rows[i] = Text_GlyphRows(font, text[first + i]);
+
+    ILI9341_SetAddressWindow(disp, x0, line->y, x0 + w - 1, line->y + ch - 1);
+    gpio_put(disp->dc_pin, 1);
+    gpio_put(disp->cs_pin, 0);
+
+    for (int row = 0; row < ch; row++) {
+        uint16_t *dst = scanline;
+        for (int i = 0; i < count; i++, dst += cw) {
+            uint16_t bits = rows[i][row];
+            for (int px = 0; px < cw; px += 4) {
+                memcpy(&dst[px], nibble_px[(bits >> (12 - px)) & 0xF], 4 * sizeof(uint16_t));
+            }
+        }
+        spi_write_blocking(disp->spi, (uint8_t*)scanline, w * 2);
+    }
+
+    gpio_put(disp->cs_pin, 1);
+}
+
+uint16_t TextLine_Set(ILI9341 *disp, TextLine *line, const char *str) {
+    char text[TEXT_LINE_MAX + 1];
+    int n = line->max_chars;
+
+    // Дополняем пробелами, чтобы стереть хвост более длинной старой строки
+    int len = 0;
+    while (len < n && str[len] && str[len] != '\n') {
+        text[len] = str[len];
+        len++;
+    }
+    memset(&text[len], ' ', n - len);
+    text[n] = '\0';
+
+    build_nibble_lut(line->fg, line->bg);
+
+    uint16_t pushed = 0;
+    int i = 0;
+    while (i < n) {
+        if (line->valid && text[i] == line->shown[i]) {
+            i++;
+            continue;
+        }
+        // Серия подряд идущих изменившихся символов
+        int first = i;
+        while (i < n && (!line->valid || text[i] != line->shown[i])) i++;
+        push_cells(disp, line, text, first, i - first);
+        pushed += i - first;
+    }
+
+    memcpy(line->shown, text, n);
+    line->valid = true;
+    return pushed;
+}
+
+void TextLine_ComposeRow8(const TextLine *line, uint16_t y, color8_t *row, uint16_t width,
+                          color8_t fg, color8_t bg) {
+    FontId font = (FontId)line->font;
+    if (!line->valid || y < line->y || y >= line->y + cell_height[font]) return;
+
+    uint8_t cw = cell_width[font];
+    uint16_t x = line->x;
+    for (int i = 0; i < line->max_chars && x < width; i++, x += cw) {
+        uint16_t bits = Text_GlyphRows(font, line->shown[i])[y - line->y];
+        for (int px = 0; px < cw && x + px < width; px++) {
+            row[x + px] = (bits & (0x8000 >> px)) ? fg : bg;
+        }
+    }
+}
+
+// Запись беззнакового числа в конец буфера, возвращает указатель на первую цифру
+static char *utoa_rev(char *end, uint32_t v) {
+    do {
+        *--end = '0' + v % 10;
+        v /= 10;
+    } while (v);
+    return end;
+}
+
+int Text_FormatFixed(char *buf, int size, int32_t value, uint8_t decimals, const char *unit) {
+    char tmp[24];
+    char *end = &tmp[sizeof(tmp)];
+    uint32_t v = value < 0 ? -(uint32_t)value : (uint32_t)value;
+
+    char *p = end;
+    for (uint8_t d = 0; d < decimals; d++) {
+        *--p = '0' + v % 10;
+        v /= 10;
+    }
+    if (decimals) *--p = '.';
+    p = utoa_rev(p, v);
+    if (value < 0) *--p = '-';
+
+    int len = 0;
+    while (p < end && len < size - 1) buf[len++] = *p++;
+    while (unit && *unit && len < size - 1) buf[len++] = *unit++;
+    buf[len] = '\0';
+    return len;
+}
+
+int Text_FormatSI(char *buf, int size, int32_t value, int8_t exp10, const char *unit) {
+    static const char prefixes[] = { 'p', 'n', 'u', 'm', 0, 'k', 'M', 'G' };
+    static const uint32_t pow10[] = { 1, 10, 100, 1000, 10000, 100000, 1000000,
+                                      10000000, 100000000, 1000000000 };
+
+    if (value == 0) {
+        return Text_FormatFixed(buf, size, 0, 0, unit);
+    }
+
+    bool negative = value < 0;
+    uint32_t v = negative ? -(uint32_t)value : (uint32_t)value;
+
+    int digits = 1;
+    while (digits < 10 && v >= pow10[digits]) digits++;
+
+    // Приводим к трём значащим цифрам с округлением
+    int e = exp10;
+    if (digits > 3) {
+        uint32_t div = pow10[digits - 3];
+        v = (v + div / 2) / div;
+        e += digits - 3;
+        if (v >= 1000) { // 999.5 -> 1000
+            v /= 10;
+            e++;
+        }
+    } else if (digits < 3) {
+        v *= pow10[3 - digits];
+        e -= 3 - digits;
+    }
+
+    // v в [100, 999], значение = v * 10^e. Инженерная степень кратна 3
+    int magnitude = e + 2;
+    int k = magnitude >= 0 ? magnitude / 3 : -((-magnitude + 2) / 3);
+    int decimals = 3 * k - e;  // 0, 1 или 2
+
+    int idx = k + 4;
+    if (idx < 0) {
+        // Меньше пико - считаем нулём
+        return Text_FormatFixed(buf, size, 0, 0, unit);
+    }
+    if (idx >= (int)sizeof(prefixes)) {
+        // Больше гига - без приставки, с потерей младших разрядов
+        return Text_FormatFixed(buf, size, negative ? -(int32_t)v : (int32_t)v, 0, unit);
+    }
+
+    char suffix[8];
+    int s = 0;
+    if (prefixes[idx]) suffix[s++] = prefixes[idx];
+    while (unit && *unit && s < (int)sizeof(suffix) - 1) suffix[s++] = *unit++;
+    suffix[s] = '\0';
+
+    int32_t signed_v = negative ? -(int32_t)v : (int32_t)v;
+    return Text_FormatFixed(buf, size, signed_v, decimals, suffix);
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "settings/settings_store.h"
+#include "wave_codec/wave_codec.h"
+
+// Эталонные осциллограммы во flash: по слоту на сектор, отсчёты сжаты
+// wave_codec. При выводе отсчёты декодируются по одному прямо из flash
+// (через XIP), в RAM эталон целиком не разворачивается.
+//
+// Слот:
+//   0  magic        REFERENCE_MAGIC
+//   2  version      1
+//   3  flags        резерв, 0
+//   4  count        число отсчётов
+//   6  encoded      байт сжатых данных
+//   8  sequence     номер захвата
+//  12  sample_rate  Гц
+//  16  gain_q16     калибровка на момент записи
+//  20  offset_mv
+//  24  reserved     0
+//  26  crc16        CRC-16/CCITT-FALSE (stream_crc16) по заголовку (0..25) и данным
+//  28  данные wave_codec
+//
+// Модуль не зависит от SDK: flash - через FlashPort (settings_store.h).
+
+#define REFERENCE_SLOTS         4
+#define REFERENCE_MAGIC         0x5EF0
+#define REFERENCE_HEADER_BYTES  28
+#define REFERENCE_MAX_SAMPLES   512
+
+typedef struct {
+    uint16_t count;
+    uint16_t encoded_bytes;
+    uint32_t sequence;
+    uint32_t sample_rate;
+    uint32_t gain_q16;
+    int32_t offset_mv;
+} ReferenceInfo;
+
+// Просмотр слотов. Слотов столько, сколько секторов в порте, но не больше
+// REFERENCE_SLOTS
+void reference_init(const FlashPort *port);
+uint8_t reference_slot_count(void);
+
+bool reference_valid(uint8_t slot);
+bool reference_get_info(uint8_t slot, ReferenceInfo *info);
+
+// Запись отсчётов в слот: стирание сектора и запись по страницам.
+// В info используются sequence, sample_rate, gain_q16, offset_mv
+bool reference_save(uint8_t slot, const uint16_t *samples, uint16_t count,
+                    const ReferenceInfo *info);
+bool reference_clear(uint8_t slot);
+
+// Потоковое чтение: отсчёты по одному прямо из flash
+typedef struct {
+    WaveDecoder dec;
+} ReferenceCursor;
+
+// Число отсчётов, 0 - слот пуст
+uint16_t reference_open(uint8_t slot, ReferenceCursor *cursor);
+
+static inline bool reference_next(ReferenceCursor *cursor, uint16_t *sample) {
+    return wave_decoder_next(&cursor->dec, sample);
+}
+
+// Сравнение с живым сигналом по столбцам
+typedef struct {
+    uint16_t columns;       // Сравнено столбцов
+    uint16_t max_diff;      // Наибольшее отклонение, коды
+    uint16_t worst_column;  // Где оно
+    uint16_t over;          // Столбцов с отклонением больше допуска
+    uint32_t sum_diff;      // Сумма отклонений (для среднего)
+} ReferenceCompare;
+
+static inline void reference_compare_reset(ReferenceCompare *c) {
+    *c = (ReferenceCompare){ 0 };
+}
+
+static inline void reference_compare_add(ReferenceCompare *c, uint16_t column,
+                                         uint16_t live, uint16_t ref, uint16_t tolerance) {
+    uint16_t d = live > ref ? live - ref : ref - live;
+    if (d > c->max_diff) {
+        c->max_diff = d;
+        c->worst_column = column;
+    }
+    if (d > tolerance) c->over++;
+    c->sum_diff += d;
+    c->columns++;
+}
+
+static inline bool reference_compare_pass(const ReferenceCompare *c) {
+    return c->columns && c->over == 0;
+}
+
+// Сравнение целиком (без вывода): по общей длине эталона и сигнала
+bool reference_compare(uint8_t slot, const uint16_t *live, uint16_t count,
+                       uint16_t tolerance, ReferenceCompare *result);
@@ -0,0 +1,148 @@
+#include "reference/reference.h"
+#include "usb_stream/stream_frame.h"
+#include <string.h>
+
+// Порт пишет в пределах страницы flash
+#define PROGRAM_CHUNK 256
+
+static const FlashPort *port;
+static uint8_t slot_count;
+static bool slot_ok[REFERENCE_SLOTS];
+
+// Буфер записи: заголовок и сжатые отсчёты худшего случая
+static uint8_t record[REFERENCE_HEADER_BYTES + WAVE_CODEC_MAX_BYTES(REFERENCE_MAX_SAMPLES)];
+
+static inline uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t get_u32(const uint8_t *p) {
+    return get_u16(p) | ((uint32_t)get_u16(p + 2) << 16);
+}
+
+static inline void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void put_u32(uint8_t *p, uint32_t v) {
+    put_u16(p, (uint16_t)v);
+    put_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+static const uint8_t *slot_base(uint8_t slot) {
+    return port->base + (uint32_t)slot * port->sector_size;
+}
+
+// Заголовок и данные одной суммой: CRC потока с продолжением
+static uint16_t record_crc(const uint8_t *p, uint16_t encoded) {
+    uint16_t crc = stream_crc16(0xFFFF, p, REFERENCE_HEADER_BYTES - 2);
+    return stream_crc16(crc, p + REFERENCE_HEADER_BYTES, encoded);
+}
+
+// Проверка слота целиком, включая CRC данных. Выполняется при запуске
+// и после записи, при выводе используется результат
+static bool check_slot(uint8_t slot) {
+    const uint8_t *p = slot_base(slot);
+    if (get_u16(p) != REFERENCE_MAGIC || p[2] != 1) return false;
+    uint16_t count = get_u16(&p[4]);
+    uint16_t encoded = get_u16(&p[6]);
+    if (count == 0 || count > REFERENCE_MAX_SAMPLES) return false;
+    if (REFERENCE_HEADER_BYTES + (uint32_t)encoded > port->sector_size) return false;
+    return get_u16(&p[26]) == record_crc(p, encoded);
+}
+
+void reference_init(const FlashPort *flash) {
+    port = flash;
+    slot_count = port->size / port->sector_size;
+    if (slot_count > REFERENCE_SLOTS) slot_count = REFERENCE_SLOTS;
+    for (uint8_t i = 0; i < REFERENCE_SLOTS; i++) {
+        slot_ok[i] = i < slot_count && check_slot(i);
+    }
+}
+
+uint8_t reference_slot_count(void) {
+    return slot_count;
+}
+
+bool reference_valid(uint8_t slot) {
+    return slot < slot_count && slot_ok[slot];
+}
+
+bool reference_get_info(uint8_t slot, ReferenceInfo *info) {
+    if (!reference_valid(slot)) return false;
+    const uint8_t *p = slot_base(slot);
+    info->count = get_u16(&p[4]);
+    info->encoded_bytes = get_u16(&p[6]);
+    info->sequence = get_u32(&p[8]);
+    info->sample_rate = get_u32(&p[12]);
+    info->gain_q16 = get_u32(&p[16]);
+    info->offset_mv = (int32_t)get_u32(&p[20]);
+    return true;
+}
+
+bool reference_save(uint8_t slot, const uint16_t *samples, uint16_t count,
+                    const ReferenceInfo *info) {
+    if (slot >= slot_count || count == 0 || count > REFERENCE_MAX_SAMPLES) return false;
+
+    size_t encoded = wave_encode(samples, count, &record[REFERENCE_HEADER_BYTES],
+                                 sizeof(record) - REFERENCE_HEADER_BYTES);
+    if (!encoded || REFERENCE_HEADER_BYTES + encoded > port->sector_size) return false;
+
+    memset(record, 0, REFERENCE_HEADER_BYTES);
+    put_u16(&record[0], REFERENCE_MAGIC);
+    record[2] = 1;
+    put_u16(&record[4], count);
+    put_u16(&record[6], (uint16_t)encoded);
+    put_u32(&record[8], info->sequence);
+    put_u32(&record[12], info->sample_rate);
+    put_u32(&record[16], info->gain_q16);
+    put_u32(&record[20], (uint32_t)info->offset_mv);
+    put_u16(&record[26], record_crc(record, (uint16_t)encoded));
+
+    // Слот недействителен с момента стирания: оборванная запись не пройдёт CRC
+    slot_ok[slot] = false;
+    uint32_t offset = (uint32_t)slot * port->sector_size;
+    if (!port->erase(port->ctx, offset)) return false;
+
+    uint32_t total = REFERENCE_HEADER_BYTES + (uint32_t)encoded;
+    for (uint32_t done = 0; done < total;) {
+        uint32_t n = PROGRAM_CHUNK - ((offset + done) & (PROGRAM_CHUNK - 1));
+        if (n > total - done) n = total - done;
+        if (!port->program(port->ctx, offset + done, &record[done], n)) return false;
+        done += n;
+    }
+
+    slot_ok[slot] = check_slot(slot);
+    return slot_ok[slot];
+}
+
+bool reference_clear(uint8_t slot) {
+    if (slot >= slot_count) return false;
+    slot_ok[slot] = false;
+    return port->erase(port->ctx, (uint32_t)slot * port->sector_size);
+}
+
+uint16_t reference_open(uint8_t slot, ReferenceCursor *cursor) {
+    if (!reference_valid(slot)) return 0;
+    const uint8_t *p = slot_base(slot);
+    uint16_t count = get_u16(&p[4]);
+    wave_decoder_init(&cursor->dec, p + REFERENCE_HEADER_BYTES, get_u16(&p[6]), count);
+    return count;
+}
+
+bool reference_compare(uint8_t slot, const uint16_t *live, uint16_t count,
+                       uint16_t tolerance, ReferenceCompare *result) {
+    reference_compare_reset(result);
+    ReferenceCursor cursor;
+    uint16_t ref_count = reference_open(slot, &cursor);
+    if (!ref_count) return false;
+
+    if (count > ref_count) count = ref_count;
+    for (uint16_t x = 0; x < count; x++) {
+        uint16_t ref;
+        if (!reference_next(&cursor, &ref)) break;
+        reference_compare_add(result, x, live[x], ref, tolerance);
+    }
+    return result->columns > 0;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "long_record/long_record.h"
+
+// Пересчёт отсчётов в столбцы экрана при любом числе отсчётов на столбец.
+//
+// Окно задаётся началом и длиной в отсчётах (Q16, дробные). Столбцы - в
+// том же виде, что у длинной записи (RecordSpan), и рисуются одинаково.
+//   - Отсчётов на столбец не меньше одного: минимум и максимум отсчётов
+//     столбца, узкие выбросы не теряются.
+//   - Меньше одного: восстановление по теореме Котельникова - свёртка с
+//     sin(x)/x в окне Ланцоша на RESAMPLE_TAPS соседних отсчётах.
+//     Коэффициенты для RESAMPLE_PHASES дробных положений посчитаны заранее
+//     (Q14, сумма каждой фазы ровно 1.0). Отсчёты за краями массива
+//     повторяют крайние. Результат ограничивается диапазоном АЦП.
+
+#define RESAMPLE_TAPS    8
+#define RESAMPLE_PHASES  64
+#define RESAMPLE_SHIFT   14
+#define RESAMPLE_ONE_Q16 65536
+
+// Окно [start, start + span) отсчётов samples[0..count) на width столбцов.
+// При прореживании столбец вне массива пустой (min > max). Возвращает
+// число столбцов до последнего непустого
+uint16_t resample(const uint16_t *samples, uint16_t count,
+                  int32_t start_q16, uint32_t span_q16,
+                  RecordSpan *columns, uint16_t width);
@@ -0,0 +1,110 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Интерпретатор команд в стиле SCPI.
+//
+// Сообщение - строка до '\n'. В одной строке можно передать несколько
+// команд через ';' (пакетная обработка): ответы на все запросы строки
+// уходят одной строкой через ';'. Заголовки без учёта регистра, в
+// короткой (заглавные буквы шаблона) или полной форме: "TRIG:LEV",
+// ":trigger:level". Ведущее ':' не обязательно, '?' в конце - запрос.
+//
+// Ядро интерпретатора не зависит от SDK: транспорт и таблица команд
+// подставляются снаружи, на хосте - транспорт в памяти.
+
+#define SCPI_LINE_MAX      128
+#define SCPI_ERROR_QUEUE   8
+
+// Транспорт. write должен передать все байты (или вернуть меньше при обрыве)
+typedef struct {
+    size_t (*read)(void *ctx, uint8_t *buf, size_t len);   // Без ожидания
+    size_t (*write)(void *ctx, const uint8_t *data, size_t len);
+    void (*flush)(void *ctx);
+    void *ctx;
+} ScpiTransport;
+
+typedef struct ScpiContext ScpiContext;
+
+// Обработчик: args - параметры после заголовка (без ведущих пробелов),
+// query - был ли '?'
+typedef void (*ScpiHandler)(ScpiContext *ctx, const char *args, bool query);
+
+typedef struct {
+    const char *pattern;   // "TRIGger:LEVel", "*IDN"
+    ScpiHandler handler;
+} ScpiCommand;
+
+struct ScpiContext {
+    const ScpiTransport *transport;
+    const ScpiCommand *commands;
+    uint16_t command_count;
+
+    char line[SCPI_LINE_MAX + 1];
+    uint16_t line_len;
+    bool overflow;          // Строка длиннее SCPI_LINE_MAX, отбрасывается
+    uint16_t held;          // Байт в line, принятых во время отложенного ответа
+
+    bool replied;           // В текущем сообщении уже был ответ
+    bool deferred;          // Данные блока и конец ответа - позже
+
+    int16_t errors[SCPI_ERROR_QUEUE];
+    uint8_t error_head;
+    uint8_t error_count;
+
+    uint32_t messages;      // Обработано строк
+    uint32_t commands_run;  // Выполнено команд
+};
+
+// Коды ошибок SCPI
+#define SCPI_ERR_NONE               0
+#define SCPI_ERR_COMMAND         -100
+#define SCPI_ERR_DATA_TYPE       -104
+#define SCPI_ERR_MISSING_PARAM   -109
+#define SCPI_ERR_UNDEFINED_HEADER -113
+#define SCPI_ERR_EXECUTION       -200
+#define SCPI_ERR_OUT_OF_RANGE    -222
+#define SCPI_ERR_ILLEGAL_VALUE   -224
+#define SCPI_ERR_QUEUE_OVERFLOW  -350
+#define SCPI_ERR_INPUT_OVERRUN   -363
+
+void scpi_init(ScpiContext *ctx, const ScpiTransport *transport,
+               const ScpiCommand *commands, uint16_t count);
+
+// Разбор принятых байт: каждая полная строка выполняется сразу. Пока
+// ответ отложен (scpi_reply_block_header), строки не выполняются: байты
+// ждут в line (не больше SCPI_LINE_MAX, остальное - ошибка переполнения)
+// и разбираются следующим scpi_feed или scpi_poll после scpi_end_deferred
+void scpi_feed(ScpiContext *ctx, const uint8_t *data, size_t len);
+
+// Чтение всего, что есть в транспорте, и выполнение. Пока ответ отложен,
+// транспорт не читается
+void scpi_poll(ScpiContext *ctx);
+
+// Для обработчиков: ответы
+void scpi_reply(ScpiContext *ctx, const char *text);
+void scpi_reply_int(ScpiContext *ctx, int32_t value);
+void scpi_reply_float(ScpiContext *ctx, float value);
+// Двоичный блок IEEE 488.2 "#<n><len><data>": данные уходят в транспорт
+// напрямую, без копирования
+void scpi_reply_block(ScpiContext *ctx, const void *data, size_t len);
+// Только заголовок блока: len байт данных владелец команды передаёт потом
+// сам, частями, и закрывает ответ scpi_end_deferred. Остальные команды
+// сообщения не выполняются, следующие сообщения ждут конца блока
+void scpi_reply_block_header(ScpiContext *ctx, size_t len);
+void scpi_end_deferred(ScpiContext *ctx);
+
+void scpi_push_error(ScpiContext *ctx, int16_t code);
+int16_t scpi_pop_error(ScpiContext *ctx);
+const char *scpi_error_text(int16_t code);
+
+// Для обработчиков: параметры
+bool scpi_parse_float(const char *args, float *value);
+bool scpi_parse_int(const char *args, int32_t *value);
+bool scpi_parse_bool(const char *args, bool *value);     // ON/OFF/1/0
+// Выбор из мнемоник в форме шаблона ("POSitive"). Возвращает индекс или -1
+int scpi_parse_choice(const char *args, const char *const *choices, int count);
+
+// Сопоставление заголовка с шаблоном (короткая или полная форма каждого узла)
+bool scpi_match(const char *pattern, const char *header, size_t header_len);
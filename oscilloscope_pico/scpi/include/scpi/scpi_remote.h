@@ -0,0 +1,41 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+// Удалённое управление по USB CDC: таблица команд прибора поверх ядра
+// интерпретатора (scpi.h). Работает на ядре дисплея.
+//
+// Команды:
+//   *IDN?  *RST  *CLS  *OPC?  SYSTem:ERRor?
+//   TIMebase:SCALe <с>            CHANnel:SCALe <В/дел>
+//   TIMebase:POSition <с, <= 0>   DISPlay:RECord ON|OFF
+//   CHANnel:OFFSet <В>            (напряжение нижнего края осциллограммы)
+//   TRIGger:LEVel <В>             TRIGger:SLOPe POSitive|NEGative|EITHer
+//   TRIGger:MODE AUTO|NORMal|SINGle
+//   TRIGger:HYSTeresis <В>        (0 - без гистерезиса)
+//   AUToscale                     (автоустановка; запрос - IDLE|RUN|LOCK|NPER)
+//   RUN  STOP  SINGle
+//   MEASure:VMAX?|VMIN?|VPP?|FREQuency?|DUTY?|ALL?
+//   WAVeform:DATA?  WAVeform:PREamble?
+//   DISPlay:PERSistence ON|OFF    DISPlay:MEASurements ON|OFF
+//   DISPlay:XY ON|OFF             (вход A по X, вход B по Y)
+//   DISPlay:SCReenshot?           (снимок экрана, screenshot/screen_rle.h)
+//   STReam ON|OFF                 STReam:ENCoding RAW|PACK12|DELTa
+//   MASK:CREate [<слот эталона>]  (без слота - из кадра на экране)
+//   MASK:TOLerance <В>            MASK:STATe ON|OFF
+//   MASK:STOP ON|OFF              (остановка на первом нарушении)
+//   MASK:RESet                    MASK:COUNt?  (испытаний,годных,негодных)
+//   MASK:FAILure?                 MASK:RATE?   (испытаний в секунду)
+//   CALibration:GAIN <В>          (усиление по кадру: на входе это напряжение;
+//                                  запрос - В на код)
+// У команд с параметром есть и форма запроса ("TRIG:LEV?").
+
+// Таймаут блокирующей записи ответа: ПК перестал читать
+#define SCPI_WRITE_TIMEOUT_US 100000
+
+void scpi_remote_init(void);
+
+// Разбор всего принятого по CDC (на каждом пробуждении цикла дисплея).
+// Пока передаётся снимок экрана - только его передача.
+// Возвращает true, если выполнялись команды (картинку нужно обновить)
+bool scpi_remote_poll(void);
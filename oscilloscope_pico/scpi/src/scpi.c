@@ -0,0 +1,303 @@
+#include "scpi/scpi.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+void scpi_init(ScpiContext *ctx, const ScpiTransport *transport,
+               const ScpiCommand *commands, uint16_t count) {
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->transport = transport;
+    ctx->commands = commands;
+    ctx->command_count = count;
+}
+
+static void write_all(ScpiContext *ctx, const void *data, size_t len) {
+    const uint8_t *p = data;
+    while (len) {
+        size_t n = ctx->transport->write(ctx->transport->ctx, p, len);
+        if (n == 0) return; // Обрыв связи: остаток теряется
+        p += n;
+        len -= n;
+    }
+}
+
+// Разделитель ответов внутри одного сообщения
+static void begin_reply(ScpiContext *ctx) {
+    if (ctx->replied) write_all(ctx, ";", 1);
+    ctx->replied = true;
+}
+
+void scpi_reply(ScpiContext *ctx, const char *text) {
+    begin_reply(ctx);
+    write_all(ctx, text, strlen(text));
+}
+
+void scpi_reply_int(ScpiContext *ctx, int32_t value) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%ld", (long)value);
+    scpi_reply(ctx, buf);
+}
+
+void scpi_reply_float(ScpiContext *ctx, float value) {
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%.6G", (double)value);
+    scpi_reply(ctx, buf);
+}
+
+void scpi_reply_block_header(ScpiContext *ctx, size_t len) {
+    char len_text[12];
+    char header[16];
+    int digits = snprintf(len_text, sizeof(len_text), "%lu", (unsigned long)len);
+    int n = snprintf(header, sizeof(header), "#%d%s", digits, len_text);
+
+    begin_reply(ctx);
+    write_all(ctx, header, n);
+    ctx->deferred = true;
+}
+
+void scpi_reply_block(ScpiContext *ctx, const void *data, size_t len) {
+    scpi_reply_block_header(ctx, len);
+    ctx->deferred = false;
+    write_all(ctx, data, len);
+}
+
+void scpi_end_deferred(ScpiContext *ctx) {
+    if (!ctx->deferred) return;
+    ctx->deferred = false;
+    write_all(ctx, "\n", 1);
+    ctx->transport->flush(ctx->transport->ctx);
+}
+
+void scpi_push_error(ScpiContext *ctx, int16_t code) {
+    if (ctx->error_count == SCPI_ERROR_QUEUE) {
+        // Очередь полна: последняя запись заменяется признаком переполнения
+        uint8_t last = (ctx->error_head + SCPI_ERROR_QUEUE - 1) % SCPI_ERROR_QUEUE;
+        ctx->errors[last] = SCPI_ERR_QUEUE_OVERFLOW;
+        return;
+    }
+    ctx->errors[(ctx->error_head + ctx->error_count) % SCPI_ERROR_QUEUE] = code;
+    ctx->error_count++;
+}
+
+int16_t scpi_pop_error(ScpiContext *ctx) {
+    if (!ctx->error_count) return SCPI_ERR_NONE;
+    int16_t code = ctx->errors[ctx->error_head];
+    ctx->error_head = (ctx->error_head + 1) % SCPI_ERROR_QUEUE;
+    ctx->error_count--;
+    return code;
+}
+
+const char *scpi_error_text(int16_t code) {
+    switch (code) {
+        case SCPI_ERR_NONE:             return "No error";
+        case SCPI_ERR_COMMAND:          return "Command error";
+        case SCPI_ERR_DATA_TYPE:        return "Data type error";
+        case SCPI_ERR_MISSING_PARAM:    return "Missing parameter";
+        case SCPI_ERR_UNDEFINED_HEADER: return "Undefined header";
+        case SCPI_ERR_EXECUTION:        return "Execution error";
+        case SCPI_ERR_OUT_OF_RANGE:     return "Data out of range";
+        case SCPI_ERR_ILLEGAL_VALUE:    return "Illegal parameter value";
+        case SCPI_ERR_QUEUE_OVERFLOW:   return "Queue overflow";
+        case SCPI_ERR_INPUT_OVERRUN:    return "Input buffer overrun";
+        default:                        return "Unknown error";
+    }
+}
+
+// Совпадение одного узла: короткая форма - заглавные буквы, цифры и '*'
+// шаблона, полная - весь узел
+static bool match_node(const char *pat, size_t pat_len, const char *in, size_t in_len) {
+    if (in_len == pat_len) {
+        size_t i = 0;
+        while (i < in_len && toupper((unsigned char)in[i]) == toupper((unsigned char)pat[i])) i++;
+        if (i == in_len) return true;
+    }
+
+    size_t short_len = 0;
+    while (short_len < pat_len && !islower((unsigned char)pat[short_len])) short_len++;
+    if (in_len != short_len) return false;
+    for (size_t i = 0; i < short_len; i++) {
+        if (toupper((unsigned char)in[i]) != pat[i]) return false;
+    }
+    return true;
+}
+
+bool scpi_match(const char *pattern, const char *header, size_t header_len) {
+    if (header_len && header[0] == ':') {
+        header++;
+        header_len--;
+    }
+
+    for (;;) {
+        const char *pat_end = strchr(pattern, ':');
+        size_t pat_len = pat_end ? (size_t)(pat_end - pattern) : strlen(pattern);
+
+        size_t in_len = 0;
+        while (in_len < header_len && header[in_len] != ':') in_len++;
+
+        if (!match_node(pattern, pat_len, header, in_len)) return false;
+
+        bool pat_more = pat_end != NULL;
+        bool in_more = in_len < header_len;
+        if (pat_more != in_more) return false;
+        if (!pat_more) return true;
+
+        pattern = pat_end + 1;
+        header += in_len + 1;
+        header_len -= in_len + 1;
+    }
+}
+
+static const char *skip_spaces(const char *s) {
+    while (*s == ' ' || *s == '\t') s++;
+    return s;
+}
+
+// Параметр без хвоста: после значения допускаются только пробелы
+static bool only_spaces(const char *s) {
+    return *skip_spaces(s) == '\0';
+}
+
+bool scpi_parse_float(const char *args, float *value) {
+    char *end;
+    args = skip_spaces(args);
+    if (!*args) return false;
+    float v = strtof(args, &end);
+    if (end == args || !only_spaces(end)) return false;
+    *value = v;
+    return true;
+}
+
+bool scpi_parse_int(const char *args, int32_t *value) {
+    char *end;
+    args = skip_spaces(args);
+    if (!*args) return false;
+    long v = strtol(args, &end, 0);
+    if (end == args || !only_spaces(end)) return false;
+    *value = (int32_t)v;
+    return true;
+}
+
+int scpi_parse_choice(const char *args, const char *const *choices, int count) {
+    args = skip_spaces(args);
+    size_t len = 0;
+    while (args[len] && args[len] != ' ' && args[len] != '\t') len++;
+    if (!len || !only_spaces(args + len)) return -1;
+
+    for (int i = 0; i < count; i++) {
+        if (match_node(choices[i], strlen(choices[i]), args, len)) return i;
+    }
+    return -1;
+}
+
+bool scpi_parse_bool(const char *args, bool *value) {
+    static const char *const names[] = { "OFF", "ON", "0", "1" };
+    int i = scpi_parse_choice(args, names, 4);
+    if (i < 0) return false;
+    *value = i & 1;
+    return true;
+}
+
+// Выполнение одной команды из сообщения (уже без ';')
+static void run_unit(ScpiContext *ctx, char *unit) {
+    unit = (char *)skip_spaces(unit);
+    if (!*unit) return;
+
+    size_t header_len = 0;
+    while (unit[header_len] && unit[header_len] != ' ' && unit[header_len] != '\t') header_len++;
+
+    bool query = header_len && unit[header_len - 1] == '?';
+    const char *args = skip_spaces(unit + header_len);
+    if (query) header_len--;
+
+    for (uint16_t i = 0; i < ctx->command_count; i++) {
+        if (scpi_match(ctx->commands[i].pattern, unit, header_len)) {
+            ctx->commands_run++;
+            ctx->commands[i].handler(ctx, args, query);
+            return;
+        }
+    }
+    scpi_push_error(ctx, SCPI_ERR_UNDEFINED_HEADER);
+}
+
+static void run_line(ScpiContext *ctx) {
+    ctx->line[ctx->line_len] = '\0';
+    ctx->replied = false;
+    ctx->messages++;
+
+    char *unit = ctx->line;
+    for (;;) {
+        char *sep = strchr(unit, ';');
+        if (sep) *sep = '\0';
+        run_unit(ctx, unit);
+        if (!sep || ctx->deferred) break;
+        unit = sep + 1;
+    }
+
+    // Все ответы сообщения - одной строкой. Отложенный блок закрывается
+    // scpi_end_deferred
+    if (ctx->replied && !ctx->deferred) {
+        write_all(ctx, "\n", 1);
+        ctx->transport->flush(ctx->transport->ctx);
+    }
+}
+
+// Разбор до конца данных или до строки, ответ на которую отложен.
+// Возвращает число разобранных байт
+static size_t parse(ScpiContext *ctx, const uint8_t *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        char c = (char)data[i];
+        if (c == '\n') {
+            if (ctx->overflow) scpi_push_error(ctx, SCPI_ERR_INPUT_OVERRUN);
+            else run_line(ctx);
+            ctx->line_len = 0;
+            ctx->overflow = false;
+            if (ctx->deferred) return i + 1;
+        } else if (c == '\r') {
+            continue;
+        } else if (ctx->line_len < SCPI_LINE_MAX) {
+            ctx->line[ctx->line_len++] = c;
+        } else {
+            ctx->overflow = true;
+        }
+    }
+    return len;
+}
+
+// Байты после строки с отложенным ответом. Строка уже выполнена, line
+// свободна
+static void hold_input(ScpiContext *ctx, const uint8_t *data, size_t len) {
+    size_t room = SCPI_LINE_MAX - ctx->held;
+    if (len > room) {
+        scpi_push_error(ctx, SCPI_ERR_INPUT_OVERRUN);
+        len = room;
+    }
+    memcpy(&ctx->line[ctx->held], data, len);
+    ctx->held += len;
+}
+
+// Разбор отложенных байт после конца блока
+static void resume_held(ScpiContext *ctx) {
+    if (!ctx->held || ctx->deferred) return;
+    uint8_t buf[SCPI_LINE_MAX];
+    size_t n = ctx->held;
+    memcpy(buf, ctx->line, n);
+    ctx->held = 0;
+    size_t done = parse(ctx, buf, n);
+    if (done < n) hold_input(ctx, buf + done, n - done);
+}
+
+void scpi_feed(ScpiContext *ctx, const uint8_t *data, size_t len) {
+    resume_held(ctx);
+    size_t done = ctx->deferred ? 0 : parse(ctx, data, len);
+    if (done < len) hold_input(ctx, data + done, len - done);
+}
+
+void scpi_poll(ScpiContext *ctx) {
+    uint8_t buf[64];
+    size_t n;
+    resume_held(ctx);
+    while (!ctx->deferred && (n = ctx->transport->read(ctx->transport->ctx, buf, sizeof(buf))) > 0) {
+        scpi_feed(ctx, buf, n);
+    }
+}
@@ -0,0 +1,787 @@
+#include "scpi/scpi_remote.h"
+#include "scpi/scpi.h"
+#include "settings/settings.h"
+#include "global_buffer/global_buffer.h"
+#include "calibration/calibration.h"
+#include "usb_stream/usb_stream.h"
+#include "display_driver/display_driver.h"
+#include "capture/capture.h"
+#include "reference/reference.h"
+#include "mask/mask.h"
+#include "math_channel/math_channel.h"
+#include "wave_codec/wave_codec.h"
+#include "screenshot/screenshot.h"
+#include "tusb.h"
+#include "pico/time.h"
+#include <stdio.h>
+#include <math.h>
+
+static ScpiContext scpi;
+static uint32_t last_commands_run = 0;
+
+/* Транспорт USB CDC */
+
+static size_t cdc_read(void *ctx, uint8_t *buf, size_t len) {
+    (void)ctx;
+    if (!tud_cdc_available()) return 0;
+    return tud_cdc_read(buf, len);
+}
+
+// Запись с ожиданием места в буфере TinyUSB. Задачу USB крутит фоновое
+// прерывание pico_stdio_usb, здесь только ждём
+static size_t cdc_write(void *ctx, const uint8_t *data, size_t len) {
+    (void)ctx;
+    size_t done = 0;
+    absolute_time_t deadline = make_timeout_time_us(SCPI_WRITE_TIMEOUT_US);
+    while (done < len && tud_cdc_connected()) {
+        uint32_t n = tud_cdc_write(data + done, len - done);
+        if (n) {
+            done += n;
+            deadline = make_timeout_time_us(SCPI_WRITE_TIMEOUT_US);
+            continue;
+        }
+        tud_cdc_write_flush();
+        if (time_reached(deadline)) break;
+    }
+    return done;
+}
+
+static void cdc_flush(void *ctx) {
+    (void)ctx;
+    tud_cdc_write_flush();
+}
+
+static const ScpiTransport cdc_transport = {
+    .read = cdc_read,
+    .write = cdc_write,
+    .flush = cdc_flush,
+    .ctx = NULL,
+};
+
+/* Общие части обработчиков */
+
+// Ответ в тот же CDC, что и поток: сначала дотолкнуть очередь кадров,
+// чтобы ответ не разрезал кадр
+static void begin_answer(void) {
+    if (usb_stream_enabled()) usb_stream_drain(SCPI_WRITE_TIMEOUT_US);
+}
+
+static bool need_float(ScpiContext *ctx, const char *args, float *value) {
+    if (!*args) {
+        scpi_push_error(ctx, SCPI_ERR_MISSING_PARAM);
+        return false;
+    }
+    if (!scpi_parse_float(args, value)) {
+        scpi_push_error(ctx, SCPI_ERR_DATA_TYPE);
+        return false;
+    }
+    return true;
+}
+
+static int need_choice(ScpiContext *ctx, const char *args, const char *const *choices, int count) {
+    if (!*args) {
+        scpi_push_error(ctx, SCPI_ERR_MISSING_PARAM);
+        return -1;
+    }
+    int i = scpi_parse_choice(args, choices, count);
+    if (i < 0) scpi_push_error(ctx, SCPI_ERR_ILLEGAL_VALUE);
+    return i;
+}
+
+static bool need_bool(ScpiContext *ctx, const char *args, bool *value) {
+    if (!*args) {
+        scpi_push_error(ctx, SCPI_ERR_MISSING_PARAM);
+        return false;
+    }
+    if (!scpi_parse_bool(args, value)) {
+        scpi_push_error(ctx, SCPI_ERR_ILLEGAL_VALUE);
+        return false;
+    }
+    return true;
+}
+
+// Ближайший по логарифму элемент таблицы значений
+static int nearest_log(float value, float (*table_value)(int), int count) {
+    int best = 0;
+    float best_dist = INFINITY;
+    float lv = logf(value);
+    for (int i = 0; i < count; i++) {
+        float d = fabsf(logf(table_value(i)) - lv);
+        if (d < best_dist) {
+            best_dist = d;
+            best = i;
+        }
+    }
+    return best;
+}
+
+// Милливольты -> исправленный код по текущей калибровке
+static uint16_t mv_to_code(int32_t mv) {
+    uint32_t gain_q16;
+    int32_t offset_mv;
+    calibration_get_gain_offset(&gain_q16, &offset_mv);
+    int64_t code = (((int64_t)(mv - offset_mv) << 16) + gain_q16 / 2) / gain_q16;
+    if (code < 0) code = 0;
+    if (code > CALIB_CODES - 1) code = CALIB_CODES - 1;
+    return (uint16_t)code;
+}
+
+static float code_to_volts(uint16_t code) {
+    return calibration_code_to_mv(code) / 1000.0f;
+}
+
+// Измерение показанной трассы: у математического канала ноль поднят
+static float trace_to_volts(uint16_t code) {
+    return (calibration_code_to_mv(code) - get_trace_zero_mv()) / 1000.0f;
+}
+
+/* Общие команды IEEE 488.2 */
+
+static void cmd_idn(ScpiContext *ctx, const char *args, bool query) {
+    if (!query) { scpi_push_error(ctx, SCPI_ERR_UNDEFINED_HEADER); return; }
+    begin_answer();
+    scpi_reply(ctx, "oscilloscope_pico,RP2040,0,0.1");
+}
+
+static void cmd_rst(ScpiContext *ctx, const char *args, bool query) {
+    settings_reset();
+    set_hold(false);
+}
+
+static void cmd_cls(ScpiContext *ctx, const char *args, bool query) {
+    while (scpi_pop_error(ctx) != SCPI_ERR_NONE) {}
+}
+
+// Команды выполняются по порядку и сразу, так что к ответу всё завершено
+static void cmd_opc(ScpiContext *ctx, const char *args, bool query) {
+    if (!query) return;
+    begin_answer();
+    scpi_reply(ctx, "1");
+}
+
+static void cmd_error(ScpiContext *ctx, const char *args, bool query) {
+    if (!query) { scpi_push_error(ctx, SCPI_ERR_UNDEFINED_HEADER); return; }
+    char text[48];
+    int16_t code = scpi_pop_error(ctx);
+    snprintf(text, sizeof(text), "%d,\"%s\"", code, scpi_error_text(code));
+    begin_answer();
+    scpi_reply(ctx, text);
+}
+
+/* Развёртка и канал */
+
+static float timebase_s(int i) {
+    static const float values[] = { 1e-6f, 1e-5f, 1e-4f, 1e-3f, 1e-2f, 1e-1f };
+    return values[i];
+}
+
+static void cmd_timebase(ScpiContext *ctx, const char *args, bool query) {
+    if (query) {
+        begin_answer();
+        scpi_reply_float(ctx, get_timebase_us() * 1e-6f);
+        return;
+    }
+    float value;
+    if (!need_float(ctx, args, &value)) return;
+    if (value <= 0.0f) { scpi_push_error(ctx, SCPI_ERR_OUT_OF_RANGE); return; }
+    set_timebase((TimebaseSetting)nearest_log(value, timebase_s, TIMEBASE_100MS + 1));
+}
+
+// Сдвиг окна длинной записи: секунды до самого нового отсчёта, <= 0
+static void cmd_timebase_position(ScpiContext *ctx, const char *args, bool query) {
+    if (query) {
+        begin_answer();
+        scpi_reply_float(ctx, -(float)get_record_position() / global_buffer.sample_rate);
+        return;
+    }
+    float value;
+    if (!need_float(ctx, args, &value)) return;
+    if (value > 0.0f) { scpi_push_error(ctx, SCPI_ERR_OUT_OF_RANGE); return; }
+    set_record_position((uint32_t)lroundf(-value * global_buffer.sample_rate));
+}
+
+static float volt_div(int i) {
+    static const float values[] = { 0.1f, 0.2f, 0.5f, 1.0f, 2.0f, 5.0f };
+    return values[i];
+}
+
+static void cmd_volt_div(ScpiContext *ctx, const char *args, bool query) {
+    if (query) {
+        begin_answer();
+        scpi_reply_float(ctx, get_volt_div_value());
+        return;
+    }
+    float value;
+    if (!need_float(ctx, args, &value)) return;
+    if (value <= 0.0f) { scpi_push_error(ctx, SCPI_ERR_OUT_OF_RANGE); return; }
+    set_volt_div((VoltDivSetting)nearest_log(value, volt_div, VOLT_DIV_5V + 1));
+}
+
+// Положение по вертикали: напряжение нижнего края осциллограммы
+static void cmd_chan_offset(ScpiContext *ctx, const char *args, bool query) {
+    if (query) {
+        begin_answer();
+        scpi_reply_float(ctx, get_voltage_offset_mv() / 1000.0f);
+        return;
+    }
+    float value;
+    if (!need_float(ctx, args, &value)) return;
+    if (value < -10.0f || value > 10.0f) { scpi_push_error(ctx, SCPI_ERR_OUT_OF_RANGE); return; }
+    set_voltage_offset_mv((int32_t)lroundf(value * 1000.0f));
+}
+
+/* Синхронизация и запуск */
+
+static void cmd_trig_level(ScpiContext *ctx, const char *args, bool query) {
+    if (query) {
+        begin_answer();
+        scpi_reply_float(ctx, code_to_volts(get_trigger_level()));
+        return;
+    }
+    float value;
+    if (!need_float(ctx, args, &value)) return;
+    if (value < -10.0f || value > 10.0f) { scpi_push_error(ctx, SCPI_ERR_OUT_OF_RANGE); return; }
+    set_trigger_level(mv_to_code((int32_t)lroundf(value * 1000.0f)));
+}
+
+// Гистерезис - ширина в кодах по текущему наклону калибровки
+static void cmd_trig_hysteresis(ScpiContext *ctx, const char *args, bool query) {
+    uint32_t gain_q16;
+    int32_t offset_mv;
+    calibration_get_gain_offset(&gain_q16, &offset_mv);
+    if (query) {
+        begin_answer();
+        scpi_reply_float(ctx, ((uint64_t)get_trigger_hysteresis() * gain_q16 >> 16) / 1000.0f);
+        return;
+    }
+    float value;
+    if (!need_float(ctx, args, &value)) return;
+    if (value < 0.0f || value > 3.3f) { scpi_push_error(ctx, SCPI_ERR_OUT_OF_RANGE); return; }
+    set_trigger_hysteresis((uint16_t)((((uint64_t)lroundf(value * 1000.0f) << 16) + gain_q16 / 2) / gain_q16));
+}
+
+static const char *const slopes[] = { "POSitive", "NEGative", "EITHer" };
+
+static void cmd_trig_slope(ScpiContext *ctx, const char *args, bool query) {
+    if (query) {
+        begin_answer();
+        scpi_reply(ctx, (const char *[]){ "POS", "NEG", "EITH" }[get_trigger_edge()]);
+        return;
+    }
+    int i = need_choice(ctx, args, slopes, 3);
+    if (i >= 0) set_trigger_edge((TriggerEdge)i);
+}
+
+static const char *const trigger_modes[] = { "AUTO", "NORMal", "SINGle" };
+
+static void cmd_trig_mode(ScpiContext *ctx, const char *args, bool query) {
+    if (query) {
+        begin_answer();
+        scpi_reply(ctx, (const char *[]){ "AUTO", "NORM", "SING" }[get_trigger_mode()]);
+        return;
+    }
+    int i = need_choice(ctx, args, trigger_modes, 3);
+    if (i >= 0) set_trigger_mode((TriggerMode)i);
+}
+
+static void cmd_run(ScpiContext *ctx, const char *args, bool query) {
+    set_hold(false);
+    if (get_trigger_mode() == TRIGGER_SINGLE) settings_arm_single();
+}
+
+static void cmd_stop(ScpiContext *ctx, const char *args, bool query) {
+    set_hold(true);
+}
+
+// Однократный запуск: кадр появится после ближайшего фронта, затем удержание
+static void cmd_single(ScpiContext *ctx, const char *args, bool query) {
+    set_hold(false);
+    if (get_trigger_mode() != TRIGGER_SINGLE) set_trigger_mode(TRIGGER_SINGLE);
+    else settings_arm_single();
+}
+
+// Автоустановка: настройки поменяются через несколько блоков захвата
+static void cmd_autoscale(ScpiContext *ctx, const char *args, bool query) {
+    if (query) {
+        begin_answer();
+        scpi_reply(ctx, (const char *[]){ "IDLE", "RUN", "LOCK", "NPER" }[get_autoset(NULL, NULL)]);
+        return;
+    }
+    start_autoset();
+}
+
+/* Измерения (по последнему обработанному кадру) */
+
+static void cmd_meas_vmax(ScpiContext *ctx, const char *args, bool query) {
+    if (!query) { scpi_push_error(ctx, SCPI_ERR_UNDEFINED_HEADER); return; }
+    begin_answer();
+    scpi_reply_float(ctx, trace_to_volts(global_buffer.max_value));
+}
+
+static void cmd_meas_vmin(ScpiContext *ctx, const char *args, bool query) {
+    if (!query) { scpi_push_error(ctx, SCPI_ERR_UNDEFINED_HEADER); return; }
+    begin_answer();
+    scpi_reply_float(ctx, trace_to_volts(global_buffer.min_value));
+}
+
+static void cmd_meas_vpp(ScpiContext *ctx, const char *args, bool query) {
+    if (!query) { scpi_push_error(ctx, SCPI_ERR_UNDEFINED_HEADER); return; }
+    begin_answer();
+    scpi_reply_float(ctx, code_to_volts(global_buffer.max_value) - code_to_volts(global_buffer.min_value));
+}
+
+static void cmd_meas_freq(ScpiContext *ctx, const char *args, bool query) {
+    if (!query) { scpi_push_error(ctx, SCPI_ERR_UNDEFINED_HEADER); return; }
+    begin_answer();
+    scpi_reply_int(ctx, global_buffer.frequency);
+}
+
+static void cmd_meas_duty(ScpiContext *ctx, const char *args, bool query) {
+    if (!query) { scpi_push_error(ctx, SCPI_ERR_UNDEFINED_HEADER); return; }
+    begin_answer();
+    scpi_reply_float(ctx, global_buffer.duty_cycle);
+}
+
+// Все измерения одним ответом: Vmax,Vmin,Vpp,Freq,Duty
+static void cmd_meas_all(ScpiContext *ctx, const char *args, bool query) {
+    cmd_meas_vmax(ctx, args, query);
+    cmd_meas_vmin(ctx, args, query);
+    cmd_meas_vpp(ctx, args, query);
+    cmd_meas_freq(ctx, args, query);
+    cmd_meas_duty(ctx, args, query);
+}
+
+/* Осциллограмма */
+
+// Отсчёты показанного кадра прямо из слота захвата (uint16, младший байт
+// первым). Слот закреплён за дисплеем, а buffer_process выполняется на этом
+// же ядре, поэтому на время передачи кадр не может смениться
+static void cmd_wave_data(ScpiContext *ctx, const char *args, bool query) {
+    if (!query) { scpi_push_error(ctx, SCPI_ERR_UNDEFINED_HEADER); return; }
+    uint16_t count;
+    const uint16_t *samples = buffer_get_current(&count);
+    begin_answer();
+    scpi_reply_block(ctx, samples, samples ? count * sizeof(uint16_t) : 0);
+}
+
+// Число точек, шаг по времени (с), время первой точки относительно
+// триггера (с), вольт на код, смещение (В), номер кадра
+static void cmd_wave_preamble(ScpiContext *ctx, const char *args, bool query) {
+    if (!query) { scpi_push_error(ctx, SCPI_ERR_UNDEFINED_HEADER); return; }
+    uint16_t count;
+    buffer_get_current(&count);
+    uint32_t gain_q16;
+    int32_t offset_mv;
+    calibration_get_gain_offset(&gain_q16, &offset_mv);
+
+    float dt = 1.0f / global_buffer.sample_rate;
+    int pre = global_buffer.display_start > 0 ? TRIGGER_PRETRIGGER : 0;
+    char text[96];
+    snprintf(text, sizeof(text), "%u,%.6G,%.6G,%.6G,%.6G,%lu",
+             count, (double)dt, (double)(-pre * dt),
+             (double)(gain_q16 / 65536.0f / 1000.0f), (double)(offset_mv / 1000.0f),
+             (unsigned long)global_buffer.display_sequence);
+    begin_answer();
+    scpi_reply(ctx, text);
+}
+
+/* Экран и поток */
+
+static void cmd_disp_persistence(ScpiContext *ctx, const char *args, bool query) {
+    if (query) {
+        begin_answer();
+        scpi_reply_int(ctx, settings_get()->persistence);
+        return;
+    }
+    bool enable;
+    if (need_bool(ctx, args, &enable)) set_persistence(enable);
+}
+
+static void cmd_disp_measurements(ScpiContext *ctx, const char *args, bool query) {
+    if (query) {
+        begin_answer();
+        scpi_reply_int(ctx, settings_get()->measurements_enabled);
+        return;
+    }
+    bool enable;
+    if (need_bool(ctx, args, &enable)) set_measurements_enabled(enable);
+}
+
+static void cmd_disp_record(ScpiContext *ctx, const char *args, bool query) {
+    if (query) {
+        begin_answer();
+        scpi_reply_int(ctx, get_record_view());
+        return;
+    }
+    bool enable;
+    if (need_bool(ctx, args, &enable)) set_record_view(enable);
+}
+
+static void cmd_disp_xy(ScpiContext *ctx, const char *args, bool query) {
+    if (query) {
+        begin_answer();
+        scpi_reply_int(ctx, settings_get()->xy_mode);
+        return;
+    }
+    bool enable;
+    if (need_bool(ctx, args, &enable)) set_xy_mode(enable);
+}
+
+// Снимок экрана (screenshot/screen_rle.h) блоком "#<n><len>": здесь
+// только заголовок, данные строка за строкой уходят из scpi_remote_poll
+static void cmd_disp_screenshot(ScpiContext *ctx, const char *args, bool query) {
+    if (!query) { scpi_push_error(ctx, SCPI_ERR_UNDEFINED_HEADER); return; }
+    begin_answer();
+    uint32_t size = display_screenshot_begin();
+    if (!size) {
+        scpi_push_error(ctx, SCPI_ERR_EXECUTION);
+        return;
+    }
+    scpi_reply_block_header(ctx, size);
+}
+
+static void cmd_stream(ScpiContext *ctx, const char *args, bool query) {
+    if (query) {
+        begin_answer();
+        scpi_reply_int(ctx, usb_stream_enabled());
+        return;
+    }
+    bool enable;
+    if (!need_bool(ctx, args, &enable)) return;
+    set_stream(enable, usb_stream_get_encoding());
+}
+
+static const char *const encodings[] = { "RAW", "PACK12", "DELTa" };
+
+static void cmd_stream_encoding(ScpiContext *ctx, const char *args, bool query) {
+    if (query) {
+        begin_answer();
+        scpi_reply(ctx, (const char *[]){ "RAW", "PACK12", "DELT" }[usb_stream_get_encoding()]);
+        return;
+    }
+    int i = need_choice(ctx, args, encodings, STREAM_ENC_COUNT);
+    if (i >= 0) set_stream(usb_stream_enabled(), (StreamEncoding)i);
+}
+
+/* Эталоны: слоты нумеруются с 1, как на экране */
+
+// Номер слота из параметра: 1..REFERENCE_SLOTS, 0 - если разрешён allow_off
+static bool need_slot(ScpiContext *ctx, const char *args, bool allow_off, int32_t *slot) {
+    if (!*args) {
+        scpi_push_error(ctx, SCPI_ERR_MISSING_PARAM);
+        return false;
+    }
+    if (!scpi_parse_int(args, slot)) {
+        scpi_push_error(ctx, SCPI_ERR_DATA_TYPE);
+        return false;
+    }
+    if (*slot < (allow_off ? 0 : 1) || *slot > reference_slot_count()) {
+        scpi_push_error(ctx, SCPI_ERR_OUT_OF_RANGE);
+        return false;
+    }
+    return true;
+}
+
+static void cmd_ref_save(ScpiContext *ctx, const char *args, bool query) {
+    if (query) { scpi_push_error(ctx, SCPI_ERR_UNDEFINED_HEADER); return; }
+    int32_t slot;
+    if (!need_slot(ctx, args, false, &slot)) return;
+    if (!save_reference(slot - 1)) scpi_push_error(ctx, SCPI_ERR_EXECUTION);
+}
+
+static void cmd_ref_clear(ScpiContext *ctx, const char *args, bool query) {
+    if (query) { scpi_push_error(ctx, SCPI_ERR_UNDEFINED_HEADER); return; }
+    int32_t slot;
+    if (!need_slot(ctx, args, false, &slot)) return;
+    if (!reference_clear(slot - 1)) scpi_push_error(ctx, SCPI_ERR_EXECUTION);
+    if (get_reference() == slot - 1) set_reference(slot - 1);
+}
+
+static void cmd_ref_display(ScpiContext *ctx, const char *args, bool query) {
+    if (query) {
+        begin_answer();
+        scpi_reply_int(ctx, get_reference() + 1);
+        return;
+    }
+    int32_t slot;
+    if (need_slot(ctx, args, true, &slot)) set_reference(slot - 1);
+}
+
+static void cmd_ref_tolerance(ScpiContext *ctx, const char *args, bool query) {
+    if (query) {
+        begin_answer();
+        scpi_reply_float(ctx, get_reference_tolerance() / 1000.0f);
+        return;
+    }
+    float value;
+    if (!need_float(ctx, args, &value)) return;
+    if (value < 0.0f || value > 10.0f) { scpi_push_error(ctx, SCPI_ERR_OUT_OF_RANGE); return; }
+    set_reference_tolerance((uint16_t)lroundf(value * 1000.0f));
+}
+
+// Итог сравнения последнего кадра: "PASS|FAIL,<max В>,<среднее В>,<столбцов
+// вне допуска>", "NONE" - эталон не показан или пуст
+static void cmd_ref_result(ScpiContext *ctx, const char *args, bool query) {
+    if (!query) { scpi_push_error(ctx, SCPI_ERR_UNDEFINED_HEADER); return; }
+    bool pass;
+    uint16_t max_mv, mean_mv, over;
+    char text[48];
+    if (get_reference_result(&pass, &max_mv, &mean_mv, &over)) {
+        snprintf(text, sizeof(text), "%s,%.3f,%.3f,%u", pass ? "PASS" : "FAIL",
+                 max_mv / 1000.0f, mean_mv / 1000.0f, over);
+    } else {
+        snprintf(text, sizeof(text), "NONE");
+    }
+    begin_answer();
+    scpi_reply(ctx, text);
+}
+
+// Занятость слотов: "1,0,1,0"
+static void cmd_ref_catalog(ScpiContext *ctx, const char *args, bool query) {
+    if (!query) { scpi_push_error(ctx, SCPI_ERR_UNDEFINED_HEADER); return; }
+    char text[2 * REFERENCE_SLOTS + 1];
+    int len = 0;
+    for (uint8_t i = 0; i < reference_slot_count(); i++) {
+        len += snprintf(text + len, sizeof(text) - len, "%s%d", i ? "," : "", reference_valid(i));
+    }
+    text[len] = '\0';
+    begin_answer();
+    scpi_reply(ctx, text);
+}
+
+/* Испытание по маске: без параметра - из кадра на экране, с номером
+   слота - из эталона */
+
+static void cmd_mask_create(ScpiContext *ctx, const char *args, bool query) {
+    if (query) { scpi_push_error(ctx, SCPI_ERR_UNDEFINED_HEADER); return; }
+    int32_t slot = 0;
+    if (*args && !need_slot(ctx, args, false, &slot)) return;
+    if (!create_mask((int8_t)(slot - 1))) scpi_push_error(ctx, SCPI_ERR_EXECUTION);
+}
+
+static void cmd_mask_tolerance(ScpiContext *ctx, const char *args, bool query) {
+    if (query) {
+        begin_answer();
+        scpi_reply_float(ctx, get_mask_tolerance() / 1000.0f);
+        return;
+    }
+    float value;
+    if (!need_float(ctx, args, &value)) return;
+    if (value < 0.0f || value > 10.0f) { scpi_push_error(ctx, SCPI_ERR_OUT_OF_RANGE); return; }
+    set_mask_tolerance((uint16_t)lroundf(value * 1000.0f));
+}
+
+static void cmd_mask_state(ScpiContext *ctx, const char *args, bool query) {
+    if (query) {
+        begin_answer();
+        scpi_reply_int(ctx, mask_enabled());
+        return;
+    }
+    bool enable;
+    if (need_bool(ctx, args, &enable) && !set_mask(enable)) scpi_push_error(ctx, SCPI_ERR_EXECUTION);
+}
+
+static void cmd_mask_stop(ScpiContext *ctx, const char *args, bool query) {
+    if (query) {
+        begin_answer();
+        scpi_reply_int(ctx, mask_get_stop_on_fail());
+        return;
+    }
+    bool enable;
+    if (need_bool(ctx, args, &enable)) mask_set_stop_on_fail(enable);
+}
+
+static void cmd_mask_reset(ScpiContext *ctx, const char *args, bool query) {
+    if (query) { scpi_push_error(ctx, SCPI_ERR_UNDEFINED_HEADER); return; }
+    reset_mask();
+}
+
+// Счётчики: "<испытаний>,<годных>,<негодных>"
+static void cmd_mask_count(ScpiContext *ctx, const char *args, bool query) {
+    if (!query) { scpi_push_error(ctx, SCPI_ERR_UNDEFINED_HEADER); return; }
+    MaskCounters c;
+    mask_get_counters(&c);
+    char text[40];
+    snprintf(text, sizeof(text), "%lu,%lu,%lu",
+             (unsigned long)c.total, (unsigned long)c.passed, (unsigned long)c.failed);
+    begin_answer();
+    scpi_reply(ctx, text);
+}
+
+// Последнее нарушение: "<номер испытания>,<столбец маски>,<В>", "NONE" -
+// нарушений не было
+static void cmd_mask_failure(ScpiContext *ctx, const char *args, bool query) {
+    if (!query) { scpi_push_error(ctx, SCPI_ERR_UNDEFINED_HEADER); return; }
+    MaskFailure f;
+    char text[40];
+    if (mask_get_failure(&f)) {
+        snprintf(text, sizeof(text), "%lu,%u,%.3f", (unsigned long)f.test, f.column,
+                 code_to_volts(f.value));
+    } else {
+        snprintf(text, sizeof(text), "NONE");
+    }
+    begin_answer();
+    scpi_reply(ctx, text);
+}
+
+static void cmd_mask_rate(ScpiContext *ctx, const char *args, bool query) {
+    if (!query) { scpi_push_error(ctx, SCPI_ERR_UNDEFINED_HEADER); return; }
+    begin_answer();
+    scpi_reply_int(ctx, (int32_t)mask_tests_per_second(time_us_32()));
+}
+
+/* Математический канал: B - показанный эталон (REFerence:DISPlay) */
+
+static const char *const math_ops[] = {
+    "OFF", "ADD", "SUBtract", "MULTiply", "DIFFerentiate", "INTegrate"
+};
+
+static void cmd_math_function(ScpiContext *ctx, const char *args, bool query) {
+    if (query) {
+        begin_answer();
+        scpi_reply(ctx, (const char *[]){ "OFF", "ADD", "SUB", "MULT", "DIFF", "INT" }[get_math()]);
+        return;
+    }
+    int i = need_choice(ctx, args, math_ops, MATH_OP_COUNT);
+    if (i >= 0) set_math((uint8_t)i);
+}
+
+static void cmd_math_scale(ScpiContext *ctx, const char *args, bool query) {
+    if (query) {
+        begin_answer();
+        scpi_reply_float(ctx, get_math_scale() / (float)MATH_SCALE_ONE_Q16);
+        return;
+    }
+    float value;
+    if (!need_float(ctx, args, &value)) return;
+    int32_t scale_q16 = (int32_t)lroundf(value * MATH_SCALE_ONE_Q16);
+    if (scale_q16 < MATH_SCALE_MIN_Q16 || scale_q16 > MATH_SCALE_MAX_Q16) {
+        scpi_push_error(ctx, SCPI_ERR_OUT_OF_RANGE);
+        return;
+    }
+    set_math_scale(scale_q16);
+}
+
+/* Калибровка */
+
+// Усиление по последнему кадру: на входе известное напряжение, ноль уже
+// откалиброван. Запрос - наклон, В на код
+static void cmd_cal_gain(ScpiContext *ctx, const char *args, bool query) {
+    if (query) {
+        uint32_t gain_q16;
+        int32_t offset_mv;
+        calibration_get_gain_offset(&gain_q16, &offset_mv);
+        begin_answer();
+        scpi_reply_float(ctx, gain_q16 / 65536.0f / 1000.0f);
+        return;
+    }
+    float value;
+    if (!need_float(ctx, args, &value)) return;
+    if (value <= 0.0f || value > CALIB_FULL_SCALE_MV / 1000.0f) {
+        scpi_push_error(ctx, SCPI_ERR_OUT_OF_RANGE);
+        return;
+    }
+    if (!calibrate_gain((int32_t)lroundf(value * 1000.0f))) scpi_push_error(ctx, SCPI_ERR_EXECUTION);
+}
+
+/* Запись на ПК */
+
+// Заголовок файла захвата (capture/capture.h) с текущими условиями: программа
+// записи на ПК запрашивает его перед включением потока
+static void cmd_capture_header(ScpiContext *ctx, const char *args, bool query) {
+    if (!query) { scpi_push_error(ctx, SCPI_ERR_UNDEFINED_HEADER); return; }
+    uint32_t gain_q16;
+    int32_t offset_mv;
+    calibration_get_gain_offset(&gain_q16, &offset_mv);
+
+    CaptureHeader header = {
+        .version = CAPTURE_VERSION,
+        .sample_rate = global_buffer.sample_rate,
+        .bits = WAVE_CODEC_SAMPLE_BITS,
+        .channels = 1,
+        .block_samples = BUFFER_SIZE,
+        .trigger_level = get_trigger_level(),
+        .trigger_mode = get_trigger_mode(),
+        .trigger_edge = get_trigger_edge(),
+        .trigger_position = TRIGGER_PRETRIGGER,
+        .gain_q16 = gain_q16,
+        .offset_mv = offset_mv,
+        .start_time_us = 0,
+        .device_time_us = time_us_32(),
+    };
+    uint8_t buf[CAPTURE_HEADER_BYTES];
+    capture_header_encode(&header, buf);
+    begin_answer();
+    scpi_reply_block(ctx, buf, sizeof(buf));
+}
+
+static const ScpiCommand commands[] = {
+    { "*IDN",                 cmd_idn },
+    { "*RST",                 cmd_rst },
+    { "*CLS",                 cmd_cls },
+    { "*OPC",                 cmd_opc },
+    { "SYSTem:ERRor",         cmd_error },
+    { "TIMebase:SCALe",       cmd_timebase },
+    { "TIMebase:POSition",    cmd_timebase_position },
+    { "CHANnel:SCALe",        cmd_volt_div },
+    { "CHANnel:OFFSet",       cmd_chan_offset },
+    { "TRIGger:LEVel",        cmd_trig_level },
+    { "TRIGger:HYSTeresis",   cmd_trig_hysteresis },
+    { "TRIGger:SLOPe",        cmd_trig_slope },
+    { "TRIGger:MODE",         cmd_trig_mode },
+    { "RUN",                  cmd_run },
+    { "STOP",                 cmd_stop },
+    { "SINGle",               cmd_single },
+    { "AUToscale",            cmd_autoscale },
+    { "MEASure:VMAX",         cmd_meas_vmax },
+    { "MEASure:VMIN",         cmd_meas_vmin },
+    { "MEASure:VPP",          cmd_meas_vpp },
+    { "MEASure:FREQuency",    cmd_meas_freq },
+    { "MEASure:DUTY",         cmd_meas_duty },
+    { "MEASure:ALL",          cmd_meas_all },
+    { "WAVeform:DATA",        cmd_wave_data },
+    { "WAVeform:PREamble",    cmd_wave_preamble },
+    { "DISPlay:PERSistence",  cmd_disp_persistence },
+    { "DISPlay:MEASurements", cmd_disp_measurements },
+    { "DISPlay:RECord",       cmd_disp_record },
+    { "DISPlay:XY",           cmd_disp_xy },
+    { "DISPlay:SCReenshot",   cmd_disp_screenshot },
+    { "STReam",               cmd_stream },
+    { "STReam:ENCoding",      cmd_stream_encoding },
+    { "CAPture:HEADer",       cmd_capture_header },
+    { "REFerence:SAVE",       cmd_ref_save },
+    { "REFerence:CLEar",      cmd_ref_clear },
+    { "REFerence:DISPlay",    cmd_ref_display },
+    { "REFerence:TOLerance",  cmd_ref_tolerance },
+    { "REFerence:RESult",     cmd_ref_result },
+    { "REFerence:CATalog",    cmd_ref_catalog },
+    { "MASK:CREate",          cmd_mask_create },
+    { "MASK:TOLerance",       cmd_mask_tolerance },
+    { "MASK:STATe",           cmd_mask_state },
+    { "MASK:STOP",            cmd_mask_stop },
+    { "MASK:RESet",           cmd_mask_reset },
+    { "MASK:COUNt",           cmd_mask_count },
+    { "MASK:FAILure",         cmd_mask_failure },
+    { "MASK:RATE",            cmd_mask_rate },
+    { "MATH:FUNCtion",        cmd_math_function },
+    { "MATH:SCALe",           cmd_math_scale },
+    { "CALibration:GAIN",     cmd_cal_gain },
+};
+
+void scpi_remote_init(void) {
+    scpi_init(&scpi, &cdc_transport, commands, sizeof(commands) / sizeof(commands[0]));
+    last_commands_run = 0;
+}
+
+bool scpi_remote_poll(void) {
+    // Пока идёт снимок, новые команды ждут в буфере CDC: их ответы
+    // разрезали бы блок
+    if (screenshot_active()) {
+        if (screenshot_service()) scpi_end_deferred(&scpi);
+        return false;
+    }
+    scpi_poll(&scpi);
+    bool ran = scpi.commands_run != last_commands_run;
+    last_commands_run = scpi.commands_run;
+    return ran;
+}
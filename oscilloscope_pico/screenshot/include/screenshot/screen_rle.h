@@ -0,0 +1,59 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Формат снимка экрана (все поля little-endian):
+//
+//   0  magic      "SCR1"
+//   4  width      точек в строке
+//   6  height     строк
+//   8  colors     записей палитры
+//   9  reserved   0
+//  10  palette    colors * RGB565
+//   .  строки     height строк подряд, каждая ровно на width точек
+//
+// Точка - индекс палитры (color8_t). Строка - серии одного цвета, серия
+// не переходит на следующую строку. Байт серии: младшие 5 бит - цвет,
+// старшие 3 бита n:
+//   n = 0..6  серия n + 1 точек (1..7)
+//   n = 7     следующий байт e, серия 8 + e точек (8..263)
+// Худший случай - байт на точку, пустая строка 320 точек - 4 байта.
+//
+// Модуль не зависит от SDK: тот же код собирается в прошивку и в
+// хостовый декодер (tools/screen_dump).
+
+#define SCREEN_MAGIC          "SCR1"
+#define SCREEN_HEADER_BYTES   10
+#define SCREEN_MAX_COLORS     32
+#define SCREEN_MAX_WIDTH      320
+#define SCREEN_MAX_HEIGHT     240
+
+#define SCREEN_RUN_SHORT      7     // Длиннее - с байтом продолжения
+#define SCREEN_RUN_MAX        (SCREEN_RUN_SHORT + 1 + 255)
+
+// Байт на строку в худшем случае
+#define SCREEN_ROW_MAX_BYTES(width) (width)
+
+// Заголовок с палитрой
+#define SCREEN_PREFIX_BYTES(colors) (SCREEN_HEADER_BYTES + 2u * (colors))
+
+typedef struct {
+    uint16_t width;
+    uint16_t height;
+    uint8_t colors;
+    uint16_t palette[SCREEN_MAX_COLORS];
+} ScreenHeader;
+
+// Заголовок с палитрой в out. Возвращает размер
+size_t screen_header_encode(uint8_t *out, const ScreenHeader *header);
+
+// Разбор заголовка. Возвращает его размер или 0 (не снимок, не хватает байт)
+size_t screen_header_decode(const uint8_t *data, size_t len, ScreenHeader *header);
+
+// Сжатие строки индексов (каждый < SCREEN_MAX_COLORS). Возвращает размер
+size_t screen_rle_encode_row(const uint8_t *row, uint16_t width, uint8_t *out);
+
+// Распаковка строки ровно на width точек. Возвращает прочитанные байты или
+// 0, если данные кончились или серия вышла за строку
+size_t screen_rle_decode_row(const uint8_t *data, size_t len, uint8_t *row, uint16_t width);
@@ -0,0 +1,63 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "pico_ili9341/pico_ili9341.h"
+#include "pico_ili9341/overlay.h"
+#include "pico_ili9341/text.h"
+#include "screenshot/screen_rle.h"
+
+// Снимок экрана для отчётов: картинка собирается заново из того, что
+// выведено на панель - 8-битной поверхности трассы со статическим слоем и
+// текстовых строк (по их теневым копиям), - в индексах палитры.
+//
+// Снимок целиком в RAM не хранится: строки собираются и сжимаются
+// (screen_rle.h) по одной, по мере того как транспорт принимает байты.
+// Размер для заголовка ответа считается заранее отдельным проходом,
+// порядка конвертации кадра 8->16 (osc_bench), много меньше его
+// передачи по SPI. Пока снимок передаётся, источник не должен меняться -
+// ядро дисплея не рисует кадры, захват при этом не останавливается.
+
+// Без приёма данных столько времени снимок прерывается: ПК перестал читать
+#define SCREENSHOT_STALL_US 500000
+
+// Что выведено на панель. Поверхность трассы - в левом верхнем углу,
+// ширина строки width, ниже неё - фон
+typedef struct {
+    uint16_t width;
+    uint16_t height;
+    const color8_t *wave;
+    uint16_t wave_height;
+    const Overlay *overlay;        // Может быть NULL
+    const TextLine *const *lines;  // Поверх, в порядке вывода
+    uint8_t line_count;
+    color8_t background;
+} ScreenSource;
+
+// Транспорт: по умолчанию USB CDC, на хосте можно подставить файл
+typedef struct {
+    size_t (*available)(void *ctx);                            // Свободно байт
+    size_t (*write)(void *ctx, const uint8_t *data, size_t len);
+    void (*flush)(void *ctx);
+    void *ctx;
+} ScreenSink;
+
+// sink = NULL - USB CDC
+void screenshot_init(const ScreenSink *sink);
+
+// Строка y снимка в индексах палитры (width точек)
+void screenshot_compose_row(const ScreenSource *src, uint16_t y, color8_t *row);
+
+// Размер снимка в байтах (с заголовком), без передачи
+uint32_t screenshot_measure(const ScreenSource *src);
+
+// Начало передачи. src должен жить до конца передачи. Возвращает размер
+// снимка или 0, если передача уже идёт
+uint32_t screenshot_begin(const ScreenSource *src);
+
+bool screenshot_active(void);
+
+// Передача следующих байт, сколько примет транспорт (на каждом пробуждении
+// ядра дисплея). Возвращает true, когда снимок закончен в этом вызове:
+// отправлен целиком или прерван
+bool screenshot_service(void);
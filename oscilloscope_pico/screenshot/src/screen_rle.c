@@ -0,0 +1,73 @@
+#include "screenshot/screen_rle.h"
+#include <string.h>
+
+static void put16(uint8_t *p, uint16_t v) {
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static uint16_t get16(const uint8_t *p) {
+    return p[0] | (p[1] << 8);
+}
+
+size_t screen_header_encode(uint8_t *out, const ScreenHeader *h) {
+    memcpy(out, SCREEN_MAGIC, 4);
+    put16(&out[4], h->width);
+    put16(&out[6], h->height);
+    out[8] = h->colors;
+    out[9] = 0;
+    for (uint8_t i = 0; i < h->colors; i++) put16(&out[SCREEN_HEADER_BYTES + 2 * i], h->palette[i]);
+    return SCREEN_PREFIX_BYTES(h->colors);
+}
+
+size_t screen_header_decode(const uint8_t *data, size_t len, ScreenHeader *h) {
+    if (len < SCREEN_HEADER_BYTES || memcmp(data, SCREEN_MAGIC, 4)) return 0;
+    h->width = get16(&data[4]);
+    h->height = get16(&data[6]);
+    h->colors = data[8];
+    if (!h->width || h->width > SCREEN_MAX_WIDTH || !h->height || h->height > SCREEN_MAX_HEIGHT ||
+        !h->colors || h->colors > SCREEN_MAX_COLORS) {
+        return 0;
+    }
+    if (len < SCREEN_PREFIX_BYTES(h->colors)) return 0;
+    for (uint8_t i = 0; i < h->colors; i++) h->palette[i] = get16(&data[SCREEN_HEADER_BYTES + 2 * i]);
+    return SCREEN_PREFIX_BYTES(h->colors);
+}
+
+size_t screen_rle_encode_row(const uint8_t *row, uint16_t width, uint8_t *out) {
+    uint8_t *p = out;
+    uint16_t x = 0;
+    while (x < width) {
+        uint8_t color = row[x];
+        uint16_t run = 1;
+        while (x + run < width && row[x + run] == color && run < SCREEN_RUN_MAX) run++;
+        x += run;
+
+        if (run <= SCREEN_RUN_SHORT) {
+            *p++ = (uint8_t)((run - 1) << 5 | color);
+        } else {
+            *p++ = (uint8_t)(SCREEN_RUN_SHORT << 5 | color);
+            *p++ = (uint8_t)(run - SCREEN_RUN_SHORT - 1);
+        }
+    }
+    return p - out;
+}
+
+size_t screen_rle_decode_row(const uint8_t *data, size_t len, uint8_t *row, uint16_t width) {
+    size_t pos = 0;
+    uint16_t x = 0;
+    while (x < width) {
+        if (pos >= len) return 0;
+        uint8_t b = data[pos++];
+        uint8_t color = b & 0x1F;
+        uint16_t run = (b >> 5) + 1;
+        if (run > SCREEN_RUN_SHORT) {
+            if (pos >= len) return 0;
+            run = SCREEN_RUN_SHORT + 1 + data[pos++];
+        }
+        if (run > width - x) return 0;
+        memset(&row[x], color, run);
+        x += run;
+    }
+    return pos;
+}
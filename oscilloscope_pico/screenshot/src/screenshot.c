@@ -0,0 +1,151 @@
+#include "screenshot/screenshot.h"
+#include "tusb.h"
+#include "pico/time.h"
+#include <string.h>
+
+static size_t cdc_available(void *ctx) {
+    (void)ctx;
+    return tud_cdc_connected() ? tud_cdc_write_available() : 0;
+}
+
+static size_t cdc_write(void *ctx, const uint8_t *data, size_t len) {
+    (void)ctx;
+    return tud_cdc_write(data, len);
+}
+
+static void cdc_flush(void *ctx) {
+    (void)ctx;
+    tud_cdc_write_flush();
+}
+
+static const ScreenSink cdc_sink = {
+    .available = cdc_available,
+    .write = cdc_write,
+    .flush = cdc_flush,
+    .ctx = NULL,
+};
+
+static const ScreenSink *sink = &cdc_sink;
+
+// Передача: source == NULL - снимка нет. pending - заголовок или сжатая
+// строка next_row - 1, отправленная до sent
+static const ScreenSource *source = NULL;
+static uint16_t next_row;
+static uint8_t pending[SCREEN_ROW_MAX_BYTES(SCREEN_MAX_WIDTH) > SCREEN_PREFIX_BYTES(SCREEN_MAX_COLORS) ?
+                      SCREEN_ROW_MAX_BYTES(SCREEN_MAX_WIDTH) : SCREEN_PREFIX_BYTES(SCREEN_MAX_COLORS)];
+static uint16_t pending_len;
+static uint16_t sent;
+static uint32_t last_progress_us;
+
+static color8_t row[SCREEN_MAX_WIDTH];
+
+void screenshot_init(const ScreenSink *s) {
+    sink = s ? s : &cdc_sink;
+    source = NULL;
+}
+
+// Цвета текста хранятся в RGB565: обратно в палитру
+static color8_t palette_index(uint16_t rgb, color8_t fallback) {
+    for (int i = 0; i < COLOR8_COUNT; i++) {
+        if (color_palette[i] == rgb) return (color8_t)i;
+    }
+    return fallback;
+}
+
+void screenshot_compose_row(const ScreenSource *src, uint16_t y, color8_t *dst) {
+    if (y < src->wave_height) {
+        const color8_t *wave = &src->wave[y * src->width];
+        memcpy(dst, wave, src->width);
+        if (src->overlay) Overlay_ComposeRow8(src->overlay, y, wave, dst, 0, src->width);
+    } else {
+        memset(dst, src->background, src->width);
+    }
+
+    for (uint8_t i = 0; i < src->line_count; i++) {
+        const TextLine *line = src->lines[i];
+        if (y < line->y || y >= line->y + Text_CellHeight((FontId)line->font)) continue;
+        TextLine_ComposeRow8(line, y, dst, src->width,
+                             palette_index(line->fg, COLOR8_WHITE),
+                             palette_index(line->bg, src->background));
+    }
+}
+
+// Палитра - цвета, которые показывает панель. Строки RGB565 уходят по SPI
+// побайтно из памяти, младшим байтом вперёд, а панель принимает старший
+// первым: на экране значение из color_palette с переставленными байтами
+static uint16_t header_encode(const ScreenSource *src, uint8_t *out) {
+    ScreenHeader h = {
+        .width = src->width,
+        .height = src->height,
+        .colors = COLOR8_COUNT,
+    };
+    for (int i = 0; i < COLOR8_COUNT; i++) {
+        h.palette[i] = (uint16_t)(color_palette[i] << 8 | color_palette[i] >> 8);
+    }
+    return (uint16_t)screen_header_encode(out, &h);
+}
+
+uint32_t screenshot_measure(const ScreenSource *src) {
+    uint8_t encoded[SCREEN_ROW_MAX_BYTES(SCREEN_MAX_WIDTH)];
+    uint32_t total = SCREEN_PREFIX_BYTES(COLOR8_COUNT);
+    for (uint16_t y = 0; y < src->height; y++) {
+        screenshot_compose_row(src, y, row);
+        total += screen_rle_encode_row(row, src->width, encoded);
+    }
+    return total;
+}
+
+uint32_t screenshot_begin(const ScreenSource *src) {
+    if (source || src->width > SCREEN_MAX_WIDTH || src->height > SCREEN_MAX_HEIGHT) return 0;
+    uint32_t size = screenshot_measure(src);
+
+    source = src;
+    next_row = 0;
+    pending_len = header_encode(src, pending);
+    sent = 0;
+    last_progress_us = time_us_32();
+    return size;
+}
+
+bool screenshot_active(void) {
+    return source != NULL;
+}
+
+bool screenshot_service(void) {
+    if (!source) return false;
+
+    bool wrote = false;
+    for (;;) {
+        if (sent == pending_len) {
+            if (next_row == source->height) {
+                source = NULL;
+                break;
+            }
+            screenshot_compose_row(source, next_row++, row);
+            pending_len = (uint16_t)screen_rle_encode_row(row, source->width, pending);
+            sent = 0;
+        }
+
+        size_t room = sink->available(sink->ctx);
+        if (room == 0) break;
+        size_t chunk = pending_len - sent;
+        if (chunk > room) chunk = room;
+
+        size_t n = sink->write(sink->ctx, &pending[sent], chunk);
+        if (n == 0) break;
+        sent += n;
+        wrote = true;
+    }
+    if (wrote) {
+        sink->flush(sink->ctx);
+        last_progress_us = time_us_32();
+    }
+    if (!source) return true;
+
+    // ПК не читает: остаток снимка не ждём, блок на ПК останется неполным
+    if (time_us_32() - last_progress_us > SCREENSHOT_STALL_US) {
+        source = NULL;
+        return true;
+    }
+    return false;
+}
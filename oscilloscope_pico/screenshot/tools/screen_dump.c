@@ -0,0 +1,316 @@
+// Снимок экрана осциллографа на ПК.
+//
+//   screen_dump -o shot.png /dev/ttyACM0  - запрос DISP:SCR? и снимок в PNG
+//   screen_dump -o shot.ppm reply.bin     - разбор уже принятого ответа
+//                                          (из файла или stdin, "-")
+//   screen_dump --selftest                - сжатие и распаковка случайных
+//       строк с сериями на всех границах длины, сверка каждой точки
+//
+// Формат по расширению: .png - PNG с палитрой, иначе PPM (P6). Цвета
+// RGB565 растягиваются до 8 бит так же, как в модели панели host_sim.
+#define _DEFAULT_SOURCE
+#include "screenshot/screen_rle.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <termios.h>
+
+typedef struct {
+    ScreenHeader header;
+    uint8_t pixels[SCREEN_MAX_WIDTH * SCREEN_MAX_HEIGHT];
+} ScreenImage;
+
+static void rgb888(uint16_t c, uint8_t rgb[3]) {
+    rgb[0] = (uint8_t)(((c >> 11) & 0x1F) * 255 / 31);
+    rgb[1] = (uint8_t)(((c >> 5) & 0x3F) * 255 / 63);
+    rgb[2] = (uint8_t)((c & 0x1F) * 255 / 31);
+}
+
+/* Разбор ответа */
+
+// Блок IEEE 488.2 "#<n><len>" в принятых байтах (перед ним могут быть
+// ответы на другие команды). Возвращает смещение данных или -1, если
+// заголовка блока ещё нет; в *len - длина данных
+static long find_block(const uint8_t *buf, size_t have, size_t *len) {
+    for (size_t i = 0; i + 2 <= have; i++) {
+        if (buf[i] != '#' || buf[i + 1] < '1' || buf[i + 1] > '9') continue;
+        size_t digits = buf[i + 1] - '0';
+        if (i + 2 + digits > have) return -1;
+        size_t n = 0;
+        size_t k;
+        for (k = 0; k < digits && buf[i + 2 + k] >= '0' && buf[i + 2 + k] <= '9'; k++) {
+            n = n * 10 + (buf[i + 2 + k] - '0');
+        }
+        if (k != digits) continue;
+        *len = n;
+        return (long)(i + 2 + digits);
+    }
+    return -1;
+}
+
+static bool decode_image(const uint8_t *data, size_t len, ScreenImage *img) {
+    size_t pos = screen_header_decode(data, len, &img->header);
+    if (!pos) {
+        fprintf(stderr, "not a screenshot (bad header)\n");
+        return false;
+    }
+    const ScreenHeader *h = &img->header;
+    for (uint16_t y = 0; y < h->height; y++) {
+        uint8_t *row = &img->pixels[y * h->width];
+        size_t n = screen_rle_decode_row(data + pos, len - pos, row, h->width);
+        if (!n) {
+            fprintf(stderr, "broken row %u (truncated transfer?)\n", y);
+            return false;
+        }
+        for (uint16_t x = 0; x < h->width; x++) {
+            if (row[x] >= h->colors) {
+                fprintf(stderr, "row %u: color %u out of palette\n", y, row[x]);
+                return false;
+            }
+        }
+        pos += n;
+    }
+    if (pos != len) fprintf(stderr, "warning: %zu extra bytes after image\n", len - pos);
+    return true;
+}
+
+/* Вывод */
+
+static bool write_ppm(const char *path, const ScreenImage *img) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return false;
+    const ScreenHeader *h = &img->header;
+    fprintf(f, "P6\n%u %u\n255\n", h->width, h->height);
+    for (size_t i = 0; i < (size_t)h->width * h->height; i++) {
+        uint8_t rgb[3];
+        rgb888(h->palette[img->pixels[i]], rgb);
+        fwrite(rgb, 1, 3, f);
+    }
+    return fclose(f) == 0;
+}
+
+static uint32_t crc_table[256];
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t len) {
+    if (!crc_table[1]) {
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++) c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            crc_table[n] = c;
+        }
+    }
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) crc = crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static void put32be(uint8_t *p, uint32_t v) {
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+static void png_chunk(FILE *f, const char *type, const uint8_t *data, size_t len) {
+    uint8_t word[4];
+    put32be(word, (uint32_t)len);
+    fwrite(word, 1, 4, f);
+    uint32_t crc = crc32_update(0, (const uint8_t *)type, 4);
+    crc = crc32_update(crc, data, len);
+    fwrite(type, 1, 4, f);
+    fwrite(data, 1, len, f);
+    put32be(word, crc);
+    fwrite(word, 1, 4, f);
+}
+
+// PNG с палитрой, IDAT - zlib без сжатия (блоки stored): внешние
+// библиотеки не нужны, снимок 320x240 - ~77 КБ
+static bool write_png(const char *path, const ScreenImage *img) {
+    const ScreenHeader *h = &img->header;
+    size_t raw_len = (size_t)(h->width + 1) * h->height;  // Байт фильтра на строку
+    size_t blocks = (raw_len + 65534) / 65535;
+    uint8_t *raw = malloc(raw_len);
+    uint8_t *z = malloc(2 + raw_len + blocks * 5 + 4);
+    if (!raw || !z) {
+        free(raw);
+        free(z);
+        return false;
+    }
+
+    for (uint16_t y = 0; y < h->height; y++) {
+        uint8_t *dst = &raw[(size_t)y * (h->width + 1)];
+        dst[0] = 0;
+        memcpy(dst + 1, &img->pixels[y * h->width], h->width);
+    }
+
+    size_t zl = 0;
+    z[zl++] = 0x78;
+    z[zl++] = 0x01;
+    for (size_t off = 0; off < raw_len; off += 65535) {
+        size_t n = raw_len - off < 65535 ? raw_len - off : 65535;
+        z[zl++] = off + n == raw_len;  // BFINAL, BTYPE = 00
+        z[zl++] = n & 0xFF;
+        z[zl++] = n >> 8;
+        z[zl++] = ~n & 0xFF;
+        z[zl++] = (~n >> 8) & 0xFF;
+        memcpy(&z[zl], &raw[off], n);
+        zl += n;
+    }
+    uint32_t a = 1, b = 0;
+    for (size_t i = 0; i < raw_len; i++) {
+        a = (a + raw[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    put32be(&z[zl], b << 16 | a);
+    zl += 4;
+
+    FILE *f = fopen(path, "wb");
+    bool ok = f != NULL;
+    if (ok) {
+        static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        fwrite(signature, 1, 8, f);
+
+        uint8_t ihdr[13];
+        put32be(&ihdr[0], h->width);
+        put32be(&ihdr[4], h->height);
+        ihdr[8] = 8;    // Бит на точку
+        ihdr[9] = 3;    // Палитра
+        ihdr[10] = ihdr[11] = ihdr[12] = 0;
+        png_chunk(f, "IHDR", ihdr, sizeof(ihdr));
+
+        uint8_t plte[SCREEN_MAX_COLORS * 3];
+        for (uint8_t i = 0; i < h->colors; i++) rgb888(h->palette[i], &plte[i * 3]);
+        png_chunk(f, "PLTE", plte, h->colors * 3);
+        png_chunk(f, "IDAT", z, zl);
+        png_chunk(f, "IEND", NULL, 0);
+        ok = fclose(f) == 0;
+    }
+    free(raw);
+    free(z);
+    return ok;
+}
+
+static bool write_image(const char *path, const ScreenImage *img) {
+    size_t n = strlen(path);
+    if (n >= 4 && !strcasecmp(path + n - 4, ".png")) return write_png(path, img);
+    return write_ppm(path, img);
+}
+
+/* Самопроверка */
+
+static uint32_t rng = 1;
+
+static uint32_t next_random(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static int run_selftest(void) {
+    // Длины серий вокруг границ кодирования и до конца строки
+    static const uint16_t edges[] = { 1, 2, 6, 7, 8, 9, 262, 263, 264, 265, 320 };
+    uint8_t row[SCREEN_MAX_WIDTH], back[SCREEN_MAX_WIDTH];
+    uint8_t encoded[SCREEN_ROW_MAX_BYTES(SCREEN_MAX_WIDTH)];
+    uint32_t errors = 0;
+    size_t total = 0;
+
+    for (int iter = 0; iter < 200000; iter++) {
+        uint16_t width = iter & 1 ? SCREEN_MAX_WIDTH : 1 + next_random() % SCREEN_MAX_WIDTH;
+        for (uint16_t x = 0; x < width;) {
+            uint16_t run = next_random() % 3 ? edges[next_random() % 11] : 1 + next_random() % 40;
+            uint8_t color = next_random() % SCREEN_MAX_COLORS;
+            for (uint16_t k = 0; k < run && x < width; k++) row[x++] = color;
+        }
+
+        size_t n = screen_rle_encode_row(row, width, encoded);
+        total += n;
+        if (n > SCREEN_ROW_MAX_BYTES(width) ||
+            screen_rle_decode_row(encoded, n, back, width) != n ||
+            memcmp(row, back, width) ||
+            (n > 1 && screen_rle_decode_row(encoded, n - 1, back, width) != 0)) {
+            errors++;
+        }
+    }
+
+    fprintf(stderr, "rows 200000, encoded %zu bytes, mismatches %u\n", total, errors);
+    fprintf(stderr, "selftest %s\n", errors ? "FAILED" : "passed");
+    return errors ? 1 : 0;
+}
+
+static void set_raw_tty(int fd) {
+    struct termios t;
+    if (tcgetattr(fd, &t) != 0) return;
+    cfmakeraw(&t);
+    tcsetattr(fd, TCSANOW, &t);
+}
+
+int main(int argc, char **argv) {
+    const char *path = NULL;
+    const char *out = "screen.png";
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--selftest")) return run_selftest();
+        if (!strcmp(argv[i], "-o") && i + 1 < argc) {
+            out = argv[++i];
+        } else {
+            path = argv[i];
+        }
+    }
+
+    int fd = STDIN_FILENO;
+    if (path && strcmp(path, "-")) {
+        fd = open(path, O_RDWR | O_NOCTTY);
+        if (fd < 0) fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            perror(path);
+            return 2;
+        }
+    }
+
+    // Прибор: запрос снимка. Файл или pipe - уже принятый ответ
+    if (isatty(fd)) {
+        set_raw_tty(fd);
+        tcflush(fd, TCIFLUSH);
+        static const char query[] = "DISP:SCR?\n";
+        if (write(fd, query, sizeof(query) - 1) < 0) {
+            perror("write");
+            return 2;
+        }
+    }
+
+    // Читаем до конца блока (прибор) или до конца файла
+    size_t cap = 1 << 16, have = 0, len = 0;
+    uint8_t *buf = malloc(cap);
+    long start = -1;
+    for (;;) {
+        if (start < 0) start = find_block(buf, have, &len);
+        if (start >= 0 && have >= (size_t)start + len) break;
+        if (have == cap) {
+            cap *= 2;
+            buf = realloc(buf, cap);
+            if (!buf) return 2;
+        }
+        ssize_t n = read(fd, buf + have, cap - have);
+        if (n <= 0) break;
+        have += (size_t)n;
+    }
+
+    if (start < 0 || have < (size_t)start + len) {
+        fprintf(stderr, "no complete screenshot block in input (%zu bytes)\n", have);
+        return 1;
+    }
+
+    static ScreenImage img;
+    if (!decode_image(buf + start, len, &img)) return 1;
+    if (!write_image(out, &img)) {
+        fprintf(stderr, "cannot write %s\n", out);
+        return 1;
+    }
+    fprintf(stderr, "%ux%u, %zu bytes (%.1f%% of 8-bit), %s\n", img.header.width, img.header.height,
+            len, 100.0 * len / ((double)img.header.width * img.header.height), out);
+    free(buf);
+    return 0;
+}
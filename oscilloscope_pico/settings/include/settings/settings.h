@@ -41,17 +41,33 @@ typedef struct {
     TriggerMode trigger_mode;
     TriggerEdge trigger_edge;
     uint16_t trigger_level;
+    uint16_t trigger_hysteresis;
+    int16_t voltage_offset_mv;
     bool persistence;
     bool measurements_enabled;
     bool cursors_enabled;
+    bool xy_mode;
 } OscilloscopeSettings;
 
-// Функции для работы с настройками
+// Изменения сохраняются, когда настройки не менялись столько времени:
+// серия нажатий или команд даёт одну запись во flash
+#define SETTINGS_SAVE_DELAY_MS 2000
+
+// Функции для работы с настройками. settings_init загружает сохранённые
 void settings_init();
 void settings_save();
 void settings_load();
 void settings_reset();
 
+// Отложенное сохранение (ядро дисплея, на каждом пробуждении)
+void settings_task();
+
+// Текущие настройки (ядро дисплея)
+const OscilloscopeSettings* settings_get();
+
+// Счётчик изменений: растёт при каждом изменении через сеттеры
+uint32_t settings_revision();
+
 // Геттеры/сеттеры для отдельных параметров
 void set_timebase(TimebaseSetting tb);
 TimebaseSetting get_timebase();
@@ -59,4 +75,34 @@ float get_timebase_us();
 
 void set_volt_div(VoltDivSetting vd);
 VoltDivSetting get_volt_div();
-float get_volt_div_value();
\ No newline at end of file
+float get_volt_div_value();
+
+// Ступени без переключения (выбор по сигналу): мкс/дел и напряжение на
+// всю высоту осциллограммы
+float timebase_step_us(TimebaseSetting tb);
+float volt_window_v(VoltDivSetting vd);
+
+void set_trigger_mode(TriggerMode mode);
+TriggerMode get_trigger_mode();
+
+void set_trigger_edge(TriggerEdge edge);
+TriggerEdge get_trigger_edge();
+
+void set_trigger_level(uint16_t level); // Код АЦП после калибровки
+uint16_t get_trigger_level();
+
+// Гистерезис триггера в кодах АЦП (0 - выключен)
+void set_trigger_hysteresis(uint16_t codes);
+uint16_t get_trigger_hysteresis();
+
+// Напряжение нижнего края осциллограммы (положение по вертикали)
+void set_voltage_offset_mv(int32_t mv);
+int32_t get_voltage_offset_mv();
+
+// Взвод однократного запуска (в режиме TRIGGER_SINGLE)
+void settings_arm_single();
+
+void set_persistence(bool enable);
+void set_measurements_enabled(bool enable);
+void set_cursors_enabled(bool enable);
+void set_xy_mode(bool enable);
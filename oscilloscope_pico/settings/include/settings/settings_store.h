@@ -0,0 +1,66 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Журнал настроек во flash: записи только дописываются.
+//
+// Область - несколько секторов (по умолчанию два последних сектора flash).
+// Каждая запись занимает SETTINGS_RECORD_BYTES байт:
+//   0  magic      0x5E77 (младший байт первым)
+//   2  version    версия формата полезной нагрузки
+//   3  length     длина полезной нагрузки
+//   4  sequence   номер записи, растёт с каждой записью
+//   8  payload    до SETTINGS_PAYLOAD_MAX байт
+//   30 crc16      CRC-16/CCITT-FALSE по байтам 0..29 (stream_crc16)
+//
+// Актуальна запись с наибольшим sequence и верной CRC. Сектор стирается
+// только при переходе на него, то есть раз в SETTINGS_RECORDS_PER_SECTOR
+// записей, и износ распределяется по всем секторам области. Запись,
+// оборванная выключением питания, не проходит CRC и пропускается, а
+// предыдущая остаётся в другом месте журнала.
+//
+// Модуль не зависит от SDK: доступ к flash - через FlashPort, на хосте
+// подставляется массив в RAM.
+
+#define SETTINGS_RECORD_BYTES   32
+#define SETTINGS_PAYLOAD_MAX    22
+#define SETTINGS_RECORD_MAGIC   0x5E77
+
+typedef struct {
+    const uint8_t *base;     // Содержимое области для чтения (XIP или RAM)
+    uint32_t size;           // Размер области, кратен sector_size
+    uint32_t sector_size;
+    // Стирание сектора и запись (только 1 -> 0). false - операция не выполнена
+    bool (*erase)(void *ctx, uint32_t offset);
+    bool (*program)(void *ctx, uint32_t offset, const uint8_t *data, uint32_t len);
+    void *ctx;
+} FlashPort;
+
+typedef struct {
+    const FlashPort *port;
+    int32_t newest;          // Смещение актуальной записи, -1 - записей нет
+    uint32_t sequence;       // Её номер
+    uint32_t next;           // Куда пойдёт следующая запись
+    bool need_erase;         // next - начало сектора, который надо стереть
+    uint32_t erases;         // Стираний с момента запуска
+    uint32_t writes;
+} SettingsStore;
+
+// Просмотр журнала и поиск актуальной записи
+void settings_store_init(SettingsStore *store, const FlashPort *port);
+
+// Полезная нагрузка актуальной записи. false - записей нет
+bool settings_store_read(const SettingsStore *store, uint8_t *payload,
+                         uint8_t *length, uint8_t *version);
+
+// Дописывание новой записи. false - flash не приняла запись
+bool settings_store_append(SettingsStore *store, const uint8_t *payload,
+                           uint8_t length, uint8_t version);
+
+// Порты прошивки (settings_flash.c): журнал - последние сектора flash,
+// перед ним - слоты эталонных осциллограмм (reference.h), по сектору на
+// слот, и сектор таблицы нелинейности АЦП (calibration.h)
+const FlashPort *settings_flash_port(void);
+const FlashPort *reference_flash_port(void);
+const FlashPort *calibration_flash_port(void);
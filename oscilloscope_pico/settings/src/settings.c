@@ -0,0 +1,294 @@
+#include "settings/settings.h"
+#include "settings/settings_store.h"
+#include "global_buffer/global_buffer.h"
+#include "persistence/persistence.h"
+#include "xy/xy.h"
+#include "calibration/calibration.h"
+#include "display_driver/display_driver.h"
+#include "pico/time.h"
+#include <string.h>
+
+#define GRID_DIV_PX 50 // Шаг сетки по вертикали (draw_grid)
+
+static const float timebase_us[] = { 1.0f, 10.0f, 100.0f, 1000.0f, 10000.0f, 100000.0f };
+static const float volt_div_v[] = { 0.1f, 0.2f, 0.5f, 1.0f, 2.0f, 5.0f };
+
+// Формат записи во flash. Новые поля только дописываются в конец с
+// увеличением версии, старые записи читаются по своей длине
+#define SETTINGS_VERSION        2
+#define SETTINGS_PAYLOAD_BYTES  19
+
+#define FLAG_PERSISTENCE   0x01
+#define FLAG_MEASUREMENTS  0x02
+#define FLAG_CURSORS       0x04
+#define FLAG_XY            0x08
+
+static OscilloscopeSettings settings;
+static uint32_t revision = 0;
+
+static SettingsStore store;
+static uint8_t stored[SETTINGS_PAYLOAD_BYTES];    // Последнее записанное
+static uint8_t candidate[SETTINGS_PAYLOAD_BYTES]; // Увиденное при прошлой проверке
+static absolute_time_t next_check;
+
+static void changed(void) {
+    revision++;
+}
+
+void settings_init() {
+    settings_reset();
+    settings_store_init(&store, settings_flash_port());
+    settings_load();
+    next_check = make_timeout_time_ms(SETTINGS_SAVE_DELAY_MS);
+}
+
+// Настройки и калибровка усиления/смещения (её меняют кнопкой в меню)
+static void encode(uint8_t *p) {
+    const OscilloscopeSettings *s = settings_get();
+    uint32_t gain_q16;
+    int32_t offset_mv;
+    calibration_get_gain_offset(&gain_q16, &offset_mv);
+
+    p[0] = s->timebase;
+    p[1] = s->volt_div;
+    p[2] = s->trigger_mode;
+    p[3] = s->trigger_edge;
+    p[4] = s->trigger_level & 0xFF;
+    p[5] = s->trigger_level >> 8;
+    p[6] = (s->persistence ? FLAG_PERSISTENCE : 0) |
+           (s->measurements_enabled ? FLAG_MEASUREMENTS : 0) |
+           (s->cursors_enabled ? FLAG_CURSORS : 0) |
+           (s->xy_mode ? FLAG_XY : 0);
+    for (int i = 0; i < 4; i++) {
+        p[7 + i] = gain_q16 >> (8 * i);
+        p[11 + i] = (uint32_t)offset_mv >> (8 * i);
+    }
+    // Версия 2
+    p[15] = (uint16_t)s->voltage_offset_mv & 0xFF;
+    p[16] = (uint16_t)s->voltage_offset_mv >> 8;
+    p[17] = s->trigger_hysteresis & 0xFF;
+    p[18] = s->trigger_hysteresis >> 8;
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+void settings_save() {
+    uint8_t payload[SETTINGS_PAYLOAD_BYTES];
+    encode(payload);
+    if (memcmp(payload, stored, sizeof(stored)) == 0) return;
+    if (settings_store_append(&store, payload, sizeof(payload), SETTINGS_VERSION)) {
+        memcpy(stored, payload, sizeof(stored));
+    }
+    memcpy(candidate, payload, sizeof(candidate));
+}
+
+// Сеттеры сами проверяют диапазоны, так что испорченное значение не пройдёт
+void settings_load() {
+    uint8_t p[SETTINGS_PAYLOAD_MAX];
+    uint8_t len;
+    if (!settings_store_read(&store, p, &len, NULL) || len < 7) {
+        encode(stored);
+        memcpy(candidate, stored, sizeof(candidate));
+        return;
+    }
+
+    set_timebase((TimebaseSetting)p[0]);
+    set_volt_div((VoltDivSetting)p[1]);
+    set_trigger_edge((TriggerEdge)p[3]);
+    set_trigger_level(p[4] | (p[5] << 8));
+    set_persistence(p[6] & FLAG_PERSISTENCE);
+    set_measurements_enabled(p[6] & FLAG_MEASUREMENTS);
+    set_cursors_enabled(p[6] & FLAG_CURSORS);
+    set_xy_mode(p[6] & FLAG_XY);
+    set_trigger_mode((TriggerMode)p[2]);
+    if (len >= 15) {
+        calibration_set_gain_offset(get_u32(&p[7]), (int32_t)get_u32(&p[11]));
+    }
+    if (len >= 19) {
+        set_voltage_offset_mv((int16_t)(p[15] | (p[16] << 8)));
+        set_trigger_hysteresis(p[17] | (p[18] << 8));
+    }
+
+    // Загруженное уже во flash - не переписываем
+    encode(stored);
+    memcpy(candidate, stored, sizeof(candidate));
+}
+
+// Запись только когда настройки одинаковы на двух проверках подряд.
+// Часть параметров пока меняется кнопками в обход сеттеров, поэтому
+// сравнивается сам образ записи, а не счётчик изменений
+void settings_task() {
+    if (!time_reached(next_check)) return;
+    next_check = make_timeout_time_ms(SETTINGS_SAVE_DELAY_MS);
+
+    uint8_t payload[SETTINGS_PAYLOAD_BYTES];
+    encode(payload);
+    if (memcmp(payload, stored, sizeof(stored)) == 0) return;
+    if (memcmp(payload, candidate, sizeof(candidate)) != 0) {
+        memcpy(candidate, payload, sizeof(candidate)); // Ещё меняются
+        return;
+    }
+    settings_save();
+}
+
+// По умолчанию - то, с чем прибор работал до появления настроек
+void settings_reset() {
+    set_timebase(TIMEBASE_1MS);
+    set_volt_div(VOLT_DIV_1V);
+    set_trigger_mode(TRIGGER_NORMAL);
+    set_trigger_edge(EDGE_RISING);
+    set_trigger_level(2048);
+    set_trigger_hysteresis(0);
+    set_voltage_offset_mv(0);
+    set_persistence(false);
+    set_measurements_enabled(true);
+    set_cursors_enabled(false);
+    set_xy_mode(false);
+}
+
+const OscilloscopeSettings* settings_get() {
+    // Уровень триггера и послесвечение пока меняются и кнопками напрямую
+    settings.trigger_level = global_buffer.trigger_level;
+    settings.persistence = global_buffer.persistence;
+    return &settings;
+}
+
+uint32_t settings_revision() {
+    return revision;
+}
+
+void set_timebase(TimebaseSetting tb) {
+    if (tb > TIMEBASE_100MS) return;
+    settings.timebase = tb;
+    global_buffer.time_scale = timebase_us[tb] / 1000.0f; // мс/дел
+    changed();
+}
+
+TimebaseSetting get_timebase() {
+    return settings.timebase;
+}
+
+float get_timebase_us() {
+    return timebase_us[settings.timebase];
+}
+
+void set_volt_div(VoltDivSetting vd) {
+    if (vd > VOLT_DIV_5V) return;
+    settings.volt_div = vd;
+    // voltage_scale = 1 - весь диапазон АЦП на высоту осциллограммы
+    global_buffer.voltage_scale = (CALIB_FULL_SCALE_MV / 1000.0f) / volt_window_v(vd);
+    changed();
+}
+
+VoltDivSetting get_volt_div() {
+    return settings.volt_div;
+}
+
+float get_volt_div_value() {
+    return volt_div_v[settings.volt_div];
+}
+
+float timebase_step_us(TimebaseSetting tb) {
+    return timebase_us[tb > TIMEBASE_100MS ? TIMEBASE_100MS : tb];
+}
+
+float volt_window_v(VoltDivSetting vd) {
+    return volt_div_v[vd > VOLT_DIV_5V ? VOLT_DIV_5V : vd] * WAVEFORM_HEIGHT / GRID_DIV_PX;
+}
+
+void set_trigger_mode(TriggerMode mode) {
+    if (mode > TRIGGER_SINGLE) return;
+    settings.trigger_mode = mode;
+    global_buffer.trigger_auto = mode == TRIGGER_AUTO;
+    global_buffer.trigger_single = mode == TRIGGER_SINGLE;
+    if (mode == TRIGGER_SINGLE) settings_arm_single();
+    else global_buffer.single_armed = false;
+    changed();
+}
+
+TriggerMode get_trigger_mode() {
+    return settings.trigger_mode;
+}
+
+void set_trigger_edge(TriggerEdge edge) {
+    if (edge > EDGE_BOTH) return;
+    settings.trigger_edge = edge;
+    global_buffer.trigger_any_edge = edge == EDGE_BOTH;
+    global_buffer.trigger_edge = edge == EDGE_RISING;
+    changed();
+}
+
+TriggerEdge get_trigger_edge() {
+    return settings.trigger_edge;
+}
+
+void set_trigger_level(uint16_t level) {
+    if (level > 4095) level = 4095;
+    settings.trigger_level = level;
+    global_buffer.trigger_level = level;
+    changed();
+}
+
+uint16_t get_trigger_level() {
+    return global_buffer.trigger_level;
+}
+
+void set_trigger_hysteresis(uint16_t codes) {
+    if (codes > 2047) codes = 2047;
+    settings.trigger_hysteresis = codes;
+    global_buffer.trigger_hysteresis = codes;
+    changed();
+}
+
+uint16_t get_trigger_hysteresis() {
+    return settings.trigger_hysteresis;
+}
+
+// Пересчёт в пиксели - в calibration_update_view при следующем кадре
+void set_voltage_offset_mv(int32_t mv) {
+    if (mv > INT16_MAX) mv = INT16_MAX;
+    if (mv < INT16_MIN) mv = INT16_MIN;
+    settings.voltage_offset_mv = (int16_t)mv;
+    global_buffer.voltage_offset = mv / 1000.0f;
+    changed();
+}
+
+int32_t get_voltage_offset_mv() {
+    return settings.voltage_offset_mv;
+}
+
+void settings_arm_single() {
+    global_buffer.single_armed = true;
+    global_buffer.hold = false;
+}
+
+void set_persistence(bool enable) {
+    if (enable != global_buffer.persistence) persistence_clear();
+    settings.persistence = enable;
+    global_buffer.persistence = enable;
+    changed();
+}
+
+void set_measurements_enabled(bool enable) {
+    settings.measurements_enabled = enable;
+    changed();
+}
+
+void set_cursors_enabled(bool enable) {
+    settings.cursors_enabled = enable;
+    changed();
+}
+
+// Входы АЦП переключает ядро захвата, увидев флаг (adc_driver.c)
+void set_xy_mode(bool enable) {
+    // Карта попаданий у XY и послесвечения общая
+    if (enable != global_buffer.xy_mode) {
+        xy_clear();
+        persistence_clear();
+    }
+    settings.xy_mode = enable;
+    global_buffer.xy_mode = enable;
+    changed();
+}
@@ -0,0 +1,116 @@
+#include "settings/settings_store.h"
+#include "settings/settings.h"
+#include "global_buffer/global_buffer.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+#include "pico/time.h"
+#include <string.h>
+
+// Журнал занимает последние сектора flash, после прошивки, перед ним
+// слоты эталонов, ещё ниже - таблица нелинейности АЦП
+#define SETTINGS_FLASH_SECTORS   2
+#define SETTINGS_FLASH_OFFSET    (PICO_FLASH_SIZE_BYTES - SETTINGS_FLASH_SECTORS * FLASH_SECTOR_SIZE)
+#define REFERENCE_FLASH_SECTORS  4
+#define REFERENCE_FLASH_OFFSET   (SETTINGS_FLASH_OFFSET - REFERENCE_FLASH_SECTORS * FLASH_SECTOR_SIZE)
+#define CALIBRATION_FLASH_OFFSET (REFERENCE_FLASH_OFFSET - FLASH_SECTOR_SIZE)
+#define FLASH_PARK_TIMEOUT_US    5000
+
+// Смещение области порта от начала flash (ctx порта)
+typedef struct {
+    uint32_t offset;
+} FlashRegion;
+
+static FlashRegion settings_region = { SETTINGS_FLASH_OFFSET };
+static FlashRegion reference_region = { REFERENCE_FLASH_OFFSET };
+static FlashRegion calibration_region = { CALIBRATION_FLASH_OFFSET };
+
+// На время стирания и записи XIP недоступен. Ядро захвата уходит в цикл в
+// RAM (park_for_flash), а его прерывание DMA работает дальше: оно и всё,
+// что оно вызывает, тоже лежит в RAM. На этом ядре прерывания запрещены
+static bool flash_begin(uint32_t *irq) {
+    global_buffer.flash_park_request = true;
+    __sev();
+    absolute_time_t deadline = make_timeout_time_us(FLASH_PARK_TIMEOUT_US);
+    while (!global_buffer.flash_parked) {
+        if (time_reached(deadline)) {
+            // Ядро захвата не ответило (ещё не запущено) - запись откладывается
+            global_buffer.flash_park_request = false;
+            return false;
+        }
+    }
+    *irq = save_and_disable_interrupts();
+    return true;
+}
+
+static void flash_end(uint32_t irq) {
+    restore_interrupts(irq);
+    global_buffer.flash_park_request = false;
+    __sev();
+}
+
+static bool port_erase(void *ctx, uint32_t offset) {
+    const FlashRegion *region = ctx;
+    uint32_t irq;
+    if (!flash_begin(&irq)) return false;
+    flash_range_erase(region->offset + offset, FLASH_SECTOR_SIZE);
+    flash_end(irq);
+    return true;
+}
+
+// Flash пишется страницами по 256 байт: остальные байты страницы 0xFF
+// и не меняются
+static bool port_program(void *ctx, uint32_t offset, const uint8_t *data, uint32_t len) {
+    const FlashRegion *region = ctx;
+    static uint8_t page[FLASH_PAGE_SIZE];
+    uint32_t page_offset = offset & ~(FLASH_PAGE_SIZE - 1);
+    uint32_t in_page = offset - page_offset;
+    if (in_page + len > FLASH_PAGE_SIZE) return false;
+
+    memset(page, 0xFF, sizeof(page));
+    memcpy(&page[in_page], data, len);
+
+    uint32_t irq;
+    if (!flash_begin(&irq)) return false;
+    flash_range_program(region->offset + page_offset, page, FLASH_PAGE_SIZE);
+    flash_end(irq);
+    return true;
+}
+
+static const FlashPort flash_port = {
+    .base = (const uint8_t *)(XIP_BASE + SETTINGS_FLASH_OFFSET),
+    .size = SETTINGS_FLASH_SECTORS * FLASH_SECTOR_SIZE,
+    .sector_size = FLASH_SECTOR_SIZE,
+    .erase = port_erase,
+    .program = port_program,
+    .ctx = &settings_region,
+};
+
+static const FlashPort reference_port = {
+    .base = (const uint8_t *)(XIP_BASE + REFERENCE_FLASH_OFFSET),
+    .size = REFERENCE_FLASH_SECTORS * FLASH_SECTOR_SIZE,
+    .sector_size = FLASH_SECTOR_SIZE,
+    .erase = port_erase,
+    .program = port_program,
+    .ctx = &reference_region,
+};
+
+static const FlashPort calibration_port = {
+    .base = (const uint8_t *)(XIP_BASE + CALIBRATION_FLASH_OFFSET),
+    .size = FLASH_SECTOR_SIZE,
+    .sector_size = FLASH_SECTOR_SIZE,
+    .erase = port_erase,
+    .program = port_program,
+    .ctx = &calibration_region,
+};
+
+const FlashPort *settings_flash_port(void) {
+    return &flash_port;
+}
+
+const FlashPort *reference_flash_port(void) {
+    return &reference_port;
+}
+
+const FlashPort *calibration_flash_port(void) {
+    return &calibration_port;
+}
@@ -0,0 +1,121 @@
+#include "settings/settings_store.h"
+#include "usb_stream/stream_frame.h"
+#include <string.h>
+
+#define CRC_OFFSET (SETTINGS_RECORD_BYTES - 2)
+
+static uint32_t get_u32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static bool slot_empty(const SettingsStore *store, uint32_t offset) {
+    const uint8_t *p = store->port->base + offset;
+    for (int i = 0; i < SETTINGS_RECORD_BYTES; i++) {
+        if (p[i] != 0xFF) return false;
+    }
+    return true;
+}
+
+static bool slot_valid(const SettingsStore *store, uint32_t offset) {
+    const uint8_t *p = store->port->base + offset;
+    if ((p[0] | (p[1] << 8)) != SETTINGS_RECORD_MAGIC) return false;
+    if (p[3] > SETTINGS_PAYLOAD_MAX) return false;
+    uint16_t crc = p[CRC_OFFSET] | (p[CRC_OFFSET + 1] << 8);
+    return crc == stream_crc16(0xFFFF, p, CRC_OFFSET);
+}
+
+// Следующее свободное место в секторе начиная с offset. Если сектор
+// закончился - начало следующего, перед записью его надо стереть
+static void seek_free(SettingsStore *store, uint32_t offset) {
+    const FlashPort *port = store->port;
+    uint32_t sector_end = (offset / port->sector_size + 1) * port->sector_size;
+
+    if (offset % port->sector_size != 0) {
+        while (offset < sector_end && !slot_empty(store, offset)) {
+            offset += SETTINGS_RECORD_BYTES;
+        }
+        if (offset < sector_end) {
+            store->next = offset;
+            return;
+        }
+    }
+    store->next = offset % port->size;
+    store->need_erase = true;
+}
+
+void settings_store_init(SettingsStore *store, const FlashPort *port) {
+    store->port = port;
+    store->newest = -1;
+    store->sequence = 0;
+    store->need_erase = false;
+    store->erases = 0;
+    store->writes = 0;
+
+    // Полный просмотр: 2 сектора по 128 записей читаются через XIP быстро
+    for (uint32_t offset = 0; offset < port->size; offset += SETTINGS_RECORD_BYTES) {
+        if (!slot_valid(store, offset)) continue;
+        uint32_t seq = get_u32(port->base + offset + 4);
+        if (store->newest < 0 || (int32_t)(seq - store->sequence) > 0) {
+            store->newest = (int32_t)offset;
+            store->sequence = seq;
+        }
+    }
+
+    // Пустой или чужой журнал начинается с первого сектора, со стиранием
+    if (store->newest < 0) seek_free(store, 0);
+    else seek_free(store, (uint32_t)store->newest + SETTINGS_RECORD_BYTES);
+}
+
+bool settings_store_read(const SettingsStore *store, uint8_t *payload,
+                         uint8_t *length, uint8_t *version) {
+    if (store->newest < 0) return false;
+    const uint8_t *p = store->port->base + store->newest;
+    if (version) *version = p[2];
+    *length = p[3];
+    memcpy(payload, p + 8, p[3]);
+    return true;
+}
+
+bool settings_store_append(SettingsStore *store, const uint8_t *payload,
+                           uint8_t length, uint8_t version) {
+    const FlashPort *port = store->port;
+    if (length > SETTINGS_PAYLOAD_MAX) return false;
+
+    uint8_t record[SETTINGS_RECORD_BYTES];
+    uint32_t seq = store->sequence + 1;
+    if (seq == 0xFFFFFFFFu) seq = 0; // Как у стёртой flash - не используем
+    memset(record, 0xFF, sizeof(record));
+    record[0] = SETTINGS_RECORD_MAGIC & 0xFF;
+    record[1] = SETTINGS_RECORD_MAGIC >> 8;
+    record[2] = version;
+    record[3] = length;
+    for (int i = 0; i < 4; i++) record[4 + i] = seq >> (8 * i);
+    memcpy(&record[8], payload, length);
+    uint16_t crc = stream_crc16(0xFFFF, record, CRC_OFFSET);
+    record[CRC_OFFSET] = crc & 0xFF;
+    record[CRC_OFFSET + 1] = crc >> 8;
+
+    // Не больше одного круга по области: место под запись находится всегда,
+    // если flash исправна
+    for (uint32_t tries = port->size / SETTINGS_RECORD_BYTES; tries; tries--) {
+        if (store->need_erase) {
+            if (!port->erase(port->ctx, store->next)) return false;
+            store->need_erase = false;
+            store->erases++;
+        }
+
+        uint32_t offset = store->next;
+        bool ok = port->program(port->ctx, offset, record, sizeof(record)) &&
+                  memcmp(port->base + offset, record, sizeof(record)) == 0;
+
+        // Даже неудачная попытка занимает место: слот уже не пустой
+        seek_free(store, offset + SETTINGS_RECORD_BYTES);
+        if (ok) {
+            store->newest = (int32_t)offset;
+            store->sequence = seq;
+            store->writes++;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Формат кадра потока (все поля little-endian):
+//
+//   0  sync       0xA5 0x5A
+//   2  encoding   StreamEncoding
+//   3  flags      резерв, 0
+//   4  sequence   сквозной номер захвата, пропуски = потерянные блоки
+//   8  timestamp  время захвата, мкс
+//  12  count      число отсчётов
+//  14  length     байт полезной нагрузки
+//  16  payload
+//   .  crc16      CRC-16/CCITT-FALSE по байтам 2..конец нагрузки
+//
+// Модуль не зависит от SDK: тот же код собирается в прошивку и в
+// хостовый декодер (tools/stream_dump).
+
+#define STREAM_SYNC0         0xA5
+#define STREAM_SYNC1         0x5A
+#define STREAM_HEADER_BYTES  16
+#define STREAM_CRC_BYTES     2
+#define STREAM_MAX_SAMPLES   4096
+
+// Размер кадра в худшем случае (без упаковки)
+#define STREAM_FRAME_MAX_BYTES(count) \
+    (STREAM_HEADER_BYTES + 2 * (count) + STREAM_CRC_BYTES)
+
+typedef enum {
+    STREAM_ENC_RAW16  = 0,  // 2 байта на отсчёт
+    STREAM_ENC_PACK12 = 1,  // 3 байта на 2 отсчёта
+    STREAM_ENC_DELTA  = 2,  // wave_codec (разности + код Райса)
+    STREAM_ENC_COUNT
+} StreamEncoding;
+
+typedef struct {
+    uint8_t encoding;
+    uint8_t flags;
+    uint32_t sequence;
+    uint32_t timestamp_us;
+    uint16_t count;
+    uint16_t length;
+} StreamHeader;
+
+uint16_t stream_crc16(uint16_t crc, const uint8_t *data, size_t len);
+
+// Упаковка 12-битных отсчётов: a0 a1 -> [a0 7:0] [a1 3:0 | a0 11:8] [a1 11:4]
+size_t stream_pack12(const uint16_t *samples, uint16_t count, uint8_t *out);
+void stream_unpack12(const uint8_t *data, uint16_t count, uint16_t *out);
+
+// Сборка кадра. Если сжатие оказалось хуже упаковки, кадр уходит в PACK12.
+// Возвращает размер кадра или 0, если не поместилось в capacity
+size_t stream_frame_encode(uint8_t *out, size_t capacity, StreamEncoding encoding,
+                           uint32_t sequence, uint32_t timestamp_us,
+                           const uint16_t *samples, uint16_t count);
+
+// Разбор потока: байты подаются кусками любого размера, на каждый целый
+// кадр с верной CRC вызывается callback с распакованными отсчётами.
+// После ошибки разбор синхронизируется по следующему 0xA5 0x5A
+typedef void (*StreamFrameCallback)(void *ctx, const StreamHeader *header,
+                                    const uint16_t *samples);
+
+typedef struct {
+    uint8_t buf[STREAM_FRAME_MAX_BYTES(STREAM_MAX_SAMPLES)];
+    size_t have;
+    uint16_t samples[STREAM_MAX_SAMPLES];
+
+    // Статистика
+    uint32_t frames;
+    uint32_t crc_errors;
+    uint32_t skipped_bytes;   // Байты вне кадров (ресинхронизация)
+    uint32_t gaps;            // Разрывы по sequence
+    uint32_t lost;            // Потерянные блоки по sequence
+    uint32_t last_sequence;
+    bool have_sequence;
+} StreamParser;
+
+void stream_parser_init(StreamParser *p);
+void stream_parser_feed(StreamParser *p, const uint8_t *data, size_t len,
+                        StreamFrameCallback cb, void *ctx);
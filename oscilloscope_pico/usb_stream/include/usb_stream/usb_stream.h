@@ -0,0 +1,56 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "usb_stream/stream_frame.h"
+
+// Потоковая передача блоков захвата на ПК через USB CDC.
+//
+// Каждый блок целиком кодируется в кадр (stream_frame.h) и кладётся в
+// очередь передачи на ядре захвата. Если кадр в очередь не помещается, он
+// выбрасывается целиком - захват никогда не ждёт USB, а ПК видит пропуск
+// по sequence. Очередь выталкивается в CDC из usb_stream_service() на ядре
+// дисплея порциями, сколько влезает в буфер TinyUSB, в том числе между
+// строками вывода кадра на панель. Кольцо - с одним писателем и одним
+// читателем, без блокировок.
+//
+// Бюджет USB Full Speed (~1 МБ/с на практике): 500 кГц по 12 бит - 750 КБ/с
+// в PACK12, это на пределе, поэтому по умолчанию DELTA (обычно 250-350 КБ/с).
+
+#define USB_STREAM_QUEUE_BYTES 4096
+
+// Транспорт: по умолчанию USB CDC, на хосте можно подставить pipe
+typedef struct {
+    size_t (*available)(void *ctx);                            // Свободно байт
+    size_t (*write)(void *ctx, const uint8_t *data, size_t len);
+    void (*flush)(void *ctx);
+    void *ctx;
+} StreamTransport;
+
+typedef struct {
+    uint32_t sent;       // Кадров поставлено в очередь
+    uint32_t dropped;    // Кадров выброшено: очередь заполнена
+    uint32_t bytes;      // Байт передано в транспорт
+} UsbStreamStats;
+
+// transport = NULL - USB CDC
+void usb_stream_init(const StreamTransport *transport);
+
+void usb_stream_set_mode(bool enabled, StreamEncoding encoding);
+bool usb_stream_enabled(void);
+StreamEncoding usb_stream_get_encoding(void);
+
+// Постановка блока в очередь (ядро захвата). false - блок выброшен
+bool usb_stream_send(const uint16_t *samples, uint16_t count,
+                     uint32_t sequence, uint32_t timestamp_us);
+
+// Выталкивание очереди в транспорт (ядро дисплея, на каждом пробуждении и
+// между строками вывода кадра)
+void usb_stream_service(void);
+
+// Выталкивание кадров, уже лежащих в очереди (перед ответом на команду в
+// тот же CDC, чтобы ответ не попал внутрь кадра). false - не успели за
+// timeout_us
+bool usb_stream_drain(uint32_t timeout_us);
+
+void usb_stream_get_stats(UsbStreamStats *stats);
@@ -0,0 +1,214 @@
+#include "usb_stream/stream_frame.h"
+#include "wave_codec/wave_codec.h"
+#include <string.h>
+
+static uint16_t crc_table[256];
+static bool crc_table_ready = false;
+
+static void crc_table_init(void) {
+    for (int i = 0; i < 256; i++) {
+        uint16_t crc = (uint16_t)(i << 8);
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+        crc_table[i] = crc;
+    }
+    crc_table_ready = true;
+}
+
+uint16_t stream_crc16(uint16_t crc, const uint8_t *data, size_t len) {
+    if (!crc_table_ready) crc_table_init();
+    while (len--) {
+        crc = (uint16_t)((crc << 8) ^ crc_table[((crc >> 8) ^ *data++) & 0xFF]);
+    }
+    return crc;
+}
+
+size_t stream_pack12(const uint16_t *samples, uint16_t count, uint8_t *out) {
+    uint8_t *p = out;
+    uint16_t i = 0;
+    for (; i + 1 < count; i += 2) {
+        uint16_t a = samples[i] & 0x0FFF;
+        uint16_t b = samples[i + 1] & 0x0FFF;
+        *p++ = (uint8_t)a;
+        *p++ = (uint8_t)((a >> 8) | (b << 4));
+        *p++ = (uint8_t)(b >> 4);
+    }
+    if (i < count) {
+        uint16_t a = samples[i] & 0x0FFF;
+        *p++ = (uint8_t)a;
+        *p++ = (uint8_t)(a >> 8);
+    }
+    return p - out;
+}
+
+void stream_unpack12(const uint8_t *data, uint16_t count, uint16_t *out) {
+    uint16_t i = 0;
+    for (; i + 1 < count; i += 2, data += 3) {
+        out[i] = data[0] | ((data[1] & 0x0F) << 8);
+        out[i + 1] = (data[1] >> 4) | (data[2] << 4);
+    }
+    if (i < count) out[i] = data[0] | ((data[1] & 0x0F) << 8);
+}
+
+static inline void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void put_u32(uint8_t *p, uint32_t v) {
+    put_u16(p, (uint16_t)v);
+    put_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+static inline uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t get_u32(const uint8_t *p) {
+    return get_u16(p) | ((uint32_t)get_u16(p + 2) << 16);
+}
+
+// Размер нагрузки PACK12
+static inline size_t pack12_bytes(uint16_t count) {
+    return (size_t)count / 2 * 3 + (count & 1) * 2;
+}
+
+size_t stream_frame_encode(uint8_t *out, size_t capacity, StreamEncoding encoding,
+                           uint32_t sequence, uint32_t timestamp_us,
+                           const uint16_t *samples, uint16_t count) {
+    if (count > STREAM_MAX_SAMPLES || capacity < STREAM_HEADER_BYTES + STREAM_CRC_BYTES) return 0;
+
+    uint8_t *payload = out + STREAM_HEADER_BYTES;
+    size_t room = capacity - STREAM_HEADER_BYTES - STREAM_CRC_BYTES;
+    size_t length = 0;
+
+    if (encoding == STREAM_ENC_DELTA) {
+        // Нагрузку больше PACK12 не допускаем: при шуме на весь диапазон
+        // сжатие проигрывает упаковке
+        size_t limit = pack12_bytes(count);
+        length = wave_encode(samples, count, payload, room < limit ? room : limit);
+        if (length == 0) encoding = STREAM_ENC_PACK12;
+    }
+    if (encoding == STREAM_ENC_PACK12) {
+        if (pack12_bytes(count) > room) return 0;
+        length = stream_pack12(samples, count, payload);
+    } else if (encoding == STREAM_ENC_RAW16) {
+        if ((size_t)count * 2 > room) return 0;
+        for (uint16_t i = 0; i < count; i++) put_u16(&payload[2 * i], samples[i]);
+        length = (size_t)count * 2;
+    }
+
+    out[0] = STREAM_SYNC0;
+    out[1] = STREAM_SYNC1;
+    out[2] = (uint8_t)encoding;
+    out[3] = 0;
+    put_u32(&out[4], sequence);
+    put_u32(&out[8], timestamp_us);
+    put_u16(&out[12], count);
+    put_u16(&out[14], (uint16_t)length);
+
+    uint16_t crc = stream_crc16(0xFFFF, &out[2], STREAM_HEADER_BYTES - 2 + length);
+    put_u16(&payload[length], crc);
+    return STREAM_HEADER_BYTES + length + STREAM_CRC_BYTES;
+}
+
+void stream_parser_init(StreamParser *p) {
+    memset(p, 0, sizeof(*p));
+}
+
+// Отбрасывание n байт из начала буфера
+static void consume(StreamParser *p, size_t n) {
+    memmove(p->buf, p->buf + n, p->have - n);
+    p->have -= n;
+}
+
+// Проверка заголовка на правдоподобие до ожидания всей нагрузки
+static bool header_valid(const StreamHeader *h) {
+    if (h->encoding >= STREAM_ENC_COUNT || h->count > STREAM_MAX_SAMPLES) return false;
+    return h->length <= 2 * h->count;
+}
+
+static bool decode_payload(StreamParser *p, const StreamHeader *h, const uint8_t *payload) {
+    switch (h->encoding) {
+        case STREAM_ENC_RAW16:
+            if (h->length != 2 * h->count) return false;
+            for (uint16_t i = 0; i < h->count; i++) p->samples[i] = get_u16(&payload[2 * i]);
+            return true;
+        case STREAM_ENC_PACK12:
+            if (h->length != pack12_bytes(h->count)) return false;
+            stream_unpack12(payload, h->count, p->samples);
+            return true;
+        case STREAM_ENC_DELTA:
+            return wave_decode(payload, h->length, p->samples, h->count) == h->count;
+        default:
+            return false;
+    }
+}
+
+void stream_parser_feed(StreamParser *p, const uint8_t *data, size_t len,
+                        StreamFrameCallback cb, void *ctx) {
+    while (len) {
+        size_t n = sizeof(p->buf) - p->have;
+        if (n > len) n = len;
+        memcpy(p->buf + p->have, data, n);
+        p->have += n;
+        data += n;
+        len -= n;
+
+        for (;;) {
+            // Поиск синхрослова
+            size_t skip = 0;
+            while (skip + 1 < p->have &&
+                   !(p->buf[skip] == STREAM_SYNC0 && p->buf[skip + 1] == STREAM_SYNC1)) {
+                skip++;
+            }
+            if (skip + 1 >= p->have && p->have && p->buf[p->have - 1] != STREAM_SYNC0) skip = p->have;
+            if (skip) {
+                p->skipped_bytes += skip;
+                consume(p, skip);
+            }
+            if (p->have < STREAM_HEADER_BYTES) break;
+
+            StreamHeader h;
+            h.encoding = p->buf[2];
+            h.flags = p->buf[3];
+            h.sequence = get_u32(&p->buf[4]);
+            h.timestamp_us = get_u32(&p->buf[8]);
+            h.count = get_u16(&p->buf[12]);
+            h.length = get_u16(&p->buf[14]);
+
+            if (!header_valid(&h)) {
+                p->crc_errors++;
+                p->skipped_bytes++;
+                consume(p, 1);
+                continue;
+            }
+
+            size_t total = STREAM_HEADER_BYTES + h.length + STREAM_CRC_BYTES;
+            if (p->have < total) break;
+
+            const uint8_t *payload = &p->buf[STREAM_HEADER_BYTES];
+            uint16_t crc = stream_crc16(0xFFFF, &p->buf[2], STREAM_HEADER_BYTES - 2 + h.length);
+            if (crc != get_u16(&payload[h.length]) || !decode_payload(p, &h, payload)) {
+                // Ложное синхрослово или повреждённый кадр
+                p->crc_errors++;
+                p->skipped_bytes++;
+                consume(p, 1);
+                continue;
+            }
+
+            if (p->have_sequence && h.sequence != p->last_sequence + 1) {
+                // Номер меньше прежнего - прибор перезапущен, потерь не считаем
+                p->gaps++;
+                if (h.sequence > p->last_sequence) p->lost += h.sequence - p->last_sequence - 1;
+            }
+            p->last_sequence = h.sequence;
+            p->have_sequence = true;
+            p->frames++;
+
+            if (cb) cb(ctx, &h, p->samples);
+            consume(p, total);
+        }
+    }
+}
@@ -0,0 +1,141 @@
+#include "usb_stream/usb_stream.h"
+#include "global_buffer/global_buffer.h"
+#include "tusb.h"
+#include "pico/time.h"
+#include <stdatomic.h>
+#include <string.h>
+
+static size_t cdc_available(void *ctx) {
+    (void)ctx;
+    return tud_cdc_connected() ? tud_cdc_write_available() : 0;
+}
+
+static size_t cdc_write(void *ctx, const uint8_t *data, size_t len) {
+    (void)ctx;
+    return tud_cdc_write(data, len);
+}
+
+static void cdc_flush(void *ctx) {
+    (void)ctx;
+    tud_cdc_write_flush();
+}
+
+static const StreamTransport cdc_transport = {
+    .available = cdc_available,
+    .write = cdc_write,
+    .flush = cdc_flush,
+    .ctx = NULL,
+};
+
+static const StreamTransport *transport = &cdc_transport;
+static volatile bool enabled = false;
+static volatile StreamEncoding encoding = STREAM_ENC_DELTA;
+static UsbStreamStats stats;  // sent/dropped - ядро захвата, bytes - ядро дисплея
+
+// Кольцо передачи: кадры лежат подряд. Счётчики байт монотонные (позиция -
+// по модулю размера): tail двигает только usb_stream_send, head - только
+// выталкивание, занято tail - head
+static uint8_t queue[USB_STREAM_QUEUE_BYTES];
+static _Atomic uint32_t head = 0;
+static _Atomic uint32_t tail = 0;
+
+static uint8_t frame[STREAM_FRAME_MAX_BYTES(BUFFER_SIZE)];
+
+void usb_stream_init(const StreamTransport *t) {
+    transport = t ? t : &cdc_transport;
+    enabled = false;
+    atomic_store_explicit(&head, 0, memory_order_relaxed);
+    atomic_store_explicit(&tail, 0, memory_order_relaxed);
+    memset(&stats, 0, sizeof(stats));
+}
+
+// Выключение сбрасывает очередь со стороны читателя: кадр, который
+// usb_stream_send кладёт в этот момент, уйдёт целиком
+void usb_stream_set_mode(bool enable, StreamEncoding enc) {
+    if (enc < STREAM_ENC_COUNT) encoding = enc;
+    enabled = enable;
+    if (!enable) {
+        atomic_store_explicit(&head, atomic_load_explicit(&tail, memory_order_acquire),
+                              memory_order_release);
+    }
+}
+
+bool usb_stream_enabled(void) {
+    return enabled;
+}
+
+StreamEncoding usb_stream_get_encoding(void) {
+    return encoding;
+}
+
+bool usb_stream_send(const uint16_t *samples, uint16_t count,
+                     uint32_t sequence, uint32_t timestamp_us) {
+    if (!enabled) return false;
+
+    size_t len = stream_frame_encode(frame, sizeof(frame), encoding,
+                                     sequence, timestamp_us, samples, count);
+    uint32_t t = atomic_load_explicit(&tail, memory_order_relaxed);
+    uint32_t used = t - atomic_load_explicit(&head, memory_order_acquire);
+    if (len == 0 || len > USB_STREAM_QUEUE_BYTES - used) {
+        stats.dropped++;
+        return false;
+    }
+
+    // Копирование в кольцо двумя кусками, затем публикация
+    uint32_t pos = t % USB_STREAM_QUEUE_BYTES;
+    size_t first = USB_STREAM_QUEUE_BYTES - pos;
+    if (first > len) first = len;
+    memcpy(&queue[pos], frame, first);
+    memcpy(queue, frame + first, len - first);
+    atomic_store_explicit(&tail, t + (uint32_t)len, memory_order_release);
+    stats.sent++;
+    return true;
+}
+
+// Выталкивание до позиции end (граница кадра): байты дальше неё в
+// транспорт не попадают. Возвращает, сколько осталось до end
+static uint32_t service_until(uint32_t end) {
+    uint32_t h = atomic_load_explicit(&head, memory_order_relaxed);
+    if ((int32_t)(end - h) <= 0) return 0;
+
+    uint32_t used = end - h;
+    bool wrote = false;
+    while (used) {
+        size_t room = transport->available(transport->ctx);
+        if (room == 0) break;
+
+        uint32_t pos = h % USB_STREAM_QUEUE_BYTES;
+        size_t chunk = USB_STREAM_QUEUE_BYTES - pos; // До конца кольца
+        if (chunk > used) chunk = used;
+        if (chunk > room) chunk = room;
+
+        size_t n = transport->write(transport->ctx, &queue[pos], chunk);
+        if (n == 0) break;
+        h += (uint32_t)n;
+        used -= (uint32_t)n;
+        atomic_store_explicit(&head, h, memory_order_release);
+        stats.bytes += n;
+        wrote = true;
+    }
+    if (wrote) transport->flush(transport->ctx);
+    return used;
+}
+
+void usb_stream_service(void) {
+    service_until(atomic_load_explicit(&tail, memory_order_acquire));
+}
+
+// Только кадры, лежавшие в очереди к началу: ядро захвата тем временем
+// кладёт новые, а транспорт должен остановиться на границе кадра
+bool usb_stream_drain(uint32_t timeout_us) {
+    absolute_time_t deadline = make_timeout_time_us(timeout_us);
+    uint32_t end = atomic_load_explicit(&tail, memory_order_acquire);
+    while (service_until(end)) {
+        if (time_reached(deadline)) return false;
+    }
+    return true;
+}
+
+void usb_stream_get_stats(UsbStreamStats *out) {
+    *out = stats;
+}
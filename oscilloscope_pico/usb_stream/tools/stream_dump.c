@@ -0,0 +1,185 @@
+// Декодер потока осциллографа для ПК.
+//
+//   stream_dump /dev/ttyACM0        - сводка по кадрам и потерям
+//   stream_dump -c out.csv /dev/ttyACM0 - отсчёты в CSV (sequence,index,code)
+//   stream_dump --selftest          - проверка кадрирования через pipe:
+//       дочерний процесс кодирует синтетические блоки всеми способами, с
+//       пропусками и порчей байт, пишет кусками случайной длины; родитель
+//       декодирует и сверяет каждый отсчёт
+#define _DEFAULT_SOURCE
+#include "usb_stream/stream_frame.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <sys/wait.h>
+
+typedef struct {
+    FILE *csv;
+    bool verbose;
+    uint32_t verify_errors;
+    uint32_t first_sequence;
+    bool verify;
+} DumpContext;
+
+// Синтетический блок, однозначно определяемый номером: синус с шумом,
+// через раз меандр с фронтами на весь диапазон
+static uint16_t synth_sample(uint32_t seq, uint16_t i) {
+    uint32_t h = seq * 2654435761u ^ i * 40503u;
+    h ^= h >> 13;
+    h *= 0x5bd1e995u;
+    h ^= h >> 15;
+    if (seq % 5 == 0) return h & 0x0FFF;                // Шум на весь диапазон
+    if (seq & 1) return ((i / 25) & 1) ? 3900 + (h & 7) : 150 + (h & 7);
+    int tri = (i * 37 + seq) % 2048;
+    return (uint16_t)(1024 + tri + (h & 3));
+}
+
+static uint16_t synth_count(uint32_t seq) {
+    return (uint16_t)(64 + seq * 7919 % 1024);
+}
+
+static void on_frame(void *ctx, const StreamHeader *h, const uint16_t *samples) {
+    DumpContext *d = ctx;
+    if (!d->first_sequence) d->first_sequence = h->sequence;
+    if (d->verbose) {
+        printf("seq %u t %u us enc %u count %u bytes %u\n",
+               h->sequence, h->timestamp_us, h->encoding, h->count, h->length);
+    }
+    if (d->csv) {
+        for (uint16_t i = 0; i < h->count; i++) {
+            fprintf(d->csv, "%u,%u,%u\n", h->sequence, i, samples[i]);
+        }
+    }
+    if (d->verify) {
+        if (h->count != synth_count(h->sequence)) {
+            d->verify_errors++;
+            return;
+        }
+        for (uint16_t i = 0; i < h->count; i++) {
+            if (samples[i] != synth_sample(h->sequence, i)) {
+                d->verify_errors++;
+                return;
+            }
+        }
+    }
+}
+
+static void print_stats(const StreamParser *p) {
+    fprintf(stderr, "frames %u, lost %u in %u gaps, crc errors %u, skipped bytes %u\n",
+            p->frames, p->lost, p->gaps, p->crc_errors, p->skipped_bytes);
+}
+
+static int run_selftest(void) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        perror("pipe");
+        return 2;
+    }
+
+    const uint32_t blocks = 20000;
+    pid_t pid = fork();
+    if (pid == 0) {
+        // Производитель: кодирует как прошивка, пишет в pipe
+        close(fds[0]);
+        static uint8_t frame[STREAM_FRAME_MAX_BYTES(STREAM_MAX_SAMPLES)];
+        static uint16_t samples[STREAM_MAX_SAMPLES];
+        srand(1);
+        for (uint32_t seq = 1; seq <= blocks; seq++) {
+            if (rand() % 50 == 0) continue;          // Блок выброшен при переполнении
+            uint16_t count = synth_count(seq);
+            for (uint16_t i = 0; i < count; i++) samples[i] = synth_sample(seq, i);
+
+            size_t len = stream_frame_encode(frame, sizeof(frame), (StreamEncoding)(seq % STREAM_ENC_COUNT),
+                                             seq, seq * 640, samples, count);
+            if (rand() % 200 == 0) frame[rand() % len] ^= 0x10; // Порча в канале
+            if (rand() % 300 == 0) {                            // Мусор между кадрами
+                uint8_t junk[7] = { STREAM_SYNC0, STREAM_SYNC1, 1, 2, 3, 4, 5 };
+                if (write(fds[1], junk, sizeof(junk)) < 0) _exit(1);
+            }
+            for (size_t off = 0; off < len;) {
+                size_t chunk = 1 + rand() % 700;
+                if (chunk > len - off) chunk = len - off;
+                if (write(fds[1], frame + off, chunk) < 0) _exit(1);
+                off += chunk;
+            }
+        }
+        close(fds[1]);
+        _exit(0);
+    }
+    close(fds[1]);
+
+    static StreamParser parser;
+    stream_parser_init(&parser);
+    DumpContext ctx = { .verify = true };
+
+    uint8_t buf[1024];
+    ssize_t n;
+    while ((n = read(fds[0], buf, sizeof(buf))) > 0) {
+        stream_parser_feed(&parser, buf, (size_t)n, on_frame, &ctx);
+    }
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+
+    print_stats(&parser);
+    fprintf(stderr, "sample mismatches %u\n", ctx.verify_errors);
+
+    // Каждый кадр либо принят целиком и верно, либо учтён как потерянный
+    bool ok = ctx.verify_errors == 0 && parser.frames > blocks * 9 / 10 &&
+              parser.frames + parser.lost == parser.last_sequence - ctx.first_sequence + 1;
+    fprintf(stderr, "selftest %s\n", ok ? "passed" : "FAILED");
+    return ok ? 0 : 1;
+}
+
+static void set_raw_tty(int fd) {
+    struct termios t;
+    if (tcgetattr(fd, &t) != 0) return; // Не терминал (файл или pipe)
+    cfmakeraw(&t);
+    tcsetattr(fd, TCSANOW, &t);
+}
+
+int main(int argc, char **argv) {
+    DumpContext ctx = { .verbose = true };
+    const char *path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--selftest")) return run_selftest();
+        if (!strcmp(argv[i], "-q")) {
+            ctx.verbose = false;
+        } else if (!strcmp(argv[i], "-c") && i + 1 < argc) {
+            ctx.csv = fopen(argv[++i], "w");
+            if (!ctx.csv) {
+                perror(argv[i]);
+                return 2;
+            }
+        } else {
+            path = argv[i];
+        }
+    }
+
+    int fd = STDIN_FILENO;
+    if (path && strcmp(path, "-")) {
+        fd = open(path, O_RDONLY | O_NOCTTY);
+        if (fd < 0) {
+            perror(path);
+            return 2;
+        }
+        set_raw_tty(fd);
+    }
+
+    static StreamParser parser;
+    stream_parser_init(&parser);
+
+    uint8_t buf[4096];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+        stream_parser_feed(&parser, buf, (size_t)n, on_frame, &ctx);
+    }
+
+    print_stats(&parser);
+    if (ctx.csv) fclose(ctx.csv);
+    return 0;
+}
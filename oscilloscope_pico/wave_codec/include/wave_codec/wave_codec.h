@@ -0,0 +1,47 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Сжатие осциллограмм без потерь: первый отсчёт 12 бит как есть, дальше
+// разности соседних отсчётов, zigzag (знак в младший бит) и адаптивный код
+// Райса. Параметр k подстраивается под скользящее среднее разностей, так что
+// шум АЦП в несколько кодов укладывается в 3-5 бит на отсчёт. Очень большие
+// скачки (фронты) уходят через escape: WAVE_CODEC_ESCAPE единиц и 13 бит
+// разности без кодирования.
+//
+// Поток битов старшим битом вперёд, число отсчётов в поток не пишется -
+// его хранит вызывающий.
+
+#define WAVE_CODEC_SAMPLE_BITS 12
+#define WAVE_CODEC_ESCAPE      12
+
+// Худший случай: 12 бит первого отсчёта и escape на каждом следующем
+#define WAVE_CODEC_MAX_BYTES(count) \
+    (((uint32_t)(count) * (WAVE_CODEC_ESCAPE + WAVE_CODEC_SAMPLE_BITS + 1) + 7) / 8 + 2)
+
+// Кодирование count отсчётов (учитываются младшие 12 бит).
+// Возвращает размер в байтах или 0, если не поместилось в capacity
+size_t wave_encode(const uint16_t *samples, uint16_t count, uint8_t *out, size_t capacity);
+
+// Потоковый декодер: отсчёты выдаются по одному, без промежуточного буфера
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    size_t pos;
+    uint32_t acc;
+    uint8_t bits;
+    uint16_t remaining;
+    uint16_t prev;
+    uint32_t mean;
+    bool first;
+    bool error;      // Поток закончился раньше времени
+} WaveDecoder;
+
+void wave_decoder_init(WaveDecoder *dec, const uint8_t *data, size_t size, uint16_t count);
+
+// Следующий отсчёт. false - отсчёты кончились или поток повреждён
+bool wave_decoder_next(WaveDecoder *dec, uint16_t *sample);
+
+// Декодирование целиком, возвращает число восстановленных отсчётов
+uint16_t wave_decode(const uint8_t *data, size_t size, uint16_t *out, uint16_t count);
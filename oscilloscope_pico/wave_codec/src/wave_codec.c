@@ -0,0 +1,138 @@
+#include "wave_codec/wave_codec.h"
+
+#define DELTA_BITS   (WAVE_CODEC_SAMPLE_BITS + 1)  // zigzag-разность 0..8190
+#define MEAN_SHIFT   4                             // Окно среднего ~16 отсчётов
+#define MEAN_INIT    (4u << MEAN_SHIFT)            // Старт с k = 2
+#define K_MAX        WAVE_CODEC_SAMPLE_BITS
+
+// Параметр Райса: 2^k не больше среднего значения разностей
+static inline uint8_t rice_k(uint32_t mean) {
+    uint32_t avg = mean >> MEAN_SHIFT;
+    uint8_t k = 0;
+    while (k < K_MAX && (2u << k) <= avg) k++;
+    return k;
+}
+
+static inline uint32_t mean_update(uint32_t mean, uint32_t u) {
+    return mean + u - (mean >> MEAN_SHIFT);
+}
+
+static inline uint32_t zigzag(int32_t d) {
+    return d >= 0 ? (uint32_t)d << 1 : ((uint32_t)(-d) << 1) - 1;
+}
+
+static inline int32_t unzigzag(uint32_t u) {
+    return (u & 1) ? -(int32_t)((u + 1) >> 1) : (int32_t)(u >> 1);
+}
+
+typedef struct {
+    uint8_t *out;
+    size_t capacity;
+    size_t pos;
+    uint32_t acc;
+    uint8_t bits;
+    bool overflow;
+} BitWriter;
+
+// Запись n <= 24 бит старшим вперёд
+static inline void put_bits(BitWriter *w, uint32_t value, uint8_t n) {
+    w->acc = (w->acc << n) | value;
+    w->bits += n;
+    while (w->bits >= 8) {
+        w->bits -= 8;
+        if (w->pos < w->capacity) w->out[w->pos++] = (uint8_t)(w->acc >> w->bits);
+        else w->overflow = true;
+    }
+}
+
+size_t wave_encode(const uint16_t *samples, uint16_t count, uint8_t *out, size_t capacity) {
+    BitWriter w = { out, capacity, 0, 0, 0, false };
+    if (count == 0) return 0;
+
+    uint16_t prev = samples[0] & 0x0FFF;
+    put_bits(&w, prev, WAVE_CODEC_SAMPLE_BITS);
+
+    uint32_t mean = MEAN_INIT;
+    for (uint16_t i = 1; i < count; i++) {
+        uint16_t s = samples[i] & 0x0FFF;
+        uint32_t u = zigzag((int32_t)s - prev);
+        prev = s;
+
+        uint8_t k = rice_k(mean);
+        uint32_t q = u >> k;
+        if (q < WAVE_CODEC_ESCAPE) {
+            // q единиц, ноль, затем k младших бит
+            put_bits(&w, (2u << q) - 2, q + 1);
+            if (k) put_bits(&w, u & ((1u << k) - 1), k);
+        } else {
+            put_bits(&w, (1u << WAVE_CODEC_ESCAPE) - 1, WAVE_CODEC_ESCAPE);
+            put_bits(&w, u, DELTA_BITS);
+        }
+        mean = mean_update(mean, u);
+    }
+
+    // Добиваем последний байт нулями
+    if (w.bits) put_bits(&w, 0, 8 - w.bits);
+    return w.overflow ? 0 : w.pos;
+}
+
+// Чтение n <= 24 бит старшим вперёд
+static inline uint32_t get_bits(WaveDecoder *dec, uint8_t n) {
+    while (dec->bits < n) {
+        uint8_t byte = 0;
+        if (dec->pos < dec->size) byte = dec->data[dec->pos++];
+        else dec->error = true;
+        dec->acc = (dec->acc << 8) | byte;
+        dec->bits += 8;
+    }
+    dec->bits -= n;
+    return (dec->acc >> dec->bits) & ((1u << n) - 1);
+}
+
+void wave_decoder_init(WaveDecoder *dec, const uint8_t *data, size_t size, uint16_t count) {
+    dec->data = data;
+    dec->size = size;
+    dec->pos = 0;
+    dec->acc = 0;
+    dec->bits = 0;
+    dec->remaining = count;
+    dec->prev = 0;
+    dec->mean = MEAN_INIT;
+    dec->first = true;
+    dec->error = false;
+}
+
+bool wave_decoder_next(WaveDecoder *dec, uint16_t *sample) {
+    if (dec->remaining == 0 || dec->error) return false;
+
+    if (dec->first) {
+        dec->first = false;
+        dec->prev = (uint16_t)get_bits(dec, WAVE_CODEC_SAMPLE_BITS);
+    } else {
+        uint8_t k = rice_k(dec->mean);
+        uint32_t q = 0;
+        while (q < WAVE_CODEC_ESCAPE && get_bits(dec, 1)) q++;
+
+        uint32_t u;
+        if (q < WAVE_CODEC_ESCAPE) {
+            u = (q << k) | (k ? get_bits(dec, k) : 0);
+        } else {
+            u = get_bits(dec, DELTA_BITS);
+        }
+        dec->mean = mean_update(dec->mean, u);
+        dec->prev = (uint16_t)((dec->prev + unzigzag(u)) & 0x0FFF);
+    }
+
+    if (dec->error) return false;
+    dec->remaining--;
+    *sample = dec->prev;
+    return true;
+}
+
+uint16_t wave_decode(const uint8_t *data, size_t size, uint16_t *out, uint16_t count) {
+    WaveDecoder dec;
+    wave_decoder_init(&dec, data, size, count);
+    uint16_t n = 0;
+    while (wave_decoder_next(&dec, &out[n])) n++;
+    return n;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "pico_ili9341/pico_ili9341.h"
+#include "display_driver/display_driver.h"
+
+// Режим XY: канал A по горизонтали, канал B по вертикали, с накоплением
+// как у послесвечения (4-битный счётчик попаданий на пиксель) и в его же
+// карте (persistence_hit_map).
+//
+// АЦП опрашивает входы A и B поочерёдно (round-robin), блок захвата -
+// пары A, B подряд, каждый блок начинается с A. Канал B оцифрован на пол
+// периода пары позже A, поэтому A пересчитывается на момент отсчёта B:
+// кубическая интерполяция посередине между соседними отсчётами A
+// (-1, 9, 9, -1) / 16, у краёв блока - среднее двух. Без этого фигура
+// Лиссажу синфазных сигналов раскрывается в эллипс на высоких частотах.
+//
+// Точки накапливаются ядром захвата на каждый блок, а не на каждый кадр
+// экрана: на экран попадают все оцифрованные пары. Обе оси в масштабе
+// вольт/деление (calibration_code_to_px), квадрат XY_SIZE по центру
+// области осциллограммы.
+
+#define XY_SIZE         WAVEFORM_HEIGHT
+#define XY_LEFT         ((WAVEFORM_WIDTH - XY_SIZE) / 2)
+#define XY_ROW_BYTES    (XY_SIZE / 2)
+#define XY_MAP_BYTES    (XY_ROW_BYTES * XY_SIZE)
+
+#define XY_INPUT_MASK   0x03    // Входы АЦП 0 (A) и 1 (B)
+
+// Период затухания по умолчанию (в блоках): счётчики делятся пополам
+#define XY_DEFAULT_DECAY 128
+
+void xy_init(void);
+
+// Запрос очистки, выполняется при следующем xy_accumulate()
+void xy_clear(void);
+
+void xy_set_decay_period(uint16_t blocks);
+
+// Блок пар A, B (count - отсчётов, чётное)
+void xy_accumulate(const uint16_t *block, uint16_t count);
+
+// Вывод карты в 8-битный буфер области осциллограммы (stride пикселей в
+// строке) через тепловую палитру, начиная со столбца XY_LEFT
+void xy_render(color8_t *dst, uint16_t stride);
+
+// Точек с последней очистки
+uint32_t xy_get_points(void);
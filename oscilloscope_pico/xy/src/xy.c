@@ -0,0 +1,103 @@
+#include "xy/xy.h"
+#include "calibration/calibration.h"
+#include "persistence/persistence.h"
+#include <pico/stdlib.h>
+#include <string.h>
+
+// Карта - общая с послесвечением (persistence.h), затухание идёт по
+// 8 пикселей за раз до целого слова
+#define MAP_WORDS ((XY_MAP_BYTES + 3) / 4)
+#if MAP_WORDS * 4 > PERSIST_MAP_BYTES
+#error "XY map does not fit the persistence map"
+#endif
+#define hit_map persistence_hit_map
+
+static volatile bool clear_requested = false;
+static volatile uint16_t decay_period = XY_DEFAULT_DECAY;
+static uint16_t since_decay = 0;
+static volatile uint32_t points = 0;
+
+void xy_init(void) {
+    memset(hit_map, 0, MAP_WORDS * 4);
+    clear_requested = false;
+    since_decay = 0;
+    points = 0;
+}
+
+void xy_clear(void) {
+    clear_requested = true;
+}
+
+void xy_set_decay_period(uint16_t blocks) {
+    decay_period = blocks;
+}
+
+uint32_t xy_get_points(void) {
+    return points;
+}
+
+// Деление всех счётчиков пополам: сдвиг слова и маска старших битов тетрад
+static void __not_in_flash_func(xy_decay)(void) {
+    uint32_t *words = (uint32_t *)hit_map;
+    for (int i = 0; i < MAP_WORDS; i++) {
+        uint32_t w = words[i];
+        if (w) words[i] = (w >> 1) & 0x77777777u;
+    }
+}
+
+static inline void __not_in_flash_func(plot)(uint16_t a, uint16_t b) {
+    int x = XY_SIZE - 1 - calibration_code_to_px(a);
+    int y = calibration_code_to_px(b);
+    uint8_t *p = &hit_map[y * XY_ROW_BYTES + (x >> 1)];
+    if (x & 1) {
+        if ((*p & 0xF0) != 0xF0) *p += 0x10;
+    } else {
+        if ((*p & 0x0F) != 0x0F) *p += 0x01;
+    }
+}
+
+void __not_in_flash_func(xy_accumulate)(const uint16_t *block, uint16_t count) {
+    if (clear_requested) {
+        memset(hit_map, 0, MAP_WORDS * 4);
+        clear_requested = false;
+        since_decay = 0;
+        points = 0;
+    }
+
+    // Пара i: A[i] = block[2i], B[i] = block[2i + 1]. У последней пары
+    // нет следующего A - она пропускается
+    uint16_t pairs = count / 2;
+    if (pairs < 2) return;
+    const uint16_t *s = block;
+    plot((s[0] + s[2] + 1) >> 1, s[1]);
+    for (uint16_t i = 1; i + 2 < pairs; i++) {
+        int32_t a = (9 * (s[2 * i] + s[2 * i + 2]) - s[2 * i - 2] - s[2 * i + 4] + 8) >> 4;
+        if (a < 0) a = 0;
+        if (a > 4095) a = 4095;
+        plot((uint16_t)a, s[2 * i + 1]);
+    }
+    if (pairs > 2) {
+        uint16_t i = pairs - 2;
+        plot((s[2 * i] + s[2 * i + 2] + 1) >> 1, s[2 * i + 1]);
+    }
+    points += pairs - 1;
+
+    if (decay_period && ++since_decay >= decay_period) {
+        since_decay = 0;
+        xy_decay();
+    }
+}
+
+void xy_render(color8_t *dst, uint16_t stride) {
+    if (clear_requested) return; // В карте ещё послесвечение
+    const uint8_t *row = hit_map;
+    dst += XY_LEFT;
+    for (int y = 0; y < XY_SIZE; y++, row += XY_ROW_BYTES, dst += stride) {
+        for (int i = 0; i < XY_ROW_BYTES; i++) {
+            uint8_t v = row[i];
+            if (!v) continue;
+            if (v & 0x0F) dst[2 * i] = COLOR8_HEAT_BASE + (v & 0x0F) - 1;
+            if (v >> 4) dst[2 * i + 1] = COLOR8_HEAT_BASE + (v >> 4) - 1;
+        }
+    }
+}